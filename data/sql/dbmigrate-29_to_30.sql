@@ -0,0 +1,39 @@
+-- Script to migate from db version 29 to 30.
+--
+-- Charts and track/artist stats used to aggregate the whole playback_log on every
+--  request. Keep per-track and per-day play counts around instead, maintained by
+--  DatabaseCommand_LogPlayback, and seed them from the existing log.
+
+CREATE INDEX IF NOT EXISTS playback_log_playtime ON playback_log(playtime);
+
+CREATE TABLE IF NOT EXISTS playback_stats (
+    source INTEGER REFERENCES source(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    track INTEGER NOT NULL REFERENCES track(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    artist INTEGER NOT NULL REFERENCES artist(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    plays INTEGER NOT NULL DEFAULT 0
+);
+CREATE INDEX playback_stats_source_track ON playback_stats(source, track);
+CREATE INDEX playback_stats_source_plays ON playback_stats(source, plays);
+CREATE INDEX playback_stats_artist ON playback_stats(artist);
+
+CREATE TABLE IF NOT EXISTS playback_stats_daily (
+    source INTEGER REFERENCES source(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    track INTEGER NOT NULL REFERENCES track(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    day INTEGER NOT NULL,
+    plays INTEGER NOT NULL DEFAULT 0
+);
+CREATE INDEX playback_stats_daily_day ON playback_stats_daily(day, source, track);
+
+INSERT INTO playback_stats(source, track, artist, plays)
+    SELECT playback_log.source, playback_log.track, track.artist, COUNT(*)
+    FROM playback_log, track
+    WHERE track.id = playback_log.track
+    GROUP BY playback_log.source, playback_log.track;
+
+INSERT INTO playback_stats_daily(source, track, day, plays)
+    SELECT source, track, playtime / 86400, COUNT(*)
+    FROM playback_log
+    WHERE track IS NOT NULL
+    GROUP BY source, track, playtime / 86400;
+
+UPDATE settings SET v = '30' WHERE k == 'schema_version';
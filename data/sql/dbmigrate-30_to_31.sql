@@ -0,0 +1,9 @@
+-- Script to migate from db version 30 to 31.
+--
+-- Playlist revisions can be stored as a delta against their previous revision
+--  instead of the full list of entry guids. Existing revisions stay full snapshots.
+
+ALTER TABLE playlist_revision ADD COLUMN entries_delta TEXT;
+ALTER TABLE playlist_revision ADD COLUMN snapshot_distance INTEGER NOT NULL DEFAULT 0;
+
+UPDATE settings SET v = '31' WHERE k == 'schema_version';
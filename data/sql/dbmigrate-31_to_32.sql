@@ -0,0 +1,18 @@
+-- Script to migate from db version 31 to 32.
+--
+-- The oplog can be compacted. The guids of ops it drops are kept together
+--  with their position, so peers that synced up to one of them can continue.
+
+CREATE TABLE IF NOT EXISTS oplog_compacted (
+    guid TEXT PRIMARY KEY,
+    id INTEGER NOT NULL
+);
+
+-- How far each peer has synced our ops, so the kept guids of older ops can be pruned.
+
+CREATE TABLE IF NOT EXISTS oplog_peers (
+    peer TEXT PRIMARY KEY,
+    id INTEGER NOT NULL
+);
+
+UPDATE settings SET v = '32' WHERE k == 'schema_version';
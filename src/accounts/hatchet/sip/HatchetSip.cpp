@@ -25,6 +25,7 @@
 #include <database/Database.h>
 #include <database/DatabaseImpl.h>
 #include <database/DatabaseCommand_LoadOps.h>
+#include <database/DatabaseCommand_SetOplogPosition.h>
 #include <network/ControlConnection.h>
 #include <network/Servent.h>
 #include <sip/PeerInfo.h>
@@ -542,6 +543,10 @@ HatchetSipPlugin::sendOplog( const QVariantMap& valMap ) const
     DatabaseCommand_loadOps* cmd = new DatabaseCommand_loadOps( SourceList::instance()->getLocal(), valMap[ "lastrevision" ].toString() );
     connect( cmd, SIGNAL( done( QString, QString, QList< dbop_ptr > ) ), SLOT( oplogFetched( QString, QString, QList< dbop_ptr > ) ) );
     Database::instance()->enqueue( QSharedPointer< DatabaseCommand >( cmd ) );
+
+    // Hatchet keeps our ops like any other peer, compacting mustn't forget the revision it is at
+    DatabaseCommand_SetOplogPosition* pos = new DatabaseCommand_SetOplogPosition( m_account->accountId(), valMap[ "lastrevision" ].toString() );
+    Database::instance()->enqueue( QSharedPointer< DatabaseCommand >( pos ) );
 }
 
 
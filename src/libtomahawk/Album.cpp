@@ -30,8 +30,11 @@
 #include "utils/TomahawkUtilsGui.h"
 #include "utils/Logger.h"
 
+#ifndef ENABLE_HEADLESS
+    #include "utils/CoverCache.h"
+#endif
+
 #include <QReadWriteLock>
-#include <QPixmapCache>
 
 using namespace Tomahawk;
 
@@ -46,10 +49,6 @@ Album::~Album()
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Deleting album:" << m_name << m_artist->name();
     m_ownRef.clear();
-
-#ifndef ENABLE_HEADLESS
-    delete m_cover;
-#endif
 }
 
 
@@ -130,9 +129,6 @@ Album::Album( unsigned int id, const QString& name, const Tomahawk::artist_ptr&
     , m_artist( artist )
     , m_coverLoaded( false )
     , m_coverLoading( false )
-#ifndef ENABLE_HEADLESS
-    , m_cover( 0 )
-#endif
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Creating album:" << id << name << artist->name();
     m_sortname = DatabaseImpl::sortname( name );
@@ -147,9 +143,6 @@ Album::Album( const QString& name, const Tomahawk::artist_ptr& artist )
     , m_artist( artist )
     , m_coverLoaded( false )
     , m_coverLoading( false )
-#ifndef ENABLE_HEADLESS
-    , m_cover( 0 )
-#endif
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Creating album:" << name << artist->name();
     m_sortname = DatabaseImpl::sortname( name );
@@ -274,33 +267,32 @@ Album::cover( const QSize& size, bool forceLoad ) const
         m_coverLoading = true;
     }
 
-    if ( !m_cover && !m_coverBuffer.isEmpty() )
+    if ( !hasCover() )
+        return QPixmap();
+
+    // decoding and scaling happen on the thread pool, onCoverDecoded() lets the views know
+    return TomahawkUtils::CoverCache::instance()->cover( m_coverHash, m_coverBuffer, m_coverImage, size, const_cast< Album* >( this ), "onCoverDecoded" );
+}
+
+
+void
+Album::onCoverDecoded( const QSize& size, const QPixmap& cover, const QImage& decoded )
+{
+    Q_UNUSED( size );
+
+    if ( !decoded.isNull() )
     {
-        QPixmap cover;
-        cover.loadFromData( m_coverBuffer );
+        // other sizes get scaled from the decoded image, the raw data isn't needed anymore
+        m_coverImage = decoded;
         m_coverBuffer.clear();
-
-        m_cover = new QPixmap( TomahawkUtils::squareCenterPixmap( cover ) );
     }
-
-    if ( m_cover && !m_cover->isNull() && !size.isEmpty() )
+    else if ( cover.isNull() && m_coverImage.isNull() )
     {
-        const QString cacheKey = infoid() + "_" + size.width();
-        QPixmap cover;
-
-        if ( !QPixmapCache::find( cacheKey, cover ) )
-        {
-            cover = m_cover->scaled( size, Qt::KeepAspectRatio, Qt::SmoothTransformation );
-            QPixmapCache::insert( cacheKey, cover );
-            return cover;
-        }
-        return cover;
+        // the data couldn't be decoded, so there is no cover
+        m_coverBuffer.clear();
     }
 
-    if ( m_cover )
-        return *m_cover;
-    else
-        return QPixmap();
+    emit coverChanged();
 }
 #endif
 
@@ -325,6 +317,10 @@ Album::infoSystemInfo( const Tomahawk::InfoSystem::InfoRequestData& requestData,
         if ( ba.length() )
         {
             m_coverBuffer = ba;
+#ifndef ENABLE_HEADLESS
+            m_coverImage = QImage();
+            m_coverHash = TomahawkUtils::CoverCache::hash( ba );
+#endif
         }
 
         m_coverLoaded = true;
@@ -23,6 +23,7 @@
 #include <QtCore/QObject>
 #include <QtCore/QSharedPointer>
 #ifndef ENABLE_HEADLESS
+    #include <QtGui/QImage>
     #include <QtGui/QPixmap>
 #endif
 #include <QFuture>
@@ -59,6 +60,10 @@ public:
     QPixmap cover( const QSize& size, bool forceLoad = true ) const;
 #endif
     bool coverLoaded() const { return m_coverLoaded; }
+#ifndef ENABLE_HEADLESS
+    // true if there is a cover, even though it might still be decoding
+    bool hasCover() const { return !m_coverBuffer.isEmpty() || !m_coverImage.isNull(); }
+#endif
 
     QList<Tomahawk::query_ptr> tracks( ModelMode mode = Mixed, const Tomahawk::collection_ptr& collection = Tomahawk::collection_ptr() );
     Tomahawk::playlistinterface_ptr playlistInterface( ModelMode mode, const Tomahawk::collection_ptr& collection = Tomahawk::collection_ptr() );
@@ -82,6 +87,10 @@ private slots:
     void infoSystemInfo( const Tomahawk::InfoSystem::InfoRequestData& requestData, const QVariant& output );
     void infoSystemFinished( const QString& target );
 
+#ifndef ENABLE_HEADLESS
+    void onCoverDecoded( const QSize& size, const QPixmap& cover, const QImage& decoded );
+#endif
+
 private:
     Q_DISABLE_COPY( Album )
     QString infoid() const;
@@ -101,7 +110,8 @@ private:
 
     mutable QByteArray m_coverBuffer;
 #ifndef ENABLE_HEADLESS
-    mutable QPixmap* m_cover;
+    QByteArray m_coverHash;
+    QImage m_coverImage;
 #endif
 
     QHash< Tomahawk::ModelMode, QHash< Tomahawk::collection_ptr, Tomahawk::playlistinterface_ptr > > m_playlistInterface;
@@ -50,6 +50,7 @@ AlbumPlaylistInterface::AlbumPlaylistInterface( Tomahawk::Album* album, Tomahawk
 
 AlbumPlaylistInterface::~AlbumPlaylistInterface()
 {
+    m_tracksToken.cancel();
     m_album = 0;
 }
 
@@ -144,6 +145,7 @@ AlbumPlaylistInterface::tracks() const
                 cmd->setSortOrder( DatabaseCommand_AllTracks::AlbumPosition );
                 connect( cmd, SIGNAL( tracks( QList<Tomahawk::query_ptr>, QVariant ) ),
                                 SLOT( onTracksLoaded( QList<Tomahawk::query_ptr> ) ) );
+                m_tracksToken = cmd->cancelToken();
                 Database::instance()->enqueue( QSharedPointer<DatabaseCommand>( cmd ) );
             }
             else
@@ -153,6 +155,8 @@ AlbumPlaylistInterface::tracks() const
                 Tomahawk::TracksRequest* cmd = m_collection->requestTracks( ap );
                 connect( dynamic_cast< QObject* >( cmd ), SIGNAL( tracks( QList<Tomahawk::query_ptr> ) ),
                          this, SLOT( onTracksLoaded( QList<Tomahawk::query_ptr> ) ), Qt::UniqueConnection );
+                if ( DatabaseCommand* dbcmd = dynamic_cast< DatabaseCommand* >( cmd ) )
+                    m_tracksToken = dbcmd->cancelToken();
 
                 cmd->enqueue();
             }
@@ -240,6 +244,7 @@ AlbumPlaylistInterface::infoSystemFinished( const QString& infoId )
             cmd->setSortOrder( DatabaseCommand_AllTracks::AlbumPosition );
             connect( cmd, SIGNAL( tracks( QList<Tomahawk::query_ptr>, QVariant ) ),
                             SLOT( onTracksLoaded( QList<Tomahawk::query_ptr> ) ) );
+            m_tracksToken = cmd->cancelToken();
             Database::instance()->enqueue( QSharedPointer<DatabaseCommand>( cmd ) );
         }
         else
@@ -249,6 +254,8 @@ AlbumPlaylistInterface::infoSystemFinished( const QString& infoId )
             Tomahawk::TracksRequest* cmd = m_collection->requestTracks( ap );
             connect( dynamic_cast< QObject* >( cmd ), SIGNAL( tracks( QList<Tomahawk::query_ptr> ) ),
                      this, SLOT( onTracksLoaded( QList<Tomahawk::query_ptr> ) ), Qt::UniqueConnection );
+            if ( DatabaseCommand* dbcmd = dynamic_cast< DatabaseCommand* >( cmd ) )
+                m_tracksToken = dbcmd->cancelToken();
 
             cmd->enqueue();
         }
@@ -26,6 +26,7 @@
 #include "Album.h"
 #include "Typedefs.h"
 #include "PlaylistInterface.h"
+#include "database/DatabaseCommand.h"
 #include "infosystem/InfoSystem.h"
 #include "DllMacro.h"
 
@@ -82,6 +83,8 @@ private:
     Tomahawk::collection_ptr m_collection;
 
     QPointer< Tomahawk::Album > m_album;
+    // the track listing we're waiting for, which nobody needs once we're gone
+    mutable DatabaseCommand::CancelToken m_tracksToken;
 
     int m_lastQueryTimestamp; //To prevent infinite loops on empty responses. This should not happen, but let's make sure.
 };
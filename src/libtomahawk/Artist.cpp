@@ -33,8 +33,11 @@
 #include "utils/TomahawkUtilsGui.h"
 #include "utils/Logger.h"
 
+#ifndef ENABLE_HEADLESS
+    #include "utils/CoverCache.h"
+#endif
+
 #include <QReadWriteLock>
-#include <QPixmapCache>
 
 using namespace Tomahawk;
 
@@ -50,10 +53,6 @@ Artist::~Artist()
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Deleting artist:" << m_name;
     m_ownRef.clear();
-
-#ifndef ENABLE_HEADLESS
-    delete m_cover;
-#endif
 }
 
 
@@ -136,9 +135,6 @@ Artist::Artist( unsigned int id, const QString& name )
     , m_infoJobs( 0 )
     , m_chartPosition( 0 )
     , m_chartCount( 0 )
-#ifndef ENABLE_HEADLESS
-    , m_cover( 0 )
-#endif
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Creating artist:" << id << name;
     m_sortname = DatabaseImpl::sortname( name, true );
@@ -157,9 +153,6 @@ Artist::Artist( const QString& name )
     , m_infoJobs( 0 )
     , m_chartPosition( 0 )
     , m_chartCount( 0 )
-#ifndef ENABLE_HEADLESS
-    , m_cover( 0 )
-#endif
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Creating artist:" << name;
     m_sortname = DatabaseImpl::sortname( name, true );
@@ -523,6 +516,10 @@ Artist::infoSystemInfo( Tomahawk::InfoSystem::InfoRequestData requestData, QVari
                 if ( ba.length() )
                 {
                     m_coverBuffer = ba;
+#ifndef ENABLE_HEADLESS
+                    m_coverImage = QImage();
+                    m_coverHash = TomahawkUtils::CoverCache::hash( ba );
+#endif
                 }
 
                 m_coverLoaded = true;
@@ -622,33 +619,32 @@ Artist::cover( const QSize& size, bool forceLoad ) const
         m_coverLoading = true;
     }
 
-    if ( !m_cover && !m_coverBuffer.isEmpty() )
+    if ( !hasCover() )
+        return QPixmap();
+
+    // decoding and scaling happen on the thread pool, onCoverDecoded() lets the views know
+    return TomahawkUtils::CoverCache::instance()->cover( m_coverHash, m_coverBuffer, m_coverImage, size, const_cast< Artist* >( this ), "onCoverDecoded" );
+}
+
+
+void
+Artist::onCoverDecoded( const QSize& size, const QPixmap& cover, const QImage& decoded )
+{
+    Q_UNUSED( size );
+
+    if ( !decoded.isNull() )
     {
-        QPixmap cover;
-        cover.loadFromData( m_coverBuffer );
+        // other sizes get scaled from the decoded image, the raw data isn't needed anymore
+        m_coverImage = decoded;
         m_coverBuffer.clear();
-
-        m_cover = new QPixmap( TomahawkUtils::squareCenterPixmap( cover ) );
     }
-
-    if ( m_cover && !m_cover->isNull() && !size.isEmpty() )
+    else if ( cover.isNull() && m_coverImage.isNull() )
     {
-        const QString cacheKey = infoid() + "_" + size.width();
-        QPixmap cover;
-
-        if ( !QPixmapCache::find( cacheKey, cover ) )
-        {
-            cover = m_cover->scaled( size, Qt::KeepAspectRatio, Qt::SmoothTransformation );
-            QPixmapCache::insert( cacheKey, cover );
-            return cover;
-        }
-        return cover;
+        // the data couldn't be decoded, so there is no cover
+        m_coverBuffer.clear();
     }
 
-    if ( m_cover )
-        return *m_cover;
-    else
-        return QPixmap();
+    emit coverChanged();
 }
 #endif
 
@@ -22,6 +22,7 @@
 
 #include <QtCore/QObject>
 #ifndef ENABLE_HEADLESS
+    #include <QtGui/QImage>
     #include <QtGui/QPixmap>
 #endif
 
@@ -72,6 +73,10 @@ public:
     QPixmap cover( const QSize& size, bool forceLoad = true ) const;
 #endif
     bool coverLoaded() const { return m_coverLoaded; }
+#ifndef ENABLE_HEADLESS
+    // true if there is a cover, even though it might still be decoding
+    bool hasCover() const { return !m_coverBuffer.isEmpty() || !m_coverImage.isNull(); }
+#endif
 
     Tomahawk::playlistinterface_ptr playlistInterface();
 
@@ -101,6 +106,10 @@ private slots:
     void infoSystemInfo( Tomahawk::InfoSystem::InfoRequestData requestData, QVariant output );
     void infoSystemFinished( QString target );
 
+#ifndef ENABLE_HEADLESS
+    void onCoverDecoded( const QSize& size, const QPixmap& cover, const QImage& decoded );
+#endif
+
 private:
     Artist();
     QString infoid() const;
@@ -134,7 +143,8 @@ private:
 
     mutable QByteArray m_coverBuffer;
 #ifndef ENABLE_HEADLESS
-    mutable QPixmap* m_cover;
+    QByteArray m_coverHash;
+    QImage m_coverImage;
 #endif
 
     QHash< Tomahawk::ModelMode, QHash< Tomahawk::collection_ptr, Tomahawk::playlistinterface_ptr > > m_playlistInterface;
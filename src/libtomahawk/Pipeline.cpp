@@ -322,10 +322,13 @@ Pipeline::addResultsToQuery( const query_ptr& query, const QList< result_ptr >&
 {
 //    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << query->toString() << results.count();
 
+    const QList< float > scores = query->howSimilar( results );
+
     QList< result_ptr > cleanResults;
-    foreach ( const result_ptr& r, results )
+    for ( int i = 0; i < results.count(); i++ )
     {
-        r->setScore( query->howSimilar( r ) );
+        const result_ptr& r = results.at( i );
+        r->setScore( scores.at( i ) );
         if ( !query->isFullTextQuery() && r->score() < MINSCORE )
             continue;
 
@@ -41,6 +41,9 @@
 #include <QtXml/QDomDocument>
 #include <QtXml/QDomElement>
 
+// after a revision is written, how long further edits are collected before the queued ones go out as one revision
+#define REVISION_COALESCE_DELAY 250
+
 using namespace Tomahawk;
 
 
@@ -106,6 +109,10 @@ Playlist::init()
     m_locallyChanged = false;
     m_loaded = false;
 
+    m_revisionTimer.setSingleShot( true );
+    m_revisionTimer.setInterval( REVISION_COALESCE_DELAY );
+    connect( &m_revisionTimer, SIGNAL( timeout() ), SLOT( flushRevisionQueue() ) );
+
     connect( Pipeline::instance(), SIGNAL( idle() ), SLOT( onResolvingFinished() ) );
 }
 
@@ -481,7 +488,10 @@ Playlist::setRevision( const QString& rev,
         connect( entry.data(), SIGNAL( resultChanged() ), SLOT( onResultsChanged() ), Qt::UniqueConnection );
     }
 
-    setBusy( false );
+    // Edits that came in while this revision was written stay queued a little longer, so a burst of
+    // them (a drag and drop, an updater syncing) ends up as one revision instead of one each.
+    const bool queued = !m_revisionQueue.isEmpty() || !m_updateQueue.isEmpty();
+    setBusy( queued );
     setLoaded( true );
 
     if ( m_initEntries.count() && currentrevision().isEmpty() )
@@ -493,7 +503,10 @@ Playlist::setRevision( const QString& rev,
     else
         emit revisionLoaded( pr );
 
-    checkRevisionQueue();
+    if ( queued )
+        m_revisionTimer.start();
+    else
+        checkRevisionQueue();
 }
 
 
@@ -568,7 +581,7 @@ Playlist::resolve()
         qlist << p->query();
     }
 
-    Pipeline::instance()->resolve( qlist );
+    Pipeline::instance()->resolve( qlist, false );
 }
 
 
@@ -720,6 +733,14 @@ Playlist::setLoaded( bool b )
 }
 
 
+void
+Playlist::flushRevisionQueue()
+{
+    setBusy( false );
+    checkRevisionQueue();
+}
+
+
 void
 Playlist::checkRevisionQueue()
 {
@@ -727,6 +748,18 @@ Playlist::checkRevisionQueue()
     {
         RevisionQueueItem item = m_revisionQueue.dequeue();
 
+        // every queued revision carries the complete list of entries, so of a run of edits
+        // to the tip only the last state needs to be written
+        while ( item.applyToTip && item.newRev != item.oldRev && !m_revisionQueue.isEmpty() &&
+                m_revisionQueue.head().applyToTip && m_revisionQueue.head().newRev != m_revisionQueue.head().oldRev )
+        {
+            const RevisionQueueItem next = m_revisionQueue.dequeue();
+            tDebug( LOGVERBOSE ) << "Merging queued playlist revision" << item.newRev << "into" << next.newRev;
+
+            item.newRev = next.newRev;
+            item.entries = next.entries;
+        }
+
         if ( item.oldRev != currentrevision() && item.applyToTip )
         {
             // this was applied to the then-latest, but the already-running operation changed it so it's out of date now. fix it
@@ -744,6 +777,28 @@ Playlist::checkRevisionQueue()
     {
         RevisionQueueItem item = m_updateQueue.dequeue();
 
+        // metadata updates only carry the changed entries, merge them with the later version winning
+        while ( item.applyToTip && item.newRev != item.oldRev && !m_updateQueue.isEmpty() &&
+                m_updateQueue.head().applyToTip && m_updateQueue.head().newRev != m_updateQueue.head().oldRev )
+        {
+            const RevisionQueueItem next = m_updateQueue.dequeue();
+            tDebug( LOGVERBOSE ) << "Merging queued playlist update" << item.newRev << "into" << next.newRev;
+
+            QSet< QString > updated;
+            foreach ( const plentry_ptr& p, next.entries )
+                updated.insert( p->guid() );
+
+            QList< plentry_ptr > entries;
+            foreach ( const plentry_ptr& p, item.entries )
+            {
+                if ( !updated.contains( p->guid() ) )
+                    entries << p;
+            }
+
+            item.newRev = next.newRev;
+            item.entries = entries + next.entries;
+        }
+
         if ( item.oldRev != currentrevision() && item.applyToTip )
         {
             // this was applied to the then-latest, but the already-running operation changed it so it's out of date now. fix it
@@ -26,6 +26,7 @@
 #include <QVariant>
 #include <QSharedPointer>
 #include <QQueue>
+#include <QTimer>
 
 #include "Typedefs.h"
 #include "Result.h"
@@ -253,6 +254,7 @@ private slots:
     void onResolvingFinished();
 
     void onDeleteResult( SourceTreePopupDialog* );
+    void flushRevisionQueue();
 
 private:
     Playlist();
@@ -277,6 +279,7 @@ private:
 
     QQueue<RevisionQueueItem> m_revisionQueue;
     QQueue<RevisionQueueItem> m_updateQueue;
+    QTimer m_revisionTimer; // collects more edits into the queued ones before writing them
 
     QList<PlaylistUpdaterInterface*> m_updaters;
 
@@ -35,6 +35,7 @@
 #include "SourceList.h"
 #include "audio/AudioEngine.h"
 
+#include "utils/EditDistance.h"
 #include "utils/Logger.h"
 
 using namespace Tomahawk;
@@ -444,15 +445,17 @@ Query::toString() const
 }
 
 
-// TODO make clever (ft. featuring live (stuff) etc)
 float
 Query::howSimilar( const Tomahawk::result_ptr& r )
 {
-    // result values
-    const QString rArtistname = r->track()->artistSortname();
-    const QString rAlbumname  = r->track()->albumSortname();
-    const QString rTrackname  = r->track()->trackSortname();
+    return howSimilar( QList< Tomahawk::result_ptr >() << r ).first();
+}
+
 
+// TODO make clever (ft. featuring live (stuff) etc)
+QList< float >
+Query::howSimilar( const QList< Tomahawk::result_ptr >& results )
+{
     QString qArtistname;
     QString qAlbumname;
     QString qTrackname;
@@ -470,44 +473,61 @@ Query::howSimilar( const Tomahawk::result_ptr& r )
         qTrackname  = queryTrack()->trackSortname();
     }
 
-    // normal edit distance
-    int artdist = TomahawkUtils::levenshtein( qArtistname, rArtistname );
-    int albdist = TomahawkUtils::levenshtein( qAlbumname, rAlbumname );
-    int trkdist = TomahawkUtils::levenshtein( qTrackname, rTrackname );
+    // the query side is the same for every result, only prepare it once
+    const TomahawkUtils::EditDistance artistMatcher( qArtistname );
+    const TomahawkUtils::EditDistance albumMatcher( qAlbumname );
+    const TomahawkUtils::EditDistance trackMatcher( qTrackname );
+    const TomahawkUtils::EditDistance artistTrackMatcher( isFullTextQuery() ? qAlbumname : QString() );
 
-    // max length of name
-    int mlart = qMax( qArtistname.length(), rArtistname.length() );
-    int mlalb = qMax( qAlbumname.length(), rAlbumname.length() );
-    int mltrk = qMax( qTrackname.length(), rTrackname.length() );
-
-    // distance scores
-    float dcart = (float)( mlart - artdist ) / mlart;
-    float dcalb = (float)( mlalb - albdist ) / mlalb;
-    float dctrk = (float)( mltrk - trkdist ) / mltrk;
-
-    if ( isFullTextQuery() )
+    QList< float > scores;
+    foreach ( const Tomahawk::result_ptr& r, results )
     {
-        const QString artistTrackname = DatabaseImpl::sortname( fullTextQuery() );
-        const QString rArtistTrackname  = DatabaseImpl::sortname( r->track()->artist() + " " + r->track()->track() );
+        // result values
+        const QString rArtistname = r->track()->artistSortname();
+        const QString rAlbumname  = r->track()->albumSortname();
+        const QString rTrackname  = r->track()->trackSortname();
+
+        // normal edit distance
+        int artdist = artistMatcher.distance( rArtistname );
+        int albdist = albumMatcher.distance( rAlbumname );
+        int trkdist = trackMatcher.distance( rTrackname );
+
+        // max length of name
+        int mlart = qMax( qArtistname.length(), rArtistname.length() );
+        int mlalb = qMax( qAlbumname.length(), rAlbumname.length() );
+        int mltrk = qMax( qTrackname.length(), rTrackname.length() );
+
+        // distance scores
+        float dcart = (float)( mlart - artdist ) / mlart;
+        float dcalb = (float)( mlalb - albdist ) / mlalb;
+        float dctrk = (float)( mltrk - trkdist ) / mltrk;
+
+        if ( isFullTextQuery() )
+        {
+            const QString& artistTrackname = artistTrackMatcher.pattern();
+            const QString rArtistTrackname  = DatabaseImpl::joinSortnames( r->track()->artistFullSortname(), rTrackname );
 
-        int atrdist = TomahawkUtils::levenshtein( artistTrackname, rArtistTrackname );
-        int mlatr = qMax( artistTrackname.length(), rArtistTrackname.length() );
-        float dcatr = (float)( mlatr - atrdist ) / mlatr;
+            int atrdist = artistTrackMatcher.distance( rArtistTrackname );
+            int mlatr = qMax( artistTrackname.length(), rArtistTrackname.length() );
+            float dcatr = (float)( mlatr - atrdist ) / mlatr;
 
-        float res = qMax( dcart, dcalb );
-        res = qMax( res, dcatr );
-        return qMax( res, dctrk );
-    }
-    else
-    {
-        // don't penalize for missing album name
-        if ( queryTrack()->albumSortname().isEmpty() )
-            dcalb = 1.0;
+            float res = qMax( dcart, dcalb );
+            res = qMax( res, dcatr );
+            scores << qMax( res, dctrk );
+        }
+        else
+        {
+            // don't penalize for missing album name
+            if ( queryTrack()->albumSortname().isEmpty() )
+                dcalb = 1.0;
 
-        // weighted, so album match is worth less than track title
-        float combined = ( dcart * 4 + dcalb + dctrk * 5 ) / 10;
-        return combined;
+            // weighted, so album match is worth less than track title
+            float combined = ( dcart * 4 + dcalb + dctrk * 5 ) / 10;
+            scores << combined;
+        }
     }
+
+    return scores;
 }
 
 
@@ -55,6 +55,7 @@ public:
 
     bool equals( const Tomahawk::query_ptr& other, bool ignoreCase = false ) const;
     float howSimilar( const Tomahawk::result_ptr& r );
+    QList< float > howSimilar( const QList< Tomahawk::result_ptr >& results );
 
     QVariant toVariant() const;
     QString toString() const;
@@ -659,7 +659,7 @@ void
 Source::updateTracks()
 {
     {
-        DatabaseCommand* cmd = new DatabaseCommand_UpdateSearchIndex();
+        DatabaseCommand* cmd = new DatabaseCommand_UpdateSearchIndex( true );
         Database::instance()->enqueue( QSharedPointer<DatabaseCommand>( cmd ) );
     }
 
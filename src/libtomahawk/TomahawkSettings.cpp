@@ -1053,6 +1053,20 @@ TomahawkSettings::setEnableEchonestCatalogs( bool enable )
 }
 
 
+QString
+TomahawkSettings::searchIndexEngine() const
+{
+    return value( "collection/search_engine", "lucene" ).toString();
+}
+
+
+void
+TomahawkSettings::setSearchIndexEngine( const QString& engine )
+{
+    setValue( "collection/search_engine", engine );
+}
+
+
 QByteArray
 TomahawkSettings::playlistColumnSizes( const QString& playlistid ) const
 {
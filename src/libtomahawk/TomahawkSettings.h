@@ -89,6 +89,10 @@ public:
     bool enableEchonestCatalogs() const;
     void setEnableEchonestCatalogs( bool enable );
 
+    /// "lucene" or "ngram", picked up on the next start
+    QString searchIndexEngine() const;
+    void setSearchIndexEngine( const QString& engine );
+
     /// Audio stuff
     unsigned int volume() const;
     void setVolume( unsigned int volume );
@@ -504,11 +504,12 @@ Track::composerPtr() const
 QPixmap
 Track::cover( const QSize& size, bool forceLoad ) const
 {
-    albumPtr()->cover( size, forceLoad );
+    const QPixmap albumCover = albumPtr()->cover( size, forceLoad );
     if ( albumPtr()->coverLoaded() )
     {
-        if ( !albumPtr()->cover( size ).isNull() )
-            return albumPtr()->cover( size );
+        // while the album cover is still being decoded, coverChanged() follows shortly
+        if ( !albumCover.isNull() || albumPtr()->hasCover() )
+            return albumCover;
 
         return artistPtr()->cover( size, forceLoad );
     }
@@ -523,10 +524,14 @@ Track::coverLoaded() const
     if ( m_albumPtr.isNull() )
         return false;
 
-    if ( m_albumPtr->coverLoaded() && !m_albumPtr->cover( QSize( 0, 0 ) ).isNull() )
-        return true;
+    // a cover that is still being decoded isn't loaded yet, asking for it starts the decoding
+    if ( m_albumPtr->coverLoaded() && m_albumPtr->hasCover() )
+        return !m_albumPtr->cover( QSize( 0, 0 ) ).isNull();
 
-    return m_artistPtr->coverLoaded();
+    if ( !m_artistPtr->coverLoaded() )
+        return false;
+
+    return !m_artistPtr->hasCover() || !m_artistPtr->cover( QSize( 0, 0 ) ).isNull();
 }
 
 #endif
@@ -593,3 +598,10 @@ Track::trackSortname() const
 {
     return m_trackData->trackSortname();
 }
+
+
+QString
+Track::artistFullSortname() const
+{
+    return m_trackData->artistFullSortname();
+}
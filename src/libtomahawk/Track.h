@@ -67,6 +67,7 @@ public:
     QString composerSortname() const { return m_composerSortname; }
     QString albumSortname() const { return m_albumSortname; }
     QString artistSortname() const;
+    QString artistFullSortname() const;
     QString trackSortname() const;
 
     QString artist() const;
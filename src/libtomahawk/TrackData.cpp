@@ -25,11 +25,10 @@
 #include "database/DatabaseImpl.h"
 #include "database/DatabaseCommand_LogPlayback.h"
 #include "database/DatabaseCommand_LoadPlaylistEntries.h"
-#include "database/DatabaseCommand_LoadSocialActions.h"
-#include "database/DatabaseCommand_LoadTrackAttributes.h"
+#include "database/DatabaseCommand_LoadTrackData.h"
 #include "database/DatabaseCommand_ShareTrack.h"
 #include "database/DatabaseCommand_SocialAction.h"
-#include "database/DatabaseCommand_TrackStats.h"
+#include "database/TrackDataLoader.h"
 #include "database/IdThreadWorker.h"
 #include "Album.h"
 #include "collection/Collection.h"
@@ -152,7 +151,8 @@ TrackData::deleteLater()
 void
 TrackData::updateSortNames()
 {
-    m_artistSortname = DatabaseImpl::sortname( m_artist, true );
+    m_artistFullSortname = DatabaseImpl::sortname( m_artist );
+    m_artistSortname = DatabaseImpl::sortname( m_artistFullSortname, true );
     m_trackSortname = DatabaseImpl::sortname( m_track );
 }
 
@@ -225,8 +225,7 @@ TrackData::loadAttributes()
 
     m_attributesLoaded = true;
 
-    DatabaseCommand_LoadTrackAttributes* cmd = new DatabaseCommand_LoadTrackAttributes( m_ownRef.toStrongRef() );
-    Database::instance()->enqueue( QSharedPointer<DatabaseCommand>(cmd) );
+    TrackDataLoader::instance()->load( m_ownRef.toStrongRef(), DatabaseCommand_LoadTrackData::Attributes );
 }
 
 
@@ -250,8 +249,7 @@ TrackData::loadSocialActions()
 
     m_socialActionsLoaded = true;
 
-    DatabaseCommand_LoadSocialActions* cmd = new DatabaseCommand_LoadSocialActions( m_ownRef.toStrongRef() );
-    Database::instance()->enqueue( QSharedPointer<DatabaseCommand>(cmd) );
+    TrackDataLoader::instance()->load( m_ownRef.toStrongRef(), DatabaseCommand_LoadTrackData::SocialActions );
 }
 
 
@@ -340,9 +338,7 @@ TrackData::loadStats()
 
     m_playbackHistoryLoaded = true;
 
-    DatabaseCommand_TrackStats* cmd = new DatabaseCommand_TrackStats( m_ownRef.toStrongRef() );
-    connect( cmd, SIGNAL( trackStats( unsigned int, unsigned int ) ), SLOT( onTrackStatsLoaded( unsigned int, unsigned int ) ) );
-    Database::instance()->enqueue( QSharedPointer<DatabaseCommand>(cmd) );
+    TrackDataLoader::instance()->load( m_ownRef.toStrongRef(), DatabaseCommand_LoadTrackData::Stats );
 }
 
 
@@ -69,6 +69,7 @@ public:
     Tomahawk::query_ptr toQuery();
 
     QString artistSortname() const { return m_artistSortname; }
+    QString artistFullSortname() const { return m_artistFullSortname; }
     QString trackSortname() const { return m_trackSortname; }
 
     QWeakPointer< Tomahawk::TrackData > weakRef() { return m_ownRef; }
@@ -134,6 +135,7 @@ private:
     QString m_artist;
     QString m_track;
     QString m_artistSortname;
+    QString m_artistFullSortname;
     QString m_trackSortname;
 
     int m_year;
@@ -0,0 +1,278 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CompletionIndex.h"
+
+#include <QSet>
+#include <QTime>
+#include <QVariantMap>
+
+#include "DatabaseImpl.h"
+#include "TomahawkSqlQuery.h"
+#include "utils/Logger.h"
+
+#include <algorithm>
+
+
+namespace
+{
+    int
+    compareChars( const QChar* a, int aLength, const QChar* b, int bLength )
+    {
+        const int length = qMin( aLength, bLength );
+        for ( int i = 0; i < length; i++ )
+        {
+            if ( a[i].unicode() != b[i].unicode() )
+                return a[i].unicode() < b[i].unicode() ? -1 : 1;
+        }
+
+        return aLength - bLength;
+    }
+}
+
+
+/// Orders keys by the part of their name starting at their offset.
+class CompletionIndex::KeyLess
+{
+public:
+    explicit KeyLess( const Snapshot& snapshot )
+        : m_snapshot( snapshot )
+    {
+    }
+
+    bool
+    operator()( const Key& left, const Key& right ) const
+    {
+        const QString& l = m_snapshot.name( left.name ).folded;
+        const QString& r = m_snapshot.name( right.name ).folded;
+        return compareChars( l.constData() + left.offset, l.length() - left.offset,
+                             r.constData() + right.offset, r.length() - right.offset ) < 0;
+    }
+
+    bool
+    operator()( const Key& key, const QString& prefix ) const
+    {
+        const QString& name = m_snapshot.name( key.name ).folded;
+        return compareChars( name.constData() + key.offset, name.length() - key.offset, prefix.constData(), prefix.length() ) < 0;
+    }
+
+    bool
+    startsWith( const Key& key, const QString& prefix ) const
+    {
+        const QString& name = m_snapshot.name( key.name ).folded;
+        if ( name.length() - (int)key.offset < prefix.length() )
+            return false;
+
+        return compareChars( name.constData() + key.offset, prefix.length(), prefix.constData(), prefix.length() ) == 0;
+    }
+
+private:
+    const Snapshot& m_snapshot;
+};
+
+
+CompletionIndex::CompletionIndex()
+    : m_snapshot( new Snapshot )
+{
+}
+
+
+CompletionIndex::~CompletionIndex()
+{
+}
+
+
+QSharedPointer< CompletionIndex::Snapshot >
+CompletionIndex::snapshot() const
+{
+    QMutexLocker lock( &m_snapshotMutex );
+    return m_snapshot;
+}
+
+
+bool
+CompletionIndex::isLoaded() const
+{
+    return snapshot()->loaded;
+}
+
+
+void
+CompletionIndex::addName( Snapshot* snapshot, QVector< Key >* keys, Type type, unsigned int id,
+                          const QString& name, const QString& sortname, const QString& artist )
+{
+    Name n;
+    n.folded = DatabaseImpl::foldedname( sortname );
+    n.name = name;
+    n.artist = artist;
+    n.id = id;
+    n.type = type;
+
+    if ( n.folded.isEmpty() )
+        return;
+
+    const quint32 index = snapshot->nameCount++;
+    if ( index % NameBlockSize == 0 )
+    {
+        snapshot->nameBlocks << QSharedPointer< QVector< Name > >( new QVector< Name > );
+        snapshot->nameBlocks.last()->reserve( NameBlockSize );
+    }
+    snapshot->nameBlocks.last()->append( n );
+
+    Key key;
+    key.name = index;
+    key.offset = 0;
+    keys[type] << key;
+
+    // sortnames have their whitespace collapsed already
+    for ( int i = n.folded.indexOf( ' ' ); i >= 0 && i + 1 < n.folded.length(); i = n.folded.indexOf( ' ', i + 1 ) )
+    {
+        key.offset = i + 1;
+        keys[type + 3] << key;
+    }
+}
+
+
+void
+CompletionIndex::update( const QSqlDatabase& db )
+{
+    QMutexLocker lock( &m_updateMutex );
+
+    QTime t;
+    t.start();
+
+    QSharedPointer< Snapshot > current = snapshot();
+    QSharedPointer< Snapshot > next( new Snapshot( *current ) );
+    QVector< Key > added[BucketCount];
+
+    // the blocks are shared with current, which readers may still be using. Only the last one gets appended to.
+    if ( next->nameCount % NameBlockSize )
+        next->nameBlocks.last() = QSharedPointer< QVector< Name > >( new QVector< Name >( *current->nameBlocks.last() ) );
+
+    TomahawkSqlQuery q( db );
+    q.prepare( "SELECT id, name, sortname FROM artist WHERE id > ?" );
+    q.bindValue( 0, current->maxArtistId );
+    q.exec();
+    while ( q.next() )
+    {
+        const unsigned int id = q.value( 0 ).toUInt();
+        addName( next.data(), added, ArtistType, id, q.value( 1 ).toString(), q.value( 2 ).toString(), QString() );
+        next->maxArtistId = qMax( next->maxArtistId, id );
+    }
+
+    q.prepare( "SELECT album.id, album.name, album.sortname, artist.name FROM album, artist WHERE artist.id = album.artist AND album.id > ?" );
+    q.bindValue( 0, current->maxAlbumId );
+    q.exec();
+    while ( q.next() )
+    {
+        const unsigned int id = q.value( 0 ).toUInt();
+        addName( next.data(), added, AlbumType, id, q.value( 1 ).toString(), q.value( 2 ).toString(), q.value( 3 ).toString() );
+        next->maxAlbumId = qMax( next->maxAlbumId, id );
+    }
+
+    q.prepare( "SELECT track.id, track.name, track.sortname, artist.name FROM track, artist WHERE artist.id = track.artist AND track.id > ?" );
+    q.bindValue( 0, current->maxTrackId );
+    q.exec();
+    while ( q.next() )
+    {
+        const unsigned int id = q.value( 0 ).toUInt();
+        addName( next.data(), added, TrackType, id, q.value( 1 ).toString(), q.value( 2 ).toString(), q.value( 3 ).toString() );
+        next->maxTrackId = qMax( next->maxTrackId, id );
+    }
+
+    if ( current->loaded && next->nameCount == current->nameCount )
+        return;
+
+    const KeyLess less( *next );
+    for ( int i = 0; i < BucketCount; i++ )
+    {
+        if ( added[i].isEmpty() )
+            continue;
+
+        std::sort( added[i].begin(), added[i].end(), less );
+
+        QVector< Key > merged( current->keys[i].count() + added[i].count() );
+        std::merge( current->keys[i].constBegin(), current->keys[i].constEnd(),
+                    added[i].constBegin(), added[i].constEnd(), merged.begin(), less );
+        next->keys[i] = merged;
+    }
+
+    next->loaded = true;
+
+    {
+        QMutexLocker lock( &m_snapshotMutex );
+        m_snapshot = next;
+    }
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Added" << next->nameCount - current->nameCount
+                         << "names to completion index, took" << t.elapsed() << "ms";
+}
+
+
+QVariantList
+CompletionIndex::suggest( const QString& prefix, int limit ) const
+{
+    QVariantList suggestions;
+
+    const QString folded = DatabaseImpl::foldedname( DatabaseImpl::sortname( prefix ) );
+    if ( folded.isEmpty() || limit <= 0 )
+        return suggestions;
+
+    QSharedPointer< Snapshot > snap = snapshot();
+    const KeyLess less( *snap );
+    QSet< quint32 > seen;
+
+    for ( int i = 0; i < BucketCount && suggestions.count() < limit; i++ )
+    {
+        const QVector< Key >& keys = snap->keys[i];
+        QVector< Key >::const_iterator it = std::lower_bound( keys.constBegin(), keys.constEnd(), folded, less );
+
+        for ( ; it != keys.constEnd() && suggestions.count() < limit && less.startsWith( *it, folded ); ++it )
+        {
+            // a name can match on more than one of its words
+            if ( seen.contains( it->name ) )
+                continue;
+            seen << it->name;
+
+            const Name& name = snap->name( it->name );
+
+            QVariantMap m;
+            switch ( name.type )
+            {
+                case ArtistType:
+                    m[ "type" ] = "artist";
+                    break;
+                case AlbumType:
+                    m[ "type" ] = "album";
+                    break;
+                case TrackType:
+                    m[ "type" ] = "track";
+                    break;
+            }
+
+            m[ "id" ] = name.id;
+            m[ "name" ] = name.name;
+            if ( name.type != ArtistType )
+                m[ "artist" ] = name.artist;
+
+            suggestions << m;
+        }
+    }
+
+    return suggestions;
+}
@@ -0,0 +1,113 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPLETIONINDEX_H
+#define COMPLETIONINDEX_H
+
+#include <QMutex>
+#include <QSharedPointer>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVariantList>
+#include <QVector>
+
+#include "DllMacro.h"
+
+/**
+ * In-memory prefix index over the artist, album and track names in the database,
+ * for as-you-type completion.
+ *
+ * Every word start of a folded name is a key in one of a few sorted arrays, one
+ * per kind of name and for whether the match is at the start of the name or
+ * further in. A lookup is a binary search per array followed by reading off
+ * entries in order, so it never touches more than the requested number of
+ * matches.
+ *
+ * Rows only ever get added to these tables, so update() just merges whatever was
+ * added since the previous call. Names are kept in fixed-size blocks shared
+ * between snapshots, so an update only copies the last, partly filled one.
+ * Lookups work on an immutable snapshot and are safe from any thread.
+ */
+class DLLEXPORT CompletionIndex
+{
+public:
+    enum Type
+    {
+        ArtistType = 0,
+        AlbumType = 1,
+        TrackType = 2
+    };
+
+    CompletionIndex();
+    ~CompletionIndex();
+
+    bool isLoaded() const;
+
+    /// Adds the names inserted since the last update. Must be called with a database connection of the calling thread.
+    void update( const QSqlDatabase& db );
+
+    /// Returns up to limit matches for prefix as maps with type, id, name and artist.
+    QVariantList suggest( const QString& prefix, int limit ) const;
+
+private:
+    struct Name
+    {
+        QString folded;
+        QString name;
+        QString artist;
+        quint32 id;
+        Type type;
+    };
+
+    struct Key
+    {
+        quint32 name;
+        quint32 offset;
+    };
+
+    // one key array per type for matches at the start of a name, then one per type for later words
+    enum { BucketCount = 6 };
+    enum { NameBlockSize = 4096 };
+
+    struct Snapshot
+    {
+        Snapshot() : nameCount( 0 ), loaded( false ), maxArtistId( 0 ), maxAlbumId( 0 ), maxTrackId( 0 ) {}
+
+        const Name& name( quint32 index ) const { return nameBlocks.at( index / NameBlockSize )->at( index % NameBlockSize ); }
+
+        QVector< QSharedPointer< QVector< Name > > > nameBlocks; // all full but the last, never changed once published
+        quint32 nameCount;
+        QVector< Key > keys[BucketCount];
+        bool loaded;
+        unsigned int maxArtistId;
+        unsigned int maxAlbumId;
+        unsigned int maxTrackId;
+    };
+
+    class KeyLess;
+
+    QSharedPointer< Snapshot > snapshot() const;
+    static void addName( Snapshot* snapshot, QVector< Key >* keys, Type type, unsigned int id,
+                         const QString& name, const QString& sortname, const QString& artist );
+
+    mutable QMutex m_snapshotMutex; // only guards swapping m_snapshot
+    QSharedPointer< Snapshot > m_snapshot;
+    QMutex m_updateMutex;
+};
+
+#endif // COMPLETIONINDEX_H
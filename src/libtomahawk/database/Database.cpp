@@ -20,14 +20,26 @@
 #include "Database.h"
 
 #include "DatabaseCommand.h"
+#include "DatabaseCommandQueue.h"
+#include "DatabaseCommand_UpdateCompletionIndex.h"
 #include "DatabaseImpl.h"
+#include "DatabaseStats.h"
 #include "DatabaseWorker.h"
 #include "IdThreadWorker.h"
 #include "utils/Logger.h"
 
+#include <QEventLoop>
+
 #define DEFAULT_WORKER_THREADS 4
 #define MAX_WORKER_THREADS 16
 
+// how long deferrable commands are held back, and how many of them are sent on right away
+#define DEFERRED_WRITE_INTERVAL 2000
+#define MAX_DEFERRED_COMMANDS 250
+
+// how long flush() waits for the RW worker to run what is queued
+#define FLUSH_TIMEOUT 30000
+
 Database* Database::s_instance = 0;
 
 
@@ -42,6 +54,8 @@ Database::Database( const QString& dbname, QObject* parent )
     : QObject( parent )
     , m_ready( false )
     , m_impl( new DatabaseImpl( dbname ) )
+    , m_stats( new DatabaseStats() )
+    , m_queueRO( new DatabaseCommandQueue() )
     , m_workerRW( new DatabaseWorkerThread( this, true ) )
     , m_idWorker( new IdThreadWorker( this ) )
 {
@@ -58,12 +72,16 @@ Database::Database( const QString& dbname, QObject* parent )
     connect( m_impl, SIGNAL( indexReady() ), SIGNAL( indexReady() ) );
     connect( m_impl, SIGNAL( indexReady() ), SIGNAL( ready() ) );
 
+    m_deferTimer.setSingleShot( true );
+    m_deferTimer.setInterval( DEFERRED_WRITE_INTERVAL );
+    connect( &m_deferTimer, SIGNAL( timeout() ), SLOT( flushDeferred() ) );
+
     Q_ASSERT( m_workerRW );
     m_workerRW.data()->start();
 
     while ( m_workerThreads.count() < m_maxConcurrentThreads )
     {
-        QPointer< DatabaseWorkerThread > workerThread( new DatabaseWorkerThread( this, false ) );
+        QPointer< DatabaseWorkerThread > workerThread( new DatabaseWorkerThread( this, false, m_queueRO ) );
         Q_ASSERT( workerThread );
         workerThread.data()->start();
         m_workerThreads << workerThread;
@@ -76,6 +94,9 @@ Database::~Database()
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO;
 
+    // TomahawkApp flushes before tearing anything down, this only catches what was enqueued since
+    flush();
+
     m_idWorker->stop();
     delete m_idWorker;
 
@@ -101,9 +122,11 @@ Database::~Database()
         }
     }
     m_workerThreads.clear();
+    delete m_queueRO;
 
     qDeleteAll( m_implHash.values() );
     delete m_impl;
+    delete m_stats;
 
 }
 
@@ -125,7 +148,23 @@ Database::enqueue( const QList< QSharedPointer<DatabaseCommand> >& lc )
         return;
     }
 
+    bool deferrable = !lc.isEmpty();
+    foreach ( const QSharedPointer<DatabaseCommand>& cmd, lc )
+    {
+        cmd->markEnqueued();
+        deferrable = deferrable && cmd->deferrable();
+    }
+
+    if ( deferrable )
+    {
+        defer( lc );
+        return;
+    }
+
     tDebug( LOGVERBOSE ) << "Enqueueing" << lc.count() << "commands to rw thread";
+
+    QMutexLocker lock( &m_deferredMutex );
+    sendDeferred();
     if ( m_workerRW && m_workerRW.data()->worker() )
         m_workerRW.data()->worker().data()->enqueue( lc );
 }
@@ -141,41 +180,103 @@ Database::enqueue( const QSharedPointer<DatabaseCommand>& lc )
         return;
     }
 
-    if ( lc->doesMutates() )
+    lc->markEnqueued();
+    if ( lc->doesMutates() && lc->deferrable() )
+    {
+        defer( QList< QSharedPointer<DatabaseCommand> >() << lc );
+    }
+    else if ( lc->doesMutates() )
     {
         tDebug( LOGVERBOSE ) << "Enqueueing command to rw thread:" << lc->commandname();
+
+        QMutexLocker lock( &m_deferredMutex );
+        sendDeferred();
         if ( m_workerRW && m_workerRW.data()->worker() )
             m_workerRW.data()->worker().data()->enqueue( lc );
     }
     else
     {
-        // find thread for commandname with lowest amount of outstanding jobs and enqueue job
-        int busyThreads = 0;
-        QPointer< DatabaseWorkerThread > workerThread;
-        QPointer< DatabaseWorker > happyWorker;
-        for ( int i = 0; i < m_workerThreads.count(); i++ )
-        {
-            workerThread = m_workerThreads.at( i );
-
-            if ( workerThread && workerThread.data()->worker() && !workerThread.data()->worker().data()->busy() )
-            {
-                happyWorker = workerThread.data()->worker();
-                break;
-            }
-            busyThreads++;
-
-            if ( ( !happyWorker && workerThread && workerThread.data()->worker() ) ||
-                 ( workerThread && workerThread.data()->worker() && workerThread.data()->worker().data()->outstandingJobs() < happyWorker.data()->outstandingJobs() ) )
-                happyWorker = workerThread.data()->worker();
-        }
-
-        tDebug( LOGVERBOSE ) << "Enqueueing command to thread:" << happyWorker << busyThreads << lc->commandname();
-        Q_ASSERT( happyWorker );
-        happyWorker.data()->enqueue( lc );
+        tDebug( LOGVERBOSE ) << "Enqueueing command to ro queue:" << lc->commandname() << lc->priority() << m_queueRO->count();
+        m_queueRO->enqueue( lc );
     }
 }
 
 
+void
+Database::defer( const QList< QSharedPointer<DatabaseCommand> >& lc )
+{
+    QMutexLocker lock( &m_deferredMutex );
+
+    m_deferred << lc;
+    if ( m_deferred.count() >= MAX_DEFERRED_COMMANDS )
+        sendDeferred();
+    else if ( m_deferred.count() == lc.count() )
+        QMetaObject::invokeMethod( &m_deferTimer, "start", Qt::QueuedConnection ); // we may be on any thread here
+}
+
+
+void
+Database::flush()
+{
+    flushDeferred();
+
+    if ( !m_workerRW || !m_workerRW.data()->worker() )
+        return;
+
+    DatabaseWorker* worker = m_workerRW.data()->worker().data();
+
+    // a nested event loop rather than sleeping: post commit hooks may call into this thread blockingly
+    QEventLoop loop;
+    connect( worker, SIGNAL( drained() ), &loop, SLOT( quit() ) );
+    QTimer::singleShot( FLUSH_TIMEOUT, &loop, SLOT( quit() ) );
+
+    if ( worker->busy() )
+        loop.exec();
+
+    if ( worker->busy() )
+        tLog() << Q_FUNC_INFO << "Gave up waiting for" << worker->outstandingJobs() << "db commands";
+}
+
+
+void
+Database::flushDeferred()
+{
+    QMutexLocker lock( &m_deferredMutex );
+    sendDeferred();
+}
+
+
+void
+Database::sendDeferred()
+{
+    // m_deferredMutex is held by the caller
+    if ( m_deferred.isEmpty() )
+        return;
+
+    tDebug( LOGVERBOSE ) << "Enqueueing" << m_deferred.count() << "deferred commands to rw thread";
+    m_stats->recordDeferredFlush( m_deferred.count() );
+
+    if ( m_workerRW && m_workerRW.data()->worker() )
+        m_workerRW.data()->worker().data()->enqueue( m_deferred );
+    m_deferred.clear();
+}
+
+
+QVariantMap
+Database::statistics() const
+{
+    QVariantMap m = m_stats->toVariant();
+
+    QVariantMap queues;
+    queues.insert( "ro", m_queueRO->count() );
+    if ( m_workerRW && m_workerRW.data()->worker() )
+        queues.insert( "rw", m_workerRW.data()->worker().data()->outstandingJobs() );
+    m.insert( "queues", queues );
+
+    return m;
+}
+
+
 DatabaseImpl*
 Database::impl()
 {
@@ -198,4 +299,7 @@ Database::markAsReady()
 {
     tLog() << Q_FUNC_INFO << "Database is ready now!";
     m_ready = true;
+
+    // also called after each indexing run, which is when new names show up
+    enqueue( QSharedPointer<DatabaseCommand>( new DatabaseCommand_UpdateCompletionIndex() ) );
 }
@@ -21,6 +21,7 @@
 #define DATABASE_H
 
 #include <QSharedPointer>
+#include <QTimer>
 #include <QVariant>
 
 #include "Artist.h"
@@ -31,6 +32,8 @@
 #include "DllMacro.h"
 
 class DatabaseImpl;
+class DatabaseCommandQueue;
+class DatabaseStats;
 class DatabaseWorkerThread;
 class DatabaseWorker;
 class IdThreadWorker;
@@ -44,12 +47,18 @@ class IdThreadWorker;
     the queue of work. There is a threadpool responsible for exec'ing all
     the non-mutating (readonly) commands and one separate thread for mutating ones,
     so sqlite doesn't write to the Database from multiple threads.
+
+    Readonly commands go to a queue shared by the pool, which runs them by
+    DatabaseCommand::priority(). Mutating commands always run in order.
+    Deferrable ones are held back for a moment, so a run of them is committed
+    in one transaction; any other mutating command sends them on first.
 */
 class DLLEXPORT Database : public QObject
 {
 Q_OBJECT
 
 public:
+
     static Database* instance();
 
     explicit Database( const QString& dbname, QObject* parent = 0 );
@@ -60,6 +69,18 @@ public:
 
     DatabaseImpl* impl();
 
+    /// Per-command latency and row count histograms, worker utilization and slow query plans.
+    DatabaseStats* stats() const { return m_stats; }
+    /// stats() plus the current queue lengths, as served by the HTTP API.
+    QVariantMap statistics() const;
+
+    /**
+     * Sends the deferred commands on and waits until the RW worker has run
+     * everything enqueued so far. Events keep being processed meanwhile, as
+     * finishing commands may need the calling thread. Called on shutdown.
+     */
+    void flush();
+
 signals:
     void indexReady(); // search index
     void ready();
@@ -73,16 +94,27 @@ public slots:
 
 private slots:
     void markAsReady();
+    void flushDeferred();
 
 private:
+    void defer( const QList< QSharedPointer<DatabaseCommand> >& lc );
+    void sendDeferred();
+
     bool m_ready;
 
     DatabaseImpl* m_impl;
+    DatabaseStats* m_stats;
+    DatabaseCommandQueue* m_queueRO;
     QPointer< DatabaseWorkerThread > m_workerRW;
     QList< QPointer< DatabaseWorkerThread > > m_workerThreads;
     IdThreadWorker* m_idWorker;
     int m_maxConcurrentThreads;
 
+    // also held while handing anything to the RW worker, so nothing overtakes the deferred commands
+    QList< QSharedPointer<DatabaseCommand> > m_deferred;
+    QMutex m_deferredMutex;
+    QTimer m_deferTimer;
+
     QHash< QThread*, DatabaseImpl* > m_implHash;
     QMutex m_mutex;
 
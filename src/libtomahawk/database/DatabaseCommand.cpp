@@ -39,6 +39,8 @@
 DatabaseCommand::DatabaseCommand( QObject* parent )
     : QObject( parent )
     , m_state( PENDING )
+    , m_priority( NormalPriority )
+    , m_cancelToken( CancelToken::create() )
 {
     //qDebug() << Q_FUNC_INFO;
 }
@@ -47,6 +49,8 @@ DatabaseCommand::DatabaseCommand( QObject* parent )
 DatabaseCommand::DatabaseCommand( const source_ptr& src, QObject* parent )
     : QObject( parent )
     , m_state( PENDING )
+    , m_priority( NormalPriority )
+    , m_cancelToken( CancelToken::create() )
     , m_source( src )
 {
     //qDebug() << Q_FUNC_INFO;
@@ -54,6 +58,9 @@ DatabaseCommand::DatabaseCommand( const source_ptr& src, QObject* parent )
 
 DatabaseCommand::DatabaseCommand( const DatabaseCommand& other )
     : QObject( other.parent() )
+    , m_state( PENDING )
+    , m_priority( other.priority() )
+    , m_cancelToken( CancelToken::create() )
 {
 }
 
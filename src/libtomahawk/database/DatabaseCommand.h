@@ -21,7 +21,9 @@
 #define DATABASECOMMAND_H
 
 #include <QObject>
+#include <QAtomicInt>
 #include <QMetaType>
+#include <QSharedPointer>
 #include <QTime>
 #include <QSqlQuery>
 #include <QVariant>
@@ -45,6 +47,34 @@ public:
         FINISHED = 2
     };
 
+    /// Read-only commands are picked from a shared queue by priority, see DatabaseCommandQueue.
+    enum Priority {
+        InteractivePriority = 0, // the user is waiting for it, e.g. filling the visible view
+        NormalPriority = 1,
+        BackgroundPriority = 2   // prefetching and statistics nobody is looking at yet
+    };
+
+    /// Lets a requester cancel a command from any thread without keeping the command itself alive.
+    class CancelToken
+    {
+    public:
+        CancelToken() {}
+
+        void cancel() { if ( m_state ) m_state->testAndSetOrdered( Running, Cancelled ); }
+        bool isCancelled() const { return m_state && (int)*m_state == Cancelled; }
+        /// The command emitted finished(), there's nothing left to cancel.
+        bool isFinished() const { return m_state && (int)*m_state == Finished; }
+
+    private:
+        friend class DatabaseCommand;
+        enum State { Running = 0, Cancelled, Finished };
+
+        static CancelToken create() { CancelToken t; t.m_state = QSharedPointer< QAtomicInt >( new QAtomicInt( Running ) ); return t; }
+        void finish() { if ( m_state ) m_state->fetchAndStoreOrdered( Finished ); }
+
+        QSharedPointer< QAtomicInt > m_state;
+    };
+
     explicit DatabaseCommand( QObject* parent = 0 );
     explicit DatabaseCommand( const Tomahawk::source_ptr& src, QObject* parent = 0 );
 
@@ -56,6 +86,21 @@ public:
     virtual bool doesMutates() const { return true; }
     State state() const { return m_state; }
 
+    Priority priority() const { return m_priority; }
+    void setPriority( Priority priority ) { m_priority = priority; }
+
+    // Commands that support it check the token in exec(): cancelled before they start, they skip their queries,
+    // cancelled halfway they stop between rows. Either way they emit what they have read so far (maybe nothing)
+    // and their usual done signal, so requesters that wait for it always get it. Mutating commands always run,
+    // they may already be in the oplog.
+    CancelToken cancelToken() const { return m_cancelToken; }
+    void cancel() { m_cancelToken.cancel(); }
+    bool isCancelled() const { return m_cancelToken.isCancelled(); }
+
+    // Time spent in the queue, from Database::enqueue() until a worker picks it up. Reported to DatabaseStats.
+    void markEnqueued() { m_enqueued.start(); }
+    int queueTime() const { return m_enqueued.isValid() ? m_enqueued.elapsed() : 0; }
+
     // if i make this pure virtual, i get compile errors in qmetatype.h.
     // we need Q_DECLARE_METATYPE to use in queued sig/slot connections.
     virtual void exec( DatabaseImpl* /*lib*/ ) { Q_ASSERT( false ); }
@@ -72,6 +117,8 @@ public:
 
     virtual bool loggable() const { return false; }
     virtual bool groupable() const { return false; }
+    // Small writes nobody waits for. Database holds them back for a moment to commit a few in one transaction.
+    virtual bool deferrable() const { return false; }
     virtual bool singletonCmd() const { return false; }
     virtual bool localOnly() const { return false; }
 
@@ -87,7 +134,7 @@ public:
     }
     void setGuid( const QString& g ) { m_guid = g; }
 
-    void emitFinished() { emit finished(); }
+    void emitFinished() { m_cancelToken.finish(); emit finished(); }
 
     static DatabaseCommand* factory( const QVariant& op, const Tomahawk::source_ptr& source );
 
@@ -98,6 +145,9 @@ signals:
 
 private:
     State m_state;
+    Priority m_priority;
+    CancelToken m_cancelToken;
+    QTime m_enqueued;
     Tomahawk::source_ptr m_source;
     mutable QString m_guid;
 
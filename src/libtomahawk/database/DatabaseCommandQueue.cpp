@@ -0,0 +1,106 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DatabaseCommandQueue.h"
+
+#include <QMetaObject>
+
+#include "DatabaseWorker.h"
+#include "utils/Logger.h"
+
+// a waiting priority class gets a turn after being passed over this many times
+#define STARVATION_LIMIT 8
+
+
+DatabaseCommandQueue::DatabaseCommandQueue()
+{
+    for ( int i = 0; i < PriorityCount; i++ )
+        m_passedOver[i] = 0;
+}
+
+
+void
+DatabaseCommandQueue::enqueue( const QSharedPointer<DatabaseCommand>& cmd )
+{
+    QMutexLocker lock( &m_mutex );
+
+    const int priority = qBound( 0, (int)cmd->priority(), PriorityCount - 1 );
+    m_commands[priority] << cmd;
+
+    if ( !m_idleWorkers.isEmpty() )
+        QMetaObject::invokeMethod( m_idleWorkers.takeFirst(), "doWork", Qt::QueuedConnection );
+}
+
+
+QSharedPointer<DatabaseCommand>
+DatabaseCommandQueue::take( DatabaseWorker* worker )
+{
+    QMutexLocker lock( &m_mutex );
+
+    int next = -1;
+    for ( int i = 0; i < PriorityCount && next < 0; i++ )
+    {
+        if ( !m_commands[i].isEmpty() )
+            next = i;
+    }
+
+    if ( next < 0 )
+    {
+        if ( !m_idleWorkers.contains( worker ) )
+            m_idleWorkers << worker;
+
+        return QSharedPointer<DatabaseCommand>();
+    }
+
+    int starved = -1;
+    for ( int i = next + 1; i < PriorityCount; i++ )
+    {
+        if ( !m_commands[i].isEmpty() && ++m_passedOver[i] >= STARVATION_LIMIT && starved < 0 )
+            starved = i;
+    }
+
+    if ( starved >= 0 )
+    {
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Running starved command of priority" << starved;
+        next = starved;
+    }
+
+    m_passedOver[next] = 0;
+    return m_commands[next].takeFirst();
+}
+
+
+void
+DatabaseCommandQueue::removeWorker( DatabaseWorker* worker )
+{
+    QMutexLocker lock( &m_mutex );
+    m_idleWorkers.removeAll( worker );
+}
+
+
+int
+DatabaseCommandQueue::count() const
+{
+    QMutexLocker lock( &m_mutex );
+
+    int count = 0;
+    for ( int i = 0; i < PriorityCount; i++ )
+        count += m_commands[i].count();
+
+    return count;
+}
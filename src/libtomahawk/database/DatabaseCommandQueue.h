@@ -0,0 +1,60 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASECOMMANDQUEUE_H
+#define DATABASECOMMANDQUEUE_H
+
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include "DatabaseCommand.h"
+
+class DatabaseWorker;
+
+/**
+ * Queue of read-only commands shared by all RO database workers.
+ *
+ * Whichever worker is free next takes the oldest command of the highest priority
+ * class waiting. A lower class that keeps getting passed over is served once
+ * every few picks, so background work still makes progress under load. Workers
+ * that find the queue empty park themselves and are woken up by enqueue().
+ */
+class DatabaseCommandQueue
+{
+public:
+    DatabaseCommandQueue();
+
+    void enqueue( const QSharedPointer<DatabaseCommand>& cmd );
+
+    /// Returns the next command for worker to run, or a null pointer once worker has been parked.
+    QSharedPointer<DatabaseCommand> take( DatabaseWorker* worker );
+    void removeWorker( DatabaseWorker* worker );
+
+    int count() const;
+
+private:
+    enum { PriorityCount = 3 };
+
+    mutable QMutex m_mutex;
+    QList< QSharedPointer<DatabaseCommand> > m_commands[PriorityCount];
+    unsigned int m_passedOver[PriorityCount];
+    QList< DatabaseWorker* > m_idleWorkers;
+};
+
+#endif // DATABASECOMMANDQUEUE_H
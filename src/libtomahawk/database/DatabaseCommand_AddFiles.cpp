@@ -19,6 +19,7 @@
 #include "DatabaseCommand_AddFiles.h"
 
 #include <QSqlQuery>
+#include <QStringList>
 
 #include "Artist.h"
 #include "Album.h"
@@ -33,17 +34,44 @@
 
 using namespace Tomahawk;
 
+// SQLite refuses statements with more than 999 bound parameters (SQLITE_MAX_VARIABLE_NUMBER),
+// 100 rows keeps even the eight columns of the file table well below that.
+#define MAX_ROWS_PER_INSERT 100
+
+
+static QString
+multiRowInsertSql( const QString& insert, int columns, int rows )
+{
+    QStringList placeholders;
+    for ( int i = 0; i < columns; i++ )
+        placeholders << "?";
+
+    const QString row = QString( "(%1)" ).arg( placeholders.join( ", " ) );
+
+    QStringList values;
+    for ( int i = 0; i < rows; i++ )
+        values << row;
+
+    return QString( "%1 VALUES %2" ).arg( insert ).arg( values.join( ", " ) );
+}
+
 
 // remove file paths when making oplog/for network transmission
 QVariantList
 DatabaseCommand_AddFiles::files() const
 {
     QVariantList list;
-    foreach ( const QVariant& v, m_files )
+    list.reserve( m_files.count() );
+
+    const bool inserted = ( m_files.fileIds.count() == m_files.count() );
+    for ( int i = 0; i < m_files.count(); i++ )
     {
+        // files that were skipped on insert have no id, peers must not hear about them
+        if ( inserted && !m_files.fileIds.at( i ) )
+            continue;
+
         // replace url with the id, we don't leak file paths over the network.
-        QVariantMap m = v.toMap();
-        m.remove( "url" );
+        QVariantMap m = m_files.toVariantMap( i );
         m.insert( "url", QString::number( m.value( "id" ).toInt() ) );
         list.append( m );
     }
@@ -64,107 +92,228 @@ DatabaseCommand_AddFiles::postCommitHook()
 
     emit notify( m_ids );
 
-    if ( source()->isLocal() )
+    if ( source()->isLocal() && Servent::instance() )
         Servent::instance()->triggerDBSync();
 }
 
 
+// Binds the values of a chunk of rows (row by row) to the prepared multi-row INSERT OR IGNORE and runs it.
+// If a row was ignored, e.g. because its url is already in the table, the chunk is rolled back and its
+// rows are inserted one by one with the single-row statement, so only the offending rows are lost.
+// Returns which rows were inserted. If ids is given, it receives the rowids of the rows, 0 for the
+// rows that could not be inserted.
+static QVector< bool >
+insertChunk( QSqlDatabase& db, TomahawkSqlQuery& multi, TomahawkSqlQuery& single, int columns, const QVariantList& values, QVector< uint >* ids = 0 )
+{
+    const int rows = values.count() / columns;
+    QVector< bool > inserted( rows, false );
+    if ( ids )
+        ids->fill( 0, rows );
+
+    TomahawkSqlQuery savepoint( db );
+    savepoint.exec( "SAVEPOINT insertchunk" );
+
+    for ( int p = 0; p < values.count(); p++ )
+        multi.bindValue( p, values.at( p ) );
+
+    if ( multi.exec() && multi.numRowsAffected() == rows )
+    {
+        savepoint.exec( "RELEASE insertchunk" );
+
+        inserted.fill( true );
+        if ( ids )
+        {
+            // A single INSERT statement on the (only) writing connection gets consecutive
+            // rowids from SQLite, so the ids of this chunk end at the last inserted one.
+            const uint lastId = multi.lastInsertId().toUInt();
+            for ( int i = 0; i < rows; i++ )
+                (*ids)[ i ] = lastId - rows + 1 + i;
+        }
+
+        return inserted;
+    }
+
+    tLog() << "Inserting" << rows << "rows at once skipped some of them, retrying them one by one";
+    savepoint.exec( "ROLLBACK TO insertchunk" );
+
+    for ( int i = 0; i < rows; i++ )
+    {
+        for ( int c = 0; c < columns; c++ )
+            single.bindValue( c, values.at( i * columns + c ) );
+
+        inserted[ i ] = ( single.exec() && single.numRowsAffected() > 0 );
+        if ( !inserted.at( i ) )
+            tLog() << "Skipping row" << values.mid( i * columns, columns );
+        else if ( ids )
+            (*ids)[ i ] = single.lastInsertId().toUInt();
+    }
+
+    savepoint.exec( "RELEASE insertchunk" );
+    return inserted;
+}
+
+
+bool
+DatabaseCommand_AddFiles::insertFiles( QSqlDatabase& db, const QVariant& srcid, FileBatch& files )
+{
+    const QString insert = "INSERT OR IGNORE INTO file(source, url, size, mtime, md5, mimetype, duration, bitrate)";
+    TomahawkSqlQuery query_file( db );
+    TomahawkSqlQuery query_singlefile( db );
+    query_singlefile.prepare( multiRowInsertSql( insert, 8, 1 ) );
+    int preparedRows = 0;
+    bool complete = true;
+
+    files.fileIds.resize( files.count() );
+    for ( int offset = 0; offset < files.count(); offset += MAX_ROWS_PER_INSERT )
+    {
+        const int rows = qMin( MAX_ROWS_PER_INSERT, files.count() - offset );
+        if ( rows != preparedRows )
+        {
+            // only the last chunk of a batch needs a statement of its own
+            query_file.prepare( multiRowInsertSql( insert, 8, rows ) );
+            preparedRows = rows;
+        }
+
+        QVariantList values;
+        values.reserve( rows * 8 );
+        for ( int i = offset; i < offset + rows; i++ )
+        {
+            values << srcid
+                   << files.urls.at( i )
+                   << files.sizes.at( i )
+                   << files.mtimes.at( i )
+                   << files.hashes.at( i )
+                   << files.mimetypes.at( i )
+                   << files.durations.at( i )
+                   << files.bitrates.at( i );
+        }
+
+        QVector< uint > ids;
+        const QVector< bool > inserted = insertChunk( db, query_file, query_singlefile, 8, values, &ids );
+        for ( int i = 0; i < rows; i++ )
+        {
+            files.fileIds[ offset + i ] = ids.at( i );
+            if ( !inserted.at( i ) )
+                complete = false;
+        }
+    }
+
+    return complete;
+}
+
+
 void
 DatabaseCommand_AddFiles::exec( DatabaseImpl* dbi )
 {
     qDebug() << Q_FUNC_INFO;
     Q_ASSERT( !source().isNull() );
 
-    TomahawkSqlQuery query_file = dbi->newquery();
-    TomahawkSqlQuery query_filejoin = dbi->newquery();
-    TomahawkSqlQuery query_trackattr = dbi->newquery();
+    QVariant srcid = source()->isLocal() ? QVariant( QVariant::Int ) : source()->id();
+    qDebug() << "Adding" << m_files.count() << "files to db for source" << srcid;
 
-    query_file.prepare( "INSERT INTO file(source, url, size, mtime, md5, mimetype, duration, bitrate) VALUES (?, ?, ?, ?, ?, ?, ?, ?)" );
-    query_filejoin.prepare( "INSERT INTO file_join(file, artist, album, track, albumpos, composer, discnumber) VALUES (?, ?, ?, ?, ?, ?, ?)" );
-    query_trackattr.prepare( "INSERT INTO track_attributes(id, k, v) VALUES (?, ?, ?)" );
+    if ( !insertFiles( dbi->database(), srcid, m_files ) )
+        tLog() << "Some files could not be inserted and were skipped";
 
-    int added = 0;
-    QVariant srcid = source()->isLocal() ? QVariant( QVariant::Int ) : source()->id();
-    qDebug() << "Adding" << m_files.length() << "files to db for source" << srcid;
+    // get internal IDs for art/alb/trk, collecting the associations column-wise
+    QVector< uint > joinFiles, joinArtists, joinTracks, joinAlbums, joinAlbumpos, joinComposers, joinDiscnumbers;
+    QVector< int > joinYears;
+    joinFiles.reserve( m_files.count() );
 
-    QList<QVariant>::iterator it;
-    for ( it = m_files.begin(); it != m_files.end(); ++it )
+    for ( int i = 0; i < m_files.count(); i++ )
     {
-        QVariant& v = *it;
-        QVariantMap m = v.toMap();
-
-        int fileid = 0, artistid = 0, albumid = 0, trackid = 0, composerid = 0;
-
-        QString url      = m.value( "url" ).toString();
-        int mtime        = m.value( "mtime" ).toInt();
-        uint size        = m.value( "size" ).toUInt();
-        QString hash     = m.value( "hash" ).toString();
-        QString mimetype = m.value( "mimetype" ).toString();
-        uint duration    = m.value( "duration" ).toUInt();
-        uint bitrate     = m.value( "bitrate" ).toUInt();
-        QString artist   = m.value( "artist" ).toString();
-        QString album    = m.value( "album" ).toString();
-        QString track    = m.value( "track" ).toString();
-        uint albumpos    = m.value( "albumpos" ).toUInt();
-        QString composer = m.value( "composer" ).toString();
-        uint discnumber  = m.value( "discnumber" ).toUInt();
-        int year         = m.value( "year" ).toInt();
-
-        query_file.bindValue( 0, srcid );
-        query_file.bindValue( 1, url );
-        query_file.bindValue( 2, size );
-        query_file.bindValue( 3, mtime );
-        query_file.bindValue( 4, hash );
-        query_file.bindValue( 5, mimetype );
-        query_file.bindValue( 6, duration );
-        query_file.bindValue( 7, bitrate );
-        query_file.exec();
-
-        if ( added % 1000 == 0 )
-            qDebug() << "Inserted" << added;
-
-        // get internal IDs for art/alb/trk
-        fileid = query_file.lastInsertId().toInt();
-        m.insert( "id", fileid );
-        // this is the qvariant(map) the remote will get
-        v = m;
-
-        artistid = dbi->artistId( artist, true );
+        int artistid = 0, albumid = 0, trackid = 0, composerid = 0;
+
+        if ( !m_files.fileIds.at( i ) )
+            continue;
+
+        artistid = dbi->artistId( m_files.artists.at( i ), true );
         if ( artistid < 1 )
             continue;
-        trackid = dbi->trackId( artistid, track, true );
+        trackid = dbi->trackId( artistid, m_files.tracks.at( i ), true );
         if ( trackid < 1 )
             continue;
-        albumid = dbi->albumId( artistid, album, true );
-
-        if( !composer.trimmed().isEmpty() )
-            composerid = dbi->artistId( composer, true );
-
-        // Now add the association
-        query_filejoin.bindValue( 0, fileid );
-        query_filejoin.bindValue( 1, artistid );
-        query_filejoin.bindValue( 2, albumid > 0 ? albumid : QVariant( QVariant::Int ) );
-        query_filejoin.bindValue( 3, trackid );
-        query_filejoin.bindValue( 4, albumpos );
-        query_filejoin.bindValue( 5, composerid > 0 ? composerid : QVariant( QVariant::Int ) );
-        query_filejoin.bindValue( 6, discnumber );
-        if ( !query_filejoin.exec() )
+        albumid = dbi->albumId( artistid, m_files.albums.at( i ), true );
+
+        if ( !m_files.composers.at( i ).trimmed().isEmpty() )
+            composerid = dbi->artistId( m_files.composers.at( i ), true );
+
+        joinFiles << m_files.fileIds.at( i );
+        joinArtists << artistid;
+        joinTracks << trackid;
+        joinAlbums << qMax( albumid, 0 );
+        joinAlbumpos << m_files.albumpos.at( i );
+        joinComposers << qMax( composerid, 0 );
+        joinDiscnumbers << m_files.discnumbers.at( i );
+        joinYears << m_files.years.at( i );
+    }
+
+    // Now add the associations. Files whose association fails are left out, like they always were.
+    const QString insertJoin = "INSERT OR IGNORE INTO file_join(file, artist, album, track, albumpos, composer, discnumber)";
+    const QString insertAttr = "INSERT OR IGNORE INTO track_attributes(id, k, v)";
+    TomahawkSqlQuery query_filejoin = dbi->newquery();
+    TomahawkSqlQuery query_singlefilejoin = dbi->newquery();
+    TomahawkSqlQuery query_trackattr = dbi->newquery();
+    TomahawkSqlQuery query_singletrackattr = dbi->newquery();
+    query_singlefilejoin.prepare( multiRowInsertSql( insertJoin, 7, 1 ) );
+    query_singletrackattr.prepare( multiRowInsertSql( insertAttr, 3, 1 ) );
+    int preparedRows = 0;
+
+    for ( int offset = 0; offset < joinFiles.count(); offset += MAX_ROWS_PER_INSERT )
+    {
+        const int rows = qMin( MAX_ROWS_PER_INSERT, joinFiles.count() - offset );
+        if ( rows != preparedRows )
         {
-            qDebug() << "Error inserting into file_join table";
-            continue;
+            query_filejoin.prepare( multiRowInsertSql( insertJoin, 7, rows ) );
+            query_trackattr.prepare( multiRowInsertSql( insertAttr, 3, rows ) );
+            preparedRows = rows;
+        }
+
+        QVariantList values;
+        values.reserve( rows * 7 );
+        for ( int i = offset; i < offset + rows; i++ )
+        {
+            values << joinFiles.at( i )
+                   << joinArtists.at( i )
+                   << ( joinAlbums.at( i ) > 0 ? QVariant( joinAlbums.at( i ) ) : QVariant( QVariant::Int ) )
+                   << joinTracks.at( i )
+                   << joinAlbumpos.at( i )
+                   << ( joinComposers.at( i ) > 0 ? QVariant( joinComposers.at( i ) ) : QVariant( QVariant::Int ) )
+                   << joinDiscnumbers.at( i );
         }
 
-        query_trackattr.bindValue( 0, trackid );
-        query_trackattr.bindValue( 1, "releaseyear" );
-        query_trackattr.bindValue( 2, year );
-        query_trackattr.exec();
+        const QVector< bool > joined = insertChunk( dbi->database(), query_filejoin, query_singlefilejoin, 7, values );
+
+        QVariantList attributes;
+        attributes.reserve( rows * 3 );
+        for ( int i = 0; i < rows; i++ )
+        {
+            if ( !joined.at( i ) )
+            {
+                qDebug() << "Error inserting into file_join table";
+                continue;
+            }
+
+            m_ids << joinFiles.at( offset + i );
+            attributes << joinTracks.at( offset + i ) << "releaseyear" << joinYears.at( offset + i );
+        }
+
+        if ( attributes.isEmpty() )
+            continue;
+
+        if ( attributes.count() != rows * 3 )
+        {
+            // some associations were skipped, so the prepared statements don't fit this chunk anymore
+            query_trackattr.prepare( multiRowInsertSql( insertAttr, 3, attributes.count() / 3 ) );
+            preparedRows = 0;
+        }
 
-        m_ids << fileid;
-        added++;
+        insertChunk( dbi->database(), query_trackattr, query_singletrackattr, 3, attributes );
     }
 
-    qDebug() << "Inserted" << added << "tracks to database";
-    tDebug() << "Committing" << added << "tracks...";
+    qDebug() << "Inserted" << m_ids.count() << "tracks to database";
+    tDebug() << "Committing" << m_ids.count() << "tracks...";
 
-    emit done( m_files, source()->dbCollection() );
+    // only build the QVariant form of the batch if someone is actually listening
+    if ( receivers( SIGNAL( done( QList<QVariant>, Tomahawk::collection_ptr ) ) ) > 0 )
+        emit done( m_files.toVariantList(), source()->dbCollection() );
 }
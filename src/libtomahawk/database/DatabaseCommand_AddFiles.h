@@ -20,9 +20,11 @@
 #define DATABASECOMMAND_ADDFILES_H
 
 #include <QObject>
+#include <QSqlDatabase>
 #include <QVariantMap>
 
 #include "database/DatabaseCommandLoggable.h"
+#include "database/FileBatch.h"
 #include "Typedefs.h"
 #include "Query.h"
 
@@ -39,6 +41,12 @@ public:
     {}
 
     explicit DatabaseCommand_AddFiles( const QList<QVariant>& files, const Tomahawk::source_ptr& source, QObject* parent = 0 )
+        : DatabaseCommandLoggable( parent ), m_files( FileBatch::fromVariantList( files ) )
+    {
+        setSource( source );
+    }
+
+    explicit DatabaseCommand_AddFiles( const FileBatch& files, const Tomahawk::source_ptr& source, QObject* parent = 0 )
         : DatabaseCommandLoggable( parent ), m_files( files )
     {
         setSource( source );
@@ -51,14 +59,22 @@ public:
     virtual void postCommitHook();
 
     QVariantList files() const;
-    void setFiles( const QVariantList& f ) { m_files = f; }
+    void setFiles( const QVariantList& f ) { m_files = FileBatch::fromVariantList( f ); }
+
+    /**
+     * Inserts all files of the batch into the file table using multi-row INSERTs
+     * and stores the new row ids in files.fileIds. Files that can't be inserted, e.g.
+     * because their url is already known for the source, are skipped and get id 0;
+     * returns false if that happened. Must be called inside a transaction.
+     */
+    static bool insertFiles( QSqlDatabase& db, const QVariant& srcid, FileBatch& files );
 
 signals:
     void done( const QList<QVariant>&, const Tomahawk::collection_ptr& );
     void notify( const QList<unsigned int>& ids );
 
 private:
-    QVariantList m_files;
+    FileBatch m_files;
     QList<unsigned int> m_ids;
 };
 
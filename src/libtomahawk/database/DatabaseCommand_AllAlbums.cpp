@@ -32,9 +32,11 @@ DatabaseCommand_AllAlbums::DatabaseCommand_AllAlbums( const Tomahawk::collection
   , m_collection( collection )
   , m_artist( artist )
   , m_amount( 0 )
+  , m_pageSize( 0 )
   , m_sortOrder( DatabaseCommand_AllAlbums::None )
   , m_sortDescending( false )
 {
+    setPriority( InteractivePriority );
 }
 
 
@@ -99,10 +101,15 @@ DatabaseCommand_AllAlbums::execForArtist( DatabaseImpl* dbi )
          .arg( m_amount > 0 ? QString( "LIMIT 0, %1" ).arg( m_amount ) : QString() );
 
     query.prepare( sql );
-    query.exec();
+    // cancelled before it got here: the query stays inactive, so we finish with no albums like any other
+    if ( !isCancelled() )
+        query.exec();
 
     while( query.next() )
     {
+        if ( isCancelled() )
+            break;
+
         unsigned int albumId = query.value( 0 ).toUInt();
         QString albumName = query.value( 1 ).toString();
         if ( query.value( 0 ).isNull() )
@@ -124,8 +131,7 @@ void
 DatabaseCommand_AllAlbums::execForCollection( DatabaseImpl* dbi )
 {
     TomahawkSqlQuery query = dbi->newquery();
-    QList<Tomahawk::album_ptr> al;
-    QString orderToken, sourceToken;
+    QString sortToken, sourceToken;
 
     switch ( m_sortOrder )
     {
@@ -133,38 +139,90 @@ DatabaseCommand_AllAlbums::execForCollection( DatabaseImpl* dbi )
             break;
 
         case ModificationTime:
-            orderToken = "file.mtime";
+            sortToken = "file.mtime";
     }
 
     if ( !m_collection.isNull() )
         sourceToken = QString( "AND file.source %1 " ).arg( m_collection->source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( m_collection->source()->id() ) );
 
-    QString sql = QString(
-        "SELECT DISTINCT album.id, album.name, album.artist, artist.name "
-        "FROM file_join, file, album "
-        "LEFT OUTER JOIN artist ON album.artist = artist.id "
-        "WHERE file.id = file_join.file "
-        "AND file_join.album = album.id "
-        "%1 "
-        "%2 %3 %4"
-        ).arg( sourceToken )
-         .arg( m_sortOrder > 0 ? QString( "ORDER BY %1" ).arg( orderToken ) : QString() )
-         .arg( m_sortDescending ? "DESC" : QString() )
-         .arg( m_amount > 0 ? QString( "LIMIT 0, %1" ).arg( m_amount ) : QString() );
+    const QStringList keys = QStringList() << "album.sortname" << "album.id";
+    const bool paged = m_sortOrder == None && ( m_pageSize > 0 || !m_cursor.isNull() );
+    Q_ASSERT( paged || m_cursor.isNull() );
 
-    query.prepare( sql );
-    query.exec();
+    QVariantList cursor = m_cursor.toList();
+    unsigned int fetched = 0;
 
-    while( query.next() )
+    while ( true )
     {
-        Tomahawk::artist_ptr artist = Tomahawk::Artist::get( query.value( 2 ).toUInt(), query.value( 3 ).toString() );
-        Tomahawk::album_ptr album = Tomahawk::Album::get( query.value( 0 ).toUInt(), query.value( 1 ).toString(), artist );
+        unsigned int limit = m_amount;
+        if ( paged && m_pageSize > 0 )
+            limit = m_amount > 0 ? qMin( m_pageSize, m_amount - fetched ) : m_pageSize;
 
-        al << album;
+        QVariantList bindValues;
+        QString cursorToken, orderToken;
+        if ( paged )
+        {
+            if ( !cursor.isEmpty() )
+                cursorToken = "AND " + DatabaseImpl::keysetCondition( keys, QList< bool >(), cursor, bindValues );
+            orderToken = DatabaseImpl::keysetOrder( keys, QList< bool >() );
+        }
+        else if ( m_sortOrder > 0 )
+        {
+            orderToken = QString( "ORDER BY %1 %2" ).arg( sortToken ).arg( m_sortDescending ? "DESC" : QString() );
+        }
+
+        QString sql = QString(
+            "SELECT DISTINCT album.id, album.name, album.artist, artist.name, album.sortname "
+            "FROM file_join, file, album "
+            "LEFT OUTER JOIN artist ON album.artist = artist.id "
+            "WHERE file.id = file_join.file "
+            "AND file_join.album = album.id "
+            "%1 %2 "
+            "%3 %4"
+            ).arg( sourceToken )
+             .arg( cursorToken )
+             .arg( orderToken )
+             .arg( limit > 0 ? QString( "LIMIT 0, %1" ).arg( limit ) : QString() );
+
+        query.prepare( sql );
+        foreach ( const QVariant& value, bindValues )
+            query.addBindValue( value );
+        // cancelled before it got here: the query stays inactive, so we finish with an empty page like any other
+        if ( !isCancelled() )
+            query.exec();
+
+        QList<Tomahawk::album_ptr> al;
+        while( query.next() )
+        {
+            if ( isCancelled() )
+                break;
+
+            Tomahawk::artist_ptr artist = Tomahawk::Artist::get( query.value( 2 ).toUInt(), query.value( 3 ).toString() );
+            Tomahawk::album_ptr album = Tomahawk::Album::get( query.value( 0 ).toUInt(), query.value( 1 ).toString(), artist );
+
+            al << album;
+            cursor = QVariantList() << query.value( 4 ) << query.value( 0 );
+        }
+
+        fetched += al.count();
+
+        // don't bother listeners with the empty page after a full one
+        if ( !al.isEmpty() || fetched == 0 )
+        {
+            emit albums( al, data() );
+            emit albums( al );
+        }
+
+        if ( isCancelled() || !paged || m_pageSize == 0 || (unsigned int)al.count() < limit )
+            break;
+
+        if ( m_amount > 0 && fetched >= m_amount )
+        {
+            emit more( cursor );
+            break;
+        }
     }
 
-    emit albums( al, data() );
-    emit albums( al );
     emit done();
 }
 
@@ -65,16 +65,26 @@ public:
     void setSortDescending( bool descending ) { m_sortDescending = descending; }
     void setFilter( const QString& filter ) { m_filter = filter; }
 
+    /// Emits albums() for every pageSize albums of a collection, in sortname order. Only without an artist or sort order.
+    void setPageSize( unsigned int pageSize ) { m_pageSize = pageSize; }
+    /// Continues after the last album of a previous command, see more().
+    void setCursor( const QVariant& cursor ) { m_cursor = cursor; }
+
 signals:
     void albums( const QList<Tomahawk::album_ptr>&, const QVariant& data );
     void albums( const QList<Tomahawk::album_ptr>& );
     void done();
 
+    /// Paged commands that stopped at their limit emit the cursor to fetch the next albums with.
+    void more( const QVariant& cursor );
+
 private:
     Tomahawk::collection_ptr m_collection;
     Tomahawk::artist_ptr m_artist;
 
     unsigned int m_amount;
+    unsigned int m_pageSize;
+    QVariant m_cursor;
     DatabaseCommand_AllAlbums::SortOrder m_sortOrder;
     bool m_sortDescending;
     QString m_filter;
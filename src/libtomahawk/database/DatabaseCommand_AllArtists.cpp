@@ -31,9 +31,11 @@ DatabaseCommand_AllArtists::DatabaseCommand_AllArtists( const Tomahawk::collecti
     : DatabaseCommand( parent )
     , m_collection( collection )
     , m_amount( 0 )
+    , m_pageSize( 0 )
     , m_sortOrder( DatabaseCommand_AllArtists::None )
     , m_sortDescending( false )
 {
+    setPriority( InteractivePriority );
 }
 
 
@@ -46,7 +48,7 @@ void
 DatabaseCommand_AllArtists::exec( DatabaseImpl* dbi )
 {
     TomahawkSqlQuery query = dbi->newquery();
-    QString orderToken, sourceToken, filterToken, tables, joins;
+    QString sortToken, sourceToken, filterToken, tables, joins;
 
     switch ( m_sortOrder )
     {
@@ -54,7 +56,7 @@ DatabaseCommand_AllArtists::exec( DatabaseImpl* dbi )
             break;
 
         case ModificationTime:
-            orderToken = "file.mtime";
+            sortToken = "file.mtime";
     }
 
     if ( !m_collection.isNull() )
@@ -76,31 +78,81 @@ DatabaseCommand_AllArtists::exec( DatabaseImpl* dbi )
     else
         tables = "artist, file, file_join";
 
-    QString sql = QString(
-            "SELECT DISTINCT artist.id, artist.name "
-            "FROM %1 "
-            "%2 "
-            "WHERE file.id = file_join.file "
-            "AND file_join.artist = artist.id "
-            "%3 %4 %5 %6 %7"
-            ).arg( tables )
-             .arg( joins )
-             .arg( sourceToken )
-             .arg( filterToken )
-             .arg( m_sortOrder > 0 ? QString( "ORDER BY %1" ).arg( orderToken ) : QString() )
-             .arg( m_sortDescending ? "DESC" : QString() )
-             .arg( m_amount > 0 ? QString( "LIMIT 0, %1" ).arg( m_amount ) : QString() );
-
-    query.prepare( sql );
-    query.exec();
-
-    QList<Tomahawk::artist_ptr> al;
-    while ( query.next() )
+    // sortnames are unique, so they make a cursor on their own
+    const QStringList keys( "artist.sortname" );
+    const bool paged = m_sortOrder == None && ( m_pageSize > 0 || !m_cursor.isNull() );
+    Q_ASSERT( paged || m_cursor.isNull() );
+
+    QVariantList cursor = m_cursor.toList();
+    unsigned int fetched = 0;
+
+    while ( true )
     {
-        Tomahawk::artist_ptr artist = Tomahawk::Artist::get( query.value( 0 ).toUInt(), query.value( 1 ).toString() );
-        al << artist;
+        unsigned int limit = m_amount;
+        if ( paged && m_pageSize > 0 )
+            limit = m_amount > 0 ? qMin( m_pageSize, m_amount - fetched ) : m_pageSize;
+
+        QVariantList bindValues;
+        QString cursorToken, orderToken;
+        if ( paged )
+        {
+            if ( !cursor.isEmpty() )
+                cursorToken = "AND " + DatabaseImpl::keysetCondition( keys, QList< bool >(), cursor, bindValues );
+            orderToken = DatabaseImpl::keysetOrder( keys, QList< bool >() );
+        }
+        else if ( m_sortOrder > 0 )
+        {
+            orderToken = QString( "ORDER BY %1 %2" ).arg( sortToken ).arg( m_sortDescending ? "DESC" : QString() );
+        }
+
+        QString sql = QString(
+                "SELECT DISTINCT artist.id, artist.name, artist.sortname "
+                "FROM %1 "
+                "%2 "
+                "WHERE file.id = file_join.file "
+                "AND file_join.artist = artist.id "
+                "%3 %4 %5 %6 %7"
+                ).arg( tables )
+                 .arg( joins )
+                 .arg( sourceToken )
+                 .arg( filterToken )
+                 .arg( cursorToken )
+                 .arg( orderToken )
+                 .arg( limit > 0 ? QString( "LIMIT 0, %1" ).arg( limit ) : QString() );
+
+        query.prepare( sql );
+        foreach ( const QVariant& value, bindValues )
+            query.addBindValue( value );
+        // cancelled before it got here: the query stays inactive, so we finish with an empty page like any other
+        if ( !isCancelled() )
+            query.exec();
+
+        QList<Tomahawk::artist_ptr> al;
+        while ( query.next() )
+        {
+            if ( isCancelled() )
+                break;
+
+            Tomahawk::artist_ptr artist = Tomahawk::Artist::get( query.value( 0 ).toUInt(), query.value( 1 ).toString() );
+            al << artist;
+            cursor = QVariantList() << query.value( 2 );
+        }
+
+        fetched += al.count();
+
+        // don't bother listeners with the empty page after a full one
+        if ( !al.isEmpty() || fetched == 0 )
+            emit artists( al );
+
+        if ( isCancelled() || !paged || m_pageSize == 0 || (unsigned int)al.count() < limit )
+            break;
+
+        if ( m_amount > 0 && fetched >= m_amount )
+        {
+            emit more( cursor );
+            break;
+        }
     }
 
-    emit artists( al );
     emit done();
 }
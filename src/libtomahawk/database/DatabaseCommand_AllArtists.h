@@ -57,13 +57,23 @@ public:
     void setSortDescending( bool descending ) { m_sortDescending = descending; }
     void setFilter( const QString& filter ) { m_filter = filter; }
 
+    /// Emits artists() for every pageSize artists, in sortname order. Only without a sort order.
+    void setPageSize( unsigned int pageSize ) { m_pageSize = pageSize; }
+    /// Continues after the last artist of a previous command, see more().
+    void setCursor( const QVariant& cursor ) { m_cursor = cursor; }
+
 signals:
     void artists( const QList<Tomahawk::artist_ptr>& );
     void done();
 
+    /// Paged commands that stopped at their limit emit the cursor to fetch the next artists with.
+    void more( const QVariant& cursor );
+
 private:
     Tomahawk::collection_ptr m_collection;
     unsigned int m_amount;
+    unsigned int m_pageSize;
+    QVariant m_cursor;
     DatabaseCommand_AllArtists::SortOrder m_sortOrder;
     bool m_sortDescending;
     QString m_filter;
@@ -32,27 +32,34 @@ void
 DatabaseCommand_AllTracks::exec( DatabaseImpl* dbi )
 {
     TomahawkSqlQuery query = dbi->newquery();
-    QList<Tomahawk::query_ptr> ql;
 
-    QString m_orderToken, sourceToken;
+    // file.id makes every key unique, so pages can pick up exactly where the last one stopped
+    QStringList keys;
     switch ( m_sortOrder )
     {
         case 0:
             break;
 
         case Album:
-            m_orderToken = "album.name, file_join.discnumber, file_join.albumpos";
+            keys << "IFNULL(album.name, '')" << "IFNULL(file_join.discnumber, 0)" << "IFNULL(file_join.albumpos, 0)";
             break;
 
         case ModificationTime:
-            m_orderToken = "file.mtime";
+            keys << "file.mtime";
             break;
 
         case AlbumPosition:
-            m_orderToken = "file_join.discnumber, file_join.albumpos";
+            keys << "IFNULL(file_join.discnumber, 0)" << "IFNULL(file_join.albumpos, 0)";
             break;
     }
 
+    // the descending order only ever applied to the last sort column, as in "ORDER BY album.name, ..., albumpos DESC"
+    QList< bool > descending;
+    for ( int i = 0; i < keys.count(); i++ )
+        descending << ( m_sortDescending && i == keys.count() - 1 );
+    keys << "file.id";
+
+    QString sourceToken;
     if ( !m_collection.isNull() )
         sourceToken = QString( "AND file.source %1" ).arg( m_collection->source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( m_collection->source()->id() ) );
 
@@ -68,73 +75,120 @@ DatabaseCommand_AllTracks::exec( DatabaseImpl* dbi )
             albumToken = QString( "AND album.id = %1" ).arg( m_album->id() );
     }
 
-    QString sql = QString(
-            "SELECT file.id, artist.name, album.name, track.name, composer.name, file.size, "   //0
-                   "file.duration, file.bitrate, file.url, file.source, file.mtime, "           //6
-                   "file.mimetype, file_join.discnumber, file_join.albumpos, artist.id, "       //11
-                   "album.id, track.id, composer.id "                                           //15
-            "FROM file, artist, track, file_join "
-            "LEFT OUTER JOIN album "
-            "ON file_join.album = album.id "
-            "LEFT OUTER JOIN artist AS composer "
-            "ON file_join.composer = composer.id "
-            "WHERE file.id = file_join.file "
-            "AND file_join.artist = artist.id "
-            "AND file_join.track = track.id "
-            "%1 "
-            "%2 %3 "
-            "%4 %5 %6"
-            ).arg( sourceToken )
-             .arg( !m_artist ? QString() : QString( "AND artist.id = %1" ).arg( m_artist->id() ) )
-             .arg( !m_album ? QString() : albumToken )
-             .arg( m_sortOrder > 0 ? QString( "ORDER BY %1" ).arg( m_orderToken ) : QString() )
-             .arg( m_sortDescending ? "DESC" : QString() )
-             .arg( m_amount > 0 ? QString( "LIMIT 0, %1" ).arg( m_amount ) : QString() );
-
-    query.prepare( sql );
-    query.exec();
-
-    while( query.next() )
+    QVariantList cursor = m_cursor.toList();
+    const bool ordered = m_sortOrder > 0 || m_pageSize > 0 || !cursor.isEmpty();
+    unsigned int fetched = 0;
+
+    while ( true )
     {
-        QString url = query.value( 8 ).toString();
-        Tomahawk::source_ptr s = SourceList::instance()->get( query.value( 9 ).toUInt() );
-        if ( !s )
+        unsigned int limit = m_amount;
+        if ( m_pageSize > 0 )
+            limit = m_amount > 0 ? qMin( m_pageSize, m_amount - fetched ) : m_pageSize;
+
+        QVariantList bindValues;
+        QString cursorToken;
+        if ( !cursor.isEmpty() )
+            cursorToken = "AND " + DatabaseImpl::keysetCondition( keys, descending, cursor, bindValues );
+
+        QString sql = QString(
+                "SELECT file.id, artist.name, album.name, track.name, composer.name, file.size, "   //0
+                       "file.duration, file.bitrate, file.url, file.source, file.mtime, "           //6
+                       "file.mimetype, file_join.discnumber, file_join.albumpos, artist.id, "       //11
+                       "album.id, track.id, composer.id, %1 "                                       //15
+                "FROM file, artist, track, file_join "
+                "LEFT OUTER JOIN album "
+                "ON file_join.album = album.id "
+                "LEFT OUTER JOIN artist AS composer "
+                "ON file_join.composer = composer.id "
+                "WHERE file.id = file_join.file "
+                "AND file_join.artist = artist.id "
+                "AND file_join.track = track.id "
+                "%2 "
+                "%3 %4 %5 "
+                "%6 %7"
+                ).arg( keys.join( ", " ) )
+                 .arg( sourceToken )
+                 .arg( !m_artist ? QString() : QString( "AND artist.id = %1" ).arg( m_artist->id() ) )
+                 .arg( !m_album ? QString() : albumToken )
+                 .arg( cursorToken )
+                 .arg( ordered ? DatabaseImpl::keysetOrder( keys, descending ) : QString() )
+                 .arg( limit > 0 ? QString( "LIMIT 0, %1" ).arg( limit ) : QString() );
+
+        query.prepare( sql );
+        foreach ( const QVariant& value, bindValues )
+            query.addBindValue( value );
+        // cancelled before it got here: the query stays inactive, so we finish with an empty page like any other
+        if ( !isCancelled() )
+            query.exec();
+
+        QList<Tomahawk::query_ptr> ql;
+        unsigned int rows = 0;
+        while( query.next() )
+        {
+            if ( isCancelled() )
+                break;
+
+            rows++;
+            cursor.clear();
+            for ( int i = 0; i < keys.count(); i++ )
+                cursor << query.value( 18 + i );
+
+            QString url = query.value( 8 ).toString();
+            Tomahawk::source_ptr s = SourceList::instance()->get( query.value( 9 ).toUInt() );
+            if ( !s )
+            {
+                Q_ASSERT( false );
+                continue;
+            }
+            if ( !s->isLocal() )
+                url = QString( "servent://%1\t%2" ).arg( s->nodeId() ).arg( url );
+
+            QString artist, track, album, composer;
+            artist = query.value( 1 ).toString();
+            album = query.value( 2 ).toString();
+            track = query.value( 3 ).toString();
+            composer = query.value( 4 ).toString();
+
+            Tomahawk::result_ptr result = Tomahawk::Result::get( url );
+            Tomahawk::query_ptr qry = Tomahawk::Query::get( artist, track, album );
+
+            Tomahawk::track_ptr t = Tomahawk::Track::get( query.value( 16 ).toUInt(), artist, track, album, query.value( 6 ).toUInt(), composer, query.value( 13 ).toUInt(), query.value( 12 ).toUInt() );
+            t->loadAttributes();
+            result->setTrack( t );
+
+            result->setSize( query.value( 5 ).toUInt() );
+            result->setBitrate( query.value( 7 ).toUInt() );
+            result->setModificationTime( query.value( 10 ).toUInt() );
+            result->setMimetype( query.value( 11 ).toString() );
+            result->setScore( 1.0 );
+            result->setCollection( s->dbCollection() );
+
+            QList<Tomahawk::result_ptr> results;
+            results << result;
+            qry->addResults( results );
+            qry->setResolveFinished( true );
+
+            ql << qry;
+        }
+
+        fetched += rows;
+
+        // don't bother listeners with the empty page after a full one
+        if ( !ql.isEmpty() || fetched == 0 )
         {
-            Q_ASSERT( false );
-            continue;
+            emit tracks( ql, data() );
+            emit tracks( ql );
+        }
+
+        if ( isCancelled() || m_pageSize == 0 || rows < limit )
+            break;
+
+        if ( m_amount > 0 && fetched >= m_amount )
+        {
+            emit more( cursor );
+            break;
         }
-        if ( !s->isLocal() )
-            url = QString( "servent://%1\t%2" ).arg( s->nodeId() ).arg( url );
-
-        QString artist, track, album, composer;
-        artist = query.value( 1 ).toString();
-        album = query.value( 2 ).toString();
-        track = query.value( 3 ).toString();
-        composer = query.value( 4 ).toString();
-
-        Tomahawk::result_ptr result = Tomahawk::Result::get( url );
-        Tomahawk::query_ptr qry = Tomahawk::Query::get( artist, track, album );
-
-        Tomahawk::track_ptr t = Tomahawk::Track::get( query.value( 16 ).toUInt(), artist, track, album, query.value( 6 ).toUInt(), composer, query.value( 13 ).toUInt(), query.value( 12 ).toUInt() );
-        t->loadAttributes();
-        result->setTrack( t );
-
-        result->setSize( query.value( 5 ).toUInt() );
-        result->setBitrate( query.value( 7 ).toUInt() );
-        result->setModificationTime( query.value( 10 ).toUInt() );
-        result->setMimetype( query.value( 11 ).toString() );
-        result->setScore( 1.0 );
-        result->setCollection( s->dbCollection() );
-
-        QList<Tomahawk::result_ptr> results;
-        results << result;
-        qry->addResults( results );
-        qry->setResolveFinished( true );
-
-        ql << qry;
     }
 
-    emit tracks( ql, data() );
-    emit tracks( ql );
     emit done( m_collection );
 }
@@ -50,9 +50,12 @@ public:
         , m_artist( 0 )
         , m_album( 0 )
         , m_amount( 0 )
+        , m_pageSize( 0 )
         , m_sortOrder( DatabaseCommand_AllTracks::None )
         , m_sortDescending( false )
-    {}
+    {
+        setPriority( InteractivePriority );
+    }
 
     virtual void exec( DatabaseImpl* );
 
@@ -68,11 +71,19 @@ public:
     void setSortOrder( DatabaseCommand_AllTracks::SortOrder order ) { m_sortOrder = order; }
     void setSortDescending( bool descending ) { m_sortDescending = descending; }
 
+    /// Emits tracks() for every pageSize rows instead of once at the end.
+    void setPageSize( unsigned int pageSize ) { m_pageSize = pageSize; }
+    /// Continues after the last row of a previous command, see more().
+    void setCursor( const QVariant& cursor ) { m_cursor = cursor; }
+
 signals:
     void tracks( const QList<Tomahawk::query_ptr>&, const QVariant& data );
     void tracks( const QList<Tomahawk::query_ptr>& );
     void done( const Tomahawk::collection_ptr& );
 
+    /// Paged commands that stopped at their limit emit the cursor to fetch the next rows with.
+    void more( const QVariant& cursor );
+
 private:
     Tomahawk::collection_ptr m_collection;
 
@@ -80,6 +91,8 @@ private:
     Tomahawk::album_ptr m_album;
 
     unsigned int m_amount;
+    unsigned int m_pageSize;
+    QVariant m_cursor;
     DatabaseCommand_AllTracks::SortOrder m_sortOrder;
     bool m_sortDescending;
 };
@@ -30,6 +30,7 @@ DatabaseCommand_ArtistStats::DatabaseCommand_ArtistStats( const artist_ptr& arti
     : DatabaseCommand( parent )
     , m_artist( artist )
 {
+    setPriority( BackgroundPriority );
 }
 
 
@@ -38,10 +39,11 @@ DatabaseCommand_ArtistStats::exec( DatabaseImpl* dbi )
 {
     TomahawkSqlQuery query = dbi->newquery();
 
-    query.prepare( "SELECT COUNT(*) AS counter, artist.id "
-                   "FROM playback_log, track, artist "
-                   "WHERE playback_log.source IS NULL AND track.id = playback_log.track AND artist.id = track.artist "
-                   "GROUP BY track.artist "
+    query.prepare( "SELECT SUM(plays) AS counter, artist "
+                   "FROM playback_stats "
+                   "WHERE source IS NULL "
+                   "GROUP BY artist "
+                   "HAVING counter >= 2 "
                    "ORDER BY counter DESC" );
     query.exec();
 
@@ -50,12 +52,8 @@ DatabaseCommand_ArtistStats::exec( DatabaseImpl* dbi )
     unsigned int chartCount = 0;
     const unsigned int artistId = m_artist->id();
 
-    QHash< QString, unsigned int > charts;
     while ( query.next() )
     {
-        if ( query.value( 0 ).toUInt() < 2 )
-            break;
-
         chartCount++;
         if ( chartPos == 0 && query.value( 1 ).toUInt() == artistId )
         {
@@ -28,6 +28,7 @@ using namespace Tomahawk;
 DatabaseCommand_CollectionStats::DatabaseCommand_CollectionStats( const source_ptr& source, QObject* parent )
     : DatabaseCommand( source, parent )
 {
+    setPriority( BackgroundPriority );
 }
 
 
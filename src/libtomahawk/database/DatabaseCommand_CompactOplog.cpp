@@ -0,0 +1,302 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DatabaseCommand_CompactOplog.h"
+
+#include <QTime>
+
+#include "Database.h"
+#include "DatabaseImpl.h"
+#include "OplogCompaction.h"
+#include "TomahawkSqlQuery.h"
+#include "jobview/OplogCompactionJobItem.h"
+#include "qjson/parser.h"
+#include "qjson/serializer.h"
+
+#ifndef ENABLE_HEADLESS
+    #include "jobview/JobStatusView.h"
+    #include "jobview/JobStatusModel.h"
+#endif
+
+#include "utils/Logger.h"
+
+// the newest ops are left alone, peers that are online are usually somewhere in there
+#define COMPACT_KEEP_RECENT 500
+// ops added since the last run before it's worth going through the whole log again
+#define COMPACT_MIN_OPS 2000
+// ids changed in one transaction at most
+#define COMPACT_RANGE 5000
+#define COMPACT_PROGRESS_STEP 250
+// same as DatabaseWorker::logOp
+#define COMPRESS_THRESHOLD 512
+
+
+static QVariantMap
+parseOp( const QByteArray& json, bool compressed )
+{
+    QJson::Parser parser;
+    bool ok;
+    const QVariantMap op = parser.parse( compressed ? qUncompress( json ) : json, &ok ).toMap();
+    if ( !ok )
+        tLog() << Q_FUNC_INFO << "Can't parse oplog entry:" << parser.errorString();
+
+    return op;
+}
+
+
+DatabaseCommand_CompactOplog::DatabaseCommand_CompactOplog( QObject* parent )
+    : DatabaseCommand( parent )
+    , m_scan( true )
+    , m_from( 0 )
+    , m_to( 0 )
+    , m_progress( 0 )
+    , m_progressTotal( 0 )
+    , m_statusJobShown( false )
+{
+    setPriority( BackgroundPriority );
+
+#ifndef ENABLE_HEADLESS
+    m_statusJob = new OplogCompactionJobItem;
+    connect( this, SIGNAL( progress( int, int ) ), m_statusJob.data(), SLOT( setProgress( int, int ) ), Qt::QueuedConnection );
+#endif
+}
+
+
+DatabaseCommand_CompactOplog::DatabaseCommand_CompactOplog( qint64 from, qint64 to, const QList< qint64 >& drop,
+                                                            const QHash< qint64, QVariantMap >& rewrite )
+    : DatabaseCommand()
+    , m_scan( false )
+    , m_from( from )
+    , m_to( to )
+    , m_drop( drop )
+    , m_rewrite( rewrite )
+    , m_progress( 0 )
+    , m_progressTotal( 0 )
+    , m_statusJobShown( false )
+{
+}
+
+
+DatabaseCommand_CompactOplog::~DatabaseCommand_CompactOplog()
+{
+#ifndef ENABLE_HEADLESS
+    if ( !m_statusJob.isNull() )
+    {
+        if ( m_statusJobShown )
+            m_statusJob.data()->done();
+        else if ( m_scan )
+            m_statusJob.data()->deleteLater();
+    }
+#endif
+}
+
+
+void
+DatabaseCommand_CompactOplog::showStatusJob()
+{
+#ifndef ENABLE_HEADLESS
+    if ( m_statusJob.isNull() || m_statusJobShown )
+        return;
+
+    m_statusJobShown = true;
+    QMetaObject::invokeMethod( JobStatusView::instance()->model(), "addJob", Qt::QueuedConnection,
+                               Q_ARG( JobStatusItem*, m_statusJob.data() ) );
+#endif
+}
+
+
+QVariantMap
+DatabaseCommand_CompactOplog::loadOp( DatabaseImpl* db, qint64 id )
+{
+    TomahawkSqlQuery query = db->newquery();
+    query.prepare( "SELECT compressed, json FROM oplog WHERE id = ?" );
+    query.addBindValue( id );
+    if ( !query.exec() || !query.next() )
+        return QVariantMap();
+
+    return parseOp( query.value( 1 ).toByteArray(), query.value( 0 ).toBool() );
+}
+
+
+void
+DatabaseCommand_CompactOplog::exec( DatabaseImpl* db )
+{
+    if ( m_scan )
+        scan( db );
+    else
+        compactRange( db );
+}
+
+
+void
+DatabaseCommand_CompactOplog::scan( DatabaseImpl* db )
+{
+    QTime t;
+    t.start();
+
+    TomahawkSqlQuery query = db->newquery();
+    query.exec( QString( "SELECT id FROM oplog WHERE source IS NULL ORDER BY id DESC LIMIT 1 OFFSET %1" ).arg( COMPACT_KEEP_RECENT ) );
+    if ( !query.next() )
+        return;
+    const qint64 until = query.value( 0 ).toLongLong();
+
+    qint64 compactedUntil = 0;
+    query.exec( "SELECT v FROM settings WHERE k = 'oplog_compacted_until'" );
+    if ( query.next() )
+        compactedUntil = query.value( 0 ).toLongLong();
+
+    query.prepare( "SELECT count(*) FROM oplog WHERE source IS NULL AND id > ? AND id <= ?" );
+    query.addBindValue( compactedUntil );
+    query.addBindValue( until );
+    if ( !query.exec() || !query.next() || query.value( 0 ).toInt() < COMPACT_MIN_OPS )
+    {
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Not enough new ops to compact, last compacted up to" << compactedUntil;
+        return;
+    }
+
+    // everything a later op can make obsolete, the newest ops are read too but never changed
+    query.exec( QString( "SELECT count(*) FROM oplog WHERE source IS NULL AND %1" ).arg( OplogCompaction::commandFilter() ) );
+    const int count = query.next() ? query.value( 0 ).toInt() : 0;
+    if ( count == 0 )
+        return;
+
+    showStatusJob();
+    tLog() << Q_FUNC_INFO << "Compacting" << count << "ops up to" << until;
+
+    OplogCompaction compaction( until, COMPACT_RANGE );
+
+    query.exec( QString( "SELECT id, command, compressed, json FROM oplog WHERE source IS NULL AND %1 ORDER BY id ASC" )
+                .arg( OplogCompaction::commandFilter() ) );
+
+    int scanned = 0;
+    while ( query.next() )
+    {
+        if ( ++scanned % COMPACT_PROGRESS_STEP == 0 )
+            emit progress( scanned, 2 * count );
+
+        const QVariantMap op = parseOp( query.value( 3 ).toByteArray(), query.value( 2 ).toBool() );
+        if ( !op.isEmpty() )
+            compaction.add( query.value( 0 ).toLongLong(), query.value( 1 ).toString(), op );
+    }
+
+    // now that we know which files are gone, shrink the addfiles ops they came with
+    foreach ( qint64 id, compaction.shrinkable() )
+    {
+        const QVariantMap op = loadOp( db, id );
+        if ( !op.isEmpty() )
+            compaction.shrink( id, op );
+    }
+
+    // hand the changes out by range, the last range always goes so the log ends up compacted up to until
+    QMap< qint64, QList< qint64 > > drops;
+    foreach ( qint64 id, compaction.dropped() )
+        drops[ compaction.range( id ) ] << id;
+
+    QMap< qint64, QHash< qint64, QVariantMap > > rewrites;
+    QHash< qint64, QVariantMap >::const_iterator it = compaction.rewritten().constBegin();
+    for ( ; it != compaction.rewritten().constEnd(); ++it )
+        rewrites[ compaction.range( it.key() ) ].insert( it.key(), it.value() );
+
+    QList< qint64 > ranges = drops.keys() + rewrites.keys();
+    ranges << compaction.range( until );
+    qSort( ranges );
+
+    QList< QSharedPointer<DatabaseCommand> > commands;
+    qint64 previous = -1;
+    foreach ( qint64 range, ranges )
+    {
+        if ( range == previous )
+            continue;
+        previous = range;
+
+        const qint64 from = range * COMPACT_RANGE;
+        DatabaseCommand_CompactOplog* cmd = new DatabaseCommand_CompactOplog( from, qMin( from + COMPACT_RANGE, until ),
+                                                                              drops.value( range ), rewrites.value( range ) );
+        cmd->m_progress = count + (int)( (qint64)count * cmd->m_to / until );
+        cmd->m_progressTotal = 2 * count;
+#ifndef ENABLE_HEADLESS
+        if ( !m_statusJob.isNull() )
+            connect( cmd, SIGNAL( progress( int, int ) ), m_statusJob.data(), SLOT( setProgress( int, int ) ), Qt::QueuedConnection );
+#endif
+        commands << QSharedPointer<DatabaseCommand>( cmd );
+    }
+
+    // the last range finishes the status job
+    DatabaseCommand_CompactOplog* last = qobject_cast< DatabaseCommand_CompactOplog* >( commands.last().data() );
+    last->m_statusJob = m_statusJob;
+    last->m_statusJobShown = m_statusJobShown;
+    m_statusJob.clear();
+
+    tLog() << Q_FUNC_INFO << "Removing" << compaction.dropped().count() << "and rewriting" << compaction.rewritten().count()
+           << "of" << count << "ops in" << commands.count() << "ranges, scanned in" << t.elapsed() << "ms";
+
+    Database::instance()->enqueue( commands );
+}
+
+
+void
+DatabaseCommand_CompactOplog::compactRange( DatabaseImpl* db )
+{
+    // rewrite before dropping, a folded revision is only dropped along with the one it was folded into
+    QJson::Serializer serializer;
+    TomahawkSqlQuery update = db->newquery();
+    update.prepare( "UPDATE oplog SET compressed = ?, json = ? WHERE id = ?" );
+    QHash< qint64, QVariantMap >::const_iterator it = m_rewrite.constBegin();
+    for ( ; it != m_rewrite.constEnd(); ++it )
+    {
+        QByteArray ba = serializer.serialize( it.value() );
+        const bool compressed = ba.length() >= COMPRESS_THRESHOLD;
+        if ( compressed )
+            ba = qCompress( ba, 9 );
+
+        update.bindValue( 0, compressed );
+        update.bindValue( 1, ba );
+        update.bindValue( 2, it.key() );
+        update.exec();
+    }
+
+    // peers that synced up to a removed op continue right after the position it had
+    TomahawkSqlQuery tombstone = db->newquery();
+    tombstone.prepare( "INSERT OR REPLACE INTO oplog_compacted( guid, id ) SELECT guid, id FROM oplog WHERE id = ?" );
+    TomahawkSqlQuery remove = db->newquery();
+    remove.prepare( "DELETE FROM oplog WHERE id = ?" );
+    foreach ( qint64 id, m_drop )
+    {
+        tombstone.bindValue( 0, id );
+        tombstone.exec();
+        remove.bindValue( 0, id );
+        remove.exec();
+    }
+
+    // no peer asks for an op older than where it is, unless we never heard from it since it was compacted
+    TomahawkSqlQuery prune = db->newquery();
+    prune.prepare( "DELETE FROM oplog_compacted "
+                   "WHERE NOT EXISTS( SELECT 1 FROM source WHERE name NOT IN ( SELECT peer FROM oplog_peers ) ) "
+                   "AND id < ( SELECT coalesce( min( id ), ? ) FROM oplog_peers )" );
+    prune.addBindValue( m_to + 1 );
+    prune.exec();
+
+    TomahawkSqlQuery query = db->newquery();
+    query.prepare( "INSERT OR REPLACE INTO settings( k, v ) VALUES( 'oplog_compacted_until', ? )" );
+    query.addBindValue( m_to );
+    query.exec();
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Removed" << m_drop.count() << "and rewrote" << m_rewrite.count()
+                         << "ops between" << m_from << "and" << m_to << "- pruned" << prune.numRowsAffected() << "kept guids";
+    emit progress( m_progress, m_progressTotal );
+}
@@ -0,0 +1,86 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASECOMMAND_COMPACTOPLOG_H
+#define DATABASECOMMAND_COMPACTOPLOG_H
+
+#include <QPointer>
+#include <QVariantMap>
+
+#include "DatabaseCommand.h"
+
+#include "DllMacro.h"
+
+class OplogCompactionJobItem;
+
+/**
+ * Rewrites the local oplog into a shorter sequence that leaves a peer replaying
+ * it from any position with the same collection and playlists:
+ *
+ *   - files that were deleted later are dropped from their addfiles op
+ *   - everything about a playlist is dropped once it was deleted, except the delete
+ *   - consecutive revisions of a playlist are folded into the last one
+ *   - only the last rename of a playlist and the last social action of a kind on a track are kept
+ *
+ * The guids of removed ops are kept in oplog_compacted together with their position,
+ * so peers that synced up to one of them still get everything after it. Once every
+ * known peer has synced past one of them (see DatabaseCommand_SetOplogPosition) it
+ * is pruned again. The most recent ops are never touched and nothing is done unless
+ * enough ops were added since the last run.
+ *
+ * Going through the log only reads, so it runs beside other commands. The changes
+ * are then made one range of ops at a time, each range in a transaction of its own,
+ * so writes only wait for a range and not for the whole history.
+ */
+class DLLEXPORT DatabaseCommand_CompactOplog : public DatabaseCommand
+{
+Q_OBJECT
+public:
+    explicit DatabaseCommand_CompactOplog( QObject* parent = 0 );
+    virtual ~DatabaseCommand_CompactOplog();
+
+    virtual QString commandname() const { return "compactoplog"; }
+    virtual bool doesMutates() const { return !m_scan; }
+    virtual void exec( DatabaseImpl* db );
+
+signals:
+    void progress( int done, int total );
+
+private:
+    /// Changes the ops with from < id <= to, then marks the log as compacted up to to.
+    DatabaseCommand_CompactOplog( qint64 from, qint64 to, const QList< qint64 >& drop, const QHash< qint64, QVariantMap >& rewrite );
+
+    void scan( DatabaseImpl* db );
+    void compactRange( DatabaseImpl* db );
+
+    QVariantMap loadOp( DatabaseImpl* db, qint64 id );
+    void showStatusJob();
+
+    bool m_scan;
+    qint64 m_from;
+    qint64 m_to;
+    QList< qint64 > m_drop;
+    QHash< qint64, QVariantMap > m_rewrite;
+    int m_progress;
+    int m_progressTotal;
+
+    QPointer<OplogCompactionJobItem> m_statusJob;
+    bool m_statusJobShown;
+};
+
+#endif // DATABASECOMMAND_COMPACTOPLOG_H
@@ -123,6 +123,6 @@ DatabaseCommand_CreateDynamicPlaylist::postCommitHook()
     {
         m_playlist->reportCreated( m_playlist );
     }
-    if( source()->isLocal() )
+    if ( source()->isLocal() && Servent::instance() )
         Servent::instance()->triggerDBSync();
 }
@@ -68,7 +68,7 @@ DatabaseCommand_CreatePlaylist::postCommitHook()
 {
     qDebug() << Q_FUNC_INFO;
 
-    if ( source()->isLocal() )
+    if ( source()->isLocal() && Servent::instance() )
         Servent::instance()->triggerDBSync();
 
     if ( m_report == false )
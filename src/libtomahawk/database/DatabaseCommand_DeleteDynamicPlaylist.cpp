@@ -67,6 +67,6 @@ DatabaseCommand_DeleteDynamicPlaylist::postCommitHook()
         tLog() << "ERROR: Just tried to load playlist for deletion:" << m_playlistguid << "Did we get a null one?" << playlist.isNull();
     }
 
-    if ( source()->isLocal() )
+    if ( source()->isLocal() && Servent::instance() )
         Servent::instance()->triggerDBSync();
 }
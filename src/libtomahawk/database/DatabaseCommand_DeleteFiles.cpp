@@ -51,7 +51,7 @@ DatabaseCommand_DeleteFiles::postCommitHook()
     tDebug() << "Notifying of deleted tracks:" << m_idList.size() << "from source" << source()->id();
     emit notify( m_idList );
 
-    if ( source()->isLocal() )
+    if ( source()->isLocal() && Servent::instance() )
         Servent::instance()->triggerDBSync();
 }
 
@@ -127,10 +127,14 @@ DatabaseCommand_DeleteFiles::exec( DatabaseImpl* dbi )
             idstring.chop( 2 ); //remove the trailing ", "
         }
 
-        delquery.prepare( QString( "DELETE FROM file WHERE source %1 AND id IN ( %2 )" )
-                             .arg( source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( source()->id() ) )
-                             .arg( idstring ) );
-        delquery.exec();
+        // none of them may be known here, e.g. when the oplog they were added with got compacted
+        if ( !idstring.isEmpty() )
+        {
+            delquery.prepare( QString( "DELETE FROM file WHERE source %1 AND id IN ( %2 )" )
+                                 .arg( source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( source()->id() ) )
+                                 .arg( idstring ) );
+            delquery.exec();
+        }
     }
 
     if ( m_idList.count() )
@@ -64,6 +64,6 @@ DatabaseCommand_DeletePlaylist::postCommitHook()
     if ( playlist )
         playlist->reportDeleted( playlist );
 
-    if( source()->isLocal() )
+    if ( source()->isLocal() && Servent::instance() )
         Servent::instance()->triggerDBSync();
 }
@@ -29,10 +29,14 @@ DatabaseCommand_loadOps::exec( DatabaseImpl* dbi )
 {
     QList< dbop_ptr > ops;
 
+    qint64 since = 0;
     if ( !m_since.isEmpty() )
     {
+        // ops removed by DatabaseCommand_CompactOplog leave their position behind in oplog_compacted
         TomahawkSqlQuery query = dbi->newquery();
-        query.prepare( QString( "SELECT id FROM oplog WHERE guid = ?" ) );
+        query.prepare( QString( "SELECT id FROM oplog WHERE guid = ? "
+                                "UNION ALL SELECT id FROM oplog_compacted WHERE guid = ?" ) );
+        query.addBindValue( m_since );
         query.addBindValue( m_since );
         query.exec();
 
@@ -43,6 +47,8 @@ DatabaseCommand_loadOps::exec( DatabaseImpl* dbi )
             emit done( m_since, m_since, ops );
             return;
         }
+
+        since = query.value( 0 ).toLongLong();
     }
 
     TomahawkSqlQuery query = dbi->newquery();
@@ -50,11 +56,11 @@ DatabaseCommand_loadOps::exec( DatabaseImpl* dbi )
                    "SELECT guid, command, json, compressed, singleton "
                    "FROM oplog "
                    "WHERE source %1 "
-                   "AND id > coalesce((SELECT id FROM oplog WHERE guid = ?),0) "
+                   "AND id > ? "
                    "ORDER BY id ASC"
                    ).arg( source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( source()->id() ) )
                   );
-    query.addBindValue( m_since );
+    query.addBindValue( since );
     query.exec();
 
     QString lastguid = m_since;
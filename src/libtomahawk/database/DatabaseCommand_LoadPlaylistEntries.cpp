@@ -22,7 +22,6 @@
 
 #include "DatabaseImpl.h"
 #include "Query.h"
-#include "qjson/parser.h"
 #include "utils/Logger.h"
 #include "Source.h"
 
@@ -42,7 +41,7 @@ void
 DatabaseCommand_LoadPlaylistEntries::generateEntries( DatabaseImpl* dbi )
 {
     TomahawkSqlQuery query_entries = dbi->newquery();
-    query_entries.prepare( "SELECT entries, playlist, author, timestamp, previous_revision "
+    query_entries.prepare( "SELECT playlist, previous_revision "
                            "FROM playlist_revision "
                            "WHERE guid = :guid" );
     query_entries.bindValue( ":guid", m_revguid );
@@ -50,17 +49,13 @@ DatabaseCommand_LoadPlaylistEntries::generateEntries( DatabaseImpl* dbi )
 
     tLog( LOGVERBOSE ) << "trying to load playlist entries for guid:" << m_revguid;
     QString prevrev;
-    QJson::Parser parser; bool ok;
 
     if ( query_entries.next() )
     {
-        if ( !query_entries.value( 0 ).isNull() )
+        // revisions are stored as deltas on top of a snapshot, DatabaseImpl puts them back together
+        m_guids = dbi->playlistRevisionEntries( m_revguid );
+        if ( !m_guids.isEmpty() )
         {
-            // entries should be a list of strings:
-            QVariant v = parser.parse( query_entries.value( 0 ).toByteArray(), &ok );
-            Q_ASSERT( ok && v.type() == QVariant::List ); //TODO
-
-            m_guids = v.toStringList();
             QString inclause = QString( "('%1')" ).arg( m_guids.join( "', '" ) );
 
             TomahawkSqlQuery query = dbi->newquery();
@@ -95,7 +90,7 @@ DatabaseCommand_LoadPlaylistEntries::generateEntries( DatabaseImpl* dbi )
             }
         }
 
-        prevrev = query_entries.value( 4 ).toString();
+        prevrev = query_entries.value( 1 ).toString();
     }
     else
     {
@@ -105,12 +100,11 @@ DatabaseCommand_LoadPlaylistEntries::generateEntries( DatabaseImpl* dbi )
     if ( prevrev.length() )
     {
         TomahawkSqlQuery query_entries_old = dbi->newquery();
-        query_entries_old.prepare( "SELECT entries, "
-                                   "(SELECT currentrevision = ? FROM playlist WHERE guid = ?) "
+        query_entries_old.prepare( "SELECT (SELECT currentrevision = ? FROM playlist WHERE guid = ?) "
                                    "FROM playlist_revision "
                                    "WHERE guid = ?" );
         query_entries_old.addBindValue( m_revguid );
-        query_entries_old.addBindValue( query_entries.value( 1 ).toString() );
+        query_entries_old.addBindValue( query_entries.value( 0 ).toString() );
         query_entries_old.addBindValue( prevrev );
 
         query_entries_old.exec();
@@ -120,13 +114,8 @@ DatabaseCommand_LoadPlaylistEntries::generateEntries( DatabaseImpl* dbi )
             Q_ASSERT( false );
         }
 
-        if ( !query_entries_old.value( 0 ).isNull() )
-        {
-            QVariant v = parser.parse( query_entries_old.value( 0 ).toByteArray(), &ok );
-            Q_ASSERT( ok && v.type() == QVariant::List ); //TODO
-            m_oldentries = v.toStringList();
-        }
-        m_islatest = query_entries_old.value( 1 ).toBool();
+        m_oldentries = dbi->playlistRevisionEntries( prevrev );
+        m_islatest = query_entries_old.value( 0 ).toBool();
     }
 
 //    qDebug() << Q_FUNC_INFO << "entrymap:" << m_entrymap;
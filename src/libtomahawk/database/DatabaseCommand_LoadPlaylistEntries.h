@@ -35,7 +35,9 @@ Q_OBJECT
 public:
     explicit DatabaseCommand_LoadPlaylistEntries( QString revision_guid, QObject* parent = 0 )
     : DatabaseCommand( parent ), m_islatest( true ), m_revguid( revision_guid )
-    {}
+    {
+        setPriority( InteractivePriority );
+    }
 
     virtual void exec( DatabaseImpl* );
     virtual bool doesMutates() const { return false; }
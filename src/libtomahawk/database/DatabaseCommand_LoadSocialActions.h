@@ -67,6 +67,7 @@ public:
         : DatabaseCommand( parent ), m_track( track )
     {
         setSource( SourceList::instance()->getLocal() );
+        setPriority( BackgroundPriority );
     }
 
     /**
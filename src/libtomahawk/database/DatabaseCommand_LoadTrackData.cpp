@@ -0,0 +1,186 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DatabaseCommand_LoadTrackData.h"
+
+#include <QStringList>
+
+#include "DatabaseImpl.h"
+#include "SourceList.h"
+#include "TrackData.h"
+#include "utils/Logger.h"
+
+using namespace Tomahawk;
+
+typedef QHash< unsigned int, QList< trackdata_ptr > > TracksById;
+
+
+DatabaseCommand_LoadTrackData::DatabaseCommand_LoadTrackData( const QList< trackdata_ptr >& tracks, const QList< int >& parts, QObject* parent )
+    : DatabaseCommand( parent )
+    , m_tracks( tracks )
+    , m_parts( parts )
+{
+    Q_ASSERT( m_tracks.count() == m_parts.count() );
+    setSource( SourceList::instance()->getLocal() );
+    setPriority( BackgroundPriority );
+}
+
+
+QString
+DatabaseCommand_LoadTrackData::idList( const QList< unsigned int >& ids )
+{
+    QStringList sl;
+    foreach ( unsigned int id, ids )
+        sl << QString::number( id );
+
+    return sl.join( "," );
+}
+
+
+void
+DatabaseCommand_LoadTrackData::exec( DatabaseImpl* dbi )
+{
+    TracksById attributes, socialActions, stats;
+
+    for ( int i = 0; i < m_tracks.count(); i++ )
+    {
+        // may have to wait for the id to be looked up, better here than in the caller
+        const unsigned int id = m_tracks.at( i )->trackId();
+        if ( id == 0 )
+            continue;
+
+        if ( m_parts.at( i ) & Attributes )
+            attributes[ id ] << m_tracks.at( i );
+        if ( m_parts.at( i ) & SocialActions )
+            socialActions[ id ] << m_tracks.at( i );
+        if ( m_parts.at( i ) & Stats )
+            stats[ id ] << m_tracks.at( i );
+    }
+
+    if ( !attributes.isEmpty() )
+        loadAttributes( dbi, attributes );
+    if ( !socialActions.isEmpty() )
+        loadSocialActions( dbi, socialActions );
+    if ( !stats.isEmpty() )
+        loadStats( dbi, stats );
+}
+
+
+void
+DatabaseCommand_LoadTrackData::loadAttributes( DatabaseImpl* dbi, const TracksById& tracks )
+{
+    TomahawkSqlQuery query = dbi->newquery();
+    query.exec( QString( "SELECT id, k, v FROM track_attributes WHERE id IN (%1)" ).arg( idList( tracks.keys() ) ) );
+
+    QHash< unsigned int, QVariantMap > attributes;
+    while ( query.next() )
+    {
+        attributes[ query.value( 0 ).toUInt() ][ query.value( 1 ).toString() ] = query.value( 2 ).toString();
+    }
+
+    TracksById::const_iterator it = tracks.constBegin();
+    for ( ; it != tracks.constEnd(); ++it )
+    {
+        const QVariantMap attr = attributes.value( it.key() );
+        foreach ( const trackdata_ptr& track, it.value() )
+            track->setAttributes( attr );
+    }
+}
+
+
+void
+DatabaseCommand_LoadTrackData::loadSocialActions( DatabaseImpl* dbi, const TracksById& tracks )
+{
+    TomahawkSqlQuery query = dbi->newquery();
+    query.exec( QString( "SELECT id, k, v, timestamp, source "
+                         "FROM social_attributes WHERE id IN (%1) "
+                         "ORDER BY timestamp ASC" ).arg( idList( tracks.keys() ) ) );
+
+    QHash< unsigned int, QList< SocialAction > > socialActions;
+    while ( query.next() )
+    {
+        SocialAction action;
+        action.action    = query.value( 1 );  // action
+        action.value     = query.value( 2 );  // comment
+        action.timestamp = query.value( 3 );  // timestamp
+        action.source    = SourceList::instance()->get( query.value( 4 ).toInt() );  // source
+
+        if ( !action.source.isNull() )
+            socialActions[ query.value( 0 ).toUInt() ] << action;
+    }
+
+    TracksById::const_iterator it = tracks.constBegin();
+    for ( ; it != tracks.constEnd(); ++it )
+    {
+        const QList< SocialAction > actions = socialActions.value( it.key() );
+        foreach ( const trackdata_ptr& track, it.value() )
+            track->setAllSocialActions( actions );
+    }
+}
+
+
+void
+DatabaseCommand_LoadTrackData::loadStats( DatabaseImpl* dbi, const TracksById& tracks )
+{
+    TomahawkSqlQuery query = dbi->newquery();
+
+    // same chart as DatabaseCommand_TrackStats, ranked in one pass for all tracks: every
+    // track gets its own position as before, ties are ranked by track id
+    query.exec( "SELECT track, plays FROM playback_stats "
+                "WHERE source IS NULL AND plays >= 2 ORDER BY plays DESC, track" );
+
+    unsigned int chartCount = 0;
+    QHash< unsigned int, unsigned int > chartPositions;
+    while ( query.next() )
+    {
+        chartCount++;
+        const unsigned int trackId = query.value( 0 ).toUInt();
+        if ( tracks.contains( trackId ) )
+            chartPositions[ trackId ] = chartCount;
+    }
+
+    query.exec( QString( "SELECT track, source, playtime, secs_played "
+                         "FROM playback_log WHERE track IN (%1) "
+                         "ORDER BY playtime ASC" ).arg( idList( tracks.keys() ) ) );
+
+    QHash< unsigned int, QList< PlaybackLog > > playbackData;
+    while ( query.next() )
+    {
+        PlaybackLog log;
+        log.source = SourceList::instance()->get( query.value( 1 ).toInt() );  // source
+        log.timestamp = query.value( 2 ).toUInt();
+        log.secsPlayed = query.value( 3 ).toUInt();
+
+        if ( log.source )
+            playbackData[ query.value( 0 ).toUInt() ] << log;
+    }
+
+    TracksById::const_iterator it = tracks.constBegin();
+    for ( ; it != tracks.constEnd(); ++it )
+    {
+        const unsigned int chartPos = chartPositions.value( it.key(), chartCount );
+        const QList< PlaybackLog > history = playbackData.value( it.key() );
+
+        foreach ( const trackdata_ptr& track, it.value() )
+        {
+            QMetaObject::invokeMethod( track.data(), "onTrackStatsLoaded", Qt::QueuedConnection,
+                                       Q_ARG( unsigned int, chartPos ), Q_ARG( unsigned int, chartCount ) );
+            track->setPlaybackHistory( history );
+        }
+    }
+}
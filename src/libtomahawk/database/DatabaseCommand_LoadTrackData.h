@@ -0,0 +1,65 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASECOMMAND_LOADTRACKDATA_H
+#define DATABASECOMMAND_LOADTRACKDATA_H
+
+#include <QHash>
+#include <QList>
+
+#include "DatabaseCommand.h"
+#include "Typedefs.h"
+#include "DllMacro.h"
+
+/**
+ * Loads attributes, social actions and playback stats for many tracks at once,
+ * with one query per kind of data instead of one command per track. This is what
+ * TrackDataLoader uses to serve TrackData::loadAttributes(), loadSocialActions()
+ * and loadStats().
+ */
+class DLLEXPORT DatabaseCommand_LoadTrackData : public DatabaseCommand
+{
+Q_OBJECT
+
+public:
+    enum Part
+    {
+        Attributes = 1,
+        SocialActions = 2,
+        Stats = 4
+    };
+
+    /// parts maps each track to the Part flags that should be loaded for it
+    explicit DatabaseCommand_LoadTrackData( const QList< Tomahawk::trackdata_ptr >& tracks, const QList< int >& parts, QObject* parent = 0 );
+
+    virtual QString commandname() const { return "loadtrackdata"; }
+    virtual bool doesMutates() const { return false; }
+    virtual void exec( DatabaseImpl* dbi );
+
+private:
+    void loadAttributes( DatabaseImpl* dbi, const QHash< unsigned int, QList< Tomahawk::trackdata_ptr > >& tracks );
+    void loadSocialActions( DatabaseImpl* dbi, const QHash< unsigned int, QList< Tomahawk::trackdata_ptr > >& tracks );
+    void loadStats( DatabaseImpl* dbi, const QHash< unsigned int, QList< Tomahawk::trackdata_ptr > >& tracks );
+
+    static QString idList( const QList< unsigned int >& ids );
+
+    QList< Tomahawk::trackdata_ptr > m_tracks;
+    QList< int > m_parts;
+};
+
+#endif // DATABASECOMMAND_LOADTRACKDATA_H
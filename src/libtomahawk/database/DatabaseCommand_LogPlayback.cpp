@@ -30,6 +30,7 @@
 #define STARTED_THRESHOLD 600   // Don't advertise tracks older than X seconds as currently playing
 #define FINISHED_THRESHOLD 10   // Don't store tracks played less than X seconds in the playback log
 #define SUBMISSION_THRESHOLD 20 // Don't broadcast playback logs when a track was played less than X seconds
+#define SECONDS_PER_DAY 86400   // Bucket size of playback_stats_daily
 
 using namespace Tomahawk;
 
@@ -61,7 +62,7 @@ DatabaseCommand_LogPlayback::postCommitHook()
         emit trackPlaying( track, m_trackDuration );
     }
 
-    if ( source()->isLocal() )
+    if ( source()->isLocal() && Servent::instance() )
     {
         Servent::instance()->triggerDBSync();
     }
@@ -117,6 +118,35 @@ DatabaseCommand_LogPlayback::exec( DatabaseImpl* dbi )
     query.bindValue( 3, m_secsPlayed );
 
     query.exec();
+
+    // keep the materialized play counts in step with the log, charts and stats read from those
+    const QString sourceToken = srcid.isNull() ? "IS NULL" : QString( "= %1" ).arg( srcid.toInt() );
+
+    query.prepare( QString( "UPDATE playback_stats SET plays = plays + 1 WHERE source %1 AND track = ?" ).arg( sourceToken ) );
+    query.addBindValue( trkid );
+    query.exec();
+    if ( query.numRowsAffected() < 1 )
+    {
+        query.prepare( "INSERT INTO playback_stats(source, track, artist, plays) VALUES (?, ?, ?, 1)" );
+        query.addBindValue( srcid );
+        query.addBindValue( trkid );
+        query.addBindValue( artid );
+        query.exec();
+    }
+
+    const unsigned int day = m_playtime / SECONDS_PER_DAY;
+    query.prepare( QString( "UPDATE playback_stats_daily SET plays = plays + 1 WHERE source %1 AND track = ? AND day = ?" ).arg( sourceToken ) );
+    query.addBindValue( trkid );
+    query.addBindValue( day );
+    query.exec();
+    if ( query.numRowsAffected() < 1 )
+    {
+        query.prepare( "INSERT INTO playback_stats_daily(source, track, day, plays) VALUES (?, ?, ?, 1)" );
+        query.addBindValue( srcid );
+        query.addBindValue( trkid );
+        query.addBindValue( day );
+        query.exec();
+    }
 }
 
 
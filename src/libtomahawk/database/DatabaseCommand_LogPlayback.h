@@ -70,6 +70,8 @@ public:
     virtual bool singletonCmd() const { return ( m_action == Started ); }
     virtual bool localOnly() const;
     virtual bool groupable() const { return true; }
+    // "now playing" is announced from postCommitHook, that must not wait
+    virtual bool deferrable() const { return ( m_action == Finished ); }
 
     QString artist() const { return m_artist; }
     void setArtist( const QString& s ) { m_artist = s; }
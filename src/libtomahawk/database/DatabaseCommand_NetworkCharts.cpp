@@ -22,6 +22,8 @@
 #include "DatabaseImpl.h"
 #include "TomahawkSqlQuery.h"
 
+#define SECONDS_PER_DAY 86400
+
 DatabaseCommand_NetworkCharts::DatabaseCommand_NetworkCharts( const QDateTime &from, const QDateTime &to, QObject *parent )
     : DatabaseCommand( parent )
     , m_amount( 0 )
@@ -50,23 +52,60 @@ DatabaseCommand_NetworkCharts::exec( DatabaseImpl * dbi )
     {
         limit = QString( "LIMIT 0, %1" ).arg( m_amount );
     }
-    QString timespan;
+    QString sql;
     if ( m_from.isValid() && m_to.isValid() )
     {
-        timespan = QString(
-                    " AND playback_log.playtime >= %1 AND playback_log.playtime <= %2 "
-                    ).arg( m_from.toTime_t() ).arg( m_to.toTime_t() );
-    }
+        // Whole days inside the timespan come from the daily play counts, only the partial
+        // days at either end still need to be counted from the log.
+        const uint from = m_from.toTime_t();
+        const uint to = m_to.toTime_t();
+        const uint firstDay = ( from + SECONDS_PER_DAY - 1 ) / SECONDS_PER_DAY;
+        const uint lastDay = to >= SECONDS_PER_DAY - 1 ? ( to - ( SECONDS_PER_DAY - 1 ) ) / SECONDS_PER_DAY : 0;
 
-    QString sql = QString(
-                "SELECT COUNT(*) as counter, track.name, artist.name "
-                " FROM playback_log, track, artist "
-                " WHERE track.id = playback_log.track AND artist.id = track.artist "
-                " AND playback_log.source IS NOT NULL %1 " // exclude self
-                " GROUP BY playback_log.track "
+        QString plays;
+        if ( firstDay <= lastDay && to >= SECONDS_PER_DAY - 1 )
+        {
+            plays = QString(
+                    "SELECT track, plays FROM playback_stats_daily "
+                    "WHERE day >= %1 AND day <= %2 AND source IS NOT NULL " // exclude self
+                    "UNION ALL "
+                    "SELECT track, 1 FROM playback_log "
+                    "WHERE ( ( playtime >= %3 AND playtime < %4 ) OR ( playtime >= %5 AND playtime <= %6 ) ) "
+                    "AND track IS NOT NULL AND source IS NOT NULL "
+                    ).arg( firstDay ).arg( lastDay )
+                     .arg( from ).arg( firstDay * SECONDS_PER_DAY )
+                     .arg( ( lastDay + 1 ) * SECONDS_PER_DAY ).arg( to );
+        }
+        else
+        {
+            plays = QString(
+                    "SELECT track, 1 AS plays FROM playback_log "
+                    "WHERE playtime >= %1 AND playtime <= %2 "
+                    "AND track IS NOT NULL AND source IS NOT NULL "
+                    ).arg( from ).arg( to );
+        }
+
+        sql = QString(
+                "SELECT SUM(plays.plays) as counter, track.name, artist.name "
+                " FROM ( %1 ) AS plays, track, artist "
+                " WHERE track.id = plays.track AND artist.id = track.artist "
+                " GROUP BY plays.track "
                 " ORDER BY counter DESC "
                 " %2"
-                ).arg( timespan ).arg( limit );
+                ).arg( plays ).arg( limit );
+    }
+    else
+    {
+        sql = QString(
+                "SELECT SUM(playback_stats.plays) as counter, track.name, artist.name "
+                " FROM playback_stats, track, artist "
+                " WHERE track.id = playback_stats.track AND artist.id = track.artist "
+                " AND playback_stats.source IS NOT NULL " // exclude self
+                " GROUP BY playback_stats.track "
+                " ORDER BY counter DESC "
+                " %1"
+                ).arg( limit );
+    }
 
     query.prepare( sql );
     query.exec();
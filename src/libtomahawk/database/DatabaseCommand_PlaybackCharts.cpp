@@ -47,15 +47,15 @@ DatabaseCommand_PlaybackCharts::exec( DatabaseImpl* dbi )
     QString sourceToken;
 
     if ( source() )
-        sourceToken = QString( "AND playback_log.source %1" ).arg( source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( source()->id() ) );
+        sourceToken = QString( "WHERE playback_stats.source %1" ).arg( source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( source()->id() ) );
 
+    // playback_stats already holds the play count per track, summing those is much cheaper than counting the log
     QString sql = QString(
-            "SELECT artist.id, artist.name, COUNT(*) AS counter "
-            "FROM playback_log, artist, track "
-            "WHERE playback_log.track = track.id "
-            "AND artist.id = track.artist "
+            "SELECT artist.id, artist.name, SUM(playback_stats.plays) AS counter "
+            "FROM playback_stats "
+            "JOIN artist ON artist.id = playback_stats.artist "
             "%1 "
-            "GROUP BY artist.id "
+            "GROUP BY playback_stats.artist "
             "ORDER BY counter DESC "
             "%2"
             ).arg( sourceToken )
@@ -66,6 +66,6 @@ DatabaseCommand_RenamePlaylist::postCommitHook()
     tDebug() << "Renaming playlist" << playlist->title() << "to" << m_playlistTitle << m_playlistguid;
     playlist->setTitle( m_playlistTitle );
 
-    if ( source()->isLocal() )
+    if ( source()->isLocal() && Servent::instance() )
         Servent::instance()->triggerDBSync();
 }
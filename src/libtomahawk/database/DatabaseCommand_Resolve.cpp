@@ -20,6 +20,7 @@
 
 #include "Artist.h"
 #include "Album.h"
+#include "DatabaseCommand_UpdateSearchIndex.h"
 #include "Pipeline.h"
 #include "SourceList.h"
 #include "utils/Logger.h"
@@ -32,6 +33,7 @@ DatabaseCommand_Resolve::DatabaseCommand_Resolve( const query_ptr& query )
     , m_query( query )
 {
     Q_ASSERT( Pipeline::instance()->isRunning() );
+    setPriority( InteractivePriority );
 }
 
 
@@ -167,27 +169,48 @@ DatabaseCommand_Resolve::fullTextResolve( DatabaseImpl* lib )
 
     // STEP 1
     QList< QPair<int, float> > trackPairs = lib->search( m_query );
-    QList< QPair<int, float> > albumPairs = lib->searchAlbum( m_query, 20 );
+    QHash< int, IndexData > albumInfo;
+    QList< QPair<int, float> > albumPairs = lib->searchAlbum( m_query, 20, &albumInfo );
 
+    // the index stores what we need for albums, only look up what it didn't know about
+    QStringList missingAlbums;
     foreach ( const scorepair_t& albumPair, albumPairs )
     {
-        TomahawkSqlQuery query = lib->newquery();
+        if ( !albumInfo.contains( albumPair.first ) )
+            missingAlbums << QString::number( albumPair.first );
+    }
 
-        QString sql = QString( "SELECT album.name, artist.id, artist.name FROM album, artist WHERE artist.id = album.artist AND album.id = %1" ).arg( albumPair.first );
-        query.prepare( sql );
-        query.exec();
+    if ( !missingAlbums.isEmpty() )
+    {
+        TomahawkSqlQuery query = lib->newquery();
+        query.exec( QString( "SELECT album.id, album.name, artist.id, artist.name FROM album, artist "
+                             "WHERE artist.id = album.artist AND album.id IN (%1)" ).arg( missingAlbums.join( "," ) ) );
 
-        QList<Tomahawk::album_ptr> albumList;
         while ( query.next() )
         {
-            Tomahawk::artist_ptr artist = Tomahawk::Artist::get( query.value( 1 ).toUInt(), query.value( 2 ).toString() );
-            Tomahawk::album_ptr album = Tomahawk::Album::get( albumPair.first, query.value( 0 ).toString(), artist );
-            albumList << album;
+            IndexData data;
+            data.id = query.value( 0 ).toUInt();
+            data.albumName = query.value( 1 ).toString();
+            data.artistId = query.value( 2 ).toUInt();
+            data.artistName = query.value( 3 ).toString();
+            albumInfo.insert( data.id, data );
         }
+    }
 
-        emit albums( m_query->id(), albumList );
+    QList<Tomahawk::album_ptr> albumList;
+    foreach ( const scorepair_t& albumPair, albumPairs )
+    {
+        if ( !albumInfo.contains( albumPair.first ) )
+            continue;
+
+        const IndexData& data = albumInfo[ albumPair.first ];
+        Tomahawk::artist_ptr artist = Tomahawk::Artist::get( data.artistId, data.artistName );
+        albumList << Tomahawk::Album::get( albumPair.first, data.albumName, artist );
     }
 
+    if ( !albumList.isEmpty() )
+        emit albums( m_query->id(), albumList );
+
     if ( trackPairs.length() == 0 )
     {
         qDebug() << "No candidates found in first pass, aborting resolve" << m_query->fullTextQuery();
@@ -77,6 +77,6 @@ DatabaseCommand_SetCollectionAttributes::postCommitHook()
          m_type == EchonestArtistCatalog )
         Tomahawk::EchonestCatalogSynchronizer::instance()->knownCatalogsChanged();
 
-    if ( source()->isLocal() )
+    if ( source()->isLocal() && Servent::instance() )
         Servent::instance()->triggerDBSync();
 }
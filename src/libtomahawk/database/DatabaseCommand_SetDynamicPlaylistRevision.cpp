@@ -163,7 +163,7 @@ DatabaseCommand_SetDynamicPlaylistRevision::postCommitHook()
                                     m_applied );
     }
 
-    if ( source()->isLocal() )
+    if ( source()->isLocal() && Servent::instance() )
         Servent::instance()->triggerDBSync();
 }
 
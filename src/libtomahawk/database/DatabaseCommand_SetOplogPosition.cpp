@@ -0,0 +1,60 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DatabaseCommand_SetOplogPosition.h"
+
+#include "DatabaseImpl.h"
+#include "TomahawkSqlQuery.h"
+#include "utils/Logger.h"
+
+
+DatabaseCommand_SetOplogPosition::DatabaseCommand_SetOplogPosition( const QString& peer, const QString& guid )
+    : DatabaseCommand()
+    , m_peer( peer )
+    , m_guid( guid )
+{
+}
+
+
+void
+DatabaseCommand_SetOplogPosition::exec( DatabaseImpl* lib )
+{
+    // a peer without any of our ops yet gets everything, it doesn't hold back pruning for long
+    qint64 id = 0;
+    if ( !m_guid.isEmpty() )
+    {
+        TomahawkSqlQuery query = lib->newquery();
+        query.prepare( "SELECT id FROM oplog WHERE guid = ? "
+                       "UNION ALL SELECT id FROM oplog_compacted WHERE guid = ?" );
+        query.addBindValue( m_guid );
+        query.addBindValue( m_guid );
+        if ( !query.exec() || !query.next() )
+        {
+            tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Unknown oplog guid for" << m_peer << m_guid;
+            return;
+        }
+
+        id = query.value( 0 ).toLongLong();
+    }
+
+    TomahawkSqlQuery query = lib->newquery();
+    query.prepare( "INSERT OR REPLACE INTO oplog_peers( peer, id ) VALUES( ?, ? )" );
+    query.addBindValue( m_peer );
+    query.addBindValue( id );
+    query.exec();
+}
@@ -0,0 +1,47 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASECOMMAND_SETOPLOGPOSITION_H
+#define DATABASECOMMAND_SETOPLOGPOSITION_H
+
+#include "DatabaseCommand.h"
+#include "DllMacro.h"
+
+/**
+ * Remembers the op a peer asked for our ops from, which is the last one it has.
+ * DatabaseCommand_CompactOplog only keeps the guids of removed ops that are newer
+ * than the oldest position of all known peers.
+ */
+class DLLEXPORT DatabaseCommand_SetOplogPosition : public DatabaseCommand
+{
+Q_OBJECT
+
+public:
+    explicit DatabaseCommand_SetOplogPosition( const QString& peer, const QString& guid );
+
+    virtual QString commandname() const { return "setoplogposition"; }
+
+    bool doesMutates() const { return true; }
+    void exec( DatabaseImpl* lib );
+
+private:
+    QString m_peer;
+    QString m_guid;
+};
+
+#endif // DATABASECOMMAND_SETOPLOGPOSITION_H
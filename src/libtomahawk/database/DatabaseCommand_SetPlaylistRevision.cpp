@@ -22,10 +22,14 @@
 
 #include "Source.h"
 #include "DatabaseImpl.h"
+#include "PlaylistDelta.h"
 #include "TomahawkSqlQuery.h"
 #include "network/Servent.h"
 #include "utils/Logger.h"
 
+// revisions stored as deltas before the next full snapshot, bounds the chain replayed when loading one
+#define SNAPSHOT_INTERVAL 32
+
 using namespace Tomahawk;
 
 
@@ -115,7 +119,7 @@ DatabaseCommand_SetPlaylistRevision::postCommitHook()
     else
         playlist->setCurrentrevision( m_newrev );
 
-    if ( source()->isLocal() )
+    if ( source()->isLocal() && Servent::instance() )
         Servent::instance()->triggerDBSync();
 }
 
@@ -142,9 +146,12 @@ DatabaseCommand_SetPlaylistRevision::exec( DatabaseImpl* lib )
         return;
     }
 
-    QVariantList vlist = m_orderedguids;
-    QJson::Serializer ser;
-    const QByteArray entries = ser.serialize( vlist );
+    // we may be at one of the revisions a compacted oplog folded into this one, then it follows ours
+    if ( currentRevision != m_oldrev && m_mergedrevisions.contains( currentRevision ) )
+    {
+        tDebug() << "Revision" << m_newrev << "was merged, applying it on top of" << currentRevision;
+        m_oldrev = currentRevision;
+    }
 
     // add any new items:
     TomahawkSqlQuery adde = lib->newquery();
@@ -220,20 +227,61 @@ DatabaseCommand_SetPlaylistRevision::exec( DatabaseImpl* lib )
         }
     }
 
+    QStringList orderedguids;
+    foreach ( const QVariant& v, m_orderedguids )
+        orderedguids << v.toString();
+
+    // the previous revision is the base of the delta and also needed to diff the change in postCommitHook
+    QStringList previousguids;
+    bool hasPrevious = false;
+    int snapshotDistance = 0;
+    if ( !m_oldrev.isEmpty() )
+    {
+        TomahawkSqlQuery prevq = lib->newquery();
+        prevq.prepare( "SELECT snapshot_distance FROM playlist_revision WHERE guid = ?" );
+        prevq.addBindValue( m_oldrev );
+        if ( prevq.exec() && prevq.next() )
+        {
+            snapshotDistance = prevq.value( 0 ).toInt() + 1;
+            previousguids = lib->playlistRevisionEntries( m_oldrev, &hasPrevious );
+        }
+    }
+
+    // store a delta against the previous revision, unless the chain is getting long or most of the playlist changed
+    QVariantList delta;
+    if ( hasPrevious && snapshotDistance < SNAPSHOT_INTERVAL )
+        delta = PlaylistDelta::diff( previousguids, orderedguids );
+
+    QJson::Serializer ser;
+    QVariant entries( QVariant::String ), entriesDelta( QVariant::String );
+    if ( hasPrevious && snapshotDistance < SNAPSHOT_INTERVAL && PlaylistDelta::size( delta ) * 2 <= orderedguids.count() )
+    {
+        entriesDelta = ser.serialize( delta );
+    }
+    else
+    {
+        entries = ser.serialize( m_orderedguids );
+        snapshotDistance = 0;
+    }
+
     // add / update the revision:
     TomahawkSqlQuery query = lib->newquery();
-    QString sql = "INSERT INTO playlist_revision(guid, playlist, entries, author, timestamp, previous_revision) "
-                  "VALUES(?, ?, ?, ?, ?, ?)";
+    QString sql = "INSERT INTO playlist_revision(guid, playlist, entries, entries_delta, snapshot_distance, author, timestamp, previous_revision) "
+                  "VALUES(?, ?, ?, ?, ?, ?, ?, ?)";
     query.prepare( sql );
 
     query.addBindValue( m_newrev );
     query.addBindValue( m_playlistguid );
     query.addBindValue( entries );
+    query.addBindValue( entriesDelta );
+    query.addBindValue( snapshotDistance );
     query.addBindValue( source()->isLocal() ? QVariant(QVariant::Int) : source()->id() );
     query.addBindValue( 0 ); //ts
     query.addBindValue( m_oldrev.isEmpty() ? QVariant(QVariant::String) : m_oldrev );
     query.exec();
 
+    lib->cachePlaylistRevisionEntries( m_newrev, orderedguids );
+
     tDebug() << "Currentrevision:" << currentRevision << "oldrev:" << m_oldrev;
     // if optimistic locking is ok, update current revision to this new one
     if ( currentRevision == m_oldrev )
@@ -248,23 +296,8 @@ DatabaseCommand_SetPlaylistRevision::exec( DatabaseImpl* lib )
 
         m_applied = true;
 
-        // load previous revision entries, which we need to pass on
-        // so the change can be diffed
-        TomahawkSqlQuery query_entries = lib->newquery();
-        query_entries.prepare( "SELECT entries, playlist, author, timestamp, previous_revision "
-                               "FROM playlist_revision "
-                               "WHERE guid = :guid" );
-        query_entries.bindValue( ":guid", m_oldrev );
-        query_entries.exec();
-        if ( query_entries.next() )
-        {
-            bool ok;
-            QJson::Parser parser;
-            QVariant v = parser.parse( query_entries.value( 0 ).toByteArray(), &ok );
-            Q_ASSERT( ok && v.type() == QVariant::List ); //TODO
-
-            m_previous_rev_orderedguids = v.toStringList();
-        }
+        // pass on the previous revision entries, so the change can be diffed
+        m_previous_rev_orderedguids = previousguids;
     }
     else if ( !m_oldrev.isEmpty() )
     {
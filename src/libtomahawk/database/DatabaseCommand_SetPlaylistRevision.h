@@ -36,6 +36,7 @@ Q_PROPERTY( QString oldrev            READ oldrev        WRITE setOldrev )
 Q_PROPERTY( QVariantList orderedguids READ orderedguids  WRITE setOrderedguids )
 Q_PROPERTY( QVariantList addedentries READ addedentriesV WRITE setAddedentriesV )
 Q_PROPERTY( bool metadataUpdate       READ metadataUpdate WRITE setMetadataUpdate )
+Q_PROPERTY( QStringList mergedrevisions READ mergedrevisions WRITE setMergedrevisions )
 
 public:
     explicit DatabaseCommand_SetPlaylistRevision( QObject* parent = 0 )
@@ -109,6 +110,10 @@ public:
     bool metadataUpdate() const { return m_metadataUpdate; }
     void setMetadataUpdate( bool metadataUpdate ) { m_metadataUpdate = metadataUpdate; }
 
+    /// Revisions between oldrev and newrev that were folded into this one when the oplog got compacted.
+    QStringList mergedrevisions() const { return m_mergedrevisions; }
+    void setMergedrevisions( const QStringList& revisions ) { m_mergedrevisions = revisions; }
+
     void setOrderedguids( const QVariantList& l ) { m_orderedguids = l; }
     QVariantList orderedguids() const { return m_orderedguids; }
 
@@ -123,6 +128,7 @@ protected:
 private:
     QVariantList m_orderedguids;
     QList<Tomahawk::plentry_ptr> m_addedentries, m_entries;
+    QStringList m_mergedrevisions;
 
     bool m_localOnly, m_metadataUpdate;
 };
@@ -67,7 +67,7 @@ DatabaseCommand_ShareTrack::exec( DatabaseImpl* dbi )
 void
 DatabaseCommand_ShareTrack::postCommitHook()
 {
-    if ( source()->isLocal() )
+    if ( source()->isLocal() && Servent::instance() )
         Servent::instance()->triggerDBSync();
 
     QString myDbid = SourceList::instance()->getLocal()->nodeId();
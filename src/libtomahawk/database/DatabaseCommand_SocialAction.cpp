@@ -32,7 +32,7 @@ void
 DatabaseCommand_SocialAction::postCommitHook()
 {
     qDebug() << Q_FUNC_INFO;
-    if ( source()->isLocal() )
+    if ( source()->isLocal() && Servent::instance() )
     {
         Servent::instance()->triggerDBSync();
     }
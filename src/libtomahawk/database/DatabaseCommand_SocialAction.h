@@ -172,6 +172,7 @@ public:
 
     virtual bool doesMutates() const { return true; }
     virtual bool groupable() const { return true; }
+    virtual bool deferrable() const { return true; }
 
 protected:
     Tomahawk::trackdata_ptr m_track;
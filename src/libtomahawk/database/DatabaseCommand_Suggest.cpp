@@ -0,0 +1,47 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DatabaseCommand_Suggest.h"
+
+#include "CompletionIndex.h"
+#include "DatabaseImpl.h"
+#include "utils/Logger.h"
+
+
+DatabaseCommand_Suggest::DatabaseCommand_Suggest( const QString& prefix, int limit, QObject* parent )
+    : DatabaseCommand( parent )
+    , m_prefix( prefix )
+    , m_limit( limit )
+{
+    setPriority( InteractivePriority );
+}
+
+
+void
+DatabaseCommand_Suggest::exec( DatabaseImpl* lib )
+{
+    // DatabaseCommand_UpdateCompletionIndex builds it in the background, there's nothing to suggest until then
+    if ( !lib->m_completionIndex->isLoaded() )
+    {
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Completion index isn't built yet";
+        emit done( m_prefix, m_limit, QVariantList() );
+        return;
+    }
+
+    emit done( m_prefix, m_limit, lib->m_completionIndex->suggest( m_prefix, m_limit ) );
+}
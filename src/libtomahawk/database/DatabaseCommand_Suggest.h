@@ -0,0 +1,50 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASECOMMAND_SUGGEST_H
+#define DATABASECOMMAND_SUGGEST_H
+
+#include "DatabaseCommand.h"
+#include "DllMacro.h"
+
+#include <QVariantList>
+
+/**
+ * Completes a partially typed name against the artists, albums and tracks in the
+ * local collection. Suggestions come as maps with type ("artist", "album" or
+ * "track"), id, name and, except for artists, artist.
+ */
+class DLLEXPORT DatabaseCommand_Suggest : public DatabaseCommand
+{
+Q_OBJECT
+public:
+    explicit DatabaseCommand_Suggest( const QString& prefix, int limit = 10, QObject* parent = 0 );
+
+    virtual QString commandname() const { return "suggest"; }
+    virtual bool doesMutates() const { return false; }
+    virtual void exec( DatabaseImpl* lib );
+
+signals:
+    void done( const QString& prefix, int limit, const QVariantList& suggestions );
+
+private:
+    QString m_prefix;
+    int m_limit;
+};
+
+#endif // DATABASECOMMAND_SUGGEST_H
@@ -30,6 +30,7 @@ DatabaseCommand_TrackStats::DatabaseCommand_TrackStats( const trackdata_ptr& tra
     : DatabaseCommand( parent )
     , m_track( track )
 {
+    setPriority( BackgroundPriority );
 }
 
 
@@ -37,6 +38,7 @@ DatabaseCommand_TrackStats::DatabaseCommand_TrackStats( const artist_ptr& artist
     : DatabaseCommand( parent )
     , m_artist( artist )
 {
+    setPriority( BackgroundPriority );
 }
 
 
@@ -50,33 +52,32 @@ DatabaseCommand_TrackStats::exec( DatabaseImpl* dbi )
         if ( m_track->trackId() == 0 )
             return;
 
-        query.prepare( "SELECT COUNT(*) AS counter, track.id "
-                       "FROM playback_log, track "
-                       "WHERE playback_log.source IS NULL AND track.id = playback_log.track "
-                       "GROUP BY track.id "
-                       "ORDER BY counter DESC" );
+        const unsigned int trackId = m_track->trackId();
+
+        // only tracks played at least twice make it into the charts
+        query.prepare( "SELECT COUNT(*) FROM playback_stats WHERE source IS NULL AND plays >= 2" );
         query.exec();
+        const unsigned int chartCount = query.next() ? query.value( 0 ).toUInt() : 0;
+        unsigned int chartPos = chartCount;
 
-        unsigned int chartPos = 0;
-        unsigned int chartCount = 0;
-        const unsigned int trackId = m_track->trackId();
+        query.prepare( "SELECT plays FROM playback_stats WHERE source IS NULL AND track = ?" );
+        query.addBindValue( trackId );
+        query.exec();
+        const unsigned int plays = query.next() ? query.value( 0 ).toUInt() : 0;
 
-        QHash< QString, unsigned int > charts;
-        while ( query.next() )
+        if ( plays >= 2 )
         {
-            if ( query.value( 0 ).toUInt() < 2 )
-                break;
-
-            chartCount++;
-            if ( chartPos == 0 && query.value( 1 ).toUInt() == trackId )
-            {
-                chartPos = chartCount;
-            }
+            // every track gets its own position as before, ties are ranked by track id
+            query.prepare( "SELECT COUNT(*) FROM playback_stats "
+                           "WHERE source IS NULL AND plays >= ? AND ( plays > ? OR track < ? )" );
+            query.addBindValue( plays );
+            query.addBindValue( plays );
+            query.addBindValue( trackId );
+            query.exec();
+            if ( query.next() )
+                chartPos = query.value( 0 ).toUInt() + 1;
         }
 
-        if ( chartPos == 0 )
-            chartPos = chartCount;
-
         emit trackStats( chartPos, chartCount );
 
         query.prepare( "SELECT * "
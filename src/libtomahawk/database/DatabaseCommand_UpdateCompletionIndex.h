@@ -0,0 +1,41 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASECOMMAND_UPDATECOMPLETIONINDEX_H
+#define DATABASECOMMAND_UPDATECOMPLETIONINDEX_H
+
+#include "DatabaseCommand.h"
+#include "DllMacro.h"
+
+/**
+ * Adds the names that were inserted since the last run to the completion index
+ * used by DatabaseCommand_Suggest. Database runs it whenever the search index
+ * is ready, so suggestions never have to wait for the index to be built.
+ */
+class DLLEXPORT DatabaseCommand_UpdateCompletionIndex : public DatabaseCommand
+{
+Q_OBJECT
+public:
+    explicit DatabaseCommand_UpdateCompletionIndex( QObject* parent = 0 );
+
+    virtual QString commandname() const { return "updatecompletionindex"; }
+    virtual bool doesMutates() const { return false; }
+    virtual void exec( DatabaseImpl* lib );
+};
+
+#endif // DATABASECOMMAND_UPDATECOMPLETIONINDEX_H
@@ -35,8 +35,9 @@
 #include "utils/Logger.h"
 
 
-DatabaseCommand_UpdateSearchIndex::DatabaseCommand_UpdateSearchIndex()
+DatabaseCommand_UpdateSearchIndex::DatabaseCommand_UpdateSearchIndex( bool incremental )
     : DatabaseCommand()
+    , m_incremental( incremental )
     , m_statusJob( new IndexingJobItem )
 {
     tLog() << Q_FUNC_INFO << "Updating index.";
@@ -61,10 +62,13 @@ DatabaseCommand_UpdateSearchIndex::~DatabaseCommand_UpdateSearchIndex()
 void
 DatabaseCommand_UpdateSearchIndex::exec( DatabaseImpl* db )
 {
-    db->m_fuzzyIndex->beginIndexing();
+    const bool incremental = m_incremental && db->m_fuzzyIndex->canUpdateIncrementally();
+    db->m_fuzzyIndex->beginIndexing( incremental );
 
     TomahawkSqlQuery q = db->newquery();
-    q.exec( "SELECT track.id, track.name, artist.name, artist.id FROM track, artist WHERE artist.id = track.artist" );
+    q.prepare( "SELECT track.id, track.sortname, artist.sortname, artist.id FROM track, artist WHERE artist.id = track.artist AND track.id > ?" );
+    q.bindValue( 0, incremental ? db->m_fuzzyIndex->maxTrackId() : 0 );
+    q.exec();
     while ( q.next() )
     {
         IndexData ida;
@@ -76,12 +80,17 @@ DatabaseCommand_UpdateSearchIndex::exec( DatabaseImpl* db )
         db->m_fuzzyIndex->appendFields( ida );
     }
 
-    q.exec( "SELECT album.id, album.name FROM album" );
+    q.prepare( "SELECT album.id, album.sortname, album.name, artist.id, artist.name FROM album, artist WHERE artist.id = album.artist AND album.id > ?" );
+    q.bindValue( 0, incremental ? db->m_fuzzyIndex->maxAlbumId() : 0 );
+    q.exec();
     while ( q.next() )
     {
         IndexData ida;
         ida.id = q.value( 0 ).toUInt();
         ida.album = q.value( 1 ).toString();
+        ida.albumName = q.value( 2 ).toString();
+        ida.artistId = q.value( 3 ).toUInt();
+        ida.artistName = q.value( 4 ).toString();
 
         db->m_fuzzyIndex->appendFields( ida );
     }
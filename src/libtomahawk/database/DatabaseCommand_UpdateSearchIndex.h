@@ -25,6 +25,7 @@
 
 class IndexingJobItem;
 
+// names are sortnames, as stored in the database
 struct IndexData
 {
     unsigned int id;
@@ -32,13 +33,18 @@ struct IndexData
     QString artist;
     QString album;
     QString track;
+
+    // display names, stored with albums so hits need no further lookup
+    QString albumName;
+    QString artistName;
 };
 
 class DLLEXPORT DatabaseCommand_UpdateSearchIndex : public DatabaseCommand
 {
 Q_OBJECT
 public:
-    explicit DatabaseCommand_UpdateSearchIndex();
+    /// An incremental update only indexes rows added since the last update, if the index supports that.
+    explicit DatabaseCommand_UpdateSearchIndex( bool incremental = false );
     virtual ~DatabaseCommand_UpdateSearchIndex();
 
     virtual QString commandname() const { return "updatesearchindex"; }
@@ -46,6 +52,7 @@ public:
     virtual void exec( DatabaseImpl* db );
 
 private:
+    bool m_incremental;
     QPointer<IndexingJobItem> m_statusJob;
 };
 
@@ -27,7 +27,10 @@
 #include <QFile>
 
 #include "database/Database.h"
+#include "qjson/parser.h"
+#include "CompletionIndex.h"
 #include "FuzzyIndex.h"
+#include "PlaylistDelta.h"
 #include "SourceList.h"
 #include "Result.h"
 #include "Artist.h"
@@ -41,7 +44,19 @@
 */
 #include "Schema.sql.h"
 
-#define CURRENT_SCHEMA_VERSION 29
+#define CURRENT_SCHEMA_VERSION 32
+
+// page cache per connection in KiB, mapped bytes of the database file and ms to wait for a lock
+#define CACHE_SIZE 8192
+#define MMAP_SIZE 268435456
+#define BUSY_TIMEOUT 5000
+
+// frames in the write-ahead log before a checkpoint waits for readers to start it over, and the bytes it's cut back to then
+#define WAL_RESTART_FRAMES 10000
+#define WAL_SIZE_LIMIT 16777216
+
+// entry guids of recently used playlist revisions we keep per connection, so a new delta doesn't have to replay the chain
+#define REVISION_CACHE_ENTRIES 50000
 
 DatabaseImpl::DatabaseImpl( const QString& dbname )
 {
@@ -65,8 +80,21 @@ DatabaseImpl::DatabaseImpl( const QString& dbname )
 
     tLog() << "Database ID:" << m_dbid;
     init();
-    query.exec( "PRAGMA auto_vacuum = FULL" );
-    query.exec( "PRAGMA synchronous = NORMAL" );
+
+    // Free pages are given back by the RW worker while it's idle instead of on every commit.
+    // Switching an existing database over takes a one-off VACUUM, which has to happen before WAL is enabled.
+    query.exec( "PRAGMA auto_vacuum" );
+    if ( query.next() && query.value( 0 ).toInt() != 2 )
+    {
+        tLog() << "Enabling incremental vacuum, this may take a while...";
+        query.exec( "PRAGMA auto_vacuum = INCREMENTAL" );
+        query.exec( "VACUUM" );
+    }
+
+    // Readers no longer block the writer and vice versa. Checkpoints are run by the RW worker, see checkpoint().
+    query.exec( "PRAGMA journal_mode = WAL" );
+    if ( query.next() )
+        tLog() << "Database journal mode:" << query.value( 0 ).toString();
 
     tDebug( LOGVERBOSE ) << "Tweaked db pragmas:" << t.elapsed();
 
@@ -75,6 +103,7 @@ DatabaseImpl::DatabaseImpl( const QString& dbname )
     query.exec( "DELETE FROM oplog WHERE source IS NULL AND singleton = 'true'" );
 
     m_fuzzyIndex = new FuzzyIndex( this, schemaUpdated );
+    m_completionIndex = QSharedPointer< CompletionIndex >( new CompletionIndex );
 
     tDebug( LOGVERBOSE ) << "Loaded index:" << t.elapsed();
     if ( qApp->arguments().contains( "--dumpdb" ) )
@@ -97,11 +126,61 @@ void
 DatabaseImpl::init()
 {
     m_lastartid = m_lastalbid = m_lasttrkid = 0;
+    m_revisionEntries.setMaxCost( REVISION_CACHE_ENTRIES );
 
     TomahawkSqlQuery query = newquery();
 
      // make sqlite behave how we want:
     query.exec( "PRAGMA foreign_keys = ON" );
+    query.exec( "PRAGMA synchronous = NORMAL" );
+    query.exec( "PRAGMA wal_autocheckpoint = 0" );
+    query.exec( QString( "PRAGMA journal_size_limit = %1" ).arg( WAL_SIZE_LIMIT ) );
+    query.exec( QString( "PRAGMA cache_size = -%1" ).arg( CACHE_SIZE ) );
+    query.exec( QString( "PRAGMA mmap_size = %1" ).arg( MMAP_SIZE ) );
+}
+
+
+bool
+DatabaseImpl::checkpoint()
+{
+    TomahawkSqlQuery query = newquery();
+    if ( !query.exec( "PRAGMA wal_checkpoint(PASSIVE)" ) || !query.next() )
+        return false;
+
+    // busy, frames in the log, frames checkpointed
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Checkpointed" << query.value( 2 ).toInt() << "of" << query.value( 1 ).toInt() << "frames";
+    if ( query.value( 0 ).toInt() == 0 && query.value( 1 ).toInt() == query.value( 2 ).toInt() )
+        return true;
+
+    // With readers around all the time a passive checkpoint never catches up and the log is never
+    // started over, so it keeps growing. Wait for the readers once it got too big.
+    if ( query.value( 1 ).toInt() < WAL_RESTART_FRAMES )
+        return false;
+
+    if ( !query.exec( "PRAGMA wal_checkpoint(RESTART)" ) || !query.next() )
+        return false;
+
+    tDebug() << Q_FUNC_INFO << "Restarted the write-ahead log after" << query.value( 1 ).toInt() << "frames, busy:" << query.value( 0 ).toInt();
+    return query.value( 0 ).toInt() == 0;
+}
+
+
+bool
+DatabaseImpl::vacuumIncrementally( int pages )
+{
+    TomahawkSqlQuery query = newquery();
+    query.exec( "PRAGMA freelist_count" );
+    if ( !query.next() || query.value( 0 ).toInt() == 0 )
+        return false;
+
+    const int freePages = query.value( 0 ).toInt();
+
+    // every step of the statement frees a single page
+    query.exec( QString( "PRAGMA incremental_vacuum(%1)" ).arg( pages ) );
+    while ( query.next() );
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Freed" << qMin( pages, freePages ) << "of" << freePages << "pages";
+    return freePages > pages;
 }
 
 
@@ -149,6 +228,7 @@ DatabaseImpl::clone() const
     DatabaseImpl* impl = new DatabaseImpl( m_db.databaseName(), true );
     impl->setDatabaseID( m_dbid );
     impl->setFuzzyIndex( m_fuzzyIndex );
+    impl->setCompletionIndex( m_completionIndex );
     return impl;
 }
 
@@ -450,7 +530,7 @@ DatabaseImpl::search( const Tomahawk::query_ptr& query, uint limit )
 {
     QList< QPair<int, float> > resultslist;
 
-    QMap< int, float > resultsmap = m_fuzzyIndex->search( query );
+    QMap< int, float > resultsmap = m_fuzzyIndex->search( query, limit );
     foreach ( int i, resultsmap.keys() )
     {
         resultslist << QPair<int, float>( i, (float)resultsmap.value( i ) );
@@ -471,11 +551,11 @@ DatabaseImpl::search( const Tomahawk::query_ptr& query, uint limit )
 
 
 QList< QPair<int, float> >
-DatabaseImpl::searchAlbum( const Tomahawk::query_ptr& query, uint limit )
+DatabaseImpl::searchAlbum( const Tomahawk::query_ptr& query, uint limit, QHash< int, IndexData >* info )
 {
     QList< QPair<int, float> > resultslist;
 
-    QMap< int, float > resultsmap = m_fuzzyIndex->searchAlbum( query );
+    QMap< int, float > resultsmap = m_fuzzyIndex->searchAlbum( query, limit, info );
     foreach ( int i, resultsmap.keys() )
     {
         resultslist << QPair<int, float>( i, (float)resultsmap.value( i ) );
@@ -516,17 +596,139 @@ DatabaseImpl::getTrackFids( int tid )
 QString
 DatabaseImpl::sortname( const QString& str, bool replaceArticle )
 {
-    QString s = str.toLower().trimmed().replace( QRegExp( "[\\s]{2,}" ), " " );
+    // Lower-cases, trims and collapses runs of two or more whitespace characters
+    // into a single space, in one pass. Single whitespace characters are kept as
+    // they are: sortnames are stored in the database, so this must not change.
+    const QString lower = str.toLower();
+    const QChar* in = lower.constData();
+    int begin = 0;
+    int end = lower.length();
+
+    while ( begin < end && in[ begin ].isSpace() )
+        begin++;
+    while ( end > begin && in[ end - 1 ].isSpace() )
+        end--;
+
+    if ( replaceArticle && end - begin >= 4 &&
+         in[ begin ] == 't' && in[ begin + 1 ] == 'h' && in[ begin + 2 ] == 'e' && in[ begin + 3 ].isSpace() )
+    {
+        // "the" followed by a single space, once the whitespace has been collapsed
+        if ( in[ begin + 3 ] == ' ' || ( begin + 4 < end && in[ begin + 4 ].isSpace() ) )
+        {
+            begin += 4;
+            while ( begin < end && in[ begin ].isSpace() )
+                begin++;
+        }
+    }
+
+    QString s( end - begin, Qt::Uninitialized );
+    QChar* out = s.data();
+    int length = 0;
+
+    for ( int i = begin; i < end; i++ )
+    {
+        if ( in[ i ].isSpace() && in[ i + 1 ].isSpace() )
+        {
+            while ( in[ i + 1 ].isSpace() )
+                i++;
+
+            out[ length++ ] = QChar( ' ' );
+        }
+        else
+            out[ length++ ] = in[ i ];
+    }
+
+    s.truncate( length );
+    return s;
+}
+
+
+QString
+DatabaseImpl::foldedname( const QString& sortname )
+{
+    const QChar* in = sortname.constData();
+    const int length = sortname.length();
 
-    if ( replaceArticle && s.startsWith( "the " ) )
+    int i = 0;
+    while ( i < length && in[ i ].unicode() < 0x80 )
+        i++;
+
+    // plain ASCII, nothing to fold
+    if ( i == length )
+        return sortname;
+
+    const QString decomposed = sortname.normalized( QString::NormalizationForm_KD );
+    QString s;
+    s.reserve( decomposed.length() );
+
+    foreach ( const QChar& c, decomposed )
     {
-        s = s.mid( 4 );
+        switch ( c.category() )
+        {
+            case QChar::Mark_NonSpacing:
+            case QChar::Mark_SpacingCombining:
+            case QChar::Mark_Enclosing:
+                break;
+
+            default:
+                s += c;
+        }
     }
 
     return s;
 }
 
 
+QString
+DatabaseImpl::joinSortnames( const QString& first, const QString& second )
+{
+    // same as sortname( a + " " + b ) for two sortnames a and b
+    if ( first.isEmpty() )
+        return second;
+    if ( second.isEmpty() )
+        return first;
+
+    return first + ' ' + second;
+}
+
+
+QString
+DatabaseImpl::keysetCondition( const QStringList& keys, const QList< bool >& descending, const QVariantList& cursor, QVariantList& bindValues )
+{
+    Q_ASSERT( keys.count() == cursor.count() );
+
+    // ( k0 > ? ) OR ( k0 = ? AND k1 > ? ) OR ..., with < for the keys sorted descending
+    QStringList alternatives;
+    for ( int i = 0; i < keys.count() && i < cursor.count(); i++ )
+    {
+        QStringList terms;
+        for ( int j = 0; j < i; j++ )
+        {
+            terms << QString( "%1 = ?" ).arg( keys.at( j ) );
+            bindValues << cursor.at( j );
+        }
+
+        terms << QString( "%1 %2 ?" ).arg( keys.at( i ) ).arg( descending.value( i ) ? "<" : ">" );
+        bindValues << cursor.at( i );
+
+        alternatives << QString( "( %1 )" ).arg( terms.join( " AND " ) );
+    }
+
+    return QString( "( %1 )" ).arg( alternatives.join( " OR " ) );
+}
+
+
+QString
+DatabaseImpl::keysetOrder( const QStringList& keys, const QList< bool >& descending )
+{
+    QStringList order;
+    for ( int i = 0; i < keys.count(); i++ )
+        order << ( descending.value( i ) ? keys.at( i ) + " DESC" : keys.at( i ) );
+
+    return QString( "ORDER BY %1" ).arg( order.join( ", " ) );
+}
+
+
 QVariantMap
 DatabaseImpl::artist( int id )
 {
@@ -580,6 +782,82 @@ DatabaseImpl::album( int id )
 }
 
 
+QStringList
+DatabaseImpl::playlistRevisionEntries( const QString& revision, bool* found )
+{
+    if ( found )
+        *found = false;
+
+    // walk back to the closest snapshot or cached revision, collecting the deltas on the way
+    QList< QVariantList > deltas;
+    QStringList entries;
+    QString current = revision;
+    QJson::Parser parser;
+    bool ok;
+
+    TomahawkSqlQuery query = newquery();
+    query.prepare( "SELECT entries, entries_delta, previous_revision FROM playlist_revision WHERE guid = ?" );
+
+    while ( true )
+    {
+        if ( QStringList* cached = m_revisionEntries.object( current ) )
+        {
+            entries = *cached;
+            break;
+        }
+
+        query.bindValue( 0, current );
+        query.exec();
+        if ( !query.next() )
+        {
+            if ( current != revision )
+                tLog() << "Missing base revision" << current << "for playlist revision" << revision;
+
+            return QStringList();
+        }
+
+        if ( !query.value( 0 ).isNull() )
+        {
+            // entries should be a list of strings:
+            QVariant v = parser.parse( query.value( 0 ).toByteArray(), &ok );
+            Q_ASSERT( ok && v.type() == QVariant::List ); //TODO
+            entries = v.toStringList();
+            break;
+        }
+        if ( query.value( 1 ).isNull() )
+            break;
+
+        QVariant v = parser.parse( query.value( 1 ).toByteArray(), &ok );
+        Q_ASSERT( ok && v.type() == QVariant::List );
+        deltas.prepend( v.toList() );
+        current = query.value( 2 ).toString();
+    }
+
+    foreach ( const QVariantList& delta, deltas )
+    {
+        if ( !PlaylistDelta::apply( entries, delta ) )
+        {
+            tLog() << "Failed to apply delta for playlist revision" << revision;
+            Q_ASSERT( false );
+            return QStringList();
+        }
+    }
+
+    if ( found )
+        *found = true;
+
+    cachePlaylistRevisionEntries( revision, entries );
+    return entries;
+}
+
+
+void
+DatabaseImpl::cachePlaylistRevisionEntries( const QString& revision, const QStringList& entries )
+{
+    m_revisionEntries.insert( revision, new QStringList( entries ), qMax( 1, entries.count() ) );
+}
+
+
 Tomahawk::result_ptr
 DatabaseImpl::resultFromHint( const Tomahawk::query_ptr& origquery )
 {
@@ -697,7 +975,8 @@ DatabaseImpl::openDatabase( const QString& dbname, bool checkSchema )
     {
         QSqlDatabase db = QSqlDatabase::addDatabase( "QSQLITE", connName );
         db.setDatabaseName( dbname );
-        db.setConnectOptions( "QSQLITE_ENABLE_SHARED_CACHE=1" );
+        // every connection keeps its own page cache, WAL lets them read concurrently
+        db.setConnectOptions( QString( "QSQLITE_BUSY_TIMEOUT=%1" ).arg( BUSY_TIMEOUT ) );
         if ( !db.open() )
         {
             tLog() << "Failed to open database" << dbname;
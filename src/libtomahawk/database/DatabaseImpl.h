@@ -21,6 +21,7 @@
 #define DATABASEIMPL_H
 
 #include <QObject>
+#include <QCache>
 #include <QList>
 #include <QMutex>
 #include <QPair>
@@ -30,6 +31,7 @@
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QHash>
+#include <QSharedPointer>
 #include <QThread>
 
 #include "DllMacro.h"
@@ -37,6 +39,8 @@
 #include "Typedefs.h"
 
 class Database;
+class CompletionIndex;
+struct IndexData;
 class FuzzyIndex;
 
 class DLLEXPORT DatabaseImpl : public QObject
@@ -45,6 +49,8 @@ Q_OBJECT
 
 friend class FuzzyIndex;
 friend class DatabaseCommand_UpdateSearchIndex;
+friend class DatabaseCommand_Suggest;
+friend class DatabaseCommand_UpdateCompletionIndex;
 
 public:
     DatabaseImpl( const QString& dbname );
@@ -60,10 +66,18 @@ public:
     int albumId( int artistid, const QString& name_orig, bool autoCreate );
 
     QList< QPair<int, float> > search( const Tomahawk::query_ptr& query, uint limit = 0 );
-    QList< QPair<int, float> > searchAlbum( const Tomahawk::query_ptr& query, uint limit = 0 );
+    QList< QPair<int, float> > searchAlbum( const Tomahawk::query_ptr& query, uint limit = 0, QHash< int, IndexData >* info = 0 );
     QList< int > getTrackFids( int tid );
 
     static QString sortname( const QString& str, bool replaceArticle = false );
+    static QString foldedname( const QString& sortname );
+    static QString joinSortnames( const QString& first, const QString& second );
+
+    /// Condition matching the rows after cursor when ordered by keys, for paging without OFFSET. Appends the values to bind in order.
+    /// descending holds the direction of each key, keys past its end are sorted ascending.
+    static QString keysetCondition( const QStringList& keys, const QList< bool >& descending, const QVariantList& cursor, QVariantList& bindValues );
+    /// ORDER BY clause for the same keys.
+    static QString keysetOrder( const QStringList& keys, const QList< bool >& descending );
 
     QVariantMap artist( int id );
     QVariantMap album( int id );
@@ -71,6 +85,10 @@ public:
     Tomahawk::result_ptr file( int fid );
     Tomahawk::result_ptr resultFromHint( const Tomahawk::query_ptr& query );
 
+    /// Ordered entry guids of a playlist revision, replayed from its last snapshot and the deltas since, see PlaylistDelta.
+    QStringList playlistRevisionEntries( const QString& revision, bool* found = 0 );
+    void cachePlaylistRevisionEntries( const QString& revision, const QStringList& entries );
+
     static bool scorepairSorter( const QPair<int,float>& left, const QPair<int,float>& right )
     {
         return left.second > right.second;
@@ -80,12 +98,18 @@ public:
 
     void loadIndex();
 
+    /// Copies committed pages from the write-ahead log into the database. Returns true if the log was fully checkpointed.
+    bool checkpoint();
+    /// Gives back up to pages free pages to the file system. Returns true if more are left.
+    bool vacuumIncrementally( int pages );
+
 signals:
     void indexReady();
 
 private:
     DatabaseImpl( const QString& dbname, bool internal );
     void setFuzzyIndex( FuzzyIndex* fi ) { m_fuzzyIndex = fi; }
+    void setCompletionIndex( const QSharedPointer< CompletionIndex >& ci ) { m_completionIndex = ci; }
     void setDatabaseID( const QString& dbid ) { m_dbid = dbid; }
 
     void init();
@@ -102,6 +126,8 @@ private:
 
     QString m_dbid;
     FuzzyIndex* m_fuzzyIndex;
+    QSharedPointer< CompletionIndex > m_completionIndex;
+    QCache< QString, QStringList > m_revisionEntries; // every thread has its own DatabaseImpl, so no locking
     mutable QMutex m_mutex;
 };
 
@@ -0,0 +1,285 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DatabaseStats.h"
+
+// how many slow statements and their plans we hold on to
+#define SLOW_QUERY_LOG 50
+
+
+DatabaseStats::Histogram::Histogram()
+    : m_count( 0 )
+    , m_total( 0 )
+    , m_max( 0 )
+{
+    for ( int i = 0; i < BucketCount; i++ )
+        m_buckets[i] = 0;
+}
+
+
+void
+DatabaseStats::Histogram::add( qint64 value )
+{
+    value = qMax( Q_INT64_C( 0 ), value );
+
+    int bucket = 0;
+    while ( bucket < BucketCount - 1 && value >= ( Q_INT64_C( 1 ) << bucket ) )
+        bucket++;
+
+    m_buckets[bucket]++;
+    m_count++;
+    m_total += value;
+    m_max = qMax( m_max, value );
+}
+
+
+qint64
+DatabaseStats::Histogram::percentile( int percent ) const
+{
+    if ( m_count == 0 )
+        return 0;
+
+    // upper bound of the bucket the percentile falls into, never more than we have actually seen
+    const qint64 rank = ( m_count * percent + 99 ) / 100;
+    qint64 seen = 0;
+    for ( int i = 0; i < BucketCount - 1; i++ )
+    {
+        seen += m_buckets[i];
+        if ( seen >= rank )
+            return qMin( ( Q_INT64_C( 1 ) << i ) - 1, m_max );
+    }
+
+    return m_max;
+}
+
+
+QVariantMap
+DatabaseStats::Histogram::toVariant() const
+{
+    QVariantMap m;
+    m.insert( "count", m_count );
+    m.insert( "total", m_total );
+    m.insert( "max", m_max );
+    m.insert( "mean", m_count > 0 ? (double)m_total / m_count : 0.0 );
+    m.insert( "p50", percentile( 50 ) );
+    m.insert( "p95", percentile( 95 ) );
+    m.insert( "p99", percentile( 99 ) );
+
+    // only the buckets that were hit, as [ upper bound, count ]
+    QVariantList buckets;
+    for ( int i = 0; i < BucketCount; i++ )
+    {
+        if ( m_buckets[i] == 0 )
+            continue;
+
+        QVariantList bucket;
+        bucket << ( i < BucketCount - 1 ? QVariant( Q_INT64_C( 1 ) << i ) : QVariant( "inf" ) ) << m_buckets[i];
+        buckets << QVariant( bucket );
+    }
+    m.insert( "buckets", buckets );
+
+    return m;
+}
+
+
+DatabaseStats::DatabaseStats()
+    : m_readers( 0 )
+    , m_since( QDateTime::currentDateTimeUtc() )
+    , m_transactions( 0 )
+    , m_transactionCommands( 0 )
+    , m_deferredFlushes( 0 )
+    , m_deferredCommands( 0 )
+{
+}
+
+
+QString
+DatabaseStats::registerWorker( bool mutates )
+{
+    QMutexLocker lock( &m_mutex );
+
+    const QString name = mutates ? QString( "rw" ) : QString( "ro%1" ).arg( ++m_readers );
+
+    WorkerStats stats;
+    stats.since = QDateTime::currentDateTimeUtc();
+    stats.busy = 0;
+    stats.commands = 0;
+    m_workers.insert( name, stats );
+
+    return name;
+}
+
+
+void
+DatabaseStats::recordWorkerBusy( const QString& worker, int msecs )
+{
+    QMutexLocker lock( &m_mutex );
+
+    QHash< QString, WorkerStats >::iterator it = m_workers.find( worker );
+    if ( it == m_workers.end() )
+        return;
+
+    it->busy += msecs;
+    it->commands++;
+}
+
+
+void
+DatabaseStats::recordCommand( const QString& command, int waitMsecs, int execMsecs, qint64 rowsChanged, qint64 rowsRead )
+{
+    QMutexLocker lock( &m_mutex );
+
+    CommandStats& stats = m_commands[ command ];
+    stats.wait.add( waitMsecs );
+    stats.exec.add( execMsecs );
+    if ( rowsChanged >= 0 )
+        stats.rowsChanged.add( rowsChanged );
+    stats.rowsRead.add( rowsRead );
+}
+
+
+void
+DatabaseStats::recordSlowQuery( const QString& sql, int msecs, const QStringList& plan )
+{
+    QMutexLocker lock( &m_mutex );
+
+    SlowQuery q;
+    q.sql = sql;
+    q.msecs = msecs;
+    q.plan = plan;
+    q.when = QDateTime::currentDateTimeUtc();
+
+    m_slowQueries << q;
+    while ( m_slowQueries.count() > SLOW_QUERY_LOG )
+        m_slowQueries.removeFirst();
+}
+
+
+void
+DatabaseStats::recordTransaction( int commands )
+{
+    QMutexLocker lock( &m_mutex );
+
+    m_transactions++;
+    m_transactionCommands += commands;
+}
+
+
+void
+DatabaseStats::recordDeferredFlush( int commands )
+{
+    QMutexLocker lock( &m_mutex );
+
+    m_deferredFlushes++;
+    m_deferredCommands += commands;
+}
+
+
+void
+DatabaseStats::reset()
+{
+    QMutexLocker lock( &m_mutex );
+
+    m_commands.clear();
+    m_slowQueries.clear();
+
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    m_since = now;
+    m_transactions = 0;
+    m_transactionCommands = 0;
+    m_deferredFlushes = 0;
+    m_deferredCommands = 0;
+
+    QHash< QString, WorkerStats >::iterator it = m_workers.begin();
+    for ( ; it != m_workers.end(); ++it )
+    {
+        it->since = now;
+        it->busy = 0;
+        it->commands = 0;
+    }
+}
+
+
+QVariantMap
+DatabaseStats::toVariant() const
+{
+    QMutexLocker lock( &m_mutex );
+
+    QVariantMap commands;
+    QHash< QString, CommandStats >::const_iterator cit = m_commands.constBegin();
+    for ( ; cit != m_commands.constEnd(); ++cit )
+    {
+        QVariantMap m;
+        m.insert( "wait_ms", cit->wait.toVariant() );
+        m.insert( "exec_ms", cit->exec.toVariant() );
+        m.insert( "rows_changed", cit->rowsChanged.toVariant() );
+        m.insert( "rows_read", cit->rowsRead.toVariant() );
+        commands.insert( cit.key(), m );
+    }
+
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    QVariantMap workers;
+    QHash< QString, WorkerStats >::const_iterator wit = m_workers.constBegin();
+    for ( ; wit != m_workers.constEnd(); ++wit )
+    {
+        const qint64 elapsed = qMax( Q_INT64_C( 1 ), wit->since.msecsTo( now ) );
+
+        QVariantMap m;
+        m.insert( "commands", wit->commands );
+        m.insert( "busy_ms", wit->busy );
+        m.insert( "elapsed_ms", elapsed );
+        m.insert( "utilization", qMin( 1.0, (double)wit->busy / elapsed ) );
+        workers.insert( wit.key(), m );
+    }
+
+    QVariantList slowQueries;
+    foreach ( const SlowQuery& q, m_slowQueries )
+    {
+        QVariantMap m;
+        m.insert( "sql", q.sql );
+        m.insert( "ms", q.msecs );
+        m.insert( "plan", q.plan );
+        m.insert( "timestamp", q.when.toTime_t() );
+        slowQueries << m;
+    }
+
+    // commits saved over running every mutating command in a transaction of its own
+    const qint64 elapsed = qMax( Q_INT64_C( 1 ), m_since.msecsTo( now ) );
+    const qint64 saved = m_transactionCommands - m_transactions;
+
+    QVariantMap transactions;
+    transactions.insert( "count", m_transactions );
+    transactions.insert( "commands", m_transactionCommands );
+    transactions.insert( "saved", saved );
+    transactions.insert( "saved_per_sec", (double)saved * 1000 / elapsed );
+    transactions.insert( "elapsed_ms", elapsed );
+
+    QVariantMap deferred;
+    deferred.insert( "flushes", m_deferredFlushes );
+    deferred.insert( "commands", m_deferredCommands );
+
+    QVariantMap m;
+    m.insert( "commands", commands );
+    m.insert( "workers", workers );
+    m.insert( "slow_queries", slowQueries );
+    m.insert( "transactions", transactions );
+    m.insert( "deferred", deferred );
+
+    return m;
+}
+
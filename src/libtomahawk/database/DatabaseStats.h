@@ -0,0 +1,120 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASESTATS_H
+#define DATABASESTATS_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QStringList>
+#include <QVariant>
+
+#include "DllMacro.h"
+
+/**
+ * Profiling data collected by the database workers while they run commands.
+ *
+ * For every commandname() it keeps histograms of the time spent waiting in the
+ * queue, the time spent executing, the number of rows its queries returned and,
+ * for commands that mutate, the number of rows they changed as counted by SQLite.
+ * Each worker reports how long it was busy, and TomahawkSqlQuery hands in the
+ * query plan of statements that took longer than its slow query threshold. The RW
+ * worker also counts its transactions, to show how many commits grouping and
+ * deferring commands saved.
+ *
+ * All methods are thread-safe, toVariant() returns a snapshot ready to be
+ * serialized to JSON.
+ */
+class DLLEXPORT DatabaseStats
+{
+public:
+    DatabaseStats();
+
+    /// Returns the name the calling worker should report its busy time under.
+    QString registerWorker( bool mutates );
+    void recordWorkerBusy( const QString& worker, int msecs );
+
+    /// rowsChanged is negative for commands that don't write.
+    void recordCommand( const QString& command, int waitMsecs, int execMsecs, qint64 rowsChanged, qint64 rowsRead );
+    void recordSlowQuery( const QString& sql, int msecs, const QStringList& plan );
+
+    void recordTransaction( int commands );
+    void recordDeferredFlush( int commands );
+
+    void reset();
+    QVariantMap toVariant() const;
+
+private:
+    class Histogram
+    {
+    public:
+        Histogram();
+
+        void add( qint64 value );
+        QVariantMap toVariant() const;
+
+    private:
+        enum { BucketCount = 24 };
+
+        qint64 percentile( int percent ) const;
+
+        qint64 m_buckets[BucketCount]; // bucket i counts values below 2^i, the last one everything above
+        qint64 m_count;
+        qint64 m_total;
+        qint64 m_max;
+    };
+
+    struct CommandStats
+    {
+        Histogram wait;
+        Histogram exec;
+        Histogram rowsChanged;
+        Histogram rowsRead;
+    };
+
+    struct WorkerStats
+    {
+        QDateTime since;
+        qint64 busy;
+        qint64 commands;
+    };
+
+    struct SlowQuery
+    {
+        QString sql;
+        int msecs;
+        QStringList plan;
+        QDateTime when;
+    };
+
+    mutable QMutex m_mutex;
+    QHash< QString, CommandStats > m_commands;
+    QHash< QString, WorkerStats > m_workers;
+    QList< SlowQuery > m_slowQueries;
+    unsigned int m_readers;
+
+    QDateTime m_since;
+    qint64 m_transactions;
+    qint64 m_transactionCommands;
+    qint64 m_deferredFlushes;
+    qint64 m_deferredCommands;
+};
+
+#endif // DATABASESTATS_H
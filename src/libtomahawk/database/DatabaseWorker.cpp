@@ -27,18 +27,32 @@
 #include "Database.h"
 #include "DatabaseImpl.h"
 #include "DatabaseCommandLoggable.h"
+#include "DatabaseCommandQueue.h"
+#include "DatabaseStats.h"
 #include "TomahawkSqlQuery.h"
 #include "utils/Logger.h"
 
-#ifndef QT_NO_DEBUG
-    //#define DEBUG_TIMING TRUE
-#endif
+// the RW worker checkpoints the WAL after this many commits even when it never goes idle
+#define CHECKPOINT_COMMITS 250
+#define IDLE_TIMEOUT 5000
+#define VACUUM_PAGES 256
 
 
-DatabaseWorkerThread::DatabaseWorkerThread( Database* db, bool mutates )
+// rows changed on this connection so far, counted by SQLite for every statement a command runs
+static qint64
+totalChanges( DatabaseImpl* impl )
+{
+    TomahawkSqlQuery query = impl->newquery();
+    query.exec( "SELECT total_changes()" );
+    return query.next() ? query.value( 0 ).toLongLong() : 0;
+}
+
+
+DatabaseWorkerThread::DatabaseWorkerThread( Database* db, bool mutates, DatabaseCommandQueue* queue )
     : QThread()
     , m_db( db )
     , m_mutates( mutates )
+    , m_queue( queue )
 {
 }
 
@@ -47,7 +61,7 @@ void
 DatabaseWorkerThread::run()
 {
     tDebug() << Q_FUNC_INFO << "DatabaseWorkerThread starting...";
-    m_worker = QPointer< DatabaseWorker >( new DatabaseWorker( m_db, m_mutates ) );
+    m_worker = QPointer< DatabaseWorker >( new DatabaseWorker( m_db, m_mutates, m_queue ) );
     exec();
     tDebug() << Q_FUNC_INFO << "DatabaseWorkerThread finishing...";
     if ( m_worker )
@@ -67,13 +81,25 @@ DatabaseWorkerThread::worker() const
 }
 
 
-DatabaseWorker::DatabaseWorker( Database* db, bool mutates )
+DatabaseWorker::DatabaseWorker( Database* db, bool mutates, DatabaseCommandQueue* queue )
     : QObject()
     , m_db( db )
     , m_outstanding( 0 )
+    , m_queue( queue )
+    , m_mutates( mutates )
+    , m_commitsSinceCheckpoint( 0 )
 {
-    Q_UNUSED( mutates );
+    m_statsName = db->stats()->registerWorker( mutates );
+
+    m_idleTimer.setSingleShot( true );
+    m_idleTimer.setInterval( IDLE_TIMEOUT );
+    connect( &m_idleTimer, SIGNAL( timeout() ), SLOT( onIdle() ) );
+
     tDebug() << Q_FUNC_INFO << "New db connection with name:" << Database::instance()->impl()->database().connectionName() << "on thread" << this->thread();
+
+    // picks up whatever was queued before this worker existed, or parks it
+    if ( m_queue )
+        QTimer::singleShot( 0, this, SLOT( doWork() ) );
 }
 
 
@@ -81,6 +107,9 @@ DatabaseWorker::~DatabaseWorker()
 {
     tDebug() << Q_FUNC_INFO << m_outstanding;
 
+    if ( m_queue )
+        m_queue->removeWorker( this );
+
     if ( m_outstanding )
     {
         foreach ( const QSharedPointer<DatabaseCommand>& cmd, m_commands )
@@ -91,6 +120,22 @@ DatabaseWorker::~DatabaseWorker()
 }
 
 
+bool
+DatabaseWorker::busy() const
+{
+    QMutexLocker lock( &m_mut );
+    return m_outstanding > 0;
+}
+
+
+unsigned int
+DatabaseWorker::outstandingJobs() const
+{
+    QMutexLocker lock( &m_mut );
+    return m_outstanding;
+}
+
+
 void
 DatabaseWorker::enqueue( const QList< QSharedPointer<DatabaseCommand> >& cmds )
 {
@@ -126,18 +171,24 @@ DatabaseWorker::doWork()
 
      */
 
-#ifdef DEBUG_TIMING
-    QTime timer;
-    timer.start();
-#endif
-
     QList< QSharedPointer<DatabaseCommand> > cmdGroup;
     QSharedPointer<DatabaseCommand> cmd;
+    if ( m_queue )
+    {
+        cmd = m_queue->take( this );
+        if ( !cmd )
+            return; // parked until the next command is enqueued
+    }
+    else
     {
         QMutexLocker lock( &m_mut );
         cmd = m_commands.takeFirst();
     }
 
+    QTime timer;
+    timer.start();
+    DatabaseStats* stats = m_db->stats();
+
     DatabaseImpl* impl = Database::instance()->impl();
     if ( cmd->doesMutates() )
     {
@@ -154,8 +205,19 @@ DatabaseWorker::doWork()
             while ( !finished )
             {
                 completed++;
+
+                QTime execTimer;
+                execTimer.start();
+                const int waited = cmd->queueTime();
+                const qint64 changesBefore = cmd->doesMutates() ? totalChanges( impl ) : 0;
+                const qint64 readBefore = TomahawkSqlQuery::rowsRead();
+
                 cmd->_exec( impl ); // runs actual SQL stuff
 
+                stats->recordCommand( cmd->commandname(), waited, execTimer.elapsed(),
+                                      cmd->doesMutates() ? totalChanges( impl ) - changesBefore : -1,
+                                      TomahawkSqlQuery::rowsRead() - readBefore );
+
                 if ( cmd->loggable() )
                 {
                     // We only save our own ops to the oplog, since incoming ops from peers
@@ -215,19 +277,18 @@ DatabaseWorker::doWork()
                     tDebug() << "FAILED TO COMMIT TRANSACTION*";
                     throw "commit failed";
                 }
-            }
 
-#ifdef DEBUG_TIMING
-            uint duration = timer.elapsed();
-            tDebug() << "DBCmd Duration:" << duration << "ms, now running postcommit for" << cmd->commandname();
-#endif
+                stats->recordTransaction( cmdGroup.count() );
+
+                if ( ++m_commitsSinceCheckpoint >= CHECKPOINT_COMMITS )
+                {
+                    impl->checkpoint();
+                    m_commitsSinceCheckpoint = 0;
+                }
+            }
 
             foreach ( QSharedPointer<DatabaseCommand> c, cmdGroup )
                 c->postCommit();
-
-#ifdef DEBUG_TIMING
-            tDebug() << "Post commit finished in" << timer.elapsed() - duration << "ms for" << cmd->commandname();
-#endif
         }
     }
     catch ( const char * msg )
@@ -258,10 +319,51 @@ DatabaseWorker::doWork()
     foreach ( QSharedPointer<DatabaseCommand> c, cmdGroup )
         c->emitFinished();
 
+    stats->recordWorkerBusy( m_statsName, timer.elapsed() );
+
+    if ( m_queue )
+    {
+        QTimer::singleShot( 0, this, SLOT( doWork() ) );
+        return;
+    }
+
     QMutexLocker lock( &m_mut );
     m_outstanding -= completed;
     if ( m_outstanding > 0 )
+    {
         QTimer::singleShot( 0, this, SLOT( doWork() ) );
+        return;
+    }
+
+    if ( m_mutates )
+        m_idleTimer.start();
+    lock.unlock();
+
+    emit drained();
+}
+
+
+void
+DatabaseWorker::onIdle()
+{
+    {
+        QMutexLocker lock( &m_mut );
+        if ( m_outstanding > 0 )
+            return; // doWork() restarts the timer once the queue is drained
+    }
+
+    DatabaseImpl* impl = Database::instance()->impl();
+
+    // vacuum in small steps so queued commands don't wait behind it
+    if ( impl->vacuumIncrementally( VACUUM_PAGES ) )
+    {
+        m_commitsSinceCheckpoint++;
+        QTimer::singleShot( 0, this, SLOT( onIdle() ) );
+    }
+    else if ( m_commitsSinceCheckpoint > 0 && impl->checkpoint() )
+    {
+        m_commitsSinceCheckpoint = 0;
+    }
 }
 
 
@@ -24,6 +24,7 @@
 #include <QMutex>
 #include <QList>
 #include <QPointer>
+#include <QTimer>
 
 #include <qjson/parser.h>
 #include <qjson/serializer.h>
@@ -33,17 +34,23 @@
 
 class Database;
 class DatabaseCommandLoggable;
+class DatabaseCommandQueue;
 
 class DatabaseWorker : public QObject
 {
 Q_OBJECT
 
 public:
-    DatabaseWorker( Database* db, bool mutates );
+    /// Read-only workers take their commands from queue, the RW worker has a FIFO queue of its own.
+    DatabaseWorker( Database* db, bool mutates, DatabaseCommandQueue* queue = 0 );
     ~DatabaseWorker();
 
-    bool busy() const { return m_outstanding > 0; }
-    unsigned int outstandingJobs() const { return m_outstanding; }
+    bool busy() const;
+    unsigned int outstandingJobs() const;
+
+signals:
+    /// Emitted by the RW worker once everything enqueued so far has run.
+    void drained();
 
 public slots:
     void enqueue( const QSharedPointer<DatabaseCommand>& );
@@ -51,14 +58,22 @@ public slots:
 
 private slots:
     void doWork();
+    void onIdle();
 
 private:
     void logOp( DatabaseCommandLoggable* command );
 
-    QMutex m_mut;
+    mutable QMutex m_mut;
     Database* m_db;
     QList< QSharedPointer<DatabaseCommand> > m_commands;
     int m_outstanding;
+    DatabaseCommandQueue* m_queue;
+    QString m_statsName;
+
+    // only used by the RW worker, which owns checkpointing and vacuuming
+    bool m_mutates;
+    unsigned int m_commitsSinceCheckpoint;
+    QTimer m_idleTimer;
 
     QJson::Serializer m_serializer;
 };
@@ -68,7 +83,7 @@ class DatabaseWorkerThread : public QThread
 Q_OBJECT
 
 public:
-    DatabaseWorkerThread( Database* db, bool mutates );
+    DatabaseWorkerThread( Database* db, bool mutates, DatabaseCommandQueue* queue = 0 );
     ~DatabaseWorkerThread();
 
     QPointer< DatabaseWorker > worker() const;
@@ -80,6 +95,7 @@ private:
     QPointer< DatabaseWorker > m_worker;
     Database* m_db;
     bool m_mutates;
+    DatabaseCommandQueue* m_queue;
 };
 
 #endif // DATABASEWORKER_H
@@ -0,0 +1,156 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FileBatch.h"
+
+
+void
+FileBatch::reserve( int size )
+{
+    urls.reserve( size );
+    mtimes.reserve( size );
+    sizes.reserve( size );
+    hashes.reserve( size );
+    mimetypes.reserve( size );
+    durations.reserve( size );
+    bitrates.reserve( size );
+    artists.reserve( size );
+    albums.reserve( size );
+    tracks.reserve( size );
+    albumpos.reserve( size );
+    years.reserve( size );
+    albumartists.reserve( size );
+    composers.reserve( size );
+    discnumbers.reserve( size );
+}
+
+
+void
+FileBatch::clear()
+{
+    // QVector::clear() drops the reserved capacity, resize( 0 ) keeps it
+    urls.resize( 0 );
+    mtimes.resize( 0 );
+    sizes.resize( 0 );
+    hashes.resize( 0 );
+    mimetypes.resize( 0 );
+    durations.resize( 0 );
+    bitrates.resize( 0 );
+    artists.resize( 0 );
+    albums.resize( 0 );
+    tracks.resize( 0 );
+    albumpos.resize( 0 );
+    years.resize( 0 );
+    albumartists.resize( 0 );
+    composers.resize( 0 );
+    discnumbers.resize( 0 );
+    fileIds.resize( 0 );
+}
+
+
+void
+FileBatch::append( const QString& url, uint mtime, uint size, const QString& hash, const QString& mimetype,
+                   uint duration, uint bitrate, const QString& artist, const QString& album, const QString& track,
+                   uint albumpos_, int year, const QString& albumartist, const QString& composer, uint discnumber )
+{
+    urls << url;
+    mtimes << mtime;
+    sizes << size;
+    hashes << hash;
+    mimetypes << mimetype;
+    durations << duration;
+    bitrates << bitrate;
+    artists << artist;
+    albums << album;
+    tracks << track;
+    albumpos << albumpos_;
+    years << year;
+    albumartists << albumartist;
+    composers << composer;
+    discnumbers << discnumber;
+}
+
+
+QVariantMap
+FileBatch::toVariantMap( int i ) const
+{
+    QVariantMap m;
+    m["url"]          = urls.at( i );
+    m["mtime"]        = mtimes.at( i );
+    m["size"]         = sizes.at( i );
+    m["hash"]         = hashes.at( i );
+    m["mimetype"]     = mimetypes.at( i );
+    m["duration"]     = durations.at( i );
+    m["bitrate"]      = bitrates.at( i );
+    m["artist"]       = artists.at( i );
+    m["album"]        = albums.at( i );
+    m["track"]        = tracks.at( i );
+    m["albumpos"]     = albumpos.at( i );
+    m["year"]         = years.at( i );
+    m["albumartist"]  = albumartists.at( i );
+    m["composer"]     = composers.at( i );
+    m["discnumber"]   = discnumbers.at( i );
+
+    if ( i < fileIds.count() )
+        m["id"] = fileIds.at( i );
+
+    return m;
+}
+
+
+QVariantList
+FileBatch::toVariantList() const
+{
+    QVariantList list;
+    list.reserve( count() );
+
+    for ( int i = 0; i < count(); i++ )
+        list << toVariantMap( i );
+
+    return list;
+}
+
+
+FileBatch
+FileBatch::fromVariantList( const QVariantList& files )
+{
+    FileBatch batch;
+    batch.reserve( files.count() );
+
+    foreach ( const QVariant& v, files )
+    {
+        const QVariantMap m = v.toMap();
+        batch.append( m.value( "url" ).toString(),
+                      m.value( "mtime" ).toUInt(),
+                      m.value( "size" ).toUInt(),
+                      m.value( "hash" ).toString(),
+                      m.value( "mimetype" ).toString(),
+                      m.value( "duration" ).toUInt(),
+                      m.value( "bitrate" ).toUInt(),
+                      m.value( "artist" ).toString(),
+                      m.value( "album" ).toString(),
+                      m.value( "track" ).toString(),
+                      m.value( "albumpos" ).toUInt(),
+                      m.value( "year" ).toInt(),
+                      m.value( "albumartist" ).toString(),
+                      m.value( "composer" ).toString(),
+                      m.value( "discnumber" ).toUInt() );
+    }
+
+    return batch;
+}
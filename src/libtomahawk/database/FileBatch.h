@@ -0,0 +1,78 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILEBATCH_H
+#define FILEBATCH_H
+
+#include <QMetaType>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+#include "DllMacro.h"
+
+/**
+ * Columnar storage for a batch of scanned (or remotely announced) files.
+ *
+ * Every column holds one value per file, so a batch of n files costs a
+ * handful of vector allocations instead of n QVariantMaps with fifteen
+ * nodes each. The QVariant form is only built when it is needed for the
+ * oplog or the network (see toVariantList()).
+ */
+class DLLEXPORT FileBatch
+{
+public:
+    FileBatch() {}
+
+    int count() const { return urls.count(); }
+    bool isEmpty() const { return urls.isEmpty(); }
+
+    void reserve( int size );
+    void clear();
+
+    void append( const QString& url, uint mtime, uint size, const QString& hash, const QString& mimetype,
+                 uint duration, uint bitrate, const QString& artist, const QString& album, const QString& track,
+                 uint albumpos, int year, const QString& albumartist, const QString& composer, uint discnumber );
+
+    QVariantMap toVariantMap( int i ) const;
+    QVariantList toVariantList() const;
+    static FileBatch fromVariantList( const QVariantList& files );
+
+    QVector< QString > urls;
+    QVector< uint > mtimes;
+    QVector< uint > sizes;
+    QVector< QString > hashes;
+    QVector< QString > mimetypes;
+    QVector< uint > durations;
+    QVector< uint > bitrates;
+    QVector< QString > artists;
+    QVector< QString > albums;
+    QVector< QString > tracks;
+    QVector< uint > albumpos;
+    QVector< int > years;
+    QVector< QString > albumartists;
+    QVector< QString > composers;
+    QVector< uint > discnumbers;
+
+    // filled in by DatabaseCommand_AddFiles once the rows have been inserted
+    QVector< uint > fileIds;
+};
+
+Q_DECLARE_METATYPE( FileBatch )
+
+#endif // FILEBATCH_H
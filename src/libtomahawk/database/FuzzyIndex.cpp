@@ -26,6 +26,8 @@
 
 #include "DatabaseImpl.h"
 #include "Database.h"
+#include "NGramIndex.h"
+#include "TomahawkSettings.h"
 #include "utils/TomahawkUtils.h"
 #include "utils/Logger.h"
 #include "Source.h"
@@ -39,12 +41,56 @@ using namespace lucene::queryParser;
 using namespace lucene::search;
 
 
+/// A reader and searcher over one committed generation of the index, closed when the last search lets go of it.
+class FuzzyIndex::Reader
+{
+public:
+    explicit Reader( IndexReader* reader )
+        : reader( reader )
+        , searcher( _CLNEW IndexSearcher( reader ) )
+    {
+    }
+
+    ~Reader()
+    {
+        try
+        {
+            searcher->close();
+            reader->close();
+        }
+        catch( CLuceneError& error )
+        {
+            tDebug() << "Caught CLucene error:" << error.what();
+        }
+
+        delete searcher;
+        delete reader;
+    }
+
+    IndexReader* reader;
+    IndexSearcher* searcher;
+};
+
+
 FuzzyIndex::FuzzyIndex( QObject* parent, bool wipe )
     : QObject( parent )
-    , m_luceneReader( 0 )
-    , m_luceneSearcher( 0 )
+    , m_analyzer( 0 )
+    , m_luceneDir( 0 )
+    , m_luceneWriter( 0 )
+    , m_indexing( false )
+    , m_ngramIndex( 0 )
 {
-    QString m_lucenePath = TomahawkUtils::appDataDir().absoluteFilePath( "tomahawk.lucene" );
+    if ( TomahawkSettings::instance()->searchIndexEngine() == "ngram" )
+    {
+        tDebug() << "Using n-gram search index.";
+        m_ngramIndex = new NGramIndex( TomahawkUtils::appDataDir().absoluteFilePath( "tomahawk.ngram" ) );
+
+        if ( wipe || !m_ngramIndex->load() )
+            wipeIndex();
+        return;
+    }
+
+    m_lucenePath = TomahawkUtils::appDataDir().absoluteFilePath( "tomahawk.lucene" );
     QByteArray path = m_lucenePath.toUtf8();
     const char* cPath = path.constData();
 
@@ -76,8 +122,8 @@ FuzzyIndex::FuzzyIndex( QObject* parent, bool wipe )
 
 FuzzyIndex::~FuzzyIndex()
 {
-    delete m_luceneSearcher;
-    delete m_luceneReader;
+    delete m_ngramIndex;
+    m_reader.clear();
     delete m_analyzer;
     delete m_luceneDir;
 }
@@ -87,8 +133,15 @@ bool
 FuzzyIndex::wipeIndex()
 {
     tLog( LOGVERBOSE ) << "Wiping fuzzy index...";
-    beginIndexing();
-    endIndexing();
+    if ( m_ngramIndex )
+    {
+        m_ngramIndex->wipe();
+    }
+    else
+    {
+        beginIndexing();
+        endIndexing();
+    }
 
     QTimer::singleShot( 0, this, SLOT( updateIndex() ) );
 
@@ -104,26 +157,51 @@ FuzzyIndex::updateIndex()
 }
 
 
+bool
+FuzzyIndex::canUpdateIncrementally() const
+{
+    return m_ngramIndex && m_ngramIndex->canUpdateIncrementally();
+}
+
+
+unsigned int
+FuzzyIndex::maxTrackId() const
+{
+    return m_ngramIndex ? m_ngramIndex->maxTrackId() : 0;
+}
+
+
+unsigned int
+FuzzyIndex::maxAlbumId() const
+{
+    return m_ngramIndex ? m_ngramIndex->maxAlbumId() : 0;
+}
+
+
 void
-FuzzyIndex::beginIndexing()
+FuzzyIndex::beginIndexing( bool incremental )
 {
+    if ( m_ngramIndex )
+    {
+        // the n-gram index keeps serving the old snapshot until the new one is complete
+        m_ngramIndex->beginIndexing( incremental );
+        return;
+    }
+
     m_mutex.lock();
 
+    {
+        // until endIndexing() the directory only holds a partial index, keep searching the old one
+        QMutexLocker lock( &m_readerMutex );
+        m_indexing = true;
+    }
+
     try
     {
         tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Starting indexing.";
-        if ( m_luceneReader != 0 )
-        {
-            tDebug( LOGVERBOSE ) << "Deleting old lucene stuff.";
-
-            m_luceneSearcher->close();
-            m_luceneReader->close();
-            delete m_luceneSearcher;
-            delete m_luceneReader;
-            m_luceneSearcher = 0;
-            m_luceneReader = 0;
-        }
 
+        // Readers keep working on the segments of their own generation. Lucene retries
+        // deleting old segment files that are still open once they're released.
         tDebug( LOGVERBOSE ) << "Creating new index writer.";
         m_luceneWriter = new IndexWriter( m_luceneDir, m_analyzer, true );
     }
@@ -138,11 +216,35 @@ FuzzyIndex::beginIndexing()
 void
 FuzzyIndex::endIndexing()
 {
-    m_luceneWriter->optimize();
-    m_luceneWriter->close();
+    if ( m_ngramIndex )
+    {
+        m_ngramIndex->endIndexing();
+        emit indexReady();
+        return;
+    }
+
+    QSharedPointer< Reader > reader;
+    try
+    {
+        m_luceneWriter->optimize();
+        m_luceneWriter->close();
+        reader = QSharedPointer< Reader >( new Reader( IndexReader::open( m_luceneDir ) ) );
+    }
+    catch( CLuceneError& error )
+    {
+        tDebug() << "Caught CLucene error:" << error.what();
+    }
+
     delete m_luceneWriter;
     m_luceneWriter = 0;
 
+    {
+        // searches still running on the previous reader finish on it, it's closed once they let go
+        QMutexLocker lock( &m_readerMutex );
+        m_reader = reader;
+        m_indexing = false;
+    }
+
     m_mutex.unlock();
     emit indexReady();
 }
@@ -151,19 +253,25 @@ FuzzyIndex::endIndexing()
 void
 FuzzyIndex::appendFields( const IndexData& data )
 {
+    if ( m_ngramIndex )
+    {
+        m_ngramIndex->appendFields( data );
+        return;
+    }
+
     try
     {
         Document doc;
 
         if ( !data.track.isEmpty() )
         {
-            doc.add( *( _CLNEW Field( _T( "fulltext" ), DatabaseImpl::sortname( QString( "%1 %2" ).arg( data.artist ).arg( data.track ) ).toStdWString().c_str(),
+            doc.add( *( _CLNEW Field( _T( "fulltext" ), DatabaseImpl::joinSortnames( data.artist, data.track ).toStdWString().c_str(),
                                       Field::STORE_NO | Field::INDEX_UNTOKENIZED ) ) );
 
-            doc.add( *( _CLNEW Field( _T( "track" ), DatabaseImpl::sortname( data.track ).toStdWString().c_str(),
+            doc.add( *( _CLNEW Field( _T( "track" ), data.track.toStdWString().c_str(),
                                       Field::STORE_NO | Field::INDEX_UNTOKENIZED ) ) );
 
-            doc.add( *( _CLNEW Field( _T( "artist" ), DatabaseImpl::sortname( data.artist ).toStdWString().c_str(),
+            doc.add( *( _CLNEW Field( _T( "artist" ), data.artist.toStdWString().c_str(),
                                       Field::STORE_NO | Field::INDEX_UNTOKENIZED ) ) );
 
             doc.add( *( _CLNEW Field( _T( "artistid" ), QString::number( data.artistId ).toStdWString().c_str(),
@@ -174,11 +282,20 @@ FuzzyIndex::appendFields( const IndexData& data )
         }
         else if ( !data.album.isEmpty() )
         {
-            doc.add( *( _CLNEW Field( _T( "album" ), DatabaseImpl::sortname( data.album ).toStdWString().c_str(),
+            doc.add( *( _CLNEW Field( _T( "album" ), data.album.toStdWString().c_str(),
                                       Field::STORE_NO | Field::INDEX_UNTOKENIZED ) ) );
 
             doc.add( *( _CLNEW Field( _T( "albumid" ), QString::number( data.id ).toStdWString().c_str(),
                                       Field::STORE_YES | Field::INDEX_NO ) ) );
+
+            doc.add( *( _CLNEW Field( _T( "albumname" ), data.albumName.toStdWString().c_str(),
+                                      Field::STORE_YES | Field::INDEX_NO ) ) );
+
+            doc.add( *( _CLNEW Field( _T( "artistid" ), QString::number( data.artistId ).toStdWString().c_str(),
+                                      Field::STORE_YES | Field::INDEX_NO ) ) );
+
+            doc.add( *( _CLNEW Field( _T( "artistname" ), data.artistName.toStdWString().c_str(),
+                                      Field::STORE_YES | Field::INDEX_NO ) ) );
         }
         else
             return;
@@ -197,29 +314,49 @@ FuzzyIndex::appendFields( const IndexData& data )
 void
 FuzzyIndex::loadLuceneIndex()
 {
+    // delta segments aren't persisted, catch up on whatever was added since the last rebuild
+    if ( canUpdateIncrementally() )
+    {
+        DatabaseCommand* cmd = new DatabaseCommand_UpdateSearchIndex( true );
+        Database::instance()->enqueue( QSharedPointer<DatabaseCommand>( cmd ) );
+    }
+
     emit indexReady();
 }
 
 
+QSharedPointer< FuzzyIndex::Reader >
+FuzzyIndex::reader()
+{
+    QMutexLocker lock( &m_readerMutex );
+
+    if ( m_reader.isNull() && !m_indexing )
+    {
+        if ( !IndexReader::indexExists( m_luceneDir ) )
+        {
+            tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "index didn't exist.";
+            return m_reader;
+        }
+
+        m_reader = QSharedPointer< Reader >( new Reader( IndexReader::open( m_luceneDir ) ) );
+    }
+
+    return m_reader;
+}
+
+
 QMap< int, float >
-FuzzyIndex::search( const Tomahawk::query_ptr& query )
+FuzzyIndex::search( const Tomahawk::query_ptr& query, int limit )
 {
-    QMutexLocker lock( &m_mutex );
+    if ( m_ngramIndex )
+        return m_ngramIndex->search( query, limit );
 
     QMap< int, float > resultsmap;
     try
     {
-        if ( !m_luceneReader )
-        {
-            if ( !IndexReader::indexExists( TomahawkUtils::appDataDir().absoluteFilePath( "tomahawk.lucene" ).toStdString().c_str() ) )
-            {
-                tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "index didn't exist.";
-                return resultsmap;
-            }
-
-            m_luceneReader = IndexReader::open( m_luceneDir );
-            m_luceneSearcher = _CLNEW IndexSearcher( m_luceneReader );
-        }
+        QSharedPointer< Reader > r = reader();
+        if ( r.isNull() )
+            return resultsmap;
 
         float minScore;
         const TCHAR** fields = 0;
@@ -261,7 +398,7 @@ FuzzyIndex::search( const Tomahawk::query_ptr& query )
             minScore = 0.00;
         }
 
-        Hits* hits = m_luceneSearcher->search( qry );
+        Hits* hits = r->searcher->search( qry );
         for ( uint i = 0; i < hits->length(); i++ )
         {
             Document* d = &hits->doc( i );
@@ -291,32 +428,25 @@ FuzzyIndex::search( const Tomahawk::query_ptr& query )
 
 
 QMap< int, float >
-FuzzyIndex::searchAlbum( const Tomahawk::query_ptr& query )
+FuzzyIndex::searchAlbum( const Tomahawk::query_ptr& query, int limit, QHash< int, IndexData >* info )
 {
     Q_ASSERT( query->isFullTextQuery() );
 
-    QMutexLocker lock( &m_mutex );
+    if ( m_ngramIndex )
+        return m_ngramIndex->searchAlbum( query, limit, info );
 
     QMap< int, float > resultsmap;
     try
     {
-        if ( !m_luceneReader )
-        {
-            if ( !IndexReader::indexExists( TomahawkUtils::appDataDir().absoluteFilePath( "tomahawk.lucene" ).toStdString().c_str() ) )
-            {
-                tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "index didn't exist.";
-                return resultsmap;
-            }
-
-            m_luceneReader = IndexReader::open( m_luceneDir );
-            m_luceneSearcher = _CLNEW IndexSearcher( m_luceneReader );
-        }
+        QSharedPointer< Reader > r = reader();
+        if ( r.isNull() )
+            return resultsmap;
 
         QueryParser parser( _T( "album" ), m_analyzer );
         QString escapedName = QString::fromWCharArray( parser.escape( DatabaseImpl::sortname( query->fullTextQuery() ).toStdWString().c_str() ) );
 
         Query* qry = _CLNEW FuzzyQuery( _CLNEW Term( _T( "album" ), escapedName.toStdWString().c_str() ) );
-        Hits* hits = m_luceneSearcher->search( qry );
+        Hits* hits = r->searcher->search( qry );
         for ( uint i = 0; i < hits->length(); i++ )
         {
             Document* d = &hits->doc( i );
@@ -327,6 +457,20 @@ FuzzyIndex::searchAlbum( const Tomahawk::query_ptr& query )
             if ( score > 0.30 )
             {
                 resultsmap.insert( id, score );
+
+                // indexes built by older versions didn't store these
+                const TCHAR* albumName = d->get( _T( "albumname" ) );
+                const TCHAR* artistId = d->get( _T( "artistid" ) );
+                const TCHAR* artistName = d->get( _T( "artistname" ) );
+                if ( info && albumName && artistId && artistName )
+                {
+                    IndexData data;
+                    data.id = id;
+                    data.artistId = QString::fromWCharArray( artistId ).toUInt();
+                    data.albumName = QString::fromWCharArray( albumName );
+                    data.artistName = QString::fromWCharArray( artistName );
+                    info->insert( id, data );
+                }
 //                tDebug() << "Index hit:" << id << score;
             }
         }
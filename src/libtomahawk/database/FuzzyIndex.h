@@ -24,6 +24,7 @@
 #include <QHash>
 #include <QString>
 #include <QMutex>
+#include <QSharedPointer>
 
 #include "Query.h"
 #include "DatabaseCommand_UpdateSearchIndex.h"
@@ -50,6 +51,7 @@ namespace lucene
 }
 
 class DatabaseImpl;
+class NGramIndex;
 
 class FuzzyIndex : public QObject
 {
@@ -59,32 +61,48 @@ public:
     explicit FuzzyIndex( QObject* parent, bool wipe = false );
     ~FuzzyIndex();
 
-    void beginIndexing();
+    void beginIndexing( bool incremental = false );
     void endIndexing();
     void appendFields( const IndexData& data );
 
+    /// Only the n-gram engine can add rows to an existing index, Lucene always rebuilds.
+    bool canUpdateIncrementally() const;
+    unsigned int maxTrackId() const;
+    unsigned int maxAlbumId() const;
+
 signals:
     void indexReady();
 
 public slots:
     void loadLuceneIndex();
 
-    QMap< int, float > search( const Tomahawk::query_ptr& query );
-    QMap< int, float > searchAlbum( const Tomahawk::query_ptr& query );
+    QMap< int, float > search( const Tomahawk::query_ptr& query, int limit = 0 );
+    /// If info is given, it's filled with the artist and display names the index stored for the hits.
+    QMap< int, float > searchAlbum( const Tomahawk::query_ptr& query, int limit = 0, QHash< int, IndexData >* info = 0 );
 
 private slots:
     void updateIndex();
     bool wipeIndex();
 
 private:
-    QMutex m_mutex;
+    class Reader;
+
+    QSharedPointer< Reader > reader();
+
+    QMutex m_mutex; // held by the writer from beginIndexing() until endIndexing()
     QString m_lucenePath;
 
     lucene::analysis::SimpleAnalyzer* m_analyzer;
     lucene::store::Directory* m_luceneDir;
-    lucene::index::IndexReader* m_luceneReader;
     lucene::index::IndexWriter* m_luceneWriter;
-    lucene::search::IndexSearcher* m_luceneSearcher;
+
+    // Searches share the reader of the last committed index, which is only swapped
+    // once the next one is complete, so they never wait for indexing.
+    QMutex m_readerMutex;
+    QSharedPointer< Reader > m_reader;
+    bool m_indexing;
+
+    NGramIndex* m_ngramIndex; // set if the n-gram engine was selected instead of Lucene
 };
 
 #endif // FUZZYINDEX_H
@@ -0,0 +1,816 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "NGramIndex.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QTime>
+
+#include "DatabaseImpl.h"
+#include "utils/Logger.h"
+
+#include <algorithm>
+#include <string.h>
+
+#define SEGMENT_MAGIC 0x474e4854 // "THNG"
+#define SEGMENT_VERSION 3
+
+// segments are mapped as they are, so they only work on a machine with the same byte order and struct layout
+#define SEGMENT_BYTE_ORDER 0x01020304
+#define SEGMENT_LAYOUT (quint32)( ( sizeof( SegmentHeader ) << 16 ) | ( sizeof( TrackDoc ) << 8 ) | sizeof( AlbumDoc ) )
+
+// deltas are only kept in memory, so after this many we'd rather rebuild and persist
+#define MAX_SEGMENTS 8
+
+#define MIN_SIMILARITY 0.4f
+#define MIN_ALBUM_SIMILARITY 0.3f
+
+// padding around names, so short names and word starts still produce grams
+#define GRAM_BEGIN 0x0002
+#define GRAM_END 0x0003
+
+namespace
+{
+    enum Field
+    {
+        TrackField = 0,
+        ArtistField = 1,
+        FullTextField = 2,
+        AlbumField = 3,
+        FieldCount = 4
+    };
+
+    struct SegmentHeader
+    {
+        quint32 magic;
+        quint32 version;
+        quint32 byteOrder;  // SEGMENT_BYTE_ORDER as the writer stored it
+        quint32 layout;     // SEGMENT_LAYOUT of the writer
+        quint32 trackCount;
+        quint32 albumCount;
+        quint32 maxTrackId;
+        quint32 maxAlbumId;
+        quint32 termCount[FieldCount];
+        quint32 fieldOffset[FieldCount];
+        quint32 stringsOffset;
+        quint32 stringsLength; // in UTF-16 code units
+    };
+
+    struct TrackDoc
+    {
+        quint32 id;
+        quint32 artistId;
+        quint16 grams[3]; // distinct grams per field: track, artist, fulltext
+        quint16 reserved;
+    };
+
+    struct AlbumDoc
+    {
+        quint32 id;
+        quint32 artistId;
+        quint32 nameOffset; // display names of album and artist, back to back in the string table
+        quint16 nameLength;
+        quint16 artistLength;
+        quint16 grams;
+        quint16 reserved;
+    };
+
+    struct Hit
+    {
+        Hit() : id( 0 ), score( 0.0 ) {}
+        Hit( int i, float s ) : id( i ), score( s ) {}
+
+        int id;
+        float score;
+    };
+
+    bool
+    hitSorter( const Hit& left, const Hit& right )
+    {
+        if ( left.score == right.score )
+            return left.id < right.id;
+
+        return left.score > right.score;
+    }
+
+
+    quint32
+    align8( quint32 offset )
+    {
+        return ( offset + 7 ) & ~7;
+    }
+
+
+    /// Fills grams with the sorted, distinct trigrams of name and returns how many there are.
+    int
+    trigrams( const QString& name, QVector< quint64 >& grams )
+    {
+        grams.clear();
+        if ( name.isEmpty() )
+            return 0;
+
+        grams.reserve( name.length() + 1 );
+
+        quint64 first = GRAM_BEGIN;
+        quint64 second = GRAM_BEGIN;
+        const QChar* c = name.constData();
+        for ( int i = 0; i <= name.length(); i++ )
+        {
+            const quint64 third = ( i < name.length() ) ? c[i].unicode() : GRAM_END;
+            grams << ( ( first << 32 ) | ( second << 16 ) | third );
+
+            first = second;
+            second = third;
+        }
+
+        std::sort( grams.begin(), grams.end() );
+        grams.erase( std::unique( grams.begin(), grams.end() ), grams.end() );
+
+        return grams.count();
+    }
+
+
+    float
+    dice( int common, int queryGrams, int docGrams )
+    {
+        return 2.0f * common / float( queryGrams + docGrams );
+    }
+
+
+    QMap< int, float >
+    topHits( QVector< Hit >& hits, int limit )
+    {
+        QMap< int, float > resultsmap;
+
+        if ( limit <= 0 || limit > hits.count() )
+            limit = hits.count();
+        std::partial_sort( hits.begin(), hits.begin() + limit, hits.end(), hitSorter );
+
+        for ( int i = 0; i < limit; i++ )
+            resultsmap.insert( hits.at( i ).id, hits.at( i ).score );
+
+        return resultsmap;
+    }
+}
+
+
+/// One immutable piece of the index, either memory-mapped from disk or held in a buffer.
+class NGramIndex::Segment
+{
+public:
+    static QSharedPointer< Segment >
+    fromFile( const QString& path )
+    {
+        QSharedPointer< Segment > segment( new Segment );
+        segment->m_file.setFileName( path );
+        if ( !segment->m_file.open( QIODevice::ReadOnly ) )
+            return QSharedPointer< Segment >();
+
+        segment->m_map = segment->m_file.map( 0, segment->m_file.size() );
+        if ( !segment->m_map || !segment->attach( segment->m_map, segment->m_file.size() ) )
+        {
+            tLog() << "Invalid n-gram index segment:" << path;
+            return QSharedPointer< Segment >();
+        }
+
+        return segment;
+    }
+
+    static QSharedPointer< Segment >
+    fromData( const QByteArray& data )
+    {
+        QSharedPointer< Segment > segment( new Segment );
+        segment->m_data = data;
+        if ( !segment->attach( reinterpret_cast< const uchar* >( segment->m_data.constData() ), segment->m_data.size() ) )
+            return QSharedPointer< Segment >();
+
+        return segment;
+    }
+
+    ~Segment()
+    {
+        if ( m_map )
+            m_file.unmap( m_map );
+    }
+
+    quint32 trackCount() const { return m_header->trackCount; }
+    quint32 albumCount() const { return m_header->albumCount; }
+    quint32 maxTrackId() const { return m_header->maxTrackId; }
+    quint32 maxAlbumId() const { return m_header->maxAlbumId; }
+
+    const TrackDoc& track( quint32 doc ) const { return m_tracks[doc]; }
+    const AlbumDoc& album( quint32 doc ) const { return m_albums[doc]; }
+
+    QString
+    string( quint32 offset, quint16 length ) const
+    {
+        if ( offset + length > m_header->stringsLength )
+            return QString();
+
+        return QString( reinterpret_cast< const QChar* >( m_strings + offset ), length );
+    }
+
+    /// Counts, per document, how many of grams it shares in field. touched collects every document that shares at least one.
+    void
+    countMatches( Field field, const QVector< quint64 >& grams, QVector< quint16 >& counts, QVector< quint32 >& touched ) const
+    {
+        const Table& table = m_tables[field];
+        const quint32 docs = ( field == AlbumField ) ? albumCount() : trackCount();
+        const quint64* keysEnd = table.keys + table.count;
+
+        foreach ( quint64 gram, grams )
+        {
+            const quint64* key = std::lower_bound( table.keys, keysEnd, gram );
+            if ( key == keysEnd || *key != gram )
+                continue;
+
+            const quint32 term = key - table.keys;
+            const quint32 end = qMin( table.starts[term + 1], table.postingCount );
+            for ( quint32 i = table.starts[term]; i < end; i++ )
+            {
+                const quint32 doc = table.postings[i];
+                if ( doc >= docs )
+                    continue;
+
+                if ( !counts[doc]++ )
+                    touched << doc;
+            }
+        }
+    }
+
+private:
+    struct Table
+    {
+        Table() : keys( 0 ), starts( 0 ), postings( 0 ), count( 0 ), postingCount( 0 ) {}
+
+        const quint64* keys;
+        const quint32* starts;
+        const quint32* postings;
+        quint32 count;
+        quint32 postingCount;
+    };
+
+    Segment()
+        : m_map( 0 )
+        , m_header( 0 )
+        , m_tracks( 0 )
+        , m_albums( 0 )
+        , m_strings( 0 )
+    {
+    }
+
+    bool
+    attach( const uchar* data, qint64 size )
+    {
+        if ( size < (qint64)sizeof( SegmentHeader ) )
+            return false;
+
+        m_header = reinterpret_cast< const SegmentHeader* >( data );
+        if ( m_header->magic != SEGMENT_MAGIC || m_header->version != SEGMENT_VERSION ||
+             m_header->byteOrder != SEGMENT_BYTE_ORDER || m_header->layout != SEGMENT_LAYOUT )
+            return false;
+
+        const qint64 docsEnd = sizeof( SegmentHeader ) + (qint64)m_header->trackCount * sizeof( TrackDoc ) + (qint64)m_header->albumCount * sizeof( AlbumDoc );
+        if ( docsEnd > size )
+            return false;
+
+        m_tracks = reinterpret_cast< const TrackDoc* >( data + sizeof( SegmentHeader ) );
+        m_albums = reinterpret_cast< const AlbumDoc* >( data + sizeof( SegmentHeader ) + m_header->trackCount * sizeof( TrackDoc ) );
+
+        const qint64 stringsEnd = (qint64)m_header->stringsOffset + (qint64)m_header->stringsLength * sizeof( ushort );
+        if ( m_header->stringsOffset < docsEnd || m_header->stringsOffset % 2 || stringsEnd > size )
+            return false;
+        m_strings = reinterpret_cast< const ushort* >( data + m_header->stringsOffset );
+
+        for ( int f = 0; f < FieldCount; f++ )
+        {
+            const qint64 offset = m_header->fieldOffset[f];
+            const qint64 count = m_header->termCount[f];
+            const qint64 postingsOffset = offset + count * sizeof( quint64 ) + ( count + 1 ) * sizeof( quint32 );
+            if ( offset < stringsEnd || offset % 8 || postingsOffset > size )
+                return false;
+
+            Table& table = m_tables[f];
+            table.keys = reinterpret_cast< const quint64* >( data + offset );
+            table.starts = reinterpret_cast< const quint32* >( data + offset + count * sizeof( quint64 ) );
+            table.postings = reinterpret_cast< const quint32* >( data + postingsOffset );
+            table.count = count;
+            table.postingCount = table.starts[count];
+
+            if ( postingsOffset + (qint64)table.postingCount * sizeof( quint32 ) > size )
+                return false;
+        }
+
+        return true;
+    }
+
+    QFile m_file;
+    uchar* m_map;
+    QByteArray m_data;
+
+    const SegmentHeader* m_header;
+    const TrackDoc* m_tracks;
+    const AlbumDoc* m_albums;
+    const ushort* m_strings;
+    Table m_tables[FieldCount];
+};
+
+
+/// Collects documents and their posting lists and serializes them into a segment.
+class NGramIndex::Builder
+{
+public:
+    Builder()
+        : maxTrackId( 0 )
+        , maxAlbumId( 0 )
+    {
+    }
+
+    void
+    addTrack( const IndexData& data )
+    {
+        const quint32 doc = m_tracks.count();
+
+        TrackDoc track;
+        track.id = data.id;
+        track.artistId = data.artistId;
+        track.grams[TrackField] = addGrams( TrackField, DatabaseImpl::foldedname( data.track ), doc );
+        track.grams[ArtistField] = addGrams( ArtistField, DatabaseImpl::foldedname( data.artist ), doc );
+        track.grams[FullTextField] = addGrams( FullTextField, DatabaseImpl::foldedname( DatabaseImpl::joinSortnames( data.artist, data.track ) ), doc );
+        track.reserved = 0;
+
+        m_tracks << track;
+        maxTrackId = qMax( maxTrackId, data.id );
+    }
+
+    void
+    addAlbum( const IndexData& data )
+    {
+        const QString name = data.albumName.left( 0xffff );
+        const QString artist = data.artistName.left( 0xffff );
+
+        AlbumDoc album;
+        album.id = data.id;
+        album.artistId = data.artistId;
+        album.nameOffset = m_strings.count();
+        album.nameLength = name.length();
+        album.artistLength = artist.length();
+        album.grams = addGrams( AlbumField, DatabaseImpl::foldedname( data.album ), m_albums.count() );
+        album.reserved = 0;
+
+        m_strings.resize( album.nameOffset + name.length() + artist.length() );
+        memcpy( m_strings.data() + album.nameOffset, name.utf16(), name.length() * sizeof( ushort ) );
+        memcpy( m_strings.data() + album.nameOffset + name.length(), artist.utf16(), artist.length() * sizeof( ushort ) );
+
+        m_albums << album;
+        maxAlbumId = qMax( maxAlbumId, data.id );
+    }
+
+    bool isEmpty() const { return m_tracks.isEmpty() && m_albums.isEmpty(); }
+
+    QByteArray
+    serialize() const
+    {
+        SegmentHeader header;
+        memset( &header, 0, sizeof( header ) );
+        header.magic = SEGMENT_MAGIC;
+        header.version = SEGMENT_VERSION;
+        header.byteOrder = SEGMENT_BYTE_ORDER;
+        header.layout = SEGMENT_LAYOUT;
+        header.trackCount = m_tracks.count();
+        header.albumCount = m_albums.count();
+        header.maxTrackId = maxTrackId;
+        header.maxAlbumId = maxAlbumId;
+
+        header.stringsOffset = sizeof( SegmentHeader ) + m_tracks.count() * sizeof( TrackDoc ) + m_albums.count() * sizeof( AlbumDoc );
+        header.stringsLength = m_strings.count();
+
+        QList< quint64 > keys[FieldCount];
+        quint32 offset = align8( header.stringsOffset + m_strings.count() * sizeof( ushort ) );
+        for ( int f = 0; f < FieldCount; f++ )
+        {
+            keys[f] = m_postings[f].keys();
+            qSort( keys[f] );
+
+            quint32 postings = 0;
+            foreach ( quint64 key, keys[f] )
+                postings += m_postings[f].value( key ).count();
+
+            header.termCount[f] = keys[f].count();
+            header.fieldOffset[f] = offset;
+            offset = align8( offset + keys[f].count() * sizeof( quint64 ) + ( keys[f].count() + 1 ) * sizeof( quint32 ) + postings * sizeof( quint32 ) );
+        }
+
+        QByteArray data( offset, '\0' );
+        char* out = data.data();
+        memcpy( out, &header, sizeof( header ) );
+        memcpy( out + sizeof( header ), m_tracks.constData(), m_tracks.count() * sizeof( TrackDoc ) );
+        memcpy( out + sizeof( header ) + m_tracks.count() * sizeof( TrackDoc ), m_albums.constData(), m_albums.count() * sizeof( AlbumDoc ) );
+        memcpy( out + header.stringsOffset, m_strings.constData(), m_strings.count() * sizeof( ushort ) );
+
+        for ( int f = 0; f < FieldCount; f++ )
+        {
+            quint64* keyOut = reinterpret_cast< quint64* >( out + header.fieldOffset[f] );
+            quint32* startOut = reinterpret_cast< quint32* >( keyOut + keys[f].count() );
+            quint32* postingOut = startOut + keys[f].count() + 1;
+
+            quint32 start = 0;
+            foreach ( quint64 key, keys[f] )
+            {
+                const QVector< quint32 >& postings = m_postings[f][ key ];
+                *keyOut++ = key;
+                *startOut++ = start;
+                memcpy( postingOut + start, postings.constData(), postings.count() * sizeof( quint32 ) );
+                start += postings.count();
+            }
+            *startOut = start;
+        }
+
+        return data;
+    }
+
+    unsigned int maxTrackId;
+    unsigned int maxAlbumId;
+
+private:
+    quint16
+    addGrams( Field field, const QString& name, quint32 doc )
+    {
+        const int count = trigrams( name, m_scratch );
+        foreach ( quint64 gram, m_scratch )
+            m_postings[field][ gram ] << doc;
+
+        return qMin( count, 0xffff );
+    }
+
+    QVector< TrackDoc > m_tracks;
+    QVector< AlbumDoc > m_albums;
+    QVector< ushort > m_strings;
+    QHash< quint64, QVector< quint32 > > m_postings[FieldCount];
+    QVector< quint64 > m_scratch;
+};
+
+
+NGramIndex::NGramIndex( const QString& path )
+    : m_dir( path )
+    , m_builder( 0 )
+    , m_incremental( false )
+{
+    m_dir.mkpath( "." );
+
+    QSharedPointer< Snapshot > empty( new Snapshot );
+    empty->maxTrackId = 0;
+    empty->maxAlbumId = 0;
+    empty->generation = 0;
+    m_snapshot = empty;
+}
+
+
+NGramIndex::~NGramIndex()
+{
+    delete m_builder;
+}
+
+
+QString
+NGramIndex::segmentPath( int generation ) const
+{
+    return m_dir.absoluteFilePath( QString( "segment-%1.ngram" ).arg( generation ) );
+}
+
+
+bool
+NGramIndex::load()
+{
+    int generation = 0;
+    foreach ( const QString& name, m_dir.entryList( QStringList() << "segment-*.ngram", QDir::Files ) )
+    {
+        generation = qMax( generation, name.mid( 8, name.length() - 14 ).toInt() );
+    }
+
+    QSharedPointer< Segment > segment;
+    if ( generation > 0 )
+        segment = Segment::fromFile( segmentPath( generation ) );
+
+    removeStaleSegments( segment.isNull() ? -1 : generation );
+    if ( segment.isNull() )
+        return false;
+
+    QSharedPointer< Snapshot > loaded( new Snapshot );
+    loaded->segments << segment;
+    loaded->maxTrackId = segment->maxTrackId();
+    loaded->maxAlbumId = segment->maxAlbumId();
+    loaded->generation = generation;
+    publish( loaded );
+
+    tDebug() << "Loaded n-gram index with" << segment->trackCount() << "tracks and" << segment->albumCount() << "albums.";
+    return true;
+}
+
+
+void
+NGramIndex::removeStaleSegments( int keepGeneration ) const
+{
+    foreach ( const QString& name, m_dir.entryList( QStringList() << "segment-*.ngram*", QDir::Files ) )
+    {
+        // files still mapped by an old snapshot can't be removed on Windows, we'll catch them next time
+        if ( name != QFileInfo( segmentPath( keepGeneration ) ).fileName() )
+            m_dir.remove( name );
+    }
+}
+
+
+void
+NGramIndex::wipe()
+{
+    QSharedPointer< Snapshot > empty( new Snapshot );
+    empty->maxTrackId = 0;
+    empty->maxAlbumId = 0;
+    empty->generation = snapshot()->generation;
+    publish( empty );
+
+    removeStaleSegments( -1 );
+}
+
+
+QSharedPointer< NGramIndex::Snapshot >
+NGramIndex::snapshot() const
+{
+    QMutexLocker lock( &m_snapshotMutex );
+    return m_snapshot;
+}
+
+
+void
+NGramIndex::publish( const QSharedPointer< Snapshot >& snapshot )
+{
+    QMutexLocker lock( &m_snapshotMutex );
+    m_snapshot = snapshot;
+}
+
+
+bool
+NGramIndex::canUpdateIncrementally() const
+{
+    QSharedPointer< Snapshot > snap = snapshot();
+    return !snap->segments.isEmpty() && snap->segments.count() < MAX_SEGMENTS;
+}
+
+
+unsigned int
+NGramIndex::maxTrackId() const
+{
+    return snapshot()->maxTrackId;
+}
+
+
+unsigned int
+NGramIndex::maxAlbumId() const
+{
+    return snapshot()->maxAlbumId;
+}
+
+
+void
+NGramIndex::beginIndexing( bool incremental )
+{
+    delete m_builder;
+    m_builder = new Builder;
+    m_incremental = incremental;
+}
+
+
+void
+NGramIndex::appendFields( const IndexData& data )
+{
+    Q_ASSERT( m_builder );
+
+    if ( !data.track.isEmpty() )
+        m_builder->addTrack( data );
+    else if ( !data.album.isEmpty() )
+        m_builder->addAlbum( data );
+}
+
+
+void
+NGramIndex::endIndexing()
+{
+    Q_ASSERT( m_builder );
+
+    QTime t;
+    t.start();
+
+    QSharedPointer< Snapshot > current = snapshot();
+    QSharedPointer< Snapshot > next( new Snapshot );
+    const QByteArray data = m_builder->serialize();
+
+    if ( m_incremental )
+    {
+        if ( m_builder->isEmpty() )
+        {
+            delete m_builder;
+            m_builder = 0;
+            return;
+        }
+
+        next->segments = current->segments;
+        next->segments << Segment::fromData( data );
+        Q_ASSERT( !next->segments.last().isNull() );
+        next->maxTrackId = qMax( current->maxTrackId, m_builder->maxTrackId );
+        next->maxAlbumId = qMax( current->maxAlbumId, m_builder->maxAlbumId );
+        next->generation = current->generation;
+    }
+    else
+    {
+        next->generation = current->generation + 1;
+        next->maxTrackId = m_builder->maxTrackId;
+        next->maxAlbumId = m_builder->maxAlbumId;
+
+        // write to a new file every time: the previous one may still be mapped by a reader
+        const QString path = segmentPath( next->generation );
+        QFile file( path + ".tmp" );
+        QSharedPointer< Segment > segment;
+        if ( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) && file.write( data ) == data.size() )
+        {
+            file.close();
+            if ( file.rename( path ) )
+                segment = Segment::fromFile( path );
+        }
+        else
+        {
+            tLog() << "Could not write n-gram index segment:" << path << file.errorString();
+        }
+
+        if ( segment.isNull() )
+            segment = Segment::fromData( data );
+
+        next->segments << segment;
+    }
+
+    publish( next );
+    if ( !m_incremental )
+        removeStaleSegments( next->generation );
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Published" << ( m_incremental ? "delta" : "base" ) << "segment of" << data.size()
+                         << "bytes, now" << next->segments.count() << "segments, took" << t.elapsed() << "ms";
+
+    delete m_builder;
+    m_builder = 0;
+}
+
+
+QMap< int, float >
+NGramIndex::search( const Tomahawk::query_ptr& query, int limit ) const
+{
+    QSharedPointer< Snapshot > snap = snapshot();
+    QVector< Hit > hits;
+
+    QVector< quint16 > counts;
+    QVector< quint32 > touched;
+
+    if ( query->isFullTextQuery() )
+    {
+        QVector< quint64 > grams;
+        const int gramCount = trigrams( DatabaseImpl::foldedname( DatabaseImpl::sortname( query->fullTextQuery() ) ), grams );
+        if ( !gramCount )
+            return QMap< int, float >();
+
+        foreach ( const QSharedPointer< Segment >& segment, snap->segments )
+        {
+            counts.fill( 0, segment->trackCount() );
+            QHash< quint32, float > best;
+
+            for ( int f = TrackField; f <= FullTextField; f++ )
+            {
+                touched.clear();
+                segment->countMatches( (Field)f, grams, counts, touched );
+
+                foreach ( quint32 doc, touched )
+                {
+                    const float score = dice( counts[doc], gramCount, segment->track( doc ).grams[f] );
+                    counts[doc] = 0;
+
+                    if ( score >= MIN_SIMILARITY && score > best.value( doc ) )
+                        best[ doc ] = score;
+                }
+            }
+
+            QHash< quint32, float >::const_iterator it = best.constBegin();
+            for ( ; it != best.constEnd(); ++it )
+                hits << Hit( segment->track( it.key() ).id, it.value() );
+        }
+    }
+    else
+    {
+        QVector< quint64 > trackGrams, artistGrams;
+        const int trackCount = trigrams( DatabaseImpl::foldedname( DatabaseImpl::sortname( query->queryTrack()->track() ) ), trackGrams );
+        const int artistCount = trigrams( DatabaseImpl::foldedname( DatabaseImpl::sortname( query->queryTrack()->artist() ) ), artistGrams );
+        if ( !trackCount || !artistCount )
+            return QMap< int, float >();
+
+        foreach ( const QSharedPointer< Segment >& segment, snap->segments )
+        {
+            counts.fill( 0, segment->trackCount() );
+            QHash< quint32, float > trackScores;
+
+            // both have to match, like the MUST clauses of the Lucene query
+            touched.clear();
+            segment->countMatches( TrackField, trackGrams, counts, touched );
+            foreach ( quint32 doc, touched )
+            {
+                const float score = dice( counts[doc], trackCount, segment->track( doc ).grams[TrackField] );
+                counts[doc] = 0;
+
+                if ( score >= MIN_SIMILARITY )
+                    trackScores.insert( doc, score );
+            }
+
+            if ( trackScores.isEmpty() )
+                continue;
+
+            touched.clear();
+            segment->countMatches( ArtistField, artistGrams, counts, touched );
+            foreach ( quint32 doc, touched )
+            {
+                const float score = dice( counts[doc], artistCount, segment->track( doc ).grams[ArtistField] );
+                counts[doc] = 0;
+
+                if ( score >= MIN_SIMILARITY && trackScores.contains( doc ) )
+                    hits << Hit( segment->track( doc ).id, ( score + trackScores.value( doc ) ) / 2.0f );
+            }
+        }
+    }
+
+    return topHits( hits, limit );
+}
+
+
+QMap< int, float >
+NGramIndex::searchAlbum( const Tomahawk::query_ptr& query, int limit, QHash< int, IndexData >* info ) const
+{
+    Q_ASSERT( query->isFullTextQuery() );
+
+    QSharedPointer< Snapshot > snap = snapshot();
+    QVector< Hit > hits;
+    QHash< int, QPair< const Segment*, quint32 > > docs;
+
+    QVector< quint64 > grams;
+    const int gramCount = trigrams( DatabaseImpl::foldedname( DatabaseImpl::sortname( query->fullTextQuery() ) ), grams );
+    if ( !gramCount )
+        return QMap< int, float >();
+
+    QVector< quint16 > counts;
+    QVector< quint32 > touched;
+    foreach ( const QSharedPointer< Segment >& segment, snap->segments )
+    {
+        counts.fill( 0, segment->albumCount() );
+        touched.clear();
+        segment->countMatches( AlbumField, grams, counts, touched );
+
+        foreach ( quint32 doc, touched )
+        {
+            const float score = dice( counts[doc], gramCount, segment->album( doc ).grams );
+            if ( score >= MIN_ALBUM_SIMILARITY )
+            {
+                hits << Hit( segment->album( doc ).id, score );
+                docs.insert( segment->album( doc ).id, qMakePair( segment.data(), doc ) );
+            }
+        }
+    }
+
+    const QMap< int, float > resultsmap = topHits( hits, limit );
+    if ( info )
+    {
+        foreach ( int id, resultsmap.keys() )
+        {
+            const Segment* segment = docs.value( id ).first;
+            const AlbumDoc& album = segment->album( docs.value( id ).second );
+
+            IndexData data;
+            data.id = album.id;
+            data.artistId = album.artistId;
+            data.albumName = segment->string( album.nameOffset, album.nameLength );
+            data.artistName = segment->string( album.nameOffset + album.nameLength, album.artistLength );
+            info->insert( id, data );
+        }
+    }
+
+    return resultsmap;
+}
@@ -0,0 +1,99 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NGRAMINDEX_H
+#define NGRAMINDEX_H
+
+#include <QDir>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include "DllMacro.h"
+#include "Query.h"
+#include "DatabaseCommand_UpdateSearchIndex.h"
+
+/**
+ * Trigram index over the track, artist and album names in the database, an
+ * in-process alternative to the Lucene index used by FuzzyIndex.
+ *
+ * The index is made of immutable segments: one base segment, which is written to
+ * disk on a full rebuild and memory-mapped on startup, and a few small delta
+ * segments built in memory from rows added since. Searches work on a snapshot of
+ * the current segment list and never wait for indexing, which only builds a new
+ * segment on the side and publishes it once it is complete.
+ *
+ * Candidates are scored with the Dice coefficient of their trigram sets.
+ *
+ * Segment files are the in-memory layout written out as is, they are only
+ * loaded on a machine with the same byte order and struct layout.
+ */
+class DLLEXPORT NGramIndex
+{
+public:
+    explicit NGramIndex( const QString& path );
+    ~NGramIndex();
+
+    /// Maps the base segment written by the last full rebuild. Returns false if there is none.
+    bool load();
+    void wipe();
+
+    // Writer side. Only one thread may be indexing at a time.
+    void beginIndexing( bool incremental );
+    void appendFields( const IndexData& data );
+    void endIndexing();
+
+    /// Whether the next update may just add a delta segment instead of rebuilding.
+    bool canUpdateIncrementally() const;
+    unsigned int maxTrackId() const;
+    unsigned int maxAlbumId() const;
+
+    // Reader side, safe from any thread.
+    QMap< int, float > search( const Tomahawk::query_ptr& query, int limit ) const;
+    /// If info is given, it's filled with the ids and display names stored for each album hit.
+    QMap< int, float > searchAlbum( const Tomahawk::query_ptr& query, int limit, QHash< int, IndexData >* info = 0 ) const;
+
+private:
+    class Segment;
+    class Builder;
+
+    struct Snapshot
+    {
+        QList< QSharedPointer< Segment > > segments;
+        unsigned int maxTrackId;
+        unsigned int maxAlbumId;
+        int generation;
+    };
+
+    QSharedPointer< Snapshot > snapshot() const;
+    void publish( const QSharedPointer< Snapshot >& snapshot );
+    QString segmentPath( int generation ) const;
+    void removeStaleSegments( int keepGeneration ) const;
+
+    QDir m_dir;
+    Builder* m_builder;
+    bool m_incremental;
+
+    mutable QMutex m_snapshotMutex; // only guards swapping m_snapshot, never held while searching
+    QSharedPointer< Snapshot > m_snapshot;
+};
+
+#endif // NGRAMINDEX_H
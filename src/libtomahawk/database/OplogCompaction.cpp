@@ -0,0 +1,213 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "OplogCompaction.h"
+
+
+static QString
+entryGuid( const QVariant& entry )
+{
+    return entry.toMap().value( "guid" ).toString();
+}
+
+
+QString
+OplogCompaction::commandFilter()
+{
+    return "command IN ( 'addfiles', 'deletefiles', 'socialaction', 'renameplaylist', "
+           "'createplaylist', 'createdynamicplaylist', 'deleteplaylist', 'deletedynamicplaylist', "
+           "'setplaylistrevision', 'setdynamicplaylistrevision' )";
+}
+
+
+OplogCompaction::OplogCompaction( qint64 until, qint64 rangeSize )
+    : m_until( until )
+    , m_rangeSize( rangeSize )
+{
+}
+
+
+void
+OplogCompaction::add( qint64 id, const QString& command, QVariantMap op )
+{
+    QList< qint64 > obsolete;
+
+    if ( command == "addfiles" )
+    {
+        foreach ( const QVariant& file, op.value( "files" ).toList() )
+            m_fileOps.insert( file.toMap().value( "id" ).toUInt(), id );
+    }
+    else if ( command == "deletefiles" )
+    {
+        if ( op.value( "deleteAll" ).toBool() )
+        {
+            QHash< uint, qint64 >::const_iterator it = m_fileOps.constBegin();
+            for ( ; it != m_fileOps.constEnd(); ++it )
+                m_deletedFiles[ it.value() ].insert( it.key() );
+            m_fileOps.clear();
+        }
+        else
+        {
+            foreach ( const QVariant& v, op.value( "ids" ).toList() )
+            {
+                const uint fileId = v.toUInt();
+                if ( m_fileOps.contains( fileId ) )
+                    m_deletedFiles[ m_fileOps.take( fileId ) ].insert( fileId );
+            }
+        }
+    }
+    else if ( command == "socialaction" )
+    {
+        // peers only keep the latest value per track and action
+        const QString key = ( QStringList() << op.value( "action" ).toString()
+                                            << op.value( "artist" ).toString()
+                                            << op.value( "track" ).toString() ).join( "\t" );
+        if ( m_lastSocialAction.contains( key ) )
+            obsolete << m_lastSocialAction.value( key );
+        m_lastSocialAction.insert( key, id );
+    }
+    else if ( command == "createplaylist" || command == "createdynamicplaylist" )
+    {
+        m_playlistOps[ op.value( "playlist" ).toMap().value( "guid" ).toString() ] << id;
+    }
+    else if ( command == "renameplaylist" )
+    {
+        const QString playlist = op.value( "playlistguid" ).toString();
+        if ( m_lastRename.contains( playlist ) )
+            obsolete << m_lastRename.value( playlist );
+        m_lastRename.insert( playlist, id );
+        m_playlistOps[ playlist ] << id;
+    }
+    else if ( command == "deleteplaylist" || command == "deletedynamicplaylist" )
+    {
+        // the delete itself stays, peers that already know the playlist still need it
+        const QString playlist = op.value( "playlistguid" ).toString();
+        obsolete << m_playlistOps.take( playlist );
+        m_lastRename.remove( playlist );
+        m_lastRevision.remove( playlist );
+    }
+    else if ( command == "setdynamicplaylistrevision" )
+    {
+        const QString playlist = op.value( "playlistguid" ).toString();
+        m_playlistOps[ playlist ] << id;
+        m_lastRevision.remove( playlist );
+    }
+    else if ( command == "setplaylistrevision" )
+    {
+        const QString playlist = op.value( "playlistguid" ).toString();
+        m_playlistOps[ playlist ] << id;
+
+        if ( op.value( "metadataUpdate" ).toBool() )
+        {
+            m_lastRevision.remove( playlist );
+            return;
+        }
+
+        QHash< QString, QPair< qint64, QVariantMap > >::iterator prev = m_lastRevision.find( playlist );
+        if ( id <= m_until && prev != m_lastRevision.end() && range( prev->first ) == range( id ) &&
+             prev->second.value( "newrev" ).toString() == op.value( "oldrev" ).toString() )
+        {
+            // fold the previous revision into this one: it now starts where the previous one did and brings
+            // along the entries that were added there and are still in the playlist. Peers that are at
+            // one of the folded revisions find it in mergedrevisions and apply it anyway.
+            QSet< QString > guids;
+            foreach ( const QVariant& v, op.value( "orderedguids" ).toList() )
+                guids << v.toString();
+
+            QSet< QString > added;
+            foreach ( const QVariant& entry, op.value( "addedentries" ).toList() )
+                added << entryGuid( entry );
+
+            QVariantList entries;
+            foreach ( const QVariant& entry, prev->second.value( "addedentries" ).toList() )
+            {
+                const QString guid = entryGuid( entry );
+                if ( guids.contains( guid ) && !added.contains( guid ) )
+                {
+                    entries << entry;
+                    added << guid;
+                }
+            }
+            entries << op.value( "addedentries" ).toList();
+
+            op.insert( "addedentries", entries );
+            op.insert( "oldrev", prev->second.value( "oldrev" ) );
+            op.insert( "mergedrevisions", QVariantList( prev->second.value( "mergedrevisions" ).toList() ) << prev->second.value( "newrev" ) );
+
+            obsolete << prev->first;
+            m_playlistOps[ playlist ].removeAll( prev->first );
+            m_rewrite.insert( id, op );
+        }
+
+        m_lastRevision.insert( playlist, qMakePair( id, op ) );
+    }
+
+    foreach ( qint64 obsoleteId, obsolete )
+        markObsolete( obsoleteId );
+}
+
+
+QList< qint64 >
+OplogCompaction::shrinkable() const
+{
+    QList< qint64 > ids;
+    QHash< qint64, QSet< uint > >::const_iterator it = m_deletedFiles.constBegin();
+    for ( ; it != m_deletedFiles.constEnd(); ++it )
+    {
+        if ( it.key() <= m_until && !m_drop.contains( it.key() ) )
+            ids << it.key();
+    }
+
+    return ids;
+}
+
+
+void
+OplogCompaction::shrink( qint64 id, const QVariantMap& op )
+{
+    const QSet< uint > deleted = m_deletedFiles.value( id );
+
+    QVariantList files;
+    foreach ( const QVariant& file, op.value( "files" ).toList() )
+    {
+        if ( !deleted.contains( file.toMap().value( "id" ).toUInt() ) )
+            files << file;
+    }
+
+    if ( files.isEmpty() )
+    {
+        markObsolete( id );
+    }
+    else
+    {
+        QVariantMap shrunk = op;
+        shrunk.insert( "files", files );
+        m_rewrite.insert( id, shrunk );
+    }
+}
+
+
+void
+OplogCompaction::markObsolete( qint64 id )
+{
+    if ( id > m_until )
+        return;
+
+    m_drop.insert( id );
+    m_rewrite.remove( id );
+}
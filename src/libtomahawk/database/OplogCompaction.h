@@ -0,0 +1,78 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPLOGCOMPACTION_H
+#define OPLOGCOMPACTION_H
+
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+#include <QVariant>
+
+#include "DllMacro.h"
+
+/**
+ * Works out how the local oplog can be shortened, see DatabaseCommand_CompactOplog.
+ *
+ * Ops are fed in ascending id order. Ops after until may make older ones obsolete,
+ * but are never dropped or rewritten themselves. The log is changed one range of
+ * rangeSize ids at a time, so revisions are only folded into one another within a
+ * range: a peer must never see the previous revision dropped while the one it was
+ * folded into is still unchanged.
+ */
+class DLLEXPORT OplogCompaction
+{
+public:
+    /// Commands that a later op can make obsolete, for an oplog query.
+    static QString commandFilter();
+
+    OplogCompaction( qint64 until, qint64 rangeSize );
+
+    void add( qint64 id, const QString& command, QVariantMap op );
+
+    /// Addfiles ops some files of which were deleted later, see shrink().
+    QList< qint64 > shrinkable() const;
+    /// Removes the deleted files from the addfiles op with this id, dropping it if none are left.
+    void shrink( qint64 id, const QVariantMap& op );
+
+    const QSet< qint64 >& dropped() const { return m_drop; }
+    const QHash< qint64, QVariantMap >& rewritten() const { return m_rewrite; }
+
+    qint64 until() const { return m_until; }
+    /// Index of the range id belongs to.
+    qint64 range( qint64 id ) const { return ( id - 1 ) / m_rangeSize; }
+    qint64 rangeSize() const { return m_rangeSize; }
+
+private:
+    void markObsolete( qint64 id );
+
+    qint64 m_until;
+    qint64 m_rangeSize;
+
+    QSet< qint64 > m_drop;
+    QHash< qint64, QVariantMap > m_rewrite;
+
+    QHash< uint, qint64 > m_fileOps;                    // file id -> addfiles op it was announced in
+    QHash< qint64, QSet< uint > > m_deletedFiles;       // addfiles op -> its files that were deleted later
+    QHash< QString, qint64 > m_lastSocialAction, m_lastRename;
+    QHash< QString, QList< qint64 > > m_playlistOps;    // playlist guid -> ops that are moot once it's deleted
+    QHash< QString, QPair< qint64, QVariantMap > > m_lastRevision; // playlist guid -> revision the next one may be folded into
+};
+
+#endif // OPLOGCOMPACTION_H
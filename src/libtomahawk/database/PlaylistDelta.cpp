@@ -0,0 +1,202 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PlaylistDelta.h"
+
+#include <QHash>
+#include <QVector>
+
+
+// Positions (into seq) of a longest strictly increasing subsequence of seq, in O(n log n).
+static QVector< int >
+longestIncreasingSubsequence( const QVector< int >& seq )
+{
+    QVector< int > tails; // tails[l] is the position ending the best subsequence of length l + 1
+    QVector< int > parents( seq.count(), -1 );
+
+    for ( int i = 0; i < seq.count(); i++ )
+    {
+        int lo = 0, hi = tails.count();
+        while ( lo < hi )
+        {
+            const int mid = ( lo + hi ) / 2;
+            if ( seq.at( tails.at( mid ) ) < seq.at( i ) )
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        if ( lo > 0 )
+            parents[i] = tails.at( lo - 1 );
+        if ( lo == tails.count() )
+            tails << i;
+        else
+            tails[lo] = i;
+    }
+
+    QVector< int > result( tails.count() );
+    int pos = tails.isEmpty() ? -1 : tails.last();
+    for ( int i = tails.count() - 1; i >= 0; i-- )
+    {
+        result[i] = pos;
+        pos = parents.at( pos );
+    }
+
+    return result;
+}
+
+
+QVariantList
+PlaylistDelta::diff( const QStringList& from, const QStringList& to )
+{
+    const int common = qMin( from.count(), to.count() );
+
+    int prefix = 0;
+    while ( prefix < common && from.at( prefix ) == to.at( prefix ) )
+        prefix++;
+
+    int suffix = 0;
+    while ( suffix < common - prefix && from.at( from.count() - 1 - suffix ) == to.at( to.count() - 1 - suffix ) )
+        suffix++;
+
+    const int oldCount = from.count() - prefix - suffix;
+    const int newCount = to.count() - prefix - suffix;
+
+    QHash< QString, int > oldIndex;
+    oldIndex.reserve( oldCount );
+    for ( int i = 0; i < oldCount; i++ )
+        oldIndex.insert( from.at( prefix + i ), i );
+
+    // old positions of the new entries we had before, the ones in increasing order can stay where they are
+    QVector< int > seq, seqPos;
+    for ( int i = 0; i < newCount; i++ )
+    {
+        QHash< QString, int >::const_iterator it = oldIndex.constFind( to.at( prefix + i ) );
+        if ( it == oldIndex.constEnd() )
+            continue;
+
+        seq << it.value();
+        seqPos << i;
+    }
+
+    QVector< bool > keepOld( oldCount, false );
+    QVector< bool > keepNew( newCount, false );
+    foreach ( int i, longestIncreasingSubsequence( seq ) )
+    {
+        keepOld[ seq.at( i ) ] = true;
+        keepNew[ seqPos.at( i ) ] = true;
+    }
+
+    QVariantList delta;
+
+    // remove back to front, so the indexes of the runs still to go stay valid
+    int i = oldCount - 1;
+    while ( i >= 0 )
+    {
+        if ( keepOld.at( i ) )
+        {
+            i--;
+            continue;
+        }
+
+        int first = i;
+        while ( first > 0 && !keepOld.at( first - 1 ) )
+            first--;
+
+        delta << QVariant( QVariantList() << "-" << prefix + first << i - first + 1 );
+        i = first - 1;
+    }
+
+    // then insert front to back, everything before an insert is in its final place by then
+    i = 0;
+    while ( i < newCount )
+    {
+        if ( keepNew.at( i ) )
+        {
+            i++;
+            continue;
+        }
+
+        QVariantList guids;
+        const int first = i;
+        while ( i < newCount && !keepNew.at( i ) )
+            guids << to.at( prefix + i++ );
+
+        delta << QVariant( QVariantList() << "+" << prefix + first << QVariant( guids ) );
+    }
+
+    return delta;
+}
+
+
+bool
+PlaylistDelta::apply( QStringList& entries, const QVariantList& delta )
+{
+    foreach ( const QVariant& v, delta )
+    {
+        const QVariantList op = v.toList();
+        if ( op.count() != 3 )
+            return false;
+
+        const QString type = op.at( 0 ).toString();
+        const int index = op.at( 1 ).toInt();
+
+        if ( type == "-" )
+        {
+            const int count = op.at( 2 ).toInt();
+            if ( index < 0 || count < 0 || index + count > entries.count() )
+                return false;
+
+            entries.erase( entries.begin() + index, entries.begin() + index + count );
+        }
+        else if ( type == "+" )
+        {
+            if ( index < 0 || index > entries.count() )
+                return false;
+
+            const QVariantList guids = op.at( 2 ).toList();
+            QStringList inserted;
+            inserted.reserve( guids.count() );
+            foreach ( const QVariant& guid, guids )
+                inserted << guid.toString();
+
+            entries = entries.mid( 0, index ) + inserted + entries.mid( index );
+        }
+        else
+            return false;
+    }
+
+    return true;
+}
+
+
+int
+PlaylistDelta::size( const QVariantList& delta )
+{
+    int size = 0;
+    foreach ( const QVariant& v, delta )
+    {
+        const QVariantList op = v.toList();
+        if ( op.count() != 3 )
+            continue;
+
+        size += op.at( 0 ).toString() == "-" ? op.at( 2 ).toInt() : op.at( 2 ).toList().count();
+    }
+
+    return size;
+}
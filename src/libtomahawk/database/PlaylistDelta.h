@@ -0,0 +1,49 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLAYLISTDELTA_H
+#define PLAYLISTDELTA_H
+
+#include <QStringList>
+#include <QVariant>
+
+#include "DllMacro.h"
+
+/**
+ * Edit script between the ordered entry guids of two playlist revisions.
+ *
+ * A delta is a list of operations applied in order:
+ *   [ "-", index, count ]     removes count entries starting at index
+ *   [ "+", index, [ guids ] ] inserts guids before index
+ *
+ * diff() keeps the longest run of entries that are still in the same relative
+ * order, so appending, inserting, removing or moving a few entries produces a
+ * delta the size of the change, not of the playlist.
+ */
+class DLLEXPORT PlaylistDelta
+{
+public:
+    static QVariantList diff( const QStringList& from, const QStringList& to );
+    /// Applies delta to entries. Returns false, leaving entries undefined, if the delta doesn't fit.
+    static bool apply( QStringList& entries, const QVariantList& delta );
+
+    /// Number of entries touched by delta.
+    static int size( const QVariantList& delta );
+};
+
+#endif // PLAYLISTDELTA_H
@@ -14,6 +14,19 @@ CREATE TABLE IF NOT EXISTS oplog (
 CREATE UNIQUE INDEX oplog_guid ON oplog(guid);
 CREATE INDEX oplog_source ON oplog(source);
 
+-- Guids of ops removed when the oplog was compacted, and the position they had.
+-- Peers that synced up to one of them get everything after it.
+CREATE TABLE IF NOT EXISTS oplog_compacted (
+    guid TEXT PRIMARY KEY,
+    id INTEGER NOT NULL
+);
+
+-- How far each peer has synced our ops, entries older than all of them are pruned.
+CREATE TABLE IF NOT EXISTS oplog_peers (
+    peer TEXT PRIMARY KEY,                 -- source name, or the service syncing our ops
+    id INTEGER NOT NULL                    -- position of the last op it has
+);
+
 
 
 -- the basic 3 catalogue tables:
@@ -94,7 +107,9 @@ CREATE INDEX playlist_item_playlist ON playlist_item(playlist);
 CREATE TABLE IF NOT EXISTS playlist_revision (
     guid TEXT PRIMARY KEY,
     playlist TEXT NOT NULL REFERENCES playlist(guid) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
-    entries TEXT, -- qlist( guid, guid... )
+    entries TEXT, -- qlist( guid, guid... ), null if stored as delta
+    entries_delta TEXT, -- PlaylistDelta against previous_revision, null if entries is set
+    snapshot_distance INTEGER NOT NULL DEFAULT 0, -- deltas since the last revision with entries
     author INTEGER REFERENCES source(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
     timestamp INTEGER NOT NULL DEFAULT 0,
     previous_revision TEXT REFERENCES playlist_revision(guid) DEFERRABLE INITIALLY DEFERRED
@@ -272,6 +287,28 @@ CREATE TABLE IF NOT EXISTS playback_log (
 
 CREATE INDEX playback_log_source ON playback_log(source);
 CREATE INDEX playback_log_track ON playback_log(track);
+CREATE INDEX playback_log_playtime ON playback_log(playtime);
+
+-- play counts from playback_log, kept up to date by DatabaseCommand_LogPlayback
+-- total per source and track, if source=null the plays are local to this machine
+CREATE TABLE IF NOT EXISTS playback_stats (
+    source INTEGER REFERENCES source(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    track INTEGER NOT NULL REFERENCES track(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    artist INTEGER NOT NULL REFERENCES artist(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    plays INTEGER NOT NULL DEFAULT 0
+);
+CREATE INDEX playback_stats_source_track ON playback_stats(source, track);
+CREATE INDEX playback_stats_source_plays ON playback_stats(source, plays);
+CREATE INDEX playback_stats_artist ON playback_stats(artist);
+
+-- per source and track and day (playtime / 86400)
+CREATE TABLE IF NOT EXISTS playback_stats_daily (
+    source INTEGER REFERENCES source(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    track INTEGER NOT NULL REFERENCES track(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    day INTEGER NOT NULL,
+    plays INTEGER NOT NULL DEFAULT 0
+);
+CREATE INDEX playback_stats_daily_day ON playback_stats_daily(day, source, track);
 
 
 
@@ -295,4 +332,4 @@ CREATE TABLE IF NOT EXISTS settings (
     v TEXT NOT NULL DEFAULT ''
 );
 
-INSERT INTO settings(k,v) VALUES('schema_version', '29');
+INSERT INTO settings(k,v) VALUES('schema_version', '32');
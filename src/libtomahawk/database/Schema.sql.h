@@ -1,5 +1,5 @@
 /*
-    This file was automatically generated from ./Schema.sql on Wed Sep 26 14:51:40 EDT 2012.
+    This file was automatically generated from ./Schema.sql on Mon Oct 19 04:05:30 UTC 2026.
 */
 
 static const char * tomahawk_schema_sql = 
@@ -14,6 +14,14 @@ static const char * tomahawk_schema_sql =
 ");"
 "CREATE UNIQUE INDEX oplog_guid ON oplog(guid);"
 "CREATE INDEX oplog_source ON oplog(source);"
+"CREATE TABLE IF NOT EXISTS oplog_compacted ("
+"    guid TEXT PRIMARY KEY,"
+"    id INTEGER NOT NULL"
+");"
+"CREATE TABLE IF NOT EXISTS oplog_peers ("
+"    peer TEXT PRIMARY KEY,                 "
+"    id INTEGER NOT NULL                    "
+");"
 "CREATE TABLE IF NOT EXISTS artist ("
 "    id INTEGER PRIMARY KEY AUTOINCREMENT,"
 "    name TEXT NOT NULL,"
@@ -71,6 +79,8 @@ static const char * tomahawk_schema_sql =
 "    guid TEXT PRIMARY KEY,"
 "    playlist TEXT NOT NULL REFERENCES playlist(guid) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,"
 "    entries TEXT, "
+"    entries_delta TEXT, "
+"    snapshot_distance INTEGER NOT NULL DEFAULT 0, "
 "    author INTEGER REFERENCES source(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,"
 "    timestamp INTEGER NOT NULL DEFAULT 0,"
 "    previous_revision TEXT REFERENCES playlist_revision(guid) DEFERRABLE INITIALLY DEFERRED"
@@ -180,6 +190,23 @@ static const char * tomahawk_schema_sql =
 ");"
 "CREATE INDEX playback_log_source ON playback_log(source);"
 "CREATE INDEX playback_log_track ON playback_log(track);"
+"CREATE INDEX playback_log_playtime ON playback_log(playtime);"
+"CREATE TABLE IF NOT EXISTS playback_stats ("
+"    source INTEGER REFERENCES source(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,"
+"    track INTEGER NOT NULL REFERENCES track(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,"
+"    artist INTEGER NOT NULL REFERENCES artist(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,"
+"    plays INTEGER NOT NULL DEFAULT 0"
+");"
+"CREATE INDEX playback_stats_source_track ON playback_stats(source, track);"
+"CREATE INDEX playback_stats_source_plays ON playback_stats(source, plays);"
+"CREATE INDEX playback_stats_artist ON playback_stats(artist);"
+"CREATE TABLE IF NOT EXISTS playback_stats_daily ("
+"    source INTEGER REFERENCES source(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,"
+"    track INTEGER NOT NULL REFERENCES track(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,"
+"    day INTEGER NOT NULL,"
+"    plays INTEGER NOT NULL DEFAULT 0"
+");"
+"CREATE INDEX playback_stats_daily_day ON playback_stats_daily(day, source, track);"
 "CREATE TABLE IF NOT EXISTS http_client_auth ("
 "    token TEXT NOT NULL PRIMARY KEY,"
 "    website TEXT NOT NULL,"
@@ -192,7 +219,7 @@ static const char * tomahawk_schema_sql =
 "    k TEXT NOT NULL PRIMARY KEY,"
 "    v TEXT NOT NULL DEFAULT ''"
 ");"
-"INSERT INTO settings(k,v) VALUES('schema_version', '29');"
+"INSERT INTO settings(k,v) VALUES('schema_version', '32');"
     ;
 
 const char * get_tomahawk_sql()
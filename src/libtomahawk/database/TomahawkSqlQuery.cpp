@@ -20,6 +20,7 @@
 
 #include "database/Database.h"
 #include "database/DatabaseImpl.h"
+#include "database/DatabaseStats.h"
 #include "utils/TomahawkUtils.h"
 #include "utils/Logger.h"
 
@@ -27,10 +28,13 @@
 #include <QSqlError>
 #include <QTime>
 #include <QThread>
+#include <QThreadStorage>
 #include <QVariant>
 
 #define QUERY_THRESHOLD 60
 
+static QThreadStorage< qint64* > s_rowsRead;
+
 
 TomahawkSqlQuery::TomahawkSqlQuery()
     : QSqlQuery()
@@ -116,10 +120,64 @@ TomahawkSqlQuery::exec()
     if ( log || e >= QUERY_THRESHOLD )
         tLog( LOGSQL ) << "TomahawkSqlQuery::exec (" << t.elapsed() << "ms ):" << lastQuery();
 
+    if ( ret && e >= QUERY_THRESHOLD && Database::instance() )
+        Database::instance()->stats()->recordSlowQuery( lastQuery(), e, queryPlan() );
+
     return ret;
 }
 
 
+bool
+TomahawkSqlQuery::next()
+{
+    if ( !QSqlQuery::next() )
+        return false;
+
+    if ( !s_rowsRead.hasLocalData() )
+        s_rowsRead.setLocalData( new qint64( 0 ) );
+    ( *s_rowsRead.localData() )++;
+
+    return true;
+}
+
+
+qint64
+TomahawkSqlQuery::rowsRead()
+{
+    return s_rowsRead.hasLocalData() ? *s_rowsRead.localData() : 0;
+}
+
+
+QStringList
+TomahawkSqlQuery::queryPlan() const
+{
+    QStringList plan;
+
+    const QString sql = lastQuery().trimmed();
+    const QString verb = sql.section( ' ', 0, 0 ).toUpper();
+    if ( !m_db.isOpen() || !( verb == "SELECT" || verb == "INSERT" || verb == "UPDATE" || verb == "DELETE" || verb == "REPLACE" ) )
+        return plan;
+
+    // plain QSqlQuery, this must neither retry nor end up in the stats itself
+    QSqlQuery explain( m_db );
+    if ( !explain.prepare( "EXPLAIN QUERY PLAN " + sql ) )
+        return plan;
+
+    const int values = boundValues().count();
+    for ( int i = 0; i < values; i++ )
+        explain.addBindValue( boundValue( i ) );
+
+    if ( !explain.exec() )
+        return plan;
+
+    // selectid, order, from, detail
+    while ( explain.next() )
+        plan << explain.value( 3 ).toString();
+
+    return plan;
+}
+
+
 bool
 TomahawkSqlQuery::commitTransaction()
 {
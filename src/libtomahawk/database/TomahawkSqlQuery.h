@@ -23,6 +23,7 @@
 
 #include <QSqlDriver>
 #include <QSqlQuery>
+#include <QStringList>
 
 //#define TOMAHAWK_QUERY_ANALYZE 1
 
@@ -40,6 +41,11 @@ public:
     bool prepare( const QString& query );
     bool exec( const QString& query );
     bool exec();
+    // counts the rows it steps to for rowsRead()
+    bool next();
+
+    /// Rows stepped to with next() so far by all queries of the calling thread.
+    static qint64 rowsRead();
 
     bool commitTransaction();
 
@@ -48,6 +54,8 @@ private:
 
     void showError();
 
+    QStringList queryPlan() const;
+
     QSqlDatabase m_db;
     QString m_query;
 };
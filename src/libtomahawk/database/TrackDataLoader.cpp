@@ -0,0 +1,112 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TrackDataLoader.h"
+
+#include <QCoreApplication>
+
+#include "Database.h"
+#include "TrackData.h"
+#include "utils/Logger.h"
+
+// how long we wait for more tracks to come in before loading them
+#define BATCH_WINDOW 20
+
+// keeps the IN (...) lists, and the time a single command blocks a worker, reasonable
+#define BATCH_SIZE 500
+
+TrackDataLoader* TrackDataLoader::s_instance = 0;
+
+
+TrackDataLoader*
+TrackDataLoader::instance()
+{
+    static QMutex mutex;
+    QMutexLocker lock( &mutex );
+
+    if ( !s_instance )
+        s_instance = new TrackDataLoader();
+
+    return s_instance;
+}
+
+
+TrackDataLoader::TrackDataLoader()
+    : QObject( 0 )
+{
+    // we're usually first asked for from a database worker, but the timer has to live in a thread with an event loop
+    moveToThread( QCoreApplication::instance()->thread() );
+    m_timer.moveToThread( QCoreApplication::instance()->thread() );
+
+    m_timer.setSingleShot( true );
+    m_timer.setInterval( BATCH_WINDOW );
+    connect( &m_timer, SIGNAL( timeout() ), SLOT( flush() ) );
+}
+
+
+void
+TrackDataLoader::load( const Tomahawk::trackdata_ptr& track, DatabaseCommand_LoadTrackData::Part part )
+{
+    QMutexLocker lock( &m_mutex );
+
+    if ( !m_parts.contains( track.data() ) )
+        m_tracks << track;
+    m_parts[ track.data() ] |= part;
+
+    if ( m_tracks.count() == 1 )
+        QMetaObject::invokeMethod( this, "scheduleFlush", Qt::QueuedConnection );
+    else if ( m_tracks.count() == BATCH_SIZE )
+        QMetaObject::invokeMethod( this, "flush", Qt::QueuedConnection );
+}
+
+
+void
+TrackDataLoader::scheduleFlush()
+{
+    if ( !m_timer.isActive() )
+        m_timer.start();
+}
+
+
+void
+TrackDataLoader::flush()
+{
+    m_timer.stop();
+
+    QList< Tomahawk::trackdata_ptr > tracks;
+    QHash< Tomahawk::TrackData*, int > parts;
+    {
+        QMutexLocker lock( &m_mutex );
+        tracks = m_tracks;
+        parts = m_parts;
+        m_tracks.clear();
+        m_parts.clear();
+    }
+
+    for ( int i = 0; i < tracks.count(); i += BATCH_SIZE )
+    {
+        const QList< Tomahawk::trackdata_ptr > batch = tracks.mid( i, BATCH_SIZE );
+
+        QList< int > batchParts;
+        foreach ( const Tomahawk::trackdata_ptr& track, batch )
+            batchParts << parts.value( track.data() );
+
+        DatabaseCommand_LoadTrackData* cmd = new DatabaseCommand_LoadTrackData( batch, batchParts );
+        Database::instance()->enqueue( QSharedPointer<DatabaseCommand>( cmd ) );
+    }
+}
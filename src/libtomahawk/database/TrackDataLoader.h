@@ -0,0 +1,63 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACKDATALOADER_H
+#define TRACKDATALOADER_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+
+#include "DatabaseCommand_LoadTrackData.h"
+#include "Typedefs.h"
+#include "DllMacro.h"
+
+/**
+ * Collects the tracks that want their attributes, social actions or stats loaded
+ * for a short while and then loads them all with a few DatabaseCommand_LoadTrackData
+ * batches, instead of one command per track and kind of data.
+ *
+ * load() may be called from any thread.
+ */
+class DLLEXPORT TrackDataLoader : public QObject
+{
+Q_OBJECT
+
+public:
+    static TrackDataLoader* instance();
+
+    void load( const Tomahawk::trackdata_ptr& track, DatabaseCommand_LoadTrackData::Part part );
+
+private slots:
+    void scheduleFlush();
+    void flush();
+
+private:
+    TrackDataLoader();
+
+    QMutex m_mutex;
+    QList< Tomahawk::trackdata_ptr > m_tracks;
+    QHash< Tomahawk::TrackData*, int > m_parts;
+    QTimer m_timer;
+
+    static TrackDataLoader* s_instance;
+};
+
+#endif // TRACKDATALOADER_H
@@ -31,9 +31,13 @@
 #include "database/DatabaseCommand_AddFiles.h"
 #include "database/DatabaseCommand_DeleteFiles.h"
 #include "taghandlers/tag.h"
+#include "ReadAheadStream.h"
 
 #include "utils/Logger.h"
 
+// directories without any changes are reported in groups of this many
+#define CHECKPOINT_DIRS 100
+
 void
 DirLister::go()
 {
@@ -70,13 +74,35 @@ DirLister::scanDir( QDir dir, int depth )
     }
 
     QFileInfoList filteredEntries;
-
-    dir.setFilter( QDir::Files | QDir::Readable | QDir::NoDotAndDotDot );
     dir.setSorting( QDir::Name );
-    filteredEntries = dir.entryInfoList();
 
-    foreach ( const QFileInfo& di, filteredEntries )
-        emit fileToScan( di );
+    if ( m_completedDirs.contains( dir.canonicalPath() ) )
+    {
+        tDebug( LOGVERBOSE ) << "Dir was completed by a previous scan, only descending";
+    }
+    else
+    {
+        dir.setFilter( QDir::Files | QDir::Readable | QDir::NoDotAndDotDot );
+        filteredEntries = dir.entryInfoList();
+
+        QStringList paths;
+        foreach ( const QFileInfo& di, filteredEntries )
+            paths << di.canonicalFilePath();
+        emit filesListed( dir.canonicalPath(), paths );
+
+        foreach ( const QFileInfo& di, filteredEntries )
+            emit fileToScan( di );
+
+        // the scanner works through the files queued above meanwhile, these only give the OS a head start on
+        // the ones it hasn't reached yet, so they must not hold up the scanner thread itself
+        foreach ( const QFileInfo& di, filteredEntries )
+        {
+            if ( isDeleting() )
+                break;
+            if ( m_prefetchSuffixes.contains( di.suffix().toLower() ) )
+                Tomahawk::prefetchTagRegions( di.canonicalFilePath() );
+        }
+    }
 
     dir.setFilter( QDir::Dirs | QDir::Readable | QDir::NoDotAndDotDot );
     filteredEntries = dir.entryInfoList();
@@ -113,7 +139,9 @@ DirListerThreadController::~DirListerThreadController()
 void
 DirListerThreadController::run()
 {
-    m_dirLister = QPointer< DirLister >( new DirLister( m_paths ) );
+    m_dirLister = QPointer< DirLister >( new DirLister( m_paths, m_completedDirs, m_prefetchSuffixes ) );
+    connect( m_dirLister.data(), SIGNAL( filesListed( QString, QStringList ) ),
+             parent(), SLOT( filesListed( QString, QStringList ) ), Qt::QueuedConnection );
     connect( m_dirLister.data(), SIGNAL( fileToScan( QFileInfo ) ),
              parent(), SLOT( scanFile( QFileInfo ) ), Qt::QueuedConnection );
 
@@ -129,13 +157,18 @@ DirListerThreadController::run()
 }
 
 
-MusicScanner::MusicScanner( MusicScanner::ScanMode scanMode, const QStringList& paths, quint32 bs )
+MusicScanner::MusicScanner( MusicScanner::ScanMode scanMode, const QStringList& paths, quint32 bs, const QStringList& completedDirs )
     : QObject()
     , m_scanMode( scanMode )
     , m_paths( paths )
     , m_batchsize( bs )
+    , m_completedDirs( completedDirs.toSet() )
+    , m_lastCommand( 0 )
     , m_dirListerThreadController( 0 )
 {
+    if ( m_batchsize )
+        m_scannedfiles.reserve( m_batchsize );
+
     m_ext2mime.insert( "mp3",  TomahawkUtils::extensionToMimetype( "mp3" ) );
     m_ext2mime.insert( "ogg",  TomahawkUtils::extensionToMimetype( "ogg" ) );
     m_ext2mime.insert( "oga",  TomahawkUtils::extensionToMimetype( "oga" ) );
@@ -193,6 +226,22 @@ MusicScanner::setFileMtimes( const QMap< QString, QMap< unsigned int, unsigned i
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO << m.count();
     m_filemtimes = m;
+
+    if ( !m_completedDirs.isEmpty() )
+    {
+        // we won't see these files again while resuming, don't treat them as deleted
+        tDebug( LOGINFO ) << "Resuming scan," << m_completedDirs.count() << "dirs already completed";
+
+        QMutableMapIterator< QString, QMap< unsigned int, unsigned int > > it( m_filemtimes );
+        while ( it.hasNext() )
+        {
+            it.next();
+            const QString path = it.key().mid( QString( "file://" ).length() );
+            if ( m_completedDirs.contains( path.left( path.lastIndexOf( '/' ) ) ) )
+                it.remove();
+        }
+    }
+
     scan();
 }
 
@@ -202,8 +251,8 @@ MusicScanner::scan()
 {
     tDebug( LOGEXTRA ) << "Num saved file mtimes from last scan:" << m_filemtimes.size();
 
-    connect( this, SIGNAL( batchReady( QVariantList, QVariantList ) ),
-                     SLOT( commitBatch( QVariantList, QVariantList ) ), Qt::DirectConnection );
+    connect( this, SIGNAL( batchReady( FileBatch, QVariantList ) ),
+                     SLOT( commitBatch( FileBatch, QVariantList ) ), Qt::DirectConnection );
 
     if ( m_scanMode == MusicScanner::FileScan )
     {
@@ -213,6 +262,8 @@ MusicScanner::scan()
 
     m_dirListerThreadController = new DirListerThreadController( this );
     m_dirListerThreadController->setPaths( m_paths );
+    m_dirListerThreadController->setCompletedDirs( m_completedDirs );
+    m_dirListerThreadController->setPrefetchSuffixes( m_ext2mime.keys().toSet() );
     m_dirListerThreadController->start( QThread::IdlePriority );
 }
 
@@ -252,7 +303,7 @@ MusicScanner::postOps()
     foreach ( const QString& s, m_skippedFiles )
         tDebug( LOGEXTRA ) << s;
 
-    if ( m_filesToDelete.length() || m_scannedfiles.length() )
+    if ( m_filesToDelete.length() || m_scannedfiles.count() )
     {
         SourceList::instance()->getLocal()->updateIndexWhenSynced();
         commitBatch( m_scannedfiles, m_filesToDelete );
@@ -283,18 +334,29 @@ MusicScanner::cleanup()
 
 
 void
-MusicScanner::commitBatch( const QVariantList& tracks, const QVariantList& deletethese )
+MusicScanner::commitBatch( const FileBatch& tracks, const QVariantList& deletethese )
 {
+    QSharedPointer<DatabaseCommand> cmd;
     if ( deletethese.length() )
     {
         tDebug( LOGINFO ) << Q_FUNC_INFO << "deleting" << deletethese.length() << "tracks";
-        executeCommand( QSharedPointer<DatabaseCommand>( new DatabaseCommand_DeleteFiles( deletethese, SourceList::instance()->getLocal() ) ) );
+        cmd = QSharedPointer<DatabaseCommand>( new DatabaseCommand_DeleteFiles( deletethese, SourceList::instance()->getLocal() ) );
+        executeCommand( cmd );
     }
 
-    if ( tracks.length() )
+    if ( tracks.count() )
     {
-        tDebug( LOGINFO ) << Q_FUNC_INFO << "adding" << tracks.length() << "tracks";
-        executeCommand( QSharedPointer<DatabaseCommand>( new DatabaseCommand_AddFiles( tracks, SourceList::instance()->getLocal() ) ) );
+        tDebug( LOGINFO ) << Q_FUNC_INFO << "adding" << tracks.count() << "tracks";
+        cmd = QSharedPointer<DatabaseCommand>( new DatabaseCommand_AddFiles( tracks, SourceList::instance()->getLocal() ) );
+        executeCommand( cmd );
+    }
+
+    // the RW worker runs commands in order, so once the last one finished all
+    // directories completed so far are safely in the database
+    if ( !cmd.isNull() && !m_uncommittedDirs.isEmpty() )
+    {
+        m_checkpoints[ cmd.data() ] << m_uncommittedDirs;
+        m_uncommittedDirs.clear();
     }
 }
 
@@ -304,6 +366,7 @@ MusicScanner::executeCommand( QSharedPointer< DatabaseCommand > cmd )
 {
     tDebug() << Q_FUNC_INFO << m_cmdQueue;
     m_cmdQueue++;
+    m_lastCommand = cmd.data();
     connect( cmd.data(), SIGNAL( finished() ), SLOT( commandFinished() ) );
     Database::instance()->enqueue( cmd );
 }
@@ -314,13 +377,82 @@ MusicScanner::commandFinished()
 {
     tDebug() << Q_FUNC_INFO << m_cmdQueue;
 
+    // only used as a key, the command may already be gone
+    if ( m_checkpoints.contains( sender() ) )
+        emit checkpoint( m_checkpoints.take( sender() ) );
+    if ( sender() == m_lastCommand )
+        m_lastCommand = 0;
+
     if ( --m_cmdQueue == 0 )
         cleanup();
 }
 
 
+void
+MusicScanner::filesListed( const QString& dir, const QStringList& paths )
+{
+    if ( paths.isEmpty() )
+        dirDone( dir );
+    else
+        m_pendingDirFiles[ dir ] = paths.count();
+}
+
+
+void
+MusicScanner::fileDone( const QFileInfo& fi )
+{
+    if ( m_scanMode != MusicScanner::DirScan )
+        return;
+
+    // DirLister keys directories by their canonical path, the scan paths themselves may be symlinks
+    if ( fi.absolutePath() != m_lastDir )
+    {
+        m_lastDir = fi.absolutePath();
+        m_lastCanonicalDir = QDir( m_lastDir ).canonicalPath();
+    }
+
+    QHash< QString, int >::iterator it = m_pendingDirFiles.find( m_lastCanonicalDir );
+    if ( it != m_pendingDirFiles.end() && --it.value() == 0 )
+    {
+        m_pendingDirFiles.erase( it );
+        dirDone( m_lastCanonicalDir );
+    }
+}
+
+
+void
+MusicScanner::dirDone( const QString& dir )
+{
+    m_uncommittedDirs << dir;
+
+    // while files are waiting for the next batch, the directories go with that batch
+    if ( !m_scannedfiles.isEmpty() || !m_filesToDelete.isEmpty() )
+        return;
+
+    // otherwise their files are either unchanged or part of a command we already queued
+    if ( m_lastCommand )
+    {
+        m_checkpoints[ m_lastCommand ] << m_uncommittedDirs;
+        m_uncommittedDirs.clear();
+    }
+    else if ( m_uncommittedDirs.count() >= CHECKPOINT_DIRS )
+    {
+        emit checkpoint( m_uncommittedDirs );
+        m_uncommittedDirs.clear();
+    }
+}
+
+
 void
 MusicScanner::scanFile( const QFileInfo& fi )
+{
+    queueFile( fi );
+    fileDone( fi );
+}
+
+
+void
+MusicScanner::queueFile( const QFileInfo& fi )
 {
     if ( m_filemtimes.contains( "file://" + fi.canonicalFilePath() ) )
     {
@@ -337,12 +469,10 @@ MusicScanner::scanFile( const QFileInfo& fi )
     }
 
     //tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Scanning file:" << fi.canonicalFilePath();
-    QVariant m = readFile( fi );
-    if ( m.toMap().isEmpty() )
+    if ( !readFile( fi, m_scannedfiles ) )
         return;
 
-    m_scannedfiles << m;
-    if ( m_batchsize != 0 && (quint32)m_scannedfiles.length() >= m_batchsize )
+    if ( m_batchsize != 0 && (quint32)m_scannedfiles.count() >= m_batchsize )
     {
         emit batchReady( m_scannedfiles, m_filesToDelete );
         m_scannedfiles.clear();
@@ -351,14 +481,14 @@ MusicScanner::scanFile( const QFileInfo& fi )
 }
 
 
-QVariant
-MusicScanner::readFile( const QFileInfo& fi )
+bool
+MusicScanner::readFile( const QFileInfo& fi, FileBatch& batch )
 {
     const QString suffix = fi.suffix().toLower();
 
     if ( !m_ext2mime.contains( suffix ) )
     {
-        return QVariantMap(); // invalid extension
+        return false; // invalid extension
     }
 
     if ( m_scanned )
@@ -374,12 +504,19 @@ MusicScanner::readFile( const QFileInfo& fi )
         const char *encodedName = fileName.constData();
     #endif
 
+#ifdef TOMAHAWK_TAGLIB_IOSTREAM
+    // the stream must outlive the FileRef, which owns the TagLib::File reading from it
+    Tomahawk::ReadAheadStream stream( fi.canonicalFilePath() );
+    TagLib::File* file = Tomahawk::ReadAheadStream::createFile( &stream, suffix );
+    TagLib::FileRef f = file ? TagLib::FileRef( file ) : TagLib::FileRef( encodedName );
+#else
     TagLib::FileRef f( encodedName );
+#endif
     if ( f.isNull() || !f.tag() )
     {
         m_skippedFiles << fi.canonicalFilePath();
         m_skipped++;
-        return QVariantMap();
+        return false;
     }
 
     int bitrate = 0;
@@ -405,30 +542,26 @@ MusicScanner::readFile( const QFileInfo& fi )
         // FIXME: do some clever filename guessing
         m_skippedFiles << fi.canonicalFilePath();
         m_skipped++;
-        return QVariantMap();
+        return false;
     }
 
-    QString mimetype = m_ext2mime.value( suffix );
-    QString url( "file://%1" );
-
-    QVariantMap m;
-    m["url"]          = url.arg( fi.canonicalFilePath() );
-    m["mtime"]        = fi.lastModified().toUTC().toTime_t();
-    m["size"]         = (unsigned int)fi.size();
-    m["mimetype"]     = mimetype;
-    m["duration"]     = duration;
-    m["bitrate"]      = bitrate;
-    m["artist"]       = artist;
-    m["album"]        = album;
-    m["track"]        = track;
-    m["albumpos"]     = tag->track();
-    m["year"]         = tag->year();
-    m["albumartist"]  = tag->albumArtist();
-    m["composer"]     = tag->composer();
-    m["discnumber"]   = tag->discNumber();
-    m["hash"]         = ""; // TODO
+    batch.append( QString( "file://%1" ).arg( fi.canonicalFilePath() ),
+                  fi.lastModified().toUTC().toTime_t(),
+                  (unsigned int)fi.size(),
+                  QString( "" ), // TODO: hash
+                  m_ext2mime.value( suffix ),
+                  duration,
+                  bitrate,
+                  artist,
+                  album,
+                  track,
+                  tag->track(),
+                  tag->year(),
+                  tag->albumArtist(),
+                  tag->composer(),
+                  tag->discNumber() );
 
     m_scanned++;
-    return m;
+    return true;
 }
 
@@ -22,6 +22,7 @@
 
 #include "TomahawkSettings.h"
 #include "database/DatabaseCommand.h"
+#include "database/FileBatch.h"
 
 /* taglib */
 #include <taglib/fileref.h>
@@ -36,6 +37,8 @@
 #include <QMutex>
 #include <QMutexLocker>
 #include <QPointer>
+#include <QSet>
+#include <QHash>
 #include <database/Database.h>
 
 // descend dir tree comparing dir mtimes to last known mtime
@@ -47,8 +50,8 @@ Q_OBJECT
 
 public:
 
-    DirLister( const QStringList& dirs )
-        : QObject(), m_dirs( dirs ), m_opcount( 0 ), m_deleting( false )
+    DirLister( const QStringList& dirs, const QSet< QString >& completedDirs = QSet< QString >(), const QSet< QString >& prefetchSuffixes = QSet< QString >() )
+        : QObject(), m_dirs( dirs ), m_completedDirs( completedDirs ), m_prefetchSuffixes( prefetchSuffixes ), m_opcount( 0 ), m_deleting( false )
     {
         qDebug() << Q_FUNC_INFO;
     }
@@ -62,6 +65,7 @@ public:
     void setIsDeleting() { QMutexLocker locker( &m_deletingMutex ); m_deleting = true; };
 
 signals:
+    void filesListed( const QString& dir, const QStringList& paths );
     void fileToScan( QFileInfo );
     void finished();
 
@@ -71,6 +75,8 @@ private slots:
 
 private:
     QStringList m_dirs;
+    QSet< QString > m_completedDirs; // files already committed by an interrupted scan
+    QSet< QString > m_prefetchSuffixes; // files the scanner reads tags from
 
     uint m_opcount;
     QMutex m_deletingMutex;
@@ -86,11 +92,15 @@ public:
     virtual ~DirListerThreadController();
 
     void setPaths( const QStringList& paths ) { m_paths = paths; }
+    void setCompletedDirs( const QSet< QString >& dirs ) { m_completedDirs = dirs; }
+    void setPrefetchSuffixes( const QSet< QString >& suffixes ) { m_prefetchSuffixes = suffixes; }
     void run();
 
 private:
     QPointer< DirLister > m_dirLister;
     QStringList m_paths;
+    QSet< QString > m_completedDirs;
+    QSet< QString > m_prefetchSuffixes;
 };
 
 class MusicScanner : public QObject
@@ -101,30 +111,37 @@ public:
     enum ScanMode { DirScan, FileScan };
     enum ScanType { None, Full, Normal, File };
 
-    MusicScanner( MusicScanner::ScanMode scanMode, const QStringList& paths, quint32 bs = 0 );
+    MusicScanner( MusicScanner::ScanMode scanMode, const QStringList& paths, quint32 bs = 0, const QStringList& completedDirs = QStringList() );
     ~MusicScanner();
 
 signals:
     //void fileScanned( QVariantMap );
     void finished();
-    void batchReady( const QVariantList&, const QVariantList& );
+    void batchReady( const FileBatch&, const QVariantList& );
+
+    // directories whose files are all committed to the database now
+    void checkpoint( const QStringList& dirs );
 
 private:
-    QVariant readFile( const QFileInfo& fi );
+    bool readFile( const QFileInfo& fi, FileBatch& batch );
     void executeCommand( QSharedPointer< DatabaseCommand > cmd );
 
 private slots:
     void postOps();
+    void filesListed( const QString& dir, const QStringList& paths );
     void scanFile( const QFileInfo& fi );
     void setFileMtimes( const QMap< QString, QMap< unsigned int, unsigned int > >& m );
     void startScan();
     void scan();
     void cleanup();
-    void commitBatch( const QVariantList& tracks, const QVariantList& deletethese );
+    void commitBatch( const FileBatch& tracks, const QVariantList& deletethese );
     void commandFinished();
 
 private:
     void scanFilePaths();
+    void queueFile( const QFileInfo& fi );
+    void fileDone( const QFileInfo& fi );
+    void dirDone( const QString& dir );
 
     MusicScanner::ScanMode m_scanMode;
     QStringList m_paths;
@@ -137,10 +154,18 @@ private:
 
     unsigned int m_cmdQueue;
 
-    QVariantList m_scannedfiles;
+    FileBatch m_scannedfiles;
     QVariantList m_filesToDelete;
     quint32 m_batchsize;
 
+    QSet< QString > m_completedDirs;
+    QHash< QString, int > m_pendingDirFiles;
+    QStringList m_uncommittedDirs;
+    QHash< QObject*, QStringList > m_checkpoints;
+    QObject* m_lastCommand;
+    QString m_lastDir;
+    QString m_lastCanonicalDir;
+
     DirListerThreadController* m_dirListerThreadController;
 };
 
@@ -0,0 +1,288 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ReadAheadStream.h"
+
+#include "utils/Logger.h"
+
+#include <taglib/id3v2framefactory.h>
+#include <taglib/vorbisfile.h>
+#include <taglib/oggflacfile.h>
+#include <taglib/flacfile.h>
+#include <taglib/mpegfile.h>
+#include <taglib/mp4file.h>
+#include <taglib/mpcfile.h>
+#include <taglib/asffile.h>
+#include <taglib/aifffile.h>
+#include <taglib/wavpackfile.h>
+
+#ifdef Q_OS_LINUX
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <string.h>
+
+// ID3v2 tags with embedded cover art easily exceed 64 KiB, MP4 files usually
+// keep their moov atom either right at the start or right at the end.
+#define HEAD_SIZE   ( 256 * 1024 )
+#define TAIL_SIZE   ( 128 * 1024 )
+#define WINDOW_SIZE ( 64 * 1024 )
+
+namespace Tomahawk
+{
+
+#ifdef TOMAHAWK_TAGLIB_IOSTREAM
+
+ReadAheadStream::ReadAheadStream( const QString& path )
+    : m_file( path )
+    , m_pos( 0 )
+    , m_length( 0 )
+    , m_tailStart( 0 )
+    , m_windowStart( 0 )
+{
+#ifdef COMPLEX_TAGLIB_FILENAME
+    m_name = path;
+#else
+    m_name = QFile::encodeName( path );
+#endif
+
+    if ( !m_file.open( QIODevice::ReadOnly ) )
+    {
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Could not open file:" << path;
+        return;
+    }
+
+    m_length = m_file.size();
+    m_head = m_file.read( qMin( m_length, (long)HEAD_SIZE ) );
+
+    if ( m_length > m_head.size() )
+    {
+        m_tailStart = qMax( (long)m_head.size(), m_length - TAIL_SIZE );
+        if ( m_file.seek( m_tailStart ) )
+            m_tail = m_file.read( m_length - m_tailStart );
+    }
+}
+
+
+ReadAheadStream::~ReadAheadStream()
+{
+}
+
+
+TagLib::File*
+ReadAheadStream::createFile( ReadAheadStream* stream, const QString& suffix )
+{
+    if ( !stream->isOpen() )
+        return 0;
+
+    if ( suffix == "mp3" )
+        return new TagLib::MPEG::File( stream, TagLib::ID3v2::FrameFactory::instance() );
+    if ( suffix == "flac" )
+        return new TagLib::FLAC::File( stream, TagLib::ID3v2::FrameFactory::instance() );
+    if ( suffix == "ogg" )
+        return new TagLib::Ogg::Vorbis::File( stream );
+    if ( suffix == "oga" )
+    {
+        // same order TagLib::FileRef uses: Ogg FLAC first, then Vorbis
+        TagLib::File* file = new TagLib::Ogg::FLAC::File( stream );
+        if ( file->isValid() )
+            return file;
+
+        delete file;
+        stream->seek( 0 );
+        return new TagLib::Ogg::Vorbis::File( stream );
+    }
+    if ( suffix == "mpc" )
+        return new TagLib::MPC::File( stream );
+    if ( suffix == "wma" )
+        return new TagLib::ASF::File( stream );
+    if ( suffix == "m4a" || suffix == "mp4" )
+        return new TagLib::MP4::File( stream );
+    if ( suffix == "aiff" || suffix == "aif" )
+        return new TagLib::RIFF::AIFF::File( stream );
+    if ( suffix == "wv" )
+        return new TagLib::WavPack::File( stream );
+
+    return 0;
+}
+
+
+TagLib::FileName
+ReadAheadStream::name() const
+{
+#ifdef COMPLEX_TAGLIB_FILENAME
+    return reinterpret_cast< const wchar_t* >( m_name.utf16() );
+#else
+    return m_name.constData();
+#endif
+}
+
+
+TagLib::ByteVector
+ReadAheadStream::readBlock( TagLib::ulong length )
+{
+    if ( m_pos >= m_length || !length )
+        return TagLib::ByteVector::null;
+
+    const long wanted = qMin( (long)length, m_length - m_pos );
+    TagLib::ByteVector block( (uint)wanted, 0 );
+    long copied = 0;
+
+    while ( copied < wanted )
+    {
+        const QByteArray* buffer = 0;
+        long bufferStart = 0;
+
+        if ( m_pos < m_head.size() )
+        {
+            buffer = &m_head;
+        }
+        else if ( !m_tail.isEmpty() && m_pos >= m_tailStart && m_pos < m_tailStart + m_tail.size() )
+        {
+            buffer = &m_tail;
+            bufferStart = m_tailStart;
+        }
+        else if ( !m_window.isEmpty() && m_pos >= m_windowStart && m_pos < m_windowStart + m_window.size() )
+        {
+            buffer = &m_window;
+            bufferStart = m_windowStart;
+        }
+        else if ( fillWindow( m_pos, wanted - copied ) )
+        {
+            continue;
+        }
+        else
+        {
+            break;
+        }
+
+        const long available = qMin( wanted - copied, bufferStart + buffer->size() - m_pos );
+        memcpy( block.data() + copied, buffer->constData() + ( m_pos - bufferStart ), available );
+        copied += available;
+        m_pos += available;
+    }
+
+    if ( copied < wanted )
+        block.resize( (uint)copied );
+
+    return block;
+}
+
+
+bool
+ReadAheadStream::fillWindow( long offset, long length )
+{
+    if ( !m_file.seek( offset ) )
+        return false;
+
+    // don't read into the tail, we already have that
+    long size = qMax( length, (long)WINDOW_SIZE );
+    if ( !m_tail.isEmpty() && offset < m_tailStart )
+        size = qMin( size, m_tailStart - offset );
+
+    m_window = m_file.read( size );
+    m_windowStart = offset;
+
+    return !m_window.isEmpty();
+}
+
+
+void
+ReadAheadStream::seek( long offset, Position p )
+{
+    switch ( p )
+    {
+        case Beginning:
+            m_pos = offset;
+            break;
+        case Current:
+            m_pos += offset;
+            break;
+        case End:
+            m_pos = m_length + offset;
+            break;
+    }
+
+    m_pos = qMax( 0L, m_pos );
+}
+
+
+void
+ReadAheadStream::writeBlock( const TagLib::ByteVector& data )
+{
+    Q_UNUSED( data );
+    tDebug() << Q_FUNC_INFO << "Trying to write to read-only stream:" << m_file.fileName();
+}
+
+
+void
+ReadAheadStream::insert( const TagLib::ByteVector& data, TagLib::ulong start, TagLib::ulong replace )
+{
+    Q_UNUSED( data );
+    Q_UNUSED( start );
+    Q_UNUSED( replace );
+    tDebug() << Q_FUNC_INFO << "Trying to write to read-only stream:" << m_file.fileName();
+}
+
+
+void
+ReadAheadStream::removeBlock( TagLib::ulong start, TagLib::ulong length )
+{
+    Q_UNUSED( start );
+    Q_UNUSED( length );
+    tDebug() << Q_FUNC_INFO << "Trying to write to read-only stream:" << m_file.fileName();
+}
+
+
+void
+ReadAheadStream::truncate( long length )
+{
+    Q_UNUSED( length );
+    tDebug() << Q_FUNC_INFO << "Trying to write to read-only stream:" << m_file.fileName();
+}
+
+#endif
+
+
+void
+prefetchTagRegions( const QString& path )
+{
+#ifdef Q_OS_LINUX
+    const QByteArray fileName = QFile::encodeName( path );
+    int fd = ::open( fileName.constData(), O_RDONLY );
+    if ( fd < 0 )
+        return;
+
+    struct stat st;
+    if ( ::fstat( fd, &st ) == 0 )
+    {
+        // asynchronous: the kernel starts reading while the scanner is still busy with earlier files
+        ::posix_fadvise( fd, 0, HEAD_SIZE, POSIX_FADV_WILLNEED );
+        if ( st.st_size > HEAD_SIZE )
+            ::posix_fadvise( fd, qMax( (off_t)HEAD_SIZE, st.st_size - TAIL_SIZE ), TAIL_SIZE, POSIX_FADV_WILLNEED );
+    }
+
+    ::close( fd );
+#else
+    Q_UNUSED( path );
+#endif
+}
+
+}
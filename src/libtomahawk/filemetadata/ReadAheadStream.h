@@ -0,0 +1,94 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef READAHEADSTREAM_H
+#define READAHEADSTREAM_H
+
+#include <taglib/taglib.h>
+#include <taglib/tfile.h>
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include "DllMacro.h"
+
+// TagLib::IOStream was introduced with TagLib 1.8
+#if TAGLIB_MAJOR_VERSION > 1 || ( TAGLIB_MAJOR_VERSION == 1 && TAGLIB_MINOR_VERSION >= 8 )
+    #define TOMAHAWK_TAGLIB_IOSTREAM
+#endif
+
+namespace Tomahawk
+{
+
+/**
+ * Feeds TagLib from a few large sequential reads instead of letting it seek and
+ * read tiny blocks all over the file. On network filesystems every one of those
+ * small reads is a round-trip, so we read the head and the tail of the file
+ * (where ID3v2, APE, ID3v1 and most MP4 atoms live) in one go and serve
+ * everything else from a read-ahead window.
+ */
+#ifdef TOMAHAWK_TAGLIB_IOSTREAM
+class DLLEXPORT ReadAheadStream : public TagLib::IOStream
+{
+public:
+    explicit ReadAheadStream( const QString& path );
+    virtual ~ReadAheadStream();
+
+    /// Creates the TagLib::File matching suffix on top of stream, or 0 if we don't know the type.
+    static TagLib::File* createFile( ReadAheadStream* stream, const QString& suffix );
+
+    virtual TagLib::FileName name() const;
+    virtual TagLib::ByteVector readBlock( TagLib::ulong length );
+    virtual void writeBlock( const TagLib::ByteVector& data );
+    virtual void insert( const TagLib::ByteVector& data, TagLib::ulong start = 0, TagLib::ulong replace = 0 );
+    virtual void removeBlock( TagLib::ulong start = 0, TagLib::ulong length = 0 );
+    virtual bool readOnly() const { return true; }
+    virtual bool isOpen() const { return m_file.isOpen(); }
+    virtual void seek( long offset, Position p = Beginning );
+    virtual long tell() const { return m_pos; }
+    virtual long length() { return m_length; }
+    virtual void truncate( long length );
+
+private:
+    bool fillWindow( long offset, long length );
+
+    QFile m_file;
+#ifdef COMPLEX_TAGLIB_FILENAME
+    QString m_name;
+#else
+    QByteArray m_name;
+#endif
+
+    long m_pos;
+    long m_length;
+
+    QByteArray m_head;
+    QByteArray m_tail;
+    long m_tailStart;
+    QByteArray m_window;
+    long m_windowStart;
+};
+#endif
+
+/// Hints the OS to start fetching the tag regions of path in the background, see DirLister.
+DLLEXPORT void prefetchTagRegions( const QString& path );
+
+}
+
+#endif // READAHEADSTREAM_H
@@ -32,13 +32,20 @@
 
 #include <QThread>
 #include <QCoreApplication>
+#include <QDataStream>
+#include <QFile>
 #include <QTimer>
 #include <QSet>
 
+// commit (and checkpoint) a directory scan every this many new files
+#define SCANNER_BATCH_SIZE 1000
+// progress of an interrupted directory scan: its paths, then every committed dir appended as it's done
+#define SCANNER_CHECKPOINT_FILE "scannercheckpoint"
+
 
 MusicScannerThreadController::MusicScannerThreadController( QObject* parent )
     : QThread( parent )
-    , m_bs( 0 )
+    , m_bs( SCANNER_BATCH_SIZE )
 {
     tDebug() << Q_FUNC_INFO;
 }
@@ -53,7 +60,8 @@ MusicScannerThreadController::~MusicScannerThreadController()
 void
 MusicScannerThreadController::run()
 {
-    m_musicScanner = QPointer< MusicScanner >( new MusicScanner( m_mode, m_paths, m_bs ) );
+    m_musicScanner = QPointer< MusicScanner >( new MusicScanner( m_mode, m_paths, m_bs, m_completedDirs ) );
+    connect( m_musicScanner.data(), SIGNAL( checkpoint( QStringList ) ), parent(), SLOT( scannerCheckpoint( QStringList ) ), Qt::QueuedConnection );
     connect( m_musicScanner.data(), SIGNAL( finished() ), parent(), SLOT( scannerFinished() ), Qt::QueuedConnection );
     QMetaObject::invokeMethod( m_musicScanner.data(), "startScan", Qt::QueuedConnection );
 
@@ -74,13 +82,15 @@ ScanManager::instance()
 }
 
 
-ScanManager::ScanManager( QObject* parent )
+ScanManager::ScanManager( QObject* parent, bool scheduleScans )
     : QObject( parent )
     , m_musicScannerThreadController( 0 )
     , m_currScannerPaths()
     , m_cachedScannerDirs()
     , m_queuedScanType( MusicScanner::None )
     , m_updateGUI( true )
+    , m_startupScanStarted( false )
+    , m_scheduleScans( scheduleScans )
 {
     s_instance = this;
 
@@ -94,9 +104,12 @@ ScanManager::ScanManager( QObject* parent )
     if ( TomahawkSettings::instance()->hasScannerPaths() )
     {
         m_cachedScannerDirs = TomahawkSettings::instance()->scannerPaths();
-        m_scanTimer->start();
-        if ( TomahawkSettings::instance()->watchForChanges() )
-            QTimer::singleShot( 1000, this, SLOT( runStartupScan() ) );
+        if ( m_scheduleScans )
+        {
+            m_scanTimer->start();
+            if ( TomahawkSettings::instance()->watchForChanges() )
+                QTimer::singleShot( 1000, this, SLOT( runStartupScan() ) );
+        }
     }
 }
 
@@ -132,7 +145,7 @@ ScanManager::onSettingsChanged()
         runNormalScan();
     }
 
-    if ( TomahawkSettings::instance()->watchForChanges() && !m_scanTimer->isActive() )
+    if ( TomahawkSettings::instance()->watchForChanges() && !m_scanTimer->isActive() && m_scheduleScans )
         m_scanTimer->start();
 }
 
@@ -141,10 +154,18 @@ void
 ScanManager::runStartupScan()
 {
     tLog( LOGVERBOSE ) << Q_FUNC_INFO;
+
+    // we schedule one ourselves when watching for changes and --scan-only asks for one as well
+    if ( m_startupScanStarted )
+        return;
+
     if ( !Database::instance() || ( Database::instance() && !Database::instance()->isReady() ) )
         QTimer::singleShot( 1000, this, SLOT( runStartupScan() ) );
     else
+    {
+        m_startupScanStarted = true;
         runNormalScan();
+    }
 }
 
 
@@ -199,6 +220,9 @@ ScanManager::runNormalScan( bool manualFull )
 
     if ( manualFull )
     {
+        // everything is going to be scanned again, nothing to resume
+        QFile::remove( checkpointFile() );
+
         DatabaseCommand_DeleteFiles *cmd = new DatabaseCommand_DeleteFiles( SourceList::instance()->getLocal() );
         connect( cmd, SIGNAL( finished() ), SLOT( filesDeleted() ) );
         Database::instance()->enqueue( QSharedPointer< DatabaseCommand >( cmd ) );
@@ -281,16 +305,119 @@ ScanManager::runScan()
 
     QStringList paths = m_currScannerPaths.empty() ? TomahawkSettings::instance()->scannerPaths() : m_currScannerPaths.toList();
 
+    m_checkpointPaths.clear();
+    m_checkpointDirs.clear();
+    if ( m_currScanMode == MusicScanner::DirScan )
+    {
+        // resume an interrupted scan of the same paths, or start a new checkpoint
+        QStringList checkpointPaths;
+        readCheckpoint( checkpointPaths, m_checkpointDirs );
+        if ( checkpointPaths != paths )
+            m_checkpointDirs.clear();
+
+        // written out once in full, so appending never continues after a record a crash cut short
+        startCheckpoint( paths );
+        appendCheckpoint( m_checkpointDirs );
+
+        m_checkpointPaths = paths;
+    }
+
     m_musicScannerThreadController->setScanMode( m_currScanMode );
     m_musicScannerThreadController->setPaths( paths );
+    m_musicScannerThreadController->setCompletedDirs( m_checkpointDirs );
     m_musicScannerThreadController->start( QThread::IdlePriority );
 }
 
 
+void
+ScanManager::scannerCheckpoint( const QStringList& dirs )
+{
+    if ( m_checkpointPaths.isEmpty() )
+        return;
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Committed" << dirs.count() << "more dirs";
+    m_checkpointDirs << dirs;
+    appendCheckpoint( dirs );
+}
+
+
+QString
+ScanManager::checkpointFile()
+{
+    return TomahawkUtils::appDataDir().absoluteFilePath( SCANNER_CHECKPOINT_FILE );
+}
+
+
+void
+ScanManager::readCheckpoint( QStringList& paths, QStringList& dirs )
+{
+    QFile f( checkpointFile() );
+    if ( !f.open( QIODevice::ReadOnly ) )
+        return;
+
+    QDataStream stream( &f );
+    stream >> paths;
+    if ( stream.status() != QDataStream::Ok )
+    {
+        paths.clear();
+        return;
+    }
+
+    while ( !stream.atEnd() )
+    {
+        QString dir;
+        stream >> dir;
+
+        // whatever was cut short by a crash while appending
+        if ( stream.status() != QDataStream::Ok )
+            break;
+
+        dirs << dir;
+    }
+}
+
+
+void
+ScanManager::startCheckpoint( const QStringList& paths )
+{
+    QFile f( checkpointFile() );
+    if ( !f.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        tLog() << Q_FUNC_INFO << "Can't write scanner checkpoint:" << f.errorString();
+        return;
+    }
+
+    QDataStream stream( &f );
+    stream << paths;
+}
+
+
+void
+ScanManager::appendCheckpoint( const QStringList& dirs )
+{
+    // only the new dirs, rewriting all of them on every commit adds up on large collections
+    QFile f( checkpointFile() );
+    if ( !f.open( QIODevice::WriteOnly | QIODevice::Append ) )
+        return;
+
+    QDataStream stream( &f );
+    foreach ( const QString& dir, dirs )
+        stream << dir;
+}
+
+
 void
 ScanManager::scannerFinished()
 {
     tLog( LOGVERBOSE ) << Q_FUNC_INFO;
+    if ( !m_checkpointPaths.isEmpty() )
+    {
+        // the scan went all the way through, next time starts from scratch
+        QFile::remove( checkpointFile() );
+        m_checkpointPaths.clear();
+        m_checkpointDirs.clear();
+    }
+
     if ( m_musicScannerThreadController )
     {
         m_musicScannerThreadController->quit();
@@ -46,13 +46,15 @@ public:
 
     void setScanMode( MusicScanner::ScanMode mode ) { m_mode = mode; }
     void setPaths( const QStringList& paths ) { m_paths = paths; }
+    void setCompletedDirs( const QStringList& dirs ) { m_completedDirs = dirs; }
     void run();
 
 private:
     QPointer< MusicScanner > m_musicScanner;
     MusicScanner::ScanMode m_mode;
     QStringList m_paths;
-    quint32 m_bs; 
+    QStringList m_completedDirs;
+    quint32 m_bs;
 };
 
 
@@ -63,7 +65,8 @@ Q_OBJECT
 public:
     static ScanManager* instance();
 
-    explicit ScanManager( QObject* parent = 0 );
+    // without scheduleScans it only scans when asked to, e.g. for --scan-only
+    explicit ScanManager( QObject* parent = 0, bool scheduleScans = true );
     virtual ~ScanManager();
 
 signals:
@@ -73,11 +76,12 @@ public slots:
     void runFileScan( const QStringList& paths = QStringList(), bool updateGUI = true );
     void runFullRescan();
     void runNormalScan( bool manualFull = false );
+    void runStartupScan();
 
 private slots:
-    void runStartupScan();
     void runScan();
 
+    void scannerCheckpoint( const QStringList& dirs );
     void scannerFinished();
     void scanTimerTimeout();
 
@@ -87,17 +91,27 @@ private slots:
     void filesDeleted();
 
 private:
+    // the checkpoint file in appDataDir(), see SCANNER_CHECKPOINT_FILE
+    static QString checkpointFile();
+    static void readCheckpoint( QStringList& paths, QStringList& dirs );
+    static void startCheckpoint( const QStringList& paths );
+    static void appendCheckpoint( const QStringList& dirs );
+
     static ScanManager* s_instance;
 
     MusicScanner::ScanMode m_currScanMode;
     MusicScannerThreadController* m_musicScannerThreadController;
     QSet< QString > m_currScannerPaths;
     QStringList m_cachedScannerDirs;
+    QStringList m_checkpointPaths;
+    QStringList m_checkpointDirs;
 
     QTimer* m_scanTimer;
     MusicScanner::ScanType m_queuedScanType;
 
     bool m_updateGUI;
+    bool m_startupScanStarted;
+    bool m_scheduleScans;
 };
 
 #endif
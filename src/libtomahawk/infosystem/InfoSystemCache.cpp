@@ -30,9 +30,13 @@
 #include "Source.h"
 
 #include <QDir>
-#include <QSettings>
+#include <QDataStream>
 #include <QCryptographicHash>
 
+// flush after this many changes, or FLUSH_INTERVAL ms after the first one
+#define MAX_PENDING_WRITES 100
+#define FLUSH_INTERVAL 5000
+
 namespace Tomahawk
 {
 
@@ -43,7 +47,8 @@ namespace InfoSystem
 InfoSystemCache::InfoSystemCache( QObject* parent )
     : QObject( parent )
     , m_cacheBaseDir( TomahawkSettings::instance()->storageCacheLocation() + "/InfoSystemCache/" )
-    , m_cacheVersion( 3 )
+    , m_store( 0 )
+    , m_cacheVersion( 4 )
 {
     tDebug() << Q_FUNC_INFO;
     TomahawkSettings *s = TomahawkSettings::instance();
@@ -62,6 +67,15 @@ InfoSystemCache::InfoSystemCache( QObject* parent )
         s->setInfoSystemCacheVersion( m_cacheVersion );
     }
 
+    QDir().mkpath( m_cacheBaseDir );
+    m_store = new TomahawkUtils::LogStore( m_cacheBaseDir + "cache.dat" );
+    if ( !m_store->open() )
+        tLog() << "Failed to open info system cache" << m_cacheBaseDir + "cache.dat";
+
+    m_flushTimer.setInterval( FLUSH_INTERVAL );
+    m_flushTimer.setSingleShot( true );
+    connect( &m_flushTimer, SIGNAL( timeout() ), SLOT( flushTimerFired() ) );
+
     m_pruneTimer.setInterval( 300000 );
     m_pruneTimer.setSingleShot( false );
     connect( &m_pruneTimer, SIGNAL( timeout() ), SLOT( pruneTimerFired() ) );
@@ -72,6 +86,9 @@ InfoSystemCache::InfoSystemCache( QObject* parent )
 InfoSystemCache::~InfoSystemCache()
 {
     tDebug() << Q_FUNC_INFO;
+
+    m_store->flush();
+    delete m_store;
 }
 
 
@@ -115,6 +132,13 @@ InfoSystemCache::doUpgrade( uint oldVersion, uint newVersion )
 
         performWipe( m_cacheBaseDir + "/InfoSystemCache/" );
     }
+
+    if ( oldVersion == 3 )
+    {
+        qDebug() << Q_FUNC_INFO << "Dropping file-per-entry cache";
+
+        performWipe( m_cacheBaseDir );
+    }
 }
 
 
@@ -122,121 +146,78 @@ void
 InfoSystemCache::pruneTimerFired()
 {
     qDebug() << Q_FUNC_INFO << "Pruning infosystemcache";
-    qlonglong currentMSecsSinceEpoch = QDateTime::currentMSecsSinceEpoch();
 
-    for ( int i = InfoNoInfo; i <= InfoLastInfo; i++ )
-    {
-        InfoType type = (InfoType)(i);
-        QHash< QString, QString > fileLocationHash = m_fileLocationCache[type];
-        const QString cacheDirName = m_cacheBaseDir + QString::number( (int)type );
-        QFileInfoList fileList = QDir( cacheDirName ).entryInfoList( QDir::Files | QDir::NoDotAndDotDot );
-        foreach ( QFileInfo file, fileList )
-        {
-            QString baseName = file.baseName();
-            if ( file.suffix().toLongLong() < currentMSecsSinceEpoch )
-            {
-                if ( !QFile::remove( file.canonicalFilePath() ) )
-                    tLog() << "Failed to remove stale cache file" << file.canonicalFilePath();
-                else
-                    qDebug() << "Removed stale cache file" << file.canonicalFilePath();
-            }
-            if ( fileLocationHash.contains( baseName ) )
-                fileLocationHash.remove( baseName );
-        }
-        m_fileLocationCache[type] = fileLocationHash;
-    }
+    const int removed = m_store->removeExpired( QDateTime::currentMSecsSinceEpoch() );
+    m_store->flush();
+
+    // we live in our own thread, so rewriting the file doesn't block anyone
+    if ( m_store->needsCompaction() )
+        m_store->compact();
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Removed" << removed << "stale entries," << m_store->count() << "left";
 }
 
 
 void
-InfoSystemCache::getCachedInfoSlot( Tomahawk::InfoSystem::InfoStringHash criteria, qint64 newMaxAge, Tomahawk::InfoSystem::InfoRequestData requestData )
+InfoSystemCache::flushTimerFired()
 {
-    QObject* sendingObj = sender();
-    const QString criteriaHashVal = criteriaMd5( criteria );
-    const QString criteriaHashValWithType = criteriaMd5( criteria, requestData.type );
-    QHash< QString, QString > fileLocationHash = m_fileLocationCache[ requestData.type ];
-    if ( !fileLocationHash.contains( criteriaHashVal ) )
-    {
-        if ( !fileLocationHash.isEmpty() )
-        {
-            //We already know of some values, so no need to re-read the directory again as it's already happened
-            //qDebug() << Q_FUNC_INFO << "notInCache -- filelocationhash empty";
-            notInCache( sendingObj, criteria, requestData );
-            return;
-        }
-
-        const QString cacheDir = m_cacheBaseDir + QString::number( (int)requestData.type );
-        QDir dir( cacheDir );
-        if ( !dir.exists() )
-        {
-            //Dir doesn't exist so clearly not in cache
-            //qDebug() << Q_FUNC_INFO << "notInCache -- dir doesn't exist";
-            notInCache( sendingObj, criteria, requestData );
-            return;
-        }
+    m_store->flush();
+}
 
-        QFileInfoList fileList = dir.entryInfoList( QDir::Files | QDir::NoDotAndDotDot );
-        foreach ( QFileInfo file, fileList )
-        {
-            QString baseName = file.baseName();
-            fileLocationHash[ baseName ] = file.canonicalFilePath();
-        }
 
-        //Store what we've loaded up
-        m_fileLocationCache[ requestData.type ] = fileLocationHash;
-        if ( !fileLocationHash.contains( criteriaHashVal ) )
-        {
-            //Still didn't find it? It's really not in the cache then
-            //qDebug() << Q_FUNC_INFO << "notInCache -- filelocationhash doesn't contain criteria val";
-            notInCache( sendingObj, criteria, requestData );
-            return;
-        }
+void
+InfoSystemCache::scheduleFlush()
+{
+    if ( m_store->pendingWrites() >= MAX_PENDING_WRITES )
+    {
+        m_flushTimer.stop();
+        m_store->flush();
     }
+    else if ( !m_flushTimer.isActive() )
+        m_flushTimer.start();
+}
 
-    QFileInfo file( fileLocationHash[ criteriaHashVal ] );
-    qlonglong currMaxAge = file.suffix().toLongLong();
-
-    if ( currMaxAge < QDateTime::currentMSecsSinceEpoch() )
-    {
-        if ( !QFile::remove( file.canonicalFilePath() ) )
-            tLog() << "Failed to remove stale cache file" << file.canonicalFilePath();
-        else
-            qDebug() << "Removed stale cache file" << file.canonicalFilePath();
 
-        fileLocationHash.remove( criteriaHashVal );
-        m_fileLocationCache[ requestData.type ] = fileLocationHash;
-        m_dataCache.remove( criteriaHashValWithType );
+void
+InfoSystemCache::getCachedInfoSlot( Tomahawk::InfoSystem::InfoStringHash criteria, qint64 newMaxAge, Tomahawk::InfoSystem::InfoRequestData requestData )
+{
+    QObject* sendingObj = sender();
+    const QByteArray key = storeKey( criteria, requestData.type );
+    const QString dataCacheKey = QString::fromLatin1( key );
 
-        qDebug() << Q_FUNC_INFO << "notInCache -- file was stale";
+    if ( !m_store->contains( key ) )
+    {
+        m_dataCache.remove( dataCacheKey );
         notInCache( sendingObj, criteria, requestData );
         return;
     }
-    else if ( newMaxAge > 0 )
+
+    if ( newMaxAge > 0 )
     {
-        const QString newFilePath = QString( file.dir().canonicalPath() + '/' + criteriaHashVal + '.' + QString::number( QDateTime::currentMSecsSinceEpoch() + newMaxAge ) );
+        m_store->setExpiry( key, QDateTime::currentMSecsSinceEpoch() + newMaxAge );
+        scheduleFlush();
+    }
 
-        if ( !QFile::rename( file.canonicalFilePath(), newFilePath ) )
+    if ( !m_dataCache.contains( dataCacheKey ) )
+    {
+        const QByteArray data = m_store->value( key );
+        if ( data.isNull() )
         {
-            qDebug() << Q_FUNC_INFO << "notInCache -- failed to move old cache file to new location";
+            qDebug() << Q_FUNC_INFO << "notInCache -- value went stale";
             notInCache( sendingObj, criteria, requestData );
             return;
         }
 
-        fileLocationHash[ criteriaHashVal ] = newFilePath;
-        m_fileLocationCache[ requestData.type ] = fileLocationHash;
-    }
-
-    if ( !m_dataCache.contains( criteriaHashValWithType ) )
-    {
-        QSettings cachedSettings( fileLocationHash[ criteriaHashVal ], QSettings::IniFormat );
-        QVariant output = cachedSettings.value( "data" );
-        m_dataCache.insert( criteriaHashValWithType, new QVariant( output ) );
+        QVariant output;
+        QDataStream stream( data );
+        stream >> output;
+        m_dataCache.insert( dataCacheKey, new QVariant( output ) );
 
         emit info( requestData, output );
     }
     else
     {
-        emit info( requestData, QVariant( *( m_dataCache[ criteriaHashValWithType ] ) ) );
+        emit info( requestData, QVariant( *( m_dataCache[ dataCacheKey ] ) ) );
     }
 }
 
@@ -251,53 +232,16 @@ InfoSystemCache::notInCache( QObject *receiver, Tomahawk::InfoSystem::InfoString
 void
 InfoSystemCache::updateCacheSlot( Tomahawk::InfoSystem::InfoStringHash criteria, qint64 maxAge, Tomahawk::InfoSystem::InfoType type, QVariant output )
 {
-    //qDebug() << Q_FUNC_INFO;
-    const QString criteriaHashVal = criteriaMd5( criteria );
-    const QString criteriaHashValWithType = criteriaMd5( criteria, type );
-    const QString cacheDir = m_cacheBaseDir + QString::number( (int)type );
-    const QString settingsFilePath( cacheDir + '/' + criteriaHashVal + '.' + QString::number( QDateTime::currentMSecsSinceEpoch() + maxAge ) );
-
-    QHash< QString, QString > fileLocationHash = m_fileLocationCache[ type ];
-    if ( fileLocationHash.contains( criteriaHashVal ) )
-    {
-        if ( !QFile::rename( fileLocationHash[ criteriaHashVal ], settingsFilePath ) )
-        {
-            tLog() << "Failed to move old cache file to new location!";
-            return;
-        }
-        fileLocationHash[ criteriaHashVal ] = settingsFilePath;
-        m_fileLocationCache[ type ] = fileLocationHash;
-
-        QSettings cachedSettings( fileLocationHash[ criteriaHashVal ], QSettings::IniFormat );
-        cachedSettings.setValue( "data", output );
+    const QByteArray key = storeKey( criteria, type );
 
-        m_dataCache.insert( criteriaHashValWithType, new QVariant( output ) );
+    QByteArray data;
+    QDataStream stream( &data, QIODevice::WriteOnly );
+    stream << output;
 
-        return;
-    }
-
-    QDir dir( cacheDir );
-    if( !dir.exists( cacheDir ) )
-    {
-        qDebug() << "Creating cache directory " << cacheDir;
-        if( !dir.mkpath( cacheDir ) )
-        {
-            tLog() << "Failed to create cache dir! Bailing...";
-            return;
-        }
-    }
+    m_store->insert( key, data, QDateTime::currentMSecsSinceEpoch() + maxAge );
+    m_dataCache.insert( QString::fromLatin1( key ), new QVariant( output ) );
 
-    QSettings cachedSettings( settingsFilePath, QSettings::IniFormat );
-    QStringList keys = criteria.keys();
-    cachedSettings.beginGroup( "criteria" );
-    for( int i = 0; i < criteria.size(); i++ )
-        cachedSettings.setValue( keys.at( i ), criteria[keys.at( i )] );
-    cachedSettings.endGroup();
-    cachedSettings.setValue( "data", output );
-
-    fileLocationHash[criteriaHashVal] = settingsFilePath;
-    m_fileLocationCache[type] = fileLocationHash;
-    m_dataCache.insert( criteriaHashValWithType, new QVariant( output ) );
+    scheduleFlush();
 }
 
 
@@ -318,6 +262,13 @@ InfoSystemCache::criteriaMd5( const Tomahawk::InfoSystem::InfoStringHash &criter
 }
 
 
+QByteArray
+InfoSystemCache::storeKey( const Tomahawk::InfoSystem::InfoStringHash &criteria, Tomahawk::InfoSystem::InfoType type ) const
+{
+    return QString( QString::number( (int)type ) + '/' + criteriaMd5( criteria ) ).toLatin1();
+}
+
+
 } //namespace InfoSystem
 
 } //namespace Tomahawk
@@ -27,6 +27,7 @@
 #include <QTimer>
 
 #include "InfoSystem.h"
+#include "utils/LogStore.h"
 
 namespace Tomahawk
 {
@@ -52,16 +53,20 @@ public slots:
 
 private slots:
     void pruneTimerFired();
+    void flushTimerFired();
 
 private:
     void notInCache( QObject *receiver, Tomahawk::InfoSystem::InfoStringHash criteria, Tomahawk::InfoSystem::InfoRequestData requestData );
     void doUpgrade( uint oldVersion, uint newVersion );
     void performWipe( QString directory );
     const QString criteriaMd5( const Tomahawk::InfoSystem::InfoStringHash &criteria, Tomahawk::InfoSystem::InfoType type = Tomahawk::InfoSystem::InfoNoInfo ) const;
+    QByteArray storeKey( const Tomahawk::InfoSystem::InfoStringHash &criteria, Tomahawk::InfoSystem::InfoType type ) const;
+    void scheduleFlush();
 
     QString m_cacheBaseDir;
-    QHash< InfoType, QHash< QString, QString > > m_fileLocationCache;
+    TomahawkUtils::LogStore* m_store;
     QTimer m_pruneTimer;
+    QTimer m_flushTimer;
     QCache< QString, QVariant > m_dataCache;
 
     uint m_cacheVersion;
@@ -0,0 +1,70 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "OplogCompactionJobItem.h"
+
+#include "utils/TomahawkUtilsGui.h"
+
+#include <QPixmap>
+
+
+OplogCompactionJobItem::OplogCompactionJobItem()
+    : m_done( 0 )
+    , m_total( 0 )
+{
+}
+
+
+QString
+OplogCompactionJobItem::mainText() const
+{
+    return tr( "Compacting sync history" );
+}
+
+
+QString
+OplogCompactionJobItem::rightColumnText() const
+{
+    if ( m_total <= 0 )
+        return QString();
+
+    return QString( "%1%" ).arg( (int)( (qint64)m_done * 100 / m_total ) );
+}
+
+
+QPixmap
+OplogCompactionJobItem::icon() const
+{
+    return TomahawkUtils::defaultPixmap( TomahawkUtils::ViewRefresh, TomahawkUtils::Original, QSize( 128, 128 ) );
+}
+
+
+void
+OplogCompactionJobItem::setProgress( int done, int total )
+{
+    m_done = done;
+    m_total = total;
+    emit statusChanged();
+}
+
+
+void
+OplogCompactionJobItem::done()
+{
+    emit finished();
+}
@@ -35,6 +35,7 @@
 #include "database/DatabaseCommand.h"
 #include "database/DatabaseCommand_CollectionStats.h"
 #include "database/DatabaseCommand_LoadOps.h"
+#include "database/DatabaseCommand_SetOplogPosition.h"
 #include "RemoteCollection.h"
 #include "Source.h"
 #include "SourceList.h"
@@ -252,9 +253,13 @@ DBSyncConnection::sendOps()
     connect( cmd, SIGNAL( done( QString, QString, QList< dbop_ptr > ) ),
                     SLOT( sendOpsData( QString, QString, QList< dbop_ptr > ) ) );
 
+    // the op the peer asks from is the last one it has, older ones it won't ask for again
+    DatabaseCommand_SetOplogPosition* pos = new DatabaseCommand_SetOplogPosition( m_source->nodeId(), m_uscache.value( "lastop" ).toString() );
+
     m_uscache.clear();
 
     Database::instance()->enqueue( QSharedPointer<DatabaseCommand>( cmd ) );
+    Database::instance()->enqueue( QSharedPointer<DatabaseCommand>( pos ) );
 }
 
 
@@ -118,6 +118,7 @@ Servent::~Servent()
     }
 
     delete d_ptr;
+    s_instance = 0;
 }
 
 
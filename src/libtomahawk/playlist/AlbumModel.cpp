@@ -31,6 +31,9 @@
 #include "utils/TomahawkUtils.h"
 #include "utils/Logger.h"
 
+// albums of a whole collection are added as they are read instead of all at once
+#define ALBUM_PAGE_SIZE 250
+
 using namespace Tomahawk;
 
 
@@ -43,6 +46,34 @@ AlbumModel::AlbumModel( QObject* parent )
 
 AlbumModel::~AlbumModel()
 {
+    cancelLoading();
+}
+
+
+void
+AlbumModel::cancelLoading()
+{
+    foreach ( DatabaseCommand::CancelToken token, m_loadTokens )
+        token.cancel();
+
+    m_loadTokens.clear();
+}
+
+
+void
+AlbumModel::addLoadToken( const DatabaseCommand::CancelToken& token )
+{
+    // forget about the loads that are done already
+    QList< DatabaseCommand::CancelToken >::iterator it = m_loadTokens.begin();
+    while ( it != m_loadTokens.end() )
+    {
+        if ( it->isFinished() )
+            it = m_loadTokens.erase( it );
+        else
+            ++it;
+    }
+
+    m_loadTokens << token;
 }
 
 
@@ -54,9 +85,15 @@ AlbumModel::addCollection( const collection_ptr& collection, bool overwrite )
                             << collection->source()->nodeId();
 
     DatabaseCommand_AllAlbums* cmd = new DatabaseCommand_AllAlbums( collection );
+    cmd->setPageSize( ALBUM_PAGE_SIZE );
     m_overwriteOnAdd = overwrite;
     m_collection = collection;
 
+    // whatever was still loading is about to be replaced anyway
+    if ( overwrite )
+        cancelLoading();
+    addLoadToken( cmd->cancelToken() );
+
     connect( cmd, SIGNAL( albums( QList<Tomahawk::album_ptr>, QVariant ) ),
                     SLOT( addAlbums( QList<Tomahawk::album_ptr> ) ) );
 
@@ -98,6 +135,11 @@ AlbumModel::addFilteredCollection( const collection_ptr& collection, unsigned in
     m_overwriteOnAdd = overwrite;
     m_collection = collection;
 
+    // whatever was still loading is about to be replaced anyway
+    if ( overwrite )
+        cancelLoading();
+    addLoadToken( cmd->cancelToken() );
+
     connect( cmd, SIGNAL( albums( QList<Tomahawk::album_ptr>, QVariant ) ),
                     SLOT( addAlbums( QList<Tomahawk::album_ptr> ) ) );
 
@@ -117,8 +159,12 @@ AlbumModel::addAlbums( const QList<Tomahawk::album_ptr>& albums )
 {
     emit loadingFinished();
 
+    // only the first page of a paged request replaces what we had
     if ( m_overwriteOnAdd )
+    {
+        m_overwriteOnAdd = false;
         clear();
+    }
 
     QList<Tomahawk::album_ptr> trimmedAlbums;
     foreach ( const album_ptr& album, albums )
@@ -60,7 +60,11 @@ private slots:
     void onCollectionChanged();
 
 private:
+    void cancelLoading();
+    void addLoadToken( const DatabaseCommand::CancelToken& token );
+
     bool m_overwriteOnAdd;
+    QList< DatabaseCommand::CancelToken > m_loadTokens;
 
     Tomahawk::collection_ptr m_collection;
 };
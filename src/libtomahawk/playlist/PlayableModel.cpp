@@ -722,7 +722,7 @@ PlayableModel::ensureResolved()
             ql << query;
     }
 
-    Pipeline::instance()->resolve( ql );
+    Pipeline::instance()->resolve( ql, false );
 }
 
 
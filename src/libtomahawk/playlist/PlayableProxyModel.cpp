@@ -36,6 +36,8 @@ PlayableProxyModel::PlayableProxyModel( QObject* parent )
     , m_showOfflineResults( true )
     , m_hideDupeItems( false )
     , m_maxVisibleItems( -1 )
+    , m_dupeRows( 0 )
+    , m_dupeRefilterPending( false )
     , m_style( Detailed )
 {
     m_playlistInterface = Tomahawk::playlistinterface_ptr( new Tomahawk::PlayableProxyModelPlaylistInterface( this ) );
@@ -110,9 +112,16 @@ PlayableProxyModel::setSourcePlayableModel( PlayableModel* sourceModel )
         disconnect( m_model, SIGNAL( indexPlayable( QModelIndex ) ), this, SLOT( onIndexPlayable( QModelIndex ) ) );
         disconnect( m_model, SIGNAL( indexResolved( QModelIndex ) ), this, SLOT( onIndexResolved( QModelIndex ) ) );
         disconnect( m_model, SIGNAL( currentIndexChanged() ), this, SIGNAL( currentIndexChanged() ) );
+        disconnect( m_model, SIGNAL( rowsAboutToBeInserted( QModelIndex, int, int ) ), this, SLOT( onSourceRowsChanging( QModelIndex, int, int ) ) );
+        disconnect( m_model, SIGNAL( rowsAboutToBeRemoved( QModelIndex, int, int ) ), this, SLOT( onSourceRowsChanging( QModelIndex, int, int ) ) );
+        disconnect( m_model, SIGNAL( rowsAboutToBeMoved( QModelIndex, int, int, QModelIndex, int ) ), this, SLOT( resetDupeKeys() ) );
+        disconnect( m_model, SIGNAL( modelAboutToBeReset() ), this, SLOT( resetDupeKeys() ) );
+        disconnect( m_model, SIGNAL( layoutAboutToBeChanged() ), this, SLOT( resetDupeKeys() ) );
+        disconnect( m_model, SIGNAL( dataChanged( QModelIndex, QModelIndex ) ), this, SLOT( onSourceDataChanged( QModelIndex, QModelIndex ) ) );
     }
 
     m_model = sourceModel;
+    resetDupeKeys();
 
     if ( m_model )
     {
@@ -122,6 +131,12 @@ PlayableProxyModel::setSourcePlayableModel( PlayableModel* sourceModel )
         connect( m_model, SIGNAL( indexPlayable( QModelIndex ) ), SLOT( onIndexPlayable( QModelIndex ) ) );
         connect( m_model, SIGNAL( indexResolved( QModelIndex ) ), SLOT( onIndexResolved( QModelIndex ) ) );
         connect( m_model, SIGNAL( currentIndexChanged() ), SIGNAL( currentIndexChanged() ) );
+        connect( m_model, SIGNAL( rowsAboutToBeInserted( QModelIndex, int, int ) ), SLOT( onSourceRowsChanging( QModelIndex, int, int ) ) );
+        connect( m_model, SIGNAL( rowsAboutToBeRemoved( QModelIndex, int, int ) ), SLOT( onSourceRowsChanging( QModelIndex, int, int ) ) );
+        connect( m_model, SIGNAL( rowsAboutToBeMoved( QModelIndex, int, int, QModelIndex, int ) ), SLOT( resetDupeKeys() ) );
+        connect( m_model, SIGNAL( modelAboutToBeReset() ), SLOT( resetDupeKeys() ) );
+        connect( m_model, SIGNAL( layoutAboutToBeChanged() ), SLOT( resetDupeKeys() ) );
+        connect( m_model, SIGNAL( dataChanged( QModelIndex, QModelIndex ) ), SLOT( onSourceDataChanged( QModelIndex, QModelIndex ) ) );
     }
 
     QSortFilterProxyModel::setSourceModel( m_model );
@@ -138,23 +153,27 @@ PlayableProxyModel::filterAcceptsRow( int sourceRow, const QModelIndex& sourcePa
     if ( m_maxVisibleItems > 0 && sourceRow > m_maxVisibleItems - 1 )
         return false;
 
-    if ( m_hideDupeItems )
+    // Duplicates are only detected among top-level rows, which is where all dupe-hiding views keep their items
+    if ( m_hideDupeItems && !sourceParent.isValid() )
     {
-        for ( int i = 0; i < sourceRow; i++ )
-        {
-            PlayableItem* di = itemFromIndex( sourceModel()->index( i, 0, sourceParent ) );
-            if ( !di )
-                continue;
+        updateDupeKeys();
+        if ( isDupe( sourceRow, pi ) )
+            return false;
+    }
 
-            bool b = ( pi->query() && pi->query()->equals( di->query() ) ) ||
-                     ( pi->album() && pi->album() == di->album() ) ||
-                     ( pi->artist() && pi->artist()->name() == di->artist()->name() );
+    if ( !acceptsItem( pi ) )
+        return false;
+
+    if ( m_hideDupeItems && !sourceParent.isValid() )
+        addDupeKeys( sourceRow, pi );
+
+    return true;
+}
 
-            if ( b && filterAcceptsRow( i, sourceParent ) )
-                return false;
-        }
-    }
 
+bool
+PlayableProxyModel::acceptsItem( PlayableItem* pi ) const
+{
     if ( pi->query() )
     {
         Tomahawk::result_ptr r;
@@ -218,6 +237,149 @@ PlayableProxyModel::filterAcceptsRow( int sourceRow, const QModelIndex& sourcePa
 }
 
 
+QStringList
+PlayableProxyModel::dupeKeys( PlayableItem* pi ) const
+{
+    QStringList keys;
+    if ( pi->query() )
+    {
+        const Tomahawk::track_ptr& t = pi->query()->queryTrack();
+        keys << ( QStringList() << "query" << t->artist() << t->album() << t->track() ).join( "\t" );
+    }
+    if ( pi->album() )
+        keys << QString( "album\t%1" ).arg( (qulonglong)pi->album().data() );
+    if ( pi->artist() )
+        keys << "artist\t" + pi->artist()->name();
+
+    return keys;
+}
+
+
+bool
+PlayableProxyModel::isDupe( int sourceRow, PlayableItem* pi ) const
+{
+    foreach ( const QString& key, dupeKeys( pi ) )
+    {
+        QHash< QString, int >::const_iterator it = m_dupeKeys.constFind( key );
+        if ( it != m_dupeKeys.constEnd() && it.value() < sourceRow )
+            return true;
+    }
+
+    return false;
+}
+
+
+void
+PlayableProxyModel::addDupeKeys( int sourceRow, PlayableItem* pi ) const
+{
+    foreach ( const QString& key, dupeKeys( pi ) )
+    {
+        QHash< QString, int >::iterator it = m_dupeKeys.find( key );
+        if ( it == m_dupeKeys.end() )
+            m_dupeKeys.insert( key, sourceRow );
+        else if ( it.value() > sourceRow )
+            it.value() = sourceRow;
+    }
+}
+
+
+void
+PlayableProxyModel::updateDupeKeys() const
+{
+    if ( !m_model )
+        return;
+
+    // Only rows that weren't seen yet are looked at, so appending to the source model stays linear
+    const int rows = m_model->rowCount( QModelIndex() );
+    for ( ; m_dupeRows < rows; m_dupeRows++ )
+    {
+        PlayableItem* pi = itemFromIndex( m_model->index( m_dupeRows, 0, QModelIndex() ) );
+        if ( !pi || isDupe( m_dupeRows, pi ) || !acceptsItem( pi ) )
+            continue;
+
+        addDupeKeys( m_dupeRows, pi );
+    }
+}
+
+
+bool
+PlayableProxyModel::ownsDupeKeys( int sourceRow, PlayableItem* pi ) const
+{
+    foreach ( const QString& key, dupeKeys( pi ) )
+    {
+        if ( m_dupeKeys.value( key, -1 ) == sourceRow )
+            return true;
+    }
+
+    return false;
+}
+
+
+void
+PlayableProxyModel::resetDupeKeys()
+{
+    m_dupeKeys.clear();
+    m_dupeRows = 0;
+}
+
+
+void
+PlayableProxyModel::onSourceDataChanged( const QModelIndex& topLeft, const QModelIndex& bottomRight )
+{
+    if ( !m_hideDupeItems || topLeft.parent().isValid() || topLeft.row() >= m_dupeRows )
+        return;
+
+    // Only matters if a row stopped being the one its keys point at, or became it: e.g. it went offline
+    // or got resolved to another track. Everything after it may have to be shown or hidden then.
+    bool changed = false;
+    const int last = qMin( bottomRight.row(), m_dupeRows - 1 );
+    for ( int row = topLeft.row(); row <= last && !changed; row++ )
+    {
+        PlayableItem* pi = itemFromIndex( m_model->index( row, 0, QModelIndex() ) );
+        if ( pi )
+            changed = ownsDupeKeys( row, pi ) != ( !isDupe( row, pi ) && acceptsItem( pi ) );
+    }
+
+    if ( changed )
+        invalidateDupes();
+}
+
+
+void
+PlayableProxyModel::invalidateDupes()
+{
+    resetDupeKeys();
+
+    // Items tend to change in bursts while resolving, refilter once for all of them
+    if ( !m_dupeRefilterPending )
+    {
+        m_dupeRefilterPending = true;
+        QMetaObject::invokeMethod( this, "refilterDupes", Qt::QueuedConnection );
+    }
+}
+
+
+void
+PlayableProxyModel::refilterDupes()
+{
+    m_dupeRefilterPending = false;
+    resetDupeKeys();
+    invalidateFilter();
+}
+
+
+void
+PlayableProxyModel::onSourceRowsChanging( const QModelIndex& parent, int start, int end )
+{
+    Q_UNUSED( end );
+
+    // Rows that get appended don't shift any row we already know about. Otherwise the first
+    // occurrence of a key may move, which changes what's a dupe further down.
+    if ( !parent.isValid() && start < m_dupeRows )
+        invalidateDupes();
+}
+
+
 void
 PlayableProxyModel::removeIndex( const QModelIndex& index )
 {
@@ -268,6 +430,7 @@ void
 PlayableProxyModel::setShowOfflineResults( bool b )
 {
     m_showOfflineResults = b;
+    resetDupeKeys();
     invalidateFilter();
 }
 
@@ -276,6 +439,7 @@ void
 PlayableProxyModel::setHideDupeItems( bool b )
 {
     m_hideDupeItems = b;
+    resetDupeKeys();
     invalidateFilter();
 }
 
@@ -287,6 +451,7 @@ PlayableProxyModel::setMaxVisibleItems( int items )
         return;
 
     m_maxVisibleItems = items;
+    resetDupeKeys();
     invalidateFilter();
 }
 
@@ -620,6 +785,7 @@ PlayableProxyModel::setFilter( const QString& pattern )
 {
     if ( pattern != filterRegExp().pattern() )
     {
+        resetDupeKeys();
         setFilterRegExp( pattern );
         emit filterChanged( pattern );
     }
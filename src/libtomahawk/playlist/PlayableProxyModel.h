@@ -109,15 +109,34 @@ private slots:
     void onIndexPlayable( const QModelIndex& index );
     void onIndexResolved( const QModelIndex& index );
 
+    void onSourceRowsChanging( const QModelIndex& parent, int start, int end );
+    void onSourceDataChanged( const QModelIndex& topLeft, const QModelIndex& bottomRight );
+    void resetDupeKeys();
+    void refilterDupes();
+
 private:
     virtual bool lessThan( int column, const Tomahawk::query_ptr& left, const Tomahawk::query_ptr& right ) const;
 
+    bool acceptsItem( PlayableItem* pi ) const;
+
+    QStringList dupeKeys( PlayableItem* pi ) const;
+    bool isDupe( int sourceRow, PlayableItem* pi ) const;
+    void addDupeKeys( int sourceRow, PlayableItem* pi ) const;
+    bool ownsDupeKeys( int sourceRow, PlayableItem* pi ) const;
+    void invalidateDupes();
+    void updateDupeKeys() const;
+
     PlayableModel* m_model;
 
     bool m_showOfflineResults;
     bool m_hideDupeItems;
     int m_maxVisibleItems;
 
+    // first accepted top-level source row for every query / album / artist key, covering the first m_dupeRows rows
+    mutable QHash< QString, int > m_dupeKeys;
+    mutable int m_dupeRows;
+    bool m_dupeRefilterPending;
+
     QHash< PlayableItemStyle, QList<PlayableModel::Columns> > m_headerStyle;
     PlayableItemStyle m_style;
 };
@@ -291,7 +291,7 @@ PlaylistModel::insertEntries( const QList< Tomahawk::plentry_ptr >& entries, int
 
     if ( !m_waitingForResolved.isEmpty() )
     {
-        Pipeline::instance()->resolve( queries );
+        Pipeline::instance()->resolve( queries, false );
         emit loadingStarted();
     }
     else
@@ -29,6 +29,8 @@
 #include "utils/Logger.h"
 
 #define LATEST_TRACK_ITEMS 250
+// rows shown before the rest of a load streams in, about a screen full
+#define LATEST_TRACK_PAGE 50
 
 using namespace Tomahawk;
 
@@ -42,6 +44,8 @@ RecentlyAddedModel::RecentlyAddedModel( QObject* parent )
 
 RecentlyAddedModel::~RecentlyAddedModel()
 {
+    // nobody is going to show what it's still reading
+    m_loadToken.cancel();
 }
 
 
@@ -54,18 +58,59 @@ RecentlyAddedModel::loadHistory()
     }
     startLoading();
 
+    requestTracks( QVariant() );
+}
+
+
+void
+RecentlyAddedModel::requestTracks( const QVariant& cursor )
+{
+    // a reload replaces whatever the previous one was still reading
+    m_loadToken.cancel();
+    m_cursor = QVariant();
+
     DatabaseCommand_AllTracks* cmd = new DatabaseCommand_AllTracks( m_source->dbCollection() );
     cmd->setLimit( m_limit );
+    cmd->setPageSize( LATEST_TRACK_PAGE );
+    cmd->setCursor( cursor );
     cmd->setSortOrder( DatabaseCommand_AllTracks::ModificationTime );
     cmd->setSortDescending( true );
+    m_loadToken = cmd->cancelToken();
 
     connect( cmd, SIGNAL( tracks( QList<Tomahawk::query_ptr>, QVariant ) ),
                     SLOT( appendQueries( QList<Tomahawk::query_ptr> ) ), Qt::QueuedConnection );
+    connect( cmd, SIGNAL( more( QVariant ) ), SLOT( onMoreTracks( QVariant ) ), Qt::QueuedConnection );
 
     Database::instance()->enqueue( QSharedPointer<DatabaseCommand>( cmd ) );
 }
 
 
+void
+RecentlyAddedModel::onMoreTracks( const QVariant& cursor )
+{
+    m_cursor = cursor;
+}
+
+
+bool
+RecentlyAddedModel::canFetchMore( const QModelIndex& parent ) const
+{
+    return !parent.isValid() && !m_cursor.isNull();
+}
+
+
+void
+RecentlyAddedModel::fetchMore( const QModelIndex& parent )
+{
+    if ( parent.isValid() || m_cursor.isNull() )
+        return;
+
+    // the next m_limit rows, once the view is scrolled to the end of what we have
+    startLoading();
+    requestTracks( m_cursor );
+}
+
+
 void
 RecentlyAddedModel::onSourcesReady()
 {
@@ -24,6 +24,7 @@
 
 #include "Typedefs.h"
 #include "PlayableModel.h"
+#include "database/DatabaseCommand.h"
 
 #include "DllMacro.h"
 
@@ -40,6 +41,9 @@ public:
 
     bool isTemporary() const;
 
+    bool canFetchMore( const QModelIndex& parent ) const;
+    void fetchMore( const QModelIndex& parent );
+
 public slots:
     void setSource( const Tomahawk::source_ptr& source );
 
@@ -48,10 +52,16 @@ private slots:
     void onSourceAdded( const Tomahawk::source_ptr& source );
 
     void loadHistory();
+    void onMoreTracks( const QVariant& cursor );
 
 private:
+    void requestTracks( const QVariant& cursor );
+
     Tomahawk::source_ptr m_source;
     unsigned int m_limit;
+
+    QVariant m_cursor;
+    DatabaseCommand::CancelToken m_loadToken;
 };
 
 #endif // RECENTLYADDEDMODEL_H
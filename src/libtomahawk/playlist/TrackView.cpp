@@ -26,6 +26,7 @@
 #include "PlayableItem.h"
 #include "DropJob.h"
 #include "Source.h"
+#include "Pipeline.h"
 #include "TomahawkSettings.h"
 #include "audio/AudioEngine.h"
 #include "context/ContextWidget.h"
@@ -43,6 +44,12 @@
 #include <QDrag>
 
 #define SCROLL_TIMEOUT 280
+// rows below the viewport that get resolved along with the visible ones
+#define RESOLVE_LOOKAHEAD 30
+// rows above the viewport, for when the user scrolls back up
+#define RESOLVE_LOOKBEHIND 5
+// upcoming tracks of the playlist interface that get resolved before the look-ahead
+#define RESOLVE_UPCOMING 3
 
 using namespace Tomahawk;
 
@@ -252,9 +259,6 @@ TrackView::onModelEmptyCheck()
 void
 TrackView::onViewChanged()
 {
-    if ( m_proxyModel->style() != PlayableProxyModel::Short && m_proxyModel->style() != PlayableProxyModel::Large ) // eventual FIXME?
-        return;
-
     if ( m_timer.isActive() )
         m_timer.stop();
 
@@ -280,6 +284,11 @@ TrackView::onScrollTimeout()
     if ( right.isValid() )
         max = right.row();
 
+    resolveVisibleItems( left.row(), max );
+
+    if ( m_proxyModel->style() != PlayableProxyModel::Short && m_proxyModel->style() != PlayableProxyModel::Large ) // eventual FIXME?
+        return;
+
     if ( !max )
         return;
 
@@ -290,6 +299,58 @@ TrackView::onScrollTimeout()
 }
 
 
+void
+TrackView::resolveVisibleItems( int first, int last )
+{
+    // Models only queue their tracks for background resolving. Move what is on screen to the front
+    // of the pipeline, followed by what is going to be played next and the rows around the viewport.
+    const int rows = m_proxyModel->rowCount();
+    if ( !rows )
+        return;
+
+    first = qMax( 0, first );
+    last = qMin( rows - 1, last );
+
+    QList< query_ptr > queries;
+    for ( int i = first; i <= last; i++ )
+        appendUnresolved( queries, m_proxyModel->index( i, 0 ) );
+
+    playlistinterface_ptr pi = m_proxyModel->playlistInterface();
+    if ( !pi.isNull() && !pi->shuffled() )
+    {
+        for ( int i = 1; i <= RESOLVE_UPCOMING; i++ )
+        {
+            const qint64 upcoming = pi->siblingIndex( i );
+            if ( upcoming < 0 )
+                break;
+
+            const query_ptr query = pi->queryAt( upcoming );
+            if ( !query.isNull() && !query->resolvingFinished() && !queries.contains( query ) )
+                queries << query;
+        }
+    }
+
+    for ( int i = last + 1; i <= qMin( rows - 1, last + RESOLVE_LOOKAHEAD ); i++ )
+        appendUnresolved( queries, m_proxyModel->index( i, 0 ) );
+    for ( int i = first - 1; i >= qMax( 0, first - RESOLVE_LOOKBEHIND ); i-- )
+        appendUnresolved( queries, m_proxyModel->index( i, 0 ) );
+
+    if ( !queries.isEmpty() )
+        Pipeline::instance()->resolve( queries, true );
+}
+
+
+void
+TrackView::appendUnresolved( QList< query_ptr >& queries, const QModelIndex& index ) const
+{
+    PlayableItem* item = m_proxyModel->itemFromIndex( m_proxyModel->mapToSource( index ) );
+    if ( !item || item->query().isNull() || item->query()->resolvingFinished() )
+        return;
+
+    queries << item->query();
+}
+
+
 void
 TrackView::startPlayingFromStart()
 {
@@ -137,6 +137,8 @@ private:
     void startAutoPlay( const QModelIndex& index );
     bool tryToPlayItem( const QModelIndex& index );
     void updateHoverIndex( const QPoint& pos );
+    void resolveVisibleItems( int first, int last );
+    void appendUnresolved( QList< Tomahawk::query_ptr >& queries, const QModelIndex& index ) const;
 
     QString m_guid;
     PlayableModel* m_model;
@@ -35,6 +35,10 @@
 #include "utils/TomahawkUtilsGui.h"
 #include "utils/Logger.h"
 
+// artists show up a page at a time, and no more than a few pages are loaded before the view scrolls there
+#define ARTIST_PAGE_SIZE 200
+#define ARTIST_FETCH_LIMIT 2000
+
 using namespace Tomahawk;
 
 
@@ -52,12 +56,14 @@ TreeModel::TreeModel( QObject* parent )
 TreeModel::~TreeModel()
 {
     tDebug() << Q_FUNC_INFO;
+    m_artistsToken.cancel();
 }
 
 
 void
 TreeModel::setMode( ModelMode mode )
 {
+    m_artistsCursor = QVariant();
     clear();
     m_mode = mode;
     emit modeChanged( mode );
@@ -86,6 +92,9 @@ TreeModel::getCover( const QModelIndex& index )
 bool
 TreeModel::canFetchMore( const QModelIndex& parent ) const
 {
+    if ( !parent.isValid() )
+        return !m_artistsCursor.isNull();
+
     PlayableItem* parentItem = itemFromIndex( parent );
 
     if ( parentItem->fetchingMore() )
@@ -107,6 +116,13 @@ TreeModel::canFetchMore( const QModelIndex& parent ) const
 void
 TreeModel::fetchMore( const QModelIndex& parent )
 {
+    if ( !parent.isValid() )
+    {
+        if ( !m_artistsCursor.isNull() )
+            requestArtists( m_artistsCursor );
+        return;
+    }
+
     PlayableItem* parentItem = itemFromIndex( parent );
     if ( !parentItem || parentItem->fetchingMore() )
         return;
@@ -132,12 +148,8 @@ TreeModel::addAllCollections()
 {
     startLoading();
 
-    DatabaseCommand_AllArtists* cmd = new DatabaseCommand_AllArtists();
-
-    connect( cmd, SIGNAL( artists( QList<Tomahawk::artist_ptr> ) ),
-                    SLOT( onArtistsAdded( QList<Tomahawk::artist_ptr> ) ) );
-
-    Database::instance()->enqueue( QSharedPointer<DatabaseCommand>( cmd ) );
+    m_collection.clear();
+    requestArtists();
 
     connect( SourceList::instance(), SIGNAL( sourceAdded( Tomahawk::source_ptr ) ), SLOT( onSourceAdded( Tomahawk::source_ptr ) ), Qt::UniqueConnection );
 
@@ -252,11 +264,7 @@ TreeModel::addCollection( const collection_ptr& collection )
     startLoading();
 
     m_collection = collection;
-
-    Tomahawk::ArtistsRequest* req = m_collection->requestArtists();
-    connect( dynamic_cast< QObject* >( req ), SIGNAL( artists( QList< Tomahawk::artist_ptr > ) ),
-             this, SLOT( onArtistsAdded( QList< Tomahawk::artist_ptr > ) ), Qt::UniqueConnection );
-    req->enqueue();
+    requestArtists();
 
     connect( collection.data(), SIGNAL( changed() ), SLOT( onCollectionChanged() ), Qt::UniqueConnection );
 
@@ -321,6 +329,47 @@ TreeModel::onCollectionChanged()
 }
 
 
+void
+TreeModel::requestArtists( const QVariant& cursor )
+{
+    // don't keep loading the collection we were showing before
+    m_artistsToken.cancel();
+    m_artistsToken = DatabaseCommand::CancelToken();
+    m_artistsCursor = QVariant();
+
+    Tomahawk::ArtistsRequest* req = 0;
+    if ( m_collection.isNull() )
+        req = new DatabaseCommand_AllArtists(); // for SuperCollection
+    else
+        req = m_collection->requestArtists();
+
+    if ( !req )
+        return;
+
+    DatabaseCommand_AllArtists* cmd = dynamic_cast< DatabaseCommand_AllArtists* >( req );
+    if ( cmd )
+    {
+        cmd->setPageSize( ARTIST_PAGE_SIZE );
+        cmd->setLimit( ARTIST_FETCH_LIMIT );
+        cmd->setCursor( cursor );
+        m_artistsToken = cmd->cancelToken();
+
+        connect( cmd, SIGNAL( more( QVariant ) ), SLOT( onMoreArtists( QVariant ) ) );
+    }
+
+    connect( dynamic_cast< QObject* >( req ), SIGNAL( artists( QList< Tomahawk::artist_ptr > ) ),
+             this, SLOT( onArtistsAdded( QList< Tomahawk::artist_ptr > ) ) );
+    req->enqueue();
+}
+
+
+void
+TreeModel::onMoreArtists( const QVariant& cursor )
+{
+    m_artistsCursor = cursor;
+}
+
+
 void
 TreeModel::onArtistsAdded( const QList<Tomahawk::artist_ptr>& artists )
 {
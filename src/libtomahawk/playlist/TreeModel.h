@@ -88,10 +88,15 @@ private slots:
 
     void onSourceAdded( const Tomahawk::source_ptr& source );
     void onCollectionChanged();
+    void onMoreArtists( const QVariant& cursor );
 
 private:
+    void requestArtists( const QVariant& cursor = QVariant() );
+
     Tomahawk::ModelMode m_mode;
     Tomahawk::collection_ptr m_collection;
+    DatabaseCommand::CancelToken m_artistsToken;
+    QVariant m_artistsCursor;
 
     QList<Tomahawk::artist_ptr> m_artistsFilter;
 };
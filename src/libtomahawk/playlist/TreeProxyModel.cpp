@@ -107,6 +107,8 @@ TreeProxyModel::setFilter( const QString& pattern )
     m_filter = pattern;
     m_albumsFilter.clear();
 
+    // the previous pattern's results would be thrown away anyway
+    m_artistsFilterToken.cancel();
     if ( m_artistsFilterCmd )
     {
         disconnect( dynamic_cast< QObject* >( m_artistsFilterCmd ), SIGNAL( artists( QList<Tomahawk::artist_ptr> ) ),
@@ -130,6 +132,9 @@ TreeProxyModel::setFilter( const QString& pattern )
         cmd->setFilter( pattern );
         m_artistsFilterCmd = cmd;
 
+        DatabaseCommand* dbcmd = dynamic_cast< DatabaseCommand* >( cmd );
+        m_artistsFilterToken = dbcmd ? dbcmd->cancelToken() : DatabaseCommand::CancelToken();
+
         connect( dynamic_cast< QObject* >( cmd ), SIGNAL( artists( QList<Tomahawk::artist_ptr> ) ),
                  SLOT( onFilterArtists( QList<Tomahawk::artist_ptr> ) ) );
 
@@ -352,7 +357,7 @@ TreeProxyModel::textForItem( PlayableItem* item ) const
     }
     else if ( !item->album().isNull() )
     {
-        return DatabaseImpl::sortname( item->album()->name() );
+        return item->album()->sortname();
     }
     else if ( !item->result().isNull() )
     {
@@ -38,7 +38,7 @@ Q_OBJECT
 
 public:
     explicit TreeProxyModel( QObject* parent = 0 );
-    virtual ~TreeProxyModel() {}
+    virtual ~TreeProxyModel() { m_artistsFilterToken.cancel(); }
 
     virtual void setSourcePlayableModel( TreeModel* model );
     // workaround overloaded-virtual warning
@@ -76,6 +76,7 @@ private:
     QList<Tomahawk::artist_ptr> m_artistsFilter;
     QList<int> m_albumsFilter;
     Tomahawk::ArtistsRequest* m_artistsFilterCmd;
+    DatabaseCommand::CancelToken m_artistsFilterToken;
 
     QString m_filter;
     TreeModel* m_model;
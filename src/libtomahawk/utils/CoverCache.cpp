@@ -0,0 +1,220 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CoverCache.h"
+
+#include "TomahawkSettings.h"
+#include "utils/Logger.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QPixmapCache>
+#include <QtConcurrentRun>
+
+// thumbnails on disk are trimmed to this size on startup, oldest first
+#define THUMBNAIL_CACHE_SIZE ( 64 * 1024 * 1024 )
+// and none are kept that were written longer ago than this
+#define THUMBNAIL_MAX_AGE_DAYS 90
+
+using namespace TomahawkUtils;
+
+CoverCache* CoverCache::s_instance = 0;
+
+
+CoverCache*
+CoverCache::instance()
+{
+    if ( !s_instance )
+        s_instance = new CoverCache();
+
+    return s_instance;
+}
+
+
+CoverCache::CoverCache()
+    : QObject( 0 )
+    , m_thumbnailDir( TomahawkSettings::instance()->storageCacheLocation() + "/Thumbnails/" )
+{
+    QDir().mkpath( m_thumbnailDir );
+
+    QtConcurrent::run( &CoverCache::pruneThumbnails, m_thumbnailDir );
+}
+
+
+QByteArray
+CoverCache::hash( const QByteArray& imageData )
+{
+    return QCryptographicHash::hash( imageData, QCryptographicHash::Md5 ).toHex();
+}
+
+
+QString
+CoverCache::cacheKey( const QByteArray& hash, const QSize& size )
+{
+    return QString( "%1_%2x%3" ).arg( QString::fromLatin1( hash ) ).arg( size.width() ).arg( size.height() );
+}
+
+
+QPixmap
+CoverCache::cover( const QByteArray& hash, const QByteArray& imageData, const QImage& decoded, const QSize& size,
+                   QObject* receiver, const char* member )
+{
+    if ( imageData.isEmpty() && decoded.isNull() )
+        return QPixmap();
+
+    if ( m_broken.contains( hash ) )
+    {
+        // let the owner know there won't be a cover for this data
+        QMetaObject::invokeMethod( receiver, member, Qt::QueuedConnection,
+                                   Q_ARG( QSize, size ), Q_ARG( QPixmap, QPixmap() ), Q_ARG( QImage, QImage() ) );
+        return QPixmap();
+    }
+
+    const QString key = cacheKey( hash, size );
+
+    QPixmap pixmap;
+    if ( QPixmapCache::find( key, &pixmap ) )
+        return pixmap;
+
+    if ( size.isEmpty() && !decoded.isNull() )
+    {
+        // nothing to decode or scale, only the conversion is left
+        pixmap = QPixmap::fromImage( decoded );
+        QPixmapCache::insert( key, pixmap );
+        return pixmap;
+    }
+
+    QList< QPair< QPointer< QObject >, QByteArray > >& receivers = m_pending[ key ];
+    const QPair< QPointer< QObject >, QByteArray > callback( receiver, QByteArray( member ) );
+    const bool running = !receivers.isEmpty();
+    if ( !receivers.contains( callback ) )
+        receivers << callback;
+
+    if ( running )
+        return QPixmap();
+
+    QFutureWatcher< QPair< QImage, QImage > >* watcher = new QFutureWatcher< QPair< QImage, QImage > >( this );
+    watcher->setProperty( "cacheKey", key );
+    watcher->setProperty( "size", size );
+    connect( watcher, SIGNAL( finished() ), SLOT( onDecoded() ) );
+    watcher->setFuture( QtConcurrent::run( &CoverCache::decode, hash, imageData, decoded, size, m_thumbnailDir ) );
+
+    return QPixmap();
+}
+
+
+void
+CoverCache::onDecoded()
+{
+    QFutureWatcher< QPair< QImage, QImage > >* watcher = static_cast< QFutureWatcher< QPair< QImage, QImage > >* >( sender() );
+    const QString key = watcher->property( "cacheKey" ).toString();
+    const QSize size = watcher->property( "size" ).toSize();
+    const QPair< QImage, QImage > result = watcher->result();
+    watcher->deleteLater();
+
+    // don't try again and again
+    if ( result.second.isNull() )
+        m_broken << key.left( key.indexOf( '_' ) ).toLatin1();
+
+    // QPixmaps can only be created in the GUI thread
+    const QPixmap pixmap = QPixmap::fromImage( result.second );
+    if ( !pixmap.isNull() )
+        QPixmapCache::insert( key, pixmap );
+
+    QList< QPair< QPointer< QObject >, QByteArray > > receivers = m_pending.take( key );
+    for ( int i = 0; i < receivers.count(); i++ )
+    {
+        if ( receivers.at( i ).first.isNull() )
+            continue;
+
+        QMetaObject::invokeMethod( receivers.at( i ).first.data(), receivers.at( i ).second.constData(),
+                                   Q_ARG( QSize, size ), Q_ARG( QPixmap, pixmap ), Q_ARG( QImage, result.first ) );
+    }
+}
+
+
+// Returns the full-size cover if it had to be decoded and the cover at the requested size
+QPair< QImage, QImage >
+CoverCache::decode( const QByteArray& hash, const QByteArray& imageData, const QImage& decoded,
+                    const QSize& size, const QString& thumbnailDir )
+{
+    const QString thumbnailPath = thumbnailDir + cacheKey( hash, size ) + ".png";
+
+    QImage image;
+    if ( !size.isEmpty() && image.load( thumbnailPath ) )
+        return qMakePair( QImage(), image );
+
+    QImage full = decoded;
+    if ( full.isNull() )
+    {
+        if ( !full.loadFromData( imageData ) )
+        {
+            tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Could not decode cover" << hash;
+            return qMakePair( QImage(), QImage() );
+        }
+
+        if ( full.width() != full.height() )
+        {
+            const int sqwidth = qMin( full.width(), full.height() );
+            const int delta = qAbs( full.width() - full.height() );
+
+            if ( full.width() > full.height() )
+                full = full.copy( delta / 2, 0, sqwidth, sqwidth );
+            else
+                full = full.copy( 0, delta / 2, sqwidth, sqwidth );
+        }
+    }
+
+    const QImage fresh = decoded.isNull() ? full : QImage();
+    if ( size.isEmpty() )
+        return qMakePair( fresh, full );
+
+    image = full.scaled( size, Qt::KeepAspectRatio, Qt::SmoothTransformation );
+    if ( !image.save( thumbnailPath, "PNG" ) )
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Could not store thumbnail" << thumbnailPath;
+
+    return qMakePair( fresh, image );
+}
+
+
+void
+CoverCache::pruneThumbnails( const QString& thumbnailDir )
+{
+    // a thumbnail that's gone is scaled again the next time it's needed
+    const QDateTime expired = QDateTime::currentDateTime().addDays( -THUMBNAIL_MAX_AGE_DAYS );
+    const QFileInfoList thumbnails = QDir( thumbnailDir ).entryInfoList( QStringList() << "*.png", QDir::Files, QDir::Time );
+
+    qint64 total = 0;
+    int removed = 0;
+    foreach ( const QFileInfo& info, thumbnails )
+    {
+        total += info.size();
+        if ( total > THUMBNAIL_CACHE_SIZE || info.lastModified() < expired )
+        {
+            if ( QFile::remove( info.absoluteFilePath() ) )
+                removed++;
+            total -= info.size();
+        }
+    }
+
+    if ( removed )
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Removed" << removed << "of" << thumbnails.count() << "thumbnails, keeping" << total << "bytes";
+}
@@ -0,0 +1,87 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_COVERCACHE_H
+#define TOMAHAWK_COVERCACHE_H
+
+#include "DllMacro.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPair>
+#include <QPixmap>
+#include <QPointer>
+#include <QSet>
+#include <QSize>
+
+namespace TomahawkUtils
+{
+
+/**
+ * Decodes and scales cover art on the global thread pool.
+ *
+ * Scaled covers are kept in the QPixmapCache and as thumbnails on disk, keyed
+ * by the hash of the image data and the requested size, so they are available
+ * right away the next time around. The thumbnails on disk are kept below a size
+ * and age limit, the oldest are removed first.
+ */
+class DLLEXPORT CoverCache : public QObject
+{
+Q_OBJECT
+
+public:
+    static CoverCache* instance();
+
+    static QByteArray hash( const QByteArray& imageData );
+
+    /**
+     * Returns the cover, cropped to a square and scaled to size. An empty size
+     * asks for the full-size cover.
+     *
+     * The cover is taken from decoded if that's set and decoded from imageData
+     * otherwise. If it isn't ready yet, a null pixmap is returned and member is
+     * invoked on receiver with the requested QSize, the QPixmap and, if imageData
+     * had to be decoded, the full-size QImage once it is. Owners should keep that
+     * image and drop imageData, so no cover has to be decoded twice.
+     */
+    QPixmap cover( const QByteArray& hash, const QByteArray& imageData, const QImage& decoded, const QSize& size,
+                   QObject* receiver, const char* member );
+
+private slots:
+    void onDecoded();
+
+private:
+    CoverCache();
+
+    static QString cacheKey( const QByteArray& hash, const QSize& size );
+    static QPair< QImage, QImage > decode( const QByteArray& hash, const QByteArray& imageData, const QImage& decoded,
+                                           const QSize& size, const QString& thumbnailDir );
+    static void pruneThumbnails( const QString& thumbnailDir );
+
+    QString m_thumbnailDir;
+    QHash< QString, QList< QPair< QPointer< QObject >, QByteArray > > > m_pending;
+    QSet< QByteArray > m_broken;
+
+    static CoverCache* s_instance;
+};
+
+}
+
+#endif // TOMAHAWK_COVERCACHE_H
@@ -0,0 +1,260 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EditDistance.h"
+
+#include <QThreadStorage>
+
+#include <string.h>
+
+#define MAX_PATTERN_LENGTH 64
+
+using namespace TomahawkUtils;
+
+namespace
+{
+
+struct Scratch
+{
+    Scratch()
+    {
+        memset( latin1, 0, sizeof( latin1 ) );
+        other.reserve( MAX_PATTERN_LENGTH );
+    }
+
+    quint64 latin1[ 256 ];
+    QVector< QPair< ushort, quint64 > > other;
+    QVector< int > rows;
+};
+
+static QThreadStorage< Scratch* > s_scratch;
+
+
+Scratch*
+scratch()
+{
+    if ( !s_scratch.hasLocalData() )
+        s_scratch.setLocalData( new Scratch );
+
+    return s_scratch.localData();
+}
+
+
+void
+buildMasks( const QChar* pattern, int m, quint64* latin1, QVector< QPair< ushort, quint64 > >& other )
+{
+    for ( int i = 0; i < m; i++ )
+    {
+        const ushort c = pattern[ i ].unicode();
+        const quint64 bit = (quint64)1 << i;
+
+        if ( c < 256 )
+        {
+            latin1[ c ] |= bit;
+            continue;
+        }
+
+        int k = 0;
+        while ( k < other.count() && other.at( k ).first != c )
+            k++;
+
+        if ( k == other.count() )
+            other << qMakePair( c, bit );
+        else
+            other[ k ].second |= bit;
+    }
+}
+
+
+void
+clearMasks( const QChar* pattern, int m, quint64* latin1, QVector< QPair< ushort, quint64 > >& other )
+{
+    for ( int i = 0; i < m; i++ )
+    {
+        const ushort c = pattern[ i ].unicode();
+        if ( c < 256 )
+            latin1[ c ] = 0;
+    }
+
+    other.resize( 0 );
+}
+
+
+/**
+ * Hyyrö's bit-vector algorithm for the restricted Damerau-Levenshtein distance,
+ * global variant. Bit i of the vectors describes row i + 1 of the DP matrix.
+ *
+ * Like the DP version, transpositions only count from the third character on.
+ */
+int
+bitParallel( const quint64* latin1, const QPair< ushort, quint64 >* other, int otherCount, int m, const QChar* text, int n )
+{
+    const quint64 last = (quint64)1 << ( m - 1 );
+    quint64 vp = ~(quint64)0;
+    quint64 vn = 0;
+    quint64 d0 = 0;
+    quint64 pmPrev = 0;
+    int score = m;
+
+    for ( int j = 0; j < n; j++ )
+    {
+        const ushort c = text[ j ].unicode();
+        quint64 pm = 0;
+        if ( c < 256 )
+            pm = latin1[ c ];
+        else
+        {
+            for ( int k = 0; k < otherCount; k++ )
+            {
+                if ( other[ k ].first == c )
+                {
+                    pm = other[ k ].second;
+                    break;
+                }
+            }
+        }
+
+        const quint64 tr = j >= 2 ? ( ( ( ~d0 & pm ) << 1 ) & pmPrev ) & ~(quint64)3 : 0;
+        d0 = ( ( ( pm & vp ) + vp ) ^ vp ) | pm | vn | tr;
+
+        quint64 hp = vn | ~( d0 | vp );
+        quint64 hn = vp & d0;
+        if ( hp & last )
+            score++;
+        else if ( hn & last )
+            score--;
+
+        hp = ( hp << 1 ) | 1;
+        hn = hn << 1;
+        vp = hn | ~( d0 | hp );
+        vn = hp & d0;
+        pmPrev = pm;
+    }
+
+    return score;
+}
+
+
+int
+dynamic( const QChar* source, int n, const QChar* target, int m, QVector< int >& rows )
+{
+    // three rows of the matrix are enough, transpositions look two rows back
+    rows.resize( 3 * ( m + 1 ) );
+    int* r2 = rows.data();
+    int* r1 = r2 + m + 1;
+    int* r0 = r1 + m + 1;
+
+    for ( int j = 0; j <= m; j++ )
+        r1[ j ] = j;
+
+    for ( int i = 1; i <= n; i++ )
+    {
+        const QChar s_i = source[ i - 1 ];
+        r0[ 0 ] = i;
+
+        for ( int j = 1; j <= m; j++ )
+        {
+            const QChar t_j = target[ j - 1 ];
+            const int cost = ( s_i == t_j ) ? 0 : 1;
+
+            int cell = qMin( r0[ j - 1 ] + 1, r1[ j - 1 ] + cost );
+            cell = qMin( cell, r1[ j ] + 1 );
+
+            if ( i > 2 && j > 2 && source[ i - 2 ] == t_j && s_i == target[ j - 2 ] )
+                cell = qMin( cell, r2[ j - 2 ] + 1 );
+
+            r0[ j ] = cell;
+        }
+
+        int* tmp = r2;
+        r2 = r1;
+        r1 = r0;
+        r0 = tmp;
+    }
+
+    return r1[ m ];
+}
+
+}
+
+
+EditDistance::EditDistance( const QString& pattern )
+    : m_pattern( pattern )
+{
+    memset( m_latin1, 0, sizeof( m_latin1 ) );
+
+    if ( m_pattern.length() <= MAX_PATTERN_LENGTH )
+        buildMasks( m_pattern.constData(), m_pattern.length(), m_latin1, m_other );
+}
+
+
+int
+EditDistance::distance( const QString& text ) const
+{
+    const int m = m_pattern.length();
+    const int n = text.length();
+
+    if ( m == 0 )
+        return n;
+    if ( n == 0 )
+        return m;
+
+    if ( m <= MAX_PATTERN_LENGTH )
+        return bitParallel( m_latin1, m_other.constData(), m_other.count(), m, text.constData(), n );
+
+    return distance( m_pattern, text );
+}
+
+
+QVector< int >
+EditDistance::distances( const QStringList& texts ) const
+{
+    QVector< int > result( texts.count() );
+    for ( int i = 0; i < texts.count(); i++ )
+        result[ i ] = distance( texts.at( i ) );
+
+    return result;
+}
+
+
+int
+EditDistance::distance( const QString& source, const QString& target )
+{
+    const int n = source.length();
+    const int m = target.length();
+
+    if ( n == 0 )
+        return m;
+    if ( m == 0 )
+        return n;
+
+    Scratch* s = scratch();
+
+    // the distance is symmetric, so use the shorter string as pattern
+    const QString& pattern = ( n <= m ) ? source : target;
+    const QString& text = ( n <= m ) ? target : source;
+
+    if ( pattern.length() > MAX_PATTERN_LENGTH )
+        return dynamic( source.constData(), n, target.constData(), m, s->rows );
+
+    buildMasks( pattern.constData(), pattern.length(), s->latin1, s->other );
+    const int d = bitParallel( s->latin1, s->other.constData(), s->other.count(), pattern.length(), text.constData(), text.length() );
+    clearMasks( pattern.constData(), pattern.length(), s->latin1, s->other );
+
+    return d;
+}
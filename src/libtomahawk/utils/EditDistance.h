@@ -0,0 +1,64 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_EDITDISTANCE_H
+#define TOMAHAWK_EDITDISTANCE_H
+
+#include "DllMacro.h"
+
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace TomahawkUtils
+{
+
+/**
+ * Edit distance (Levenshtein plus transpositions of adjacent characters)
+ * between one pattern and any number of texts.
+ *
+ * The pattern's character masks are computed once, every text is then scored
+ * with Hyyrö's bit-parallel variant of Myers' algorithm: one pass over the
+ * text, a handful of 64-bit operations per character and no allocations.
+ * Patterns longer than 64 characters fall back to a dynamic programming
+ * implementation using a per-thread scratch buffer.
+ *
+ * Results are identical to TomahawkUtils::levenshtein().
+ */
+class DLLEXPORT EditDistance
+{
+public:
+    explicit EditDistance( const QString& pattern );
+
+    const QString& pattern() const { return m_pattern; }
+
+    int distance( const QString& text ) const;
+    QVector< int > distances( const QStringList& texts ) const;
+
+    static int distance( const QString& source, const QString& target );
+
+private:
+    QString m_pattern;
+    quint64 m_latin1[ 256 ];
+    QVector< QPair< ushort, quint64 > > m_other;
+};
+
+}
+
+#endif // TOMAHAWK_EDITDISTANCE_H
@@ -0,0 +1,597 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LogStore.h"
+
+#include "utils/Logger.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QtEndian>
+
+#define LOGSTORE_MAGIC 0x54484c53 // "THLS"
+#define LOGSTORE_VERSION 1
+#define LOGSTORE_HEADER_SIZE 8
+
+// length (4) + checksum (2)
+#define RECORD_PREFIX_SIZE 6
+
+// don't bother rewriting the file for less than this
+#define MIN_COMPACTION_BYTES ( 4 * 1024 * 1024 )
+
+using namespace TomahawkUtils;
+
+
+LogStore::LogStore( const QString& path )
+    : m_path( path )
+    , m_file( path )
+    , m_map( 0 )
+    , m_mapSize( 0 )
+    , m_liveBytes( 0 )
+{
+}
+
+
+LogStore::~LogStore()
+{
+    close();
+}
+
+
+bool
+LogStore::open()
+{
+    QMutexLocker lock( &m_mutex );
+
+    if ( m_file.isOpen() )
+        return true;
+
+    QDir().mkpath( QFileInfo( m_path ).absolutePath() );
+    if ( !m_file.open( QIODevice::ReadWrite ) )
+    {
+        tLog() << Q_FUNC_INFO << "Failed to open" << m_path << m_file.errorString();
+        return false;
+    }
+
+    if ( load() )
+        return true;
+
+    tLog() << Q_FUNC_INFO << "Discarding unreadable store" << m_path;
+    unmap();
+    m_index.clear();
+    m_liveBytes = 0;
+    m_file.resize( 0 );
+    m_file.seek( 0 );
+
+    QDataStream stream( &m_file );
+    stream << (quint32)LOGSTORE_MAGIC << (quint32)LOGSTORE_VERSION;
+    return m_file.flush();
+}
+
+
+void
+LogStore::close()
+{
+    flush();
+
+    QMutexLocker lock( &m_mutex );
+    unmap();
+    m_file.close();
+    m_index.clear();
+    m_liveBytes = 0;
+}
+
+
+bool
+LogStore::isOpen() const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_file.isOpen();
+}
+
+
+bool
+LogStore::load()
+{
+    const qint64 size = m_file.size();
+    if ( size == 0 )
+    {
+        QDataStream stream( &m_file );
+        stream << (quint32)LOGSTORE_MAGIC << (quint32)LOGSTORE_VERSION;
+        return m_file.flush();
+    }
+
+    remap();
+    if ( !m_map || m_mapSize < LOGSTORE_HEADER_SIZE )
+        return false;
+
+    if ( qFromBigEndian< quint32 >( m_map ) != LOGSTORE_MAGIC ||
+         qFromBigEndian< quint32 >( m_map + 4 ) != LOGSTORE_VERSION )
+        return false;
+
+    // only walk the record headers, values stay on disk until they are asked for
+    qint64 pos = LOGSTORE_HEADER_SIZE;
+    while ( pos + RECORD_PREFIX_SIZE <= size )
+    {
+        const uchar* p = m_map + pos;
+        const quint32 bodySize = qFromBigEndian< quint32 >( p );
+        const quint16 checksum = qFromBigEndian< quint16 >( p + 4 );
+        if ( pos + RECORD_PREFIX_SIZE + bodySize > size || bodySize < 13 )
+            break;
+
+        const uchar* body = p + RECORD_PREFIX_SIZE;
+        const Operation op = (Operation)body[ 0 ];
+        const quint32 keySize = qFromBigEndian< quint32 >( body + 1 );
+        quint32 headerSize = 1 + 4 + keySize + 8;
+        if ( op == Insert )
+            headerSize += 4;
+        if ( headerSize > bodySize ||
+             qChecksum( reinterpret_cast< const char* >( body ), headerSize ) != checksum )
+            break;
+
+        const QByteArray key( reinterpret_cast< const char* >( body + 5 ), keySize );
+        const qint64 expiry = qFromBigEndian< qint64 >( body + 5 + keySize );
+
+        QHash< QByteArray, Entry >::iterator it = m_index.find( key );
+        if ( it != m_index.end() && ( op == Insert || op == Remove ) )
+        {
+            m_liveBytes -= it.value().recordSize;
+            m_index.erase( it );
+            it = m_index.end();
+        }
+
+        if ( op == Insert )
+        {
+            Entry entry;
+            entry.expiry = expiry;
+            entry.length = qFromBigEndian< quint32 >( body + 5 + keySize + 8 );
+            entry.offset = pos + RECORD_PREFIX_SIZE + headerSize;
+            entry.recordSize = RECORD_PREFIX_SIZE + bodySize;
+            entry.persisted = true;
+
+            if ( headerSize + entry.length > bodySize )
+                break;
+
+            m_index.insert( key, entry );
+            m_liveBytes += entry.recordSize;
+        }
+        else if ( op == SetExpiry && it != m_index.end() )
+        {
+            it.value().expiry = expiry;
+        }
+
+        pos += RECORD_PREFIX_SIZE + bodySize;
+    }
+
+    if ( pos < size )
+    {
+        // most likely we were killed in the middle of a write
+        tLog() << Q_FUNC_INFO << "Truncating" << m_path << "from" << size << "to" << pos << "bytes";
+        unmap();
+        m_file.resize( pos );
+        remap();
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QMutableHashIterator< QByteArray, Entry > it( m_index );
+    while ( it.hasNext() )
+    {
+        it.next();
+        if ( isExpired( it.value(), now ) )
+        {
+            m_liveBytes -= it.value().recordSize;
+            it.remove();
+        }
+    }
+
+    tDebug() << Q_FUNC_INFO << "Loaded" << m_index.count() << "values from" << m_path << "-" << m_liveBytes << "of" << pos << "bytes live";
+    return true;
+}
+
+
+bool
+LogStore::isExpired( const Entry& entry, qint64 now ) const
+{
+    return entry.expiry != 0 && entry.expiry < now;
+}
+
+
+bool
+LogStore::contains( const QByteArray& key ) const
+{
+    QMutexLocker lock( &m_mutex );
+
+    QHash< QByteArray, Entry >::const_iterator it = m_index.constFind( key );
+    return it != m_index.constEnd() && !isExpired( it.value(), QDateTime::currentMSecsSinceEpoch() );
+}
+
+
+QByteArray
+LogStore::value( const QByteArray& key, qint64* expiry ) const
+{
+    QMutexLocker lock( &m_mutex );
+
+    QHash< QByteArray, Entry >::const_iterator it = m_index.constFind( key );
+    if ( it == m_index.constEnd() || isExpired( it.value(), QDateTime::currentMSecsSinceEpoch() ) )
+        return QByteArray();
+
+    if ( expiry )
+        *expiry = it.value().expiry;
+
+    if ( it.value().offset < 0 )
+        return m_pending.value( key ).value;
+
+    return readValue( it.value() );
+}
+
+
+QList< QByteArray >
+LogStore::keys() const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_index.keys();
+}
+
+
+int
+LogStore::count() const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_index.count();
+}
+
+
+QByteArray
+LogStore::readValue( const Entry& entry ) const
+{
+    if ( entry.offset + entry.length > m_mapSize )
+        remap();
+
+    if ( m_map && entry.offset + entry.length <= m_mapSize )
+        return QByteArray( reinterpret_cast< const char* >( m_map + entry.offset ), entry.length );
+
+    // couldn't map the file, do it the old-fashioned way
+    if ( !m_file.seek( entry.offset ) )
+        return QByteArray();
+
+    return m_file.read( entry.length );
+}
+
+
+void
+LogStore::remap() const
+{
+    unmap();
+
+    const qint64 size = m_file.size();
+    if ( size <= 0 )
+        return;
+
+    m_map = m_file.map( 0, size );
+    m_mapSize = m_map ? size : 0;
+}
+
+
+void
+LogStore::unmap() const
+{
+    if ( m_map )
+        m_file.unmap( m_map );
+
+    m_map = 0;
+    m_mapSize = 0;
+}
+
+
+void
+LogStore::insert( const QByteArray& key, const QByteArray& value, qint64 expiry )
+{
+    QMutexLocker lock( &m_mutex );
+
+    Entry entry;
+    QHash< QByteArray, Entry >::iterator it = m_index.find( key );
+    if ( it != m_index.end() )
+    {
+        entry.persisted = it.value().persisted;
+        if ( it.value().offset >= 0 )
+            m_liveBytes -= it.value().recordSize;
+    }
+    else if ( m_pending.contains( key ) )
+    {
+        // a pending Remove, so the file still holds an older value
+        entry.persisted = true;
+    }
+
+    entry.expiry = expiry;
+    entry.length = value.size();
+    m_index.insert( key, entry );
+    m_pending.insert( key, Record( Insert, key, expiry, value ) );
+}
+
+
+void
+LogStore::setExpiry( const QByteArray& key, qint64 expiry )
+{
+    QMutexLocker lock( &m_mutex );
+
+    QHash< QByteArray, Entry >::iterator it = m_index.find( key );
+    if ( it == m_index.end() )
+        return;
+
+    it.value().expiry = expiry;
+
+    QHash< QByteArray, Record >::iterator pending = m_pending.find( key );
+    if ( pending != m_pending.end() )
+        pending.value().expiry = expiry;
+    else
+        m_pending.insert( key, Record( SetExpiry, key, expiry ) );
+}
+
+
+void
+LogStore::remove( const QByteArray& key )
+{
+    QMutexLocker lock( &m_mutex );
+    removeEntry( key );
+}
+
+
+void
+LogStore::removeEntry( const QByteArray& key )
+{
+    QHash< QByteArray, Entry >::iterator it = m_index.find( key );
+    if ( it == m_index.end() )
+        return;
+
+    const Entry entry = it.value();
+    m_index.erase( it );
+
+    if ( entry.offset >= 0 )
+        m_liveBytes -= entry.recordSize;
+
+    if ( entry.persisted )
+        m_pending.insert( key, Record( Remove, key, 0 ) );
+    else
+        m_pending.remove( key );
+}
+
+
+int
+LogStore::removeExpired( qint64 now )
+{
+    QMutexLocker lock( &m_mutex );
+
+    QList< QByteArray > expired;
+    QHash< QByteArray, Entry >::const_iterator it = m_index.constBegin();
+    for ( ; it != m_index.constEnd(); ++it )
+    {
+        if ( isExpired( it.value(), now ) )
+            expired << it.key();
+    }
+
+    foreach ( const QByteArray& key, expired )
+    {
+        const Entry entry = m_index.value( key );
+        if ( entry.offset >= 0 && !m_pending.contains( key ) )
+        {
+            // the file carries this very expiry, the record will be skipped when loading
+            m_liveBytes -= entry.recordSize;
+            m_index.remove( key );
+        }
+        else
+        {
+            // either only pending or the expiry was changed since the last flush, in which case
+            // the file still has the old one and needs to be told explicitly
+            removeEntry( key );
+        }
+    }
+
+    return expired.count();
+}
+
+
+int
+LogStore::pendingWrites() const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_pending.count();
+}
+
+
+QByteArray
+LogStore::serialize( const Record& record, quint32* valueOffset )
+{
+    QByteArray ba;
+    ba.reserve( RECORD_PREFIX_SIZE + 1 + 4 + record.key.size() + 8 + 4 + record.value.size() );
+
+    QDataStream stream( &ba, QIODevice::WriteOnly );
+    stream << (quint32)0 << (quint16)0; // filled in below
+    stream << (quint8)record.op;
+    stream.writeBytes( record.key.constData(), record.key.size() );
+    stream << record.expiry;
+    if ( record.op == Insert )
+        stream.writeBytes( record.value.constData(), record.value.size() );
+
+    quint32 headerSize = 1 + 4 + record.key.size() + 8;
+    if ( record.op == Insert )
+        headerSize += 4;
+
+    uchar* data = reinterpret_cast< uchar* >( ba.data() );
+    qToBigEndian< quint32 >( ba.size() - RECORD_PREFIX_SIZE, data );
+    qToBigEndian< quint16 >( qChecksum( ba.constData() + RECORD_PREFIX_SIZE, headerSize ), data + 4 );
+
+    if ( valueOffset )
+        *valueOffset = RECORD_PREFIX_SIZE + headerSize;
+
+    return ba;
+}
+
+
+bool
+LogStore::writeRecords( QFile& file, const QList< Record >& records, QHash< QByteArray, Entry >& index )
+{
+    qint64 pos = file.size();
+    if ( !file.seek( pos ) )
+        return false;
+
+    QByteArray buffer;
+    foreach ( const Record& record, records )
+    {
+        quint32 valueOffset = 0;
+        const QByteArray ba = serialize( record, &valueOffset );
+
+        if ( record.op == Insert )
+        {
+            QHash< QByteArray, Entry >::iterator it = index.find( record.key );
+            if ( it != index.end() )
+            {
+                it.value().offset = pos + buffer.size() + valueOffset;
+                it.value().recordSize = ba.size();
+                it.value().persisted = true;
+            }
+        }
+
+        buffer += ba;
+    }
+
+    // one big sequential write instead of one per value
+    return file.write( buffer ) == buffer.size() && file.flush();
+}
+
+
+bool
+LogStore::flush()
+{
+    QMutexLocker lock( &m_mutex );
+
+    if ( m_pending.isEmpty() || !m_file.isOpen() )
+        return true;
+
+    const QList< Record > records = m_pending.values();
+    if ( !writeRecords( m_file, records, m_index ) )
+    {
+        tLog() << Q_FUNC_INFO << "Failed writing to" << m_path << m_file.errorString();
+        return false;
+    }
+
+    foreach ( const Record& record, records )
+    {
+        if ( record.op == Insert && m_index.contains( record.key ) )
+            m_liveBytes += m_index.value( record.key ).recordSize;
+    }
+
+    m_pending.clear();
+    return true;
+}
+
+
+bool
+LogStore::needsCompaction() const
+{
+    QMutexLocker lock( &m_mutex );
+
+    const qint64 dead = m_file.size() - LOGSTORE_HEADER_SIZE - m_liveBytes;
+    return dead > MIN_COMPACTION_BYTES && dead > m_liveBytes;
+}
+
+
+bool
+LogStore::compact()
+{
+    if ( !flush() )
+        return false;
+
+    QMutexLocker lock( &m_mutex );
+
+    const QString tmpPath = m_path + ".compact";
+    QFile tmp( tmpPath );
+    if ( !tmp.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        tLog() << Q_FUNC_INFO << "Failed to open" << tmpPath;
+        return false;
+    }
+
+    QDataStream stream( &tmp );
+    stream << (quint32)LOGSTORE_MAGIC << (quint32)LOGSTORE_VERSION;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QHash< QByteArray, Entry > index;
+    QList< Record > records;
+    bool ok = true;
+    QHash< QByteArray, Entry >::const_iterator it = m_index.constBegin();
+    for ( ; it != m_index.constEnd(); ++it )
+    {
+        if ( isExpired( it.value(), now ) )
+            continue;
+
+        if ( it.value().offset < 0 )
+        {
+            // changed since the flush above, stays pending. The old value is gone after this.
+            Entry entry = it.value();
+            entry.persisted = false;
+            index.insert( it.key(), entry );
+            continue;
+        }
+
+        index.insert( it.key(), it.value() );
+        records << Record( Insert, it.key(), it.value().expiry, readValue( it.value() ) );
+
+        // keep the memory footprint bounded for big stores
+        if ( records.count() >= 1000 )
+        {
+            ok = writeRecords( tmp, records, index );
+            records.clear();
+            if ( !ok )
+                break;
+        }
+    }
+
+    if ( ok )
+        ok = writeRecords( tmp, records, index );
+
+    if ( !ok )
+    {
+        // the store itself is untouched, just don't leave half a copy of it lying around
+        tLog() << Q_FUNC_INFO << "Failed writing" << tmpPath << tmp.errorString();
+        tmp.close();
+        QFile::remove( tmpPath );
+        return false;
+    }
+    tmp.close();
+
+    unmap();
+    m_file.close();
+    QFile::remove( m_path );
+    if ( !QFile::rename( tmpPath, m_path ) || !m_file.open( QIODevice::ReadWrite ) )
+    {
+        tLog() << Q_FUNC_INFO << "Failed to replace" << m_path << "with compacted store";
+        m_index.clear();
+        m_liveBytes = 0;
+        return false;
+    }
+
+    m_index = index;
+    m_liveBytes = m_file.size() - LOGSTORE_HEADER_SIZE;
+    remap();
+
+    tDebug() << Q_FUNC_INFO << "Compacted" << m_path << "to" << m_liveBytes << "bytes";
+    return true;
+}
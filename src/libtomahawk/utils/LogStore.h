@@ -0,0 +1,129 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_LOGSTORE_H
+#define TOMAHAWK_LOGSTORE_H
+
+#include "DllMacro.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+namespace TomahawkUtils
+{
+
+/**
+ * A log-structured key/value store kept in a single file.
+ *
+ * Every change is appended to the file as a record; an in-memory index maps each
+ * key to the offset of its current value, which is read from a memory-mapping of
+ * the file. Opening the store only walks the record headers, values are never
+ * touched until somebody asks for them.
+ *
+ * Writes are buffered until flush() is called and coalesced per key. Values carry
+ * an expiry timestamp (msecs since epoch, 0 = never) and expired values are
+ * treated as missing. Superseded records stay in the file until compact()
+ * rewrites it with only the live values.
+ *
+ * All methods are thread-safe.
+ */
+class DLLEXPORT LogStore
+{
+public:
+    explicit LogStore( const QString& path );
+    ~LogStore();
+
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    bool contains( const QByteArray& key ) const;
+    QByteArray value( const QByteArray& key, qint64* expiry = 0 ) const;
+    QList< QByteArray > keys() const;
+    int count() const;
+
+    void insert( const QByteArray& key, const QByteArray& value, qint64 expiry );
+    void setExpiry( const QByteArray& key, qint64 expiry );
+    void remove( const QByteArray& key );
+    int removeExpired( qint64 now );
+
+    int pendingWrites() const;
+    bool flush();
+
+    bool needsCompaction() const;
+    bool compact();
+
+private:
+    enum Operation
+    {
+        Insert = 1,
+        Remove = 2,
+        SetExpiry = 3
+    };
+
+    struct Record
+    {
+        Record() : op( Insert ), expiry( 0 ) {}
+        Record( Operation o, const QByteArray& k, qint64 e, const QByteArray& v = QByteArray() ) : op( o ), key( k ), expiry( e ), value( v ) {}
+
+        Operation op;
+        QByteArray key;
+        qint64 expiry;
+        QByteArray value;
+    };
+
+    struct Entry
+    {
+        Entry() : expiry( 0 ), offset( -1 ), length( 0 ), recordSize( 0 ), persisted( false ) {}
+
+        qint64 expiry;
+        qint64 offset;      // of the value in the file, -1 while the value is only in m_pending
+        quint32 length;
+        quint32 recordSize;
+        bool persisted;     // an older value of this key is stored in the file
+    };
+
+    bool load();
+    bool isExpired( const Entry& entry, qint64 now ) const;
+    QByteArray readValue( const Entry& entry ) const;
+    void remap() const;
+    void unmap() const;
+    void removeEntry( const QByteArray& key );
+    bool writeRecords( QFile& file, const QList< Record >& records, QHash< QByteArray, Entry >& index );
+
+    static QByteArray serialize( const Record& record, quint32* valueOffset );
+
+    QString m_path;
+    mutable QFile m_file;
+    mutable uchar* m_map;
+    mutable qint64 m_mapSize;
+
+    QHash< QByteArray, Entry > m_index;
+    QHash< QByteArray, Record > m_pending;
+    qint64 m_liveBytes;
+
+    mutable QMutex m_mutex;
+};
+
+}
+
+#endif // TOMAHAWK_LOGSTORE_H
@@ -20,11 +20,22 @@
 
 #include "TomahawkSettings.h"
 #include "Source.h"
+#include "utils/LogStore.h"
 #include "utils/Logger.h"
 
+#include <QDataStream>
 #include <QDateTime>
-#include <QSettings>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QMutexLocker>
+#include <QSettings>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+// write pending changes at most this often (ms)
+#define FLUSH_INTERVAL 2000
 
 using namespace TomahawkUtils;
 
@@ -43,127 +54,276 @@ Cache* Cache::instance()
 Cache::Cache()
     : QObject( 0 )
     , m_cacheBaseDir( TomahawkSettings::instance()->storageCacheLocation() + "/GenericCache/" )
-    , m_cacheManifest( m_cacheBaseDir + "cachemanifest.ini", QSettings::IniFormat )
+    , m_store( 0 )
 {
+    QDir().mkpath( m_cacheBaseDir );
+    m_store = new LogStore( m_cacheBaseDir + "cache.dat" );
+    if ( !m_store->open() )
+        tLog() << Q_FUNC_INFO << "Failed to open cache store in" << m_cacheBaseDir;
+
+    importLegacyCache();
+
     m_pruneTimer.setInterval( 300000 );
     m_pruneTimer.setSingleShot( false );
     connect( &m_pruneTimer, SIGNAL( timeout() ), SLOT( pruneTimerFired() ) );
     m_pruneTimer.start();
+
+    m_flushTimer.setInterval( FLUSH_INTERVAL );
+    m_flushTimer.setSingleShot( true );
+    connect( &m_flushTimer, SIGNAL( timeout() ), SLOT( flushTimerFired() ) );
 }
 
 
 Cache::~Cache()
 {
+    m_flushTimer.stop();
+    m_flushFuture.waitForFinished();
+
+    m_store->flush();
+    delete m_store;
 }
 
 
 void
-Cache::pruneTimerFired()
+Cache::importLegacyCache()
 {
-    QMutexLocker mutex_locker( &m_mutex );
+    // caches written by older versions: one INI file per client plus a manifest
+    const QString manifestPath = m_cacheBaseDir + "cachemanifest.ini";
+    if ( !QFile::exists( manifestPath ) )
+        return;
 
-    qDebug() << Q_FUNC_INFO << "Pruning tomahawkcache";
-    qlonglong currentMSecsSinceEpoch = QDateTime::currentMSecsSinceEpoch();
-
-    QVariantList clients = m_cacheManifest.value( "clients" ).toList();
-    foreach ( const QVariant& client, clients )
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    int imported = 0;
     {
-        const QString client_identifier = client.toString();
-        const QString cache_dir = m_cacheBaseDir + client_identifier;
-
-        QSettings cached_settings( cache_dir, QSettings::IniFormat );
-        const QStringList keys = cached_settings.allKeys();
-        foreach ( const QString& key, keys )
+        QSettings manifest( manifestPath, QSettings::IniFormat );
+        foreach ( const QVariant& client, manifest.value( "clients" ).toList() )
         {
-            CacheData data = cached_settings.value( key ).value<TomahawkUtils::CacheData>();
-            if ( data.maxAge < currentMSecsSinceEpoch )
+            const QString identifier = client.toString();
+            const QString path = m_cacheBaseDir + identifier;
             {
-                cached_settings.remove( key );
-                tLog() << Q_FUNC_INFO << "Removed stale entry: " << client_identifier << key;
+                QSettings cachedSettings( path, QSettings::IniFormat );
+                foreach ( const QString& key, cachedSettings.allKeys() )
+                {
+                    const CacheData data = cachedSettings.value( key ).value< TomahawkUtils::CacheData >();
+                    if ( data.maxAge < now )
+                        continue;
+
+                    QByteArray ba;
+                    QDataStream stream( &ba, QIODevice::WriteOnly );
+                    stream << data.data;
+                    m_store->insert( storeKey( identifier, key ), ba, data.maxAge );
+                    imported++;
+                }
             }
+            QFile::remove( path );
         }
-        cached_settings.sync();
-        if ( cached_settings.allKeys().size() == 0 )
-            removeClient( client_identifier );
     }
+    QFile::remove( manifestPath );
+
+    m_store->flush();
+    tLog() << Q_FUNC_INFO << "Imported" << imported << "entries from legacy cache";
 }
 
 
-QVariant
-Cache::getData( const QString& identifier, const QString& key )
+QByteArray
+Cache::storeKey( const QString& identifier, const QString& key )
+{
+    QByteArray ba = identifier.toUtf8();
+    ba.append( '\0' );
+    ba.append( key.toUtf8() );
+    return ba;
+}
+
+
+void
+Cache::pruneTimerFired()
 {
     QMutexLocker mutex_locker( &m_mutex );
 
-    const QString cacheDir = m_cacheBaseDir + identifier;
-    QSettings cached_settings( cacheDir, QSettings::IniFormat );
+    qDebug() << Q_FUNC_INFO << "Pruning tomahawkcache";
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
 
-    if ( cached_settings.contains( key ) )
+    int removed = 0;
+    while ( !m_expiryHeap.isEmpty() && m_expiryHeap.first().expiry < now )
     {
-        CacheData data = cached_settings.value( key ).value<TomahawkUtils::CacheData>();
+        std::pop_heap( m_expiryHeap.begin(), m_expiryHeap.end() );
+        const ExpiryEntry entry = m_expiryHeap.takeLast();
+
+        // the heap may still hold entries for values that have been replaced since
+        QHash< QString, QHash< QString, CacheData > >::iterator client = m_data.find( entry.identifier );
+        if ( client == m_data.end() )
+            continue;
 
-        if ( data.maxAge < QDateTime::currentMSecsSinceEpoch() )
+        QHash< QString, CacheData >::iterator it = client.value().find( entry.key );
+        if ( it == client.value().end() || it.value().maxAge != entry.expiry )
+            continue;
+
+        client.value().erase( it );
+        if ( client.value().isEmpty() )
+            m_data.erase( client );
+
+        m_store->remove( storeKey( entry.identifier, entry.key ) );
+        removed++;
+    }
+
+    // values that were never loaded into memory
+    removed += m_store->removeExpired( now );
+
+    // get rid of stale heap entries when they start to outnumber the real ones
+    int entries = 0;
+    QHash< QString, QHash< QString, CacheData > >::const_iterator client = m_data.constBegin();
+    for ( ; client != m_data.constEnd(); ++client )
+        entries += client.value().count();
+    if ( m_expiryHeap.count() > 2 * entries + 64 )
+    {
+        QList< ExpiryEntry > heap;
+        for ( client = m_data.constBegin(); client != m_data.constEnd(); ++client )
         {
-            cached_settings.remove( key );
-            tLog() << Q_FUNC_INFO << "Removed stale entry:" << identifier << key;
-            return QVariant();
+            QHash< QString, CacheData >::const_iterator it = client.value().constBegin();
+            for ( ; it != client.value().constEnd(); ++it )
+                heap << ExpiryEntry( it.value().maxAge, client.key(), it.key() );
         }
-        tDebug() << Q_FUNC_INFO << "Fetched data for" << identifier << key;
-        return data.data;
 
+        std::make_heap( heap.begin(), heap.end() );
+        m_expiryHeap = heap;
     }
-    tDebug() << Q_FUNC_INFO << "No such key" << key;
-    return QVariant();
-}
 
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Removed" << removed << "stale entries -"
+                         << "hits:" << m_stats.hits << "misses:" << m_stats.misses << "puts:" << m_stats.puts
+                         << "avg lookup (us):" << ( m_stats.hits + m_stats.misses ? m_stats.lookupUSecs / ( m_stats.hits + m_stats.misses ) : 0 );
 
-void
-Cache::putData( const QString& identifier, qint64 maxAge, const QString& key, const QVariant& value )
-{
-    QMutexLocker mutex_locker( &m_mutex );
+    if ( m_flushFuture.isRunning() )
+        return;
 
-    const QString cacheDir = m_cacheBaseDir + identifier;
-    addClient( identifier );
-    QSettings cached_settings( cacheDir, QSettings::IniFormat );
-    cached_settings.setValue( key, QVariant::fromValue( CacheData( QDateTime::currentMSecsSinceEpoch() + maxAge, value ) ) );
-    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Storing from client" << identifier << maxAge << key;
+    m_flushTimer.stop();
+    if ( m_store->needsCompaction() )
+        m_flushFuture = QtConcurrent::run( m_store, &LogStore::compact );
+    else
+        m_flushFuture = QtConcurrent::run( m_store, &LogStore::flush );
 }
 
 
 void
-Cache::addClient( const QString& identifier )
+Cache::flushTimerFired()
 {
-    QVariantList clients = m_cacheManifest.value( "clients" ).toList();
-    foreach ( const QVariant& client, clients )
+    if ( m_flushFuture.isRunning() )
     {
-        const QString client_identifier = client.toString();
-        if ( identifier == client_identifier )
-            return;
+        // still busy with the last batch
+        m_flushTimer.start();
+        return;
     }
 
-    tLog() << Q_FUNC_INFO << "adding client" << identifier;
-    clients.append( identifier );
-    m_cacheManifest.setValue( "clients", clients );
-    m_cacheManifest.sync();
+    m_flushFuture = QtConcurrent::run( m_store, &LogStore::flush );
+}
+
+
+void
+Cache::scheduleFlush()
+{
+    // we may be called from any thread, the timer lives in ours
+    if ( !m_flushTimer.isActive() )
+        QMetaObject::invokeMethod( &m_flushTimer, "start", Qt::QueuedConnection );
 }
 
 
 void
-Cache::removeClient( const QString& identifier )
+Cache::insert( const QString& identifier, const QString& key, const CacheData& data )
 {
-    QVariantList clients = m_cacheManifest.value( "clients" ).toList();
-    QVariantList::iterator it = clients.begin();
-    while ( it != clients.end() )
+    m_data[ identifier ].insert( key, data );
+
+    m_expiryHeap << ExpiryEntry( data.maxAge, identifier, key );
+    std::push_heap( m_expiryHeap.begin(), m_expiryHeap.end() );
+}
+
+
+QVariant
+Cache::getData( const QString& identifier, const QString& key )
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QMutexLocker mutex_locker( &m_mutex );
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVariant result;
+
+    QHash< QString, QHash< QString, CacheData > >::iterator client = m_data.find( identifier );
+    QHash< QString, CacheData >::iterator it;
+    if ( client != m_data.end() && ( it = client.value().find( key ) ) != client.value().end() )
     {
-        const QString client_identifier = it->toString();
-        if ( identifier == client_identifier )
+        if ( it.value().maxAge < now )
         {
-            tLog() << Q_FUNC_INFO << "removing client" << identifier;
-            clients.erase( it );
-            break;
+            client.value().erase( it );
+            m_store->remove( storeKey( identifier, key ) );
+            scheduleFlush();
+            tLog() << Q_FUNC_INFO << "Removed stale entry:" << identifier << key;
+        }
+        else
+            result = it.value().data;
+    }
+    else
+    {
+        // not loaded yet
+        qint64 expiry = 0;
+        const QByteArray ba = m_store->value( storeKey( identifier, key ), &expiry );
+        if ( !ba.isNull() )
+        {
+            QDataStream stream( ba );
+            stream >> result;
+            insert( identifier, key, CacheData( expiry, result ) );
         }
-        ++it;
     }
 
-    m_cacheManifest.setValue( "clients", clients );
-    m_cacheManifest.sync();
+    if ( result.isValid() )
+    {
+        m_stats.hits++;
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Fetched data for" << identifier << key;
+    }
+    else
+    {
+        m_stats.misses++;
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "No such key" << key;
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK( 4, 8, 0 )
+    m_stats.lookupUSecs += timer.nsecsElapsed() / 1000;
+#else
+    m_stats.lookupUSecs += timer.elapsed() * 1000;
+#endif
+
+    return result;
+}
+
+
+void
+Cache::putData( const QString& identifier, qint64 maxAge, const QString& key, const QVariant& value )
+{
+    QMutexLocker mutex_locker( &m_mutex );
+
+    const qint64 expiry = QDateTime::currentMSecsSinceEpoch() + maxAge;
+    insert( identifier, key, CacheData( expiry, value ) );
+
+    QByteArray ba;
+    QDataStream stream( &ba, QIODevice::WriteOnly );
+    stream << value;
+    m_store->insert( storeKey( identifier, key ), ba, expiry );
+
+    m_stats.puts++;
+    scheduleFlush();
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Storing from client" << identifier << maxAge << key;
+}
+
+
+Cache::Stats
+Cache::stats() const
+{
+    QMutexLocker mutex_locker( &m_mutex );
+
+    Stats stats = m_stats;
+    QHash< QString, QHash< QString, CacheData > >::const_iterator client = m_data.constBegin();
+    for ( ; client != m_data.constEnd(); ++client )
+        stats.entries += client.value().count();
+
+    return stats;
 }
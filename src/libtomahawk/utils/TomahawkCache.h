@@ -22,8 +22,9 @@
 #include "DllMacro.h"
 #include "utils/TomahawkUtils.h"
 
+#include <QFuture>
+#include <QHash>
 #include <QMutex>
-#include <QSettings>
 #include <QObject>
 #include <QTimer>
 
@@ -45,6 +46,8 @@ struct CacheData
     QVariant data;
 };
 
+class LogStore;
+
 /**
  * A simple generic cache for anyone to use.
  *
@@ -53,6 +56,10 @@ struct CacheData
  *
  * Structure is a basic key-value store with associated max lifetime in
  * milliseconds.
+ *
+ * Lookups are served from memory. Changes are written to a LogStore in the
+ * background, in batches, and values are only read back from it the first
+ * time they are asked for.
  */
 class DLLEXPORT Cache : public QObject
 {
@@ -79,29 +86,67 @@ public:
      */
     QVariant getData( const QString& identifier, const QString& key );
 
+    struct Stats
+    {
+        Stats() : hits( 0 ), misses( 0 ), puts( 0 ), lookupUSecs( 0 ), entries( 0 ) {}
+
+        quint64 hits;
+        quint64 misses;
+        quint64 puts;
+        quint64 lookupUSecs; //!< total time spent in getData()
+        int entries;         //!< values currently held in memory
+    };
+
+    Stats stats() const;
+
 private slots:
     void pruneTimerFired();
+    void flushTimerFired();
 
 private:
     Cache();
     static Cache* s_instance;
 
+    struct ExpiryEntry
+    {
+        ExpiryEntry() : expiry( 0 ) {}
+        ExpiryEntry( qint64 e, const QString& i, const QString& k ) : expiry( e ), identifier( i ), key( k ) {}
+
+        // std heaps are max-heaps, we want the earliest expiry on top
+        bool operator<( const ExpiryEntry& other ) const { return expiry > other.expiry; }
+
+        qint64 expiry;
+        QString identifier;
+        QString key;
+    };
+
     /**
-     * Adds a client to the manifest.
+     * Puts data into the in-memory hash and the expiry heap.
      * Does not lock the mutex.
      */
-    void addClient( const QString& identifier );
+    void insert( const QString& identifier, const QString& key, const CacheData& data );
 
     /**
-     * Removes a client to the manifest.
+     * Schedules writing out pending changes.
      * Does not lock the mutex.
      */
-    void removeClient( const QString& identifier );
+    void scheduleFlush();
+
+    void importLegacyCache();
+
+    static QByteArray storeKey( const QString& identifier, const QString& key );
 
     QString m_cacheBaseDir;
-    QSettings m_cacheManifest;
+    LogStore* m_store;
+    QFuture< bool > m_flushFuture;
+
+    QHash< QString, QHash< QString, CacheData > > m_data;
+    QList< ExpiryEntry > m_expiryHeap;
+    Stats m_stats;
+
     QTimer m_pruneTimer;
-    QMutex m_mutex;
+    QTimer m_flushTimer;
+    mutable QMutex m_mutex;
 };
 
 }
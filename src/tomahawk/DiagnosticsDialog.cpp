@@ -44,6 +44,10 @@
 #include <QClipboard>
 #include <QDebug>
 
+// how many of the most expensive database commands and recent slow queries to list
+#define DATABASE_COMMANDS 15
+#define DATABASE_SLOW_QUERIES 5
+
 
 DiagnosticsDialog::DiagnosticsDialog( QWidget *parent )
     : QDialog( parent )
@@ -103,6 +107,8 @@ DiagnosticsDialog::updateLogView()
 
     log.append( "\n\n" );
 
+    log.append( databaseLog() + "\n" );
+
     log.append( "ACCOUNTS:\n" );
 
     const QList< Tomahawk::source_ptr > sources = SourceList::instance()->sources( true );
@@ -138,6 +144,78 @@ DiagnosticsDialog::openLogfile()
 }
 
 
+QString
+DiagnosticsDialog::databaseLog()
+{
+    const QVariantMap stats = Database::instance()->statistics();
+    QString dbInfo( "DATABASE:\n" );
+
+    const QVariantMap queues = stats.value( "queues" ).toMap();
+    dbInfo.append( QString( "    Queued: %1 read-only, %2 read-write\n" ).arg( queues.value( "ro" ).toInt() ).arg( queues.value( "rw" ).toInt() ) );
+
+    dbInfo.append( "    Workers:\n" );
+    const QVariantMap workers = stats.value( "workers" ).toMap();
+    foreach ( const QString& name, workers.keys() )
+    {
+        const QVariantMap w = workers.value( name ).toMap();
+        dbInfo.append( QString( "      %1: %2 commands, %3% busy\n" )
+                          .arg( name )
+                          .arg( w.value( "commands" ).toLongLong() )
+                          .arg( w.value( "utilization" ).toDouble() * 100.0, 0, 'f', 1 ) );
+    }
+
+    const QVariantMap transactions = stats.value( "transactions" ).toMap();
+    dbInfo.append( QString( "    Transactions: %1 for %2 commands, %3 saved (%4/s), %5 commands deferred\n" )
+                      .arg( transactions.value( "count" ).toLongLong() )
+                      .arg( transactions.value( "commands" ).toLongLong() )
+                      .arg( transactions.value( "saved" ).toLongLong() )
+                      .arg( transactions.value( "saved_per_sec" ).toDouble(), 0, 'f', 2 )
+                      .arg( stats.value( "deferred" ).toMap().value( "commands" ).toLongLong() ) );
+
+    // most total execution time first
+    const QVariantMap commands = stats.value( "commands" ).toMap();
+    QMultiMap< qlonglong, QString > byTotal;
+    foreach ( const QString& name, commands.keys() )
+        byTotal.insert( commands.value( name ).toMap().value( "exec_ms" ).toMap().value( "total" ).toLongLong(), name );
+
+    dbInfo.append( "    Commands (count, exec ms p50/p95/max, wait ms p95, rows read p95, rows changed p95):\n" );
+    QMapIterator< qlonglong, QString > it( byTotal );
+    it.toBack();
+    int listed = 0;
+    while ( it.hasPrevious() && listed++ < DATABASE_COMMANDS )
+    {
+        it.previous();
+        const QVariantMap c = commands.value( it.value() ).toMap();
+        const QVariantMap exec = c.value( "exec_ms" ).toMap();
+
+        dbInfo.append( QString( "      %1: %2, %3/%4/%5, %6, %7, %8\n" )
+                          .arg( it.value() )
+                          .arg( exec.value( "count" ).toLongLong() )
+                          .arg( exec.value( "p50" ).toLongLong() )
+                          .arg( exec.value( "p95" ).toLongLong() )
+                          .arg( exec.value( "max" ).toLongLong() )
+                          .arg( c.value( "wait_ms" ).toMap().value( "p95" ).toLongLong() )
+                          .arg( c.value( "rows_read" ).toMap().value( "p95" ).toLongLong() )
+                          .arg( c.value( "rows_changed" ).toMap().value( "p95" ).toLongLong() ) );
+    }
+
+    const QVariantList slowQueries = stats.value( "slow_queries" ).toList();
+    if ( !slowQueries.isEmpty() )
+    {
+        dbInfo.append( "    Slow queries:\n" );
+        for ( int i = qMax( 0, slowQueries.count() - DATABASE_SLOW_QUERIES ); i < slowQueries.count(); i++ )
+        {
+            const QVariantMap q = slowQueries.at( i ).toMap();
+            dbInfo.append( QString( "      %1 ms: %2\n" ).arg( q.value( "ms" ).toInt() ).arg( q.value( "sql" ).toString().simplified() ) );
+            foreach ( const QVariant& step, q.value( "plan" ).toList() )
+                dbInfo.append( QString( "        %1\n" ).arg( step.toString() ) );
+        }
+    }
+
+    return dbInfo;
+}
+
+
 QString
 DiagnosticsDialog::accountLog( Tomahawk::Accounts::Account* account )
 {
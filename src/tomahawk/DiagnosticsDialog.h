@@ -50,6 +50,8 @@ private slots:
     QString accountLog( Tomahawk::Accounts::Account* );
 
 private:
+    QString databaseLog();
+
     Ui::DiagnosticsDialog* ui;
     QString peerLog( const QString& nodeid, const QList<Tomahawk::peerinfo_ptr>& peerInfos );
 };
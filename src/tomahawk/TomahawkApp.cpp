@@ -37,6 +37,7 @@
 #include "database/Database.h"
 #include "database/DatabaseCollection.h"
 #include "database/DatabaseCommand_CollectionStats.h"
+#include "database/DatabaseCommand_CompactOplog.h"
 #include "database/DatabaseResolver.h"
 #include "playlist/dynamic/GeneratorFactory.h"
 #include "playlist/dynamic/echonest/EchonestGenerator.h"
@@ -175,7 +176,7 @@ TomahawkApp::init()
 #ifdef ENABLE_HEADLESS
     m_headless = true;
 #else
-    m_headless = arguments().contains( "--headless" );
+    m_headless = arguments().contains( "--headless" ) || arguments().contains( "--scan-only" );
     setWindowIcon( QIcon( RESPATH "icons/tomahawk-icon-128x128.png" ) );
     setQuitOnLastWindowClosed( false );
 
@@ -208,7 +209,8 @@ TomahawkApp::init()
     tDebug() << "Init Database.";
     initDatabase();
 
-    m_scanManager = QPointer<ScanManager>( new ScanManager( this ) );
+    // --scan-only runs the one scan it quits after itself, see onInfoSystemReady()
+    m_scanManager = QPointer<ScanManager>( new ScanManager( this, !arguments().contains( "--scan-only" ) ) );
 
 #ifndef ENABLE_HEADLESS
     Pipeline::instance()->addExternalResolverFactory( boost::bind( &JSResolver::factory, _1, _2 ) );
@@ -269,6 +271,10 @@ TomahawkApp::~TomahawkApp()
 {
     tDebug( LOGVERBOSE ) << "Shutting down Tomahawk...";
 
+    // deferred and queued writes run their post commit hooks against the Servent and friends
+    if ( !m_database.isNull() )
+        m_database.data()->flush();
+
     if ( !m_session.isNull() )
         delete m_session.data();
     if ( !m_connector.isNull() )
@@ -331,6 +337,7 @@ TomahawkApp::printHelp()
     echo( "  --testdb       Use a test database instead of real collection" );
     echo( "  --noupnp       Disable UPnP port-forwarding" );
     echo( "  --nosip        Disable Session Initiation Protocol (required to find other Tomahawk clients)" );
+    echo( "  --scan-only    Scan the collection without a GUI and quit when done" );
     echo( "  --verbose      Increase verbosity (activates debug output)" );
     echo();
     echo( "Playback Controls:" );
@@ -531,6 +538,9 @@ TomahawkApp::initLocalCollection()
     connect( cmd,       SIGNAL( done( const QVariantMap& ) ),
              src.data(),  SLOT( setStats( const QVariantMap& ) ), Qt::QueuedConnection );
     Database::instance()->enqueue( QSharedPointer<DatabaseCommand>( cmd ) );
+
+    // keeps the history we replay to new peers short, only does something once enough ops piled up
+    Database::instance()->enqueue( QSharedPointer<DatabaseCommand>( new DatabaseCommand_CompactOplog() ) );
 }
 
 
@@ -582,7 +592,7 @@ TomahawkApp::initSIP()
 {
     tDebug() << Q_FUNC_INFO;
     //FIXME: jabber autoconnect is really more, now that there is sip -- should be renamed and/or split out of jabber-specific settings
-    if ( !arguments().contains( "--nosip" ) &&
+    if ( !arguments().contains( "--nosip" ) && !arguments().contains( "--scan-only" ) &&
          Servent::instance()->isReady() && Accounts::AccountManager::instance()->isReadyForSip() )
     {
         tDebug( LOGINFO ) << "Connecting SIP classes";
@@ -638,7 +648,7 @@ TomahawkApp::onInfoSystemReady()
     connect( TomahawkSettings::instance(), SIGNAL( changed() ), SLOT( initHTTP() ) );
 
 #ifndef ENABLE_HEADLESS
-    if ( !s->hasScannerPaths() )
+    if ( !m_headless && !s->hasScannerPaths() )
     {
         m_mainwindow->showSettingsDialog();
     }
@@ -654,6 +664,13 @@ TomahawkApp::onInfoSystemReady()
         m_scanManager.data()->runFullRescan();
     }
 
+    if ( arguments().contains( "--scan-only" ) )
+    {
+        // import the collection (resuming an interrupted scan) and quit once it's committed
+        connect( m_scanManager.data(), SIGNAL( finished() ), SLOT( quit() ) );
+        m_scanManager.data()->runStartupScan();
+    }
+
     // Set up echonest catalog synchronizer
     Tomahawk::EchonestCatalogSynchronizer::instance();
 
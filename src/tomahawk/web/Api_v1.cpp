@@ -27,6 +27,8 @@
 #include "database/Database.h"
 #include "database/DatabaseCommand_AddClientAuth.h"
 #include "database/DatabaseCommand_ClientAuthValid.h"
+#include "database/DatabaseCommand_Suggest.h"
+#include "database/DatabaseStats.h"
 #include "network/Servent.h"
 #include "Pipeline.h"
 #include "Source.h"
@@ -171,6 +173,8 @@ Api_v1::api( QxtWebRequestEvent* event )
         if ( method == "stat" )        return stat( event );
         if ( method == "resolve" )     return resolve( event );
         if ( method == "get_results" ) return get_results( event );
+        if ( method == "suggest" )     return suggest( event );
+        if ( method == "dbstats" )     return dbstats( event );
     }
 
     send404( event );
@@ -314,6 +318,59 @@ Api_v1::resolve( QxtWebRequestEvent* event )
 }
 
 
+void
+Api_v1::suggest( QxtWebRequestEvent* event )
+{
+    const QString prefix = urlQueryItemValue( event->url, "q" );
+    if ( prefix.trimmed().isEmpty() )
+    {
+        tDebug( LOGVERBOSE ) << "Malformed HTTP suggest request";
+        return send404( event );
+    }
+
+    int limit = 10;
+    if ( urlHasQueryItem( event->url, "limit" ) )
+        limit = qBound( 1, urlQueryItemValue( event->url, "limit" ).toInt(), 50 );
+
+    // clients typing fast tend to ask for the same prefix more than once
+    const QPair< QString, int > key( prefix, limit );
+    const bool pending = m_pendingSuggestions.contains( key );
+    m_pendingSuggestions[ key ] << event;
+    if ( pending )
+        return;
+
+    DatabaseCommand_Suggest* cmd = new DatabaseCommand_Suggest( prefix, limit );
+    connect( cmd, SIGNAL( done( QString, int, QVariantList ) ), SLOT( suggestResult( QString, int, QVariantList ) ), Qt::QueuedConnection );
+    Database::instance()->enqueue( QSharedPointer<DatabaseCommand>( cmd ) );
+}
+
+
+void
+Api_v1::suggestResult( const QString& prefix, int limit, const QVariantList& suggestions )
+{
+    QVariantMap m;
+    m.insert( "query", prefix );
+    m.insert( "suggestions", suggestions );
+
+    foreach ( QxtWebRequestEvent* event, m_pendingSuggestions.take( qMakePair( prefix, limit ) ) )
+        sendJSON( m, event );
+}
+
+
+// latency histograms, worker utilization and slow query plans of the database, see DatabaseStats.
+// A POST also clears them after they were read.
+void
+Api_v1::dbstats( QxtWebRequestEvent* event )
+{
+    const QVariantMap m = Database::instance()->statistics();
+
+    if ( event->method == "POST" )
+        Database::instance()->stats()->reset();
+
+    sendJSON( m, event );
+}
+
+
 void
 Api_v1::staticdata( QxtWebRequestEvent* event, const QString& str )
 {
@@ -34,6 +34,8 @@
 #include <qjson/qobjecthelper.h>
 
 #include <QFile>
+#include <QHash>
+#include <QPair>
 #include <QSharedPointer>
 #include <QStringList>
 
@@ -66,6 +68,9 @@ public slots:
     void stat( QxtWebRequestEvent* event );
     void statResult( const QString& clientToken, const QString& name, bool valid );
     void resolve( QxtWebRequestEvent* event );
+    void suggest( QxtWebRequestEvent* event );
+    void suggestResult( const QString& prefix, int limit, const QVariantList& suggestions );
+    void dbstats( QxtWebRequestEvent* event );
     void staticdata( QxtWebRequestEvent* event,const QString& );
     void get_results( QxtWebRequestEvent* event );
     void sendJSON( const QVariantMap& m, QxtWebRequestEvent* event );
@@ -80,6 +85,7 @@ private:
     void processSid( QxtWebRequestEvent* event, Tomahawk::result_ptr&, QSharedPointer< QIODevice >& );
 
     QxtWebRequestEvent* m_storedEvent;
+    QHash< QPair< QString, int >, QList< QxtWebRequestEvent* > > m_pendingSuggestions; // by prefix and limit
     QSharedPointer< QIODevice > m_ioDevice;
 };
 
@@ -0,0 +1,143 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTADDFILES_H
+#define TOMAHAWK_TESTADDFILES_H
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+
+#include "libtomahawk/database/DatabaseCommand_AddFiles.h"
+#include "libtomahawk/database/FileBatch.h"
+
+class TestAddFiles : public QObject
+{
+    Q_OBJECT
+
+private:
+    FileBatch syntheticBatch( int count )
+    {
+        FileBatch batch;
+        batch.reserve( count );
+        for ( int i = 0; i < count; i++ )
+        {
+            batch.append( QString( "file:///music/artist%1/album%2/track%3.mp3" ).arg( i / 100 ).arg( i / 10 ).arg( i ),
+                          1360000000 + i, 4000000 + i, "", "audio/mpeg", 240, 320,
+                          QString( "Artist %1" ).arg( i / 100 ), QString( "Album %1" ).arg( i / 10 ), QString( "Track %1" ).arg( i ),
+                          i % 10 + 1, 2013, QString(), QString(), 1 );
+        }
+
+        return batch;
+    }
+
+    QSqlDatabase openDatabase( const QString& name )
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase( "QSQLITE", name );
+        db.setDatabaseName( ":memory:" );
+        db.open();
+
+        QSqlQuery query( db );
+        query.exec( "CREATE TABLE file ("
+                    "id INTEGER PRIMARY KEY AUTOINCREMENT, source INTEGER, url TEXT NOT NULL, size INTEGER NOT NULL, "
+                    "mtime INTEGER NOT NULL, md5 TEXT, mimetype TEXT, duration INTEGER NOT NULL DEFAULT 0, "
+                    "bitrate INTEGER NOT NULL DEFAULT 0 )" );
+        query.exec( "CREATE UNIQUE INDEX file_url_src_uniq ON file(source, url)" );
+        return db;
+    }
+
+private slots:
+    void testVariantRoundTrip()
+    {
+        FileBatch batch = syntheticBatch( 3 );
+        FileBatch copy = FileBatch::fromVariantList( batch.toVariantList() );
+
+        QCOMPARE( copy.count(), 3 );
+        QCOMPARE( copy.urls, batch.urls );
+        QCOMPARE( copy.artists, batch.artists );
+        QCOMPARE( copy.albumpos, batch.albumpos );
+    }
+
+    void testInsertFiles()
+    {
+        QSqlDatabase db = openDatabase( "testInsertFiles" );
+        FileBatch batch = syntheticBatch( 250 );
+
+        db.transaction();
+        QVERIFY( DatabaseCommand_AddFiles::insertFiles( db, QVariant( QVariant::Int ), batch ) );
+        db.commit();
+
+        QCOMPARE( batch.fileIds.count(), 250 );
+        QSqlQuery query( db );
+        query.exec( "SELECT id, url FROM file ORDER BY id" );
+        for ( int i = 0; i < batch.count(); i++ )
+        {
+            QVERIFY( query.next() );
+            QCOMPARE( query.value( 0 ).toUInt(), batch.fileIds.at( i ) );
+            QCOMPARE( query.value( 1 ).toString(), batch.urls.at( i ) );
+        }
+    }
+
+    void testInsertFilesSkipsExisting()
+    {
+        QSqlDatabase db = openDatabase( "testInsertFilesSkipsExisting" );
+        FileBatch first = syntheticBatch( 1 );
+        FileBatch batch = syntheticBatch( 250 );
+
+        db.transaction();
+        QVERIFY( DatabaseCommand_AddFiles::insertFiles( db, QVariant( QVariant::Int ), first ) );
+
+        // the first url is already known, only that file must be lost, not its whole chunk
+        QVERIFY( !DatabaseCommand_AddFiles::insertFiles( db, QVariant( QVariant::Int ), batch ) );
+        db.commit();
+
+        QCOMPARE( batch.fileIds.at( 0 ), 0u );
+        QSqlQuery query( db );
+        query.exec( "SELECT id, url FROM file ORDER BY id" );
+        QVERIFY( query.next() );
+        QCOMPARE( query.value( 0 ).toUInt(), first.fileIds.at( 0 ) );
+        for ( int i = 1; i < batch.count(); i++ )
+        {
+            QVERIFY( query.next() );
+            QCOMPARE( query.value( 0 ).toUInt(), batch.fileIds.at( i ) );
+            QCOMPARE( query.value( 1 ).toString(), batch.urls.at( i ) );
+        }
+        QVERIFY( !query.next() );
+    }
+
+    void testFilesSkipsNotInserted()
+    {
+        QSqlDatabase db = openDatabase( "testFilesSkipsNotInserted" );
+        FileBatch first = syntheticBatch( 1 );
+        FileBatch batch = syntheticBatch( 3 );
+
+        db.transaction();
+        QVERIFY( DatabaseCommand_AddFiles::insertFiles( db, QVariant( QVariant::Int ), first ) );
+        QVERIFY( !DatabaseCommand_AddFiles::insertFiles( db, QVariant( QVariant::Int ), batch ) );
+        db.commit();
+
+        // what goes to the oplog: the skipped file is left out, urls are replaced by the ids
+        DatabaseCommand_AddFiles cmd( batch, Tomahawk::source_ptr() );
+        const QVariantList files = cmd.files();
+        QCOMPARE( files.count(), 2 );
+        QCOMPARE( files.at( 0 ).toMap().value( "url" ).toString(), QString::number( batch.fileIds.at( 1 ) ) );
+        QCOMPARE( files.at( 1 ).toMap().value( "url" ).toString(), QString::number( batch.fileIds.at( 2 ) ) );
+    }
+};
+
+#endif
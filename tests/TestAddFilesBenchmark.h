@@ -0,0 +1,132 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTADDFILESBENCHMARK_H
+#define TOMAHAWK_TESTADDFILESBENCHMARK_H
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+
+#include "libtomahawk/database/DatabaseCommand_AddFiles.h"
+#include "libtomahawk/database/FileBatch.h"
+
+#define SYNTHETIC_FILES 100000
+
+/// Scans and inserts a collection of SYNTHETIC_FILES files, the old way through QVariants and with FileBatch.
+class TestAddFilesBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    FileBatch syntheticBatch( int count )
+    {
+        FileBatch batch;
+        batch.reserve( count );
+        for ( int i = 0; i < count; i++ )
+        {
+            batch.append( QString( "file:///music/artist%1/album%2/track%3.mp3" ).arg( i / 100 ).arg( i / 10 ).arg( i ),
+                          1360000000 + i, 4000000 + i, "", "audio/mpeg", 240, 320,
+                          QString( "Artist %1" ).arg( i / 100 ), QString( "Album %1" ).arg( i / 10 ), QString( "Track %1" ).arg( i ),
+                          i % 10 + 1, 2013, QString(), QString(), 1 );
+        }
+
+        return batch;
+    }
+
+    QSqlDatabase openDatabase( const QString& name )
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase( "QSQLITE", name );
+        db.setDatabaseName( ":memory:" );
+        db.open();
+
+        QSqlQuery query( db );
+        query.exec( "CREATE TABLE file ("
+                    "id INTEGER PRIMARY KEY AUTOINCREMENT, source INTEGER, url TEXT NOT NULL, size INTEGER NOT NULL, "
+                    "mtime INTEGER NOT NULL, md5 TEXT, mimetype TEXT, duration INTEGER NOT NULL DEFAULT 0, "
+                    "bitrate INTEGER NOT NULL DEFAULT 0 )" );
+        query.exec( "CREATE UNIQUE INDEX file_url_src_uniq ON file(source, url)" );
+        return db;
+    }
+
+private slots:
+    void benchmarkVariantScan()
+    {
+        QBENCHMARK_ONCE
+        {
+            QVariantList files = syntheticBatch( SYNTHETIC_FILES ).toVariantList();
+            QCOMPARE( files.count(), SYNTHETIC_FILES );
+        }
+    }
+
+    void benchmarkBatchScan()
+    {
+        QBENCHMARK_ONCE
+        {
+            FileBatch batch = syntheticBatch( SYNTHETIC_FILES );
+            QCOMPARE( batch.count(), SYNTHETIC_FILES );
+        }
+    }
+
+    void benchmarkSingleRowInsert()
+    {
+        QSqlDatabase db = openDatabase( "benchmarkSingleRowInsert" );
+        QVariantList files = syntheticBatch( SYNTHETIC_FILES ).toVariantList();
+
+        QBENCHMARK_ONCE
+        {
+            db.transaction();
+            QSqlQuery query( db );
+            query.prepare( "INSERT INTO file(source, url, size, mtime, md5, mimetype, duration, bitrate) VALUES (?, ?, ?, ?, ?, ?, ?, ?)" );
+            foreach ( const QVariant& v, files )
+            {
+                const QVariantMap m = v.toMap();
+                query.bindValue( 0, QVariant( QVariant::Int ) );
+                query.bindValue( 1, m.value( "url" ).toString() );
+                query.bindValue( 2, m.value( "size" ).toUInt() );
+                query.bindValue( 3, m.value( "mtime" ).toInt() );
+                query.bindValue( 4, m.value( "hash" ).toString() );
+                query.bindValue( 5, m.value( "mimetype" ).toString() );
+                query.bindValue( 6, m.value( "duration" ).toUInt() );
+                query.bindValue( 7, m.value( "bitrate" ).toUInt() );
+                query.exec();
+            }
+            db.commit();
+        }
+    }
+
+    void benchmarkMultiRowInsert()
+    {
+        QSqlDatabase db = openDatabase( "benchmarkMultiRowInsert" );
+        FileBatch batch = syntheticBatch( SYNTHETIC_FILES );
+
+        QBENCHMARK_ONCE
+        {
+            db.transaction();
+            QVERIFY( DatabaseCommand_AddFiles::insertFiles( db, QVariant( QVariant::Int ), batch ) );
+            db.commit();
+        }
+
+        QSqlQuery query( db );
+        query.exec( "SELECT COUNT(*) FROM file" );
+        QVERIFY( query.next() );
+        QCOMPARE( query.value( 0 ).toInt(), SYNTHETIC_FILES );
+    }
+};
+
+#endif
@@ -0,0 +1,227 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTCOMPLETIONINDEX_H
+#define TOMAHAWK_TESTCOMPLETIONINDEX_H
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+
+#include "libtomahawk/database/CompletionIndex.h"
+
+// more than one block of names, so lookups and updates cross block boundaries
+#define SYNTHETIC_TRACKS 10000
+
+class TestCompletionIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    QSqlDatabase openDatabase( const QString& name )
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase( "QSQLITE", name );
+        db.setDatabaseName( ":memory:" );
+        db.open();
+
+        QSqlQuery query( db );
+        query.exec( "CREATE TABLE artist ( id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT NOT NULL, sortname TEXT NOT NULL )" );
+        query.exec( "CREATE TABLE album ( id INTEGER PRIMARY KEY AUTOINCREMENT, artist INTEGER NOT NULL, name TEXT NOT NULL, sortname TEXT NOT NULL )" );
+        query.exec( "CREATE TABLE track ( id INTEGER PRIMARY KEY AUTOINCREMENT, artist INTEGER NOT NULL, name TEXT NOT NULL, sortname TEXT NOT NULL )" );
+        return db;
+    }
+
+    // sortnames as DatabaseImpl::sortname() stores them
+    int addArtist( QSqlDatabase& db, const QString& name )
+    {
+        QSqlQuery query( db );
+        query.prepare( "INSERT INTO artist ( name, sortname ) VALUES ( ?, ? )" );
+        query.addBindValue( name );
+        query.addBindValue( name.toLower() );
+        query.exec();
+        return query.lastInsertId().toInt();
+    }
+
+    void add( QSqlDatabase& db, const QString& table, int artist, const QString& name )
+    {
+        QSqlQuery query( db );
+        query.prepare( QString( "INSERT INTO %1 ( artist, name, sortname ) VALUES ( ?, ?, ? )" ).arg( table ) );
+        query.addBindValue( artist );
+        query.addBindValue( name );
+        query.addBindValue( name.toLower() );
+        query.exec();
+    }
+
+    void fill( QSqlDatabase& db )
+    {
+        const int portishead = addArtist( db, "Portishead" );
+        const int massive = addArtist( db, "Massive Attack" );
+        addArtist( db, "Love" );
+
+        add( db, "album", portishead, "Dummy" );
+        add( db, "album", massive, "Mezzanine" );
+        add( db, "track", portishead, "Glory Box" );
+        add( db, "track", portishead, "Sour Times" );
+        add( db, "track", massive, "Teardrop" );
+        add( db, "track", massive, "Angel" );
+        add( db, "track", massive, "Love You Love Me Love" );
+    }
+
+    static QStringList names( const QVariantList& suggestions )
+    {
+        QStringList names;
+        foreach ( const QVariant& v, suggestions )
+            names << v.toMap().value( "type" ).toString() + ":" + v.toMap().value( "name" ).toString();
+
+        return names;
+    }
+
+private slots:
+    void testPrefix()
+    {
+        QSqlDatabase db = openDatabase( "testPrefix" );
+        fill( db );
+
+        CompletionIndex index;
+        QVERIFY( !index.isLoaded() );
+        index.update( db );
+        QVERIFY( index.isLoaded() );
+
+        QCOMPARE( names( index.suggest( "port", 10 ) ), QStringList() << "artist:Portishead" );
+        QCOMPARE( names( index.suggest( "MEZ", 10 ) ), QStringList() << "album:Mezzanine" );
+        QCOMPARE( names( index.suggest( "  glory   b", 10 ) ), QStringList() << "track:Glory Box" );
+        QVERIFY( index.suggest( "zz", 10 ).isEmpty() );
+        QVERIFY( index.suggest( "", 10 ).isEmpty() );
+
+        const QVariantMap track = index.suggest( "tear", 10 ).first().toMap();
+        QCOMPARE( track.value( "type" ).toString(), QString( "track" ) );
+        QCOMPARE( track.value( "artist" ).toString(), QString( "Massive Attack" ) );
+        QCOMPARE( track.value( "id" ).toUInt(), 3u );
+
+        const QVariantMap artist = index.suggest( "massive", 10 ).first().toMap();
+        QVERIFY( !artist.contains( "artist" ) );
+    }
+
+    void testInnerWords()
+    {
+        QSqlDatabase db = openDatabase( "testInnerWords" );
+        fill( db );
+
+        CompletionIndex index;
+        index.update( db );
+
+        // matches at the start of a name come before later words, artists before albums before tracks
+        QCOMPARE( names( index.suggest( "box", 10 ) ), QStringList() << "track:Glory Box" );
+        QCOMPARE( names( index.suggest( "att", 10 ) ), QStringList() << "artist:Massive Attack" );
+        QCOMPARE( names( index.suggest( "times", 10 ) ), QStringList() << "track:Sour Times" );
+        QCOMPARE( names( index.suggest( "a", 10 ) ), QStringList() << "track:Angel" << "artist:Massive Attack" );
+    }
+
+    void testDuplicates()
+    {
+        QSqlDatabase db = openDatabase( "testDuplicates" );
+        fill( db );
+
+        CompletionIndex index;
+        index.update( db );
+
+        // "love you love me love" matches on three of its words, and is listed once
+        QCOMPARE( names( index.suggest( "love", 10 ) ), QStringList() << "artist:Love" << "track:Love You Love Me Love" );
+        QCOMPARE( names( index.suggest( "me", 10 ) ), QStringList() << "album:Mezzanine" << "track:Love You Love Me Love" );
+    }
+
+    void testLimit()
+    {
+        QSqlDatabase db = openDatabase( "testLimit" );
+        fill( db );
+
+        CompletionIndex index;
+        index.update( db );
+
+        QCOMPARE( index.suggest( "love", 1 ).count(), 1 );
+        QCOMPARE( names( index.suggest( "love", 1 ) ), QStringList() << "artist:Love" );
+        QVERIFY( index.suggest( "love", 0 ).isEmpty() );
+        QVERIFY( index.suggest( "love", -1 ).isEmpty() );
+
+        QCOMPARE( names( index.suggest( "m", 2 ) ), QStringList() << "artist:Massive Attack" << "album:Mezzanine" );
+    }
+
+    void testIncrementalUpdate()
+    {
+        QSqlDatabase db = openDatabase( "testIncrementalUpdate" );
+        fill( db );
+
+        CompletionIndex index;
+        index.update( db );
+        QVERIFY( index.suggest( "tricky", 10 ).isEmpty() );
+
+        db.transaction();
+        const int tricky = addArtist( db, "Tricky" );
+        for ( int i = 0; i < SYNTHETIC_TRACKS; i++ )
+            add( db, "track", tricky, QString( "Track %1" ).arg( i, 5, 10, QChar( '0' ) ) );
+        db.commit();
+
+        index.update( db );
+
+        QCOMPARE( names( index.suggest( "glory", 10 ) ), QStringList() << "track:Glory Box" );
+        QCOMPARE( names( index.suggest( "tricky", 10 ) ), QStringList() << "artist:Tricky" );
+        QCOMPARE( names( index.suggest( "track 0000", 10 ) ), QStringList() << "track:Track 00000" << "track:Track 00001" << "track:Track 00002"
+                                                                               << "track:Track 00003" << "track:Track 00004" << "track:Track 00005"
+                                                                               << "track:Track 00006" << "track:Track 00007" << "track:Track 00008"
+                                                                               << "track:Track 00009" );
+        QCOMPARE( names( index.suggest( "track 09999", 10 ) ), QStringList() << "track:Track 09999" );
+
+        // names added later land in the last, partly filled block
+        add( db, "track", tricky, "Hell Is Round The Corner" );
+        add( db, "album", tricky, "Maxinquaye" );
+        index.update( db );
+
+        QCOMPARE( names( index.suggest( "hell", 10 ) ), QStringList() << "track:Hell Is Round The Corner" );
+        QCOMPARE( names( index.suggest( "corner", 10 ) ), QStringList() << "track:Hell Is Round The Corner" );
+        QCOMPARE( names( index.suggest( "maxin", 10 ) ), QStringList() << "album:Maxinquaye" );
+        QCOMPARE( names( index.suggest( "track 05000", 10 ) ), QStringList() << "track:Track 05000" );
+
+        // nothing new, nothing changes
+        index.update( db );
+        QCOMPARE( names( index.suggest( "maxin", 10 ) ), QStringList() << "album:Maxinquaye" );
+    }
+
+    void testLookupLatency()
+    {
+        QSqlDatabase db = openDatabase( "testLookupLatency" );
+        fill( db );
+
+        db.transaction();
+        for ( int i = 0; i < SYNTHETIC_TRACKS; i++ )
+            add( db, "track", 1, QString( "Song number %1" ).arg( i ) );
+        db.commit();
+
+        CompletionIndex index;
+        index.update( db );
+
+        // what a keystroke costs: a few binary searches and reading off the first matches
+        QVariantList suggestions;
+        QBENCHMARK
+        {
+            suggestions = index.suggest( "so", 10 );
+        }
+        QCOMPARE( suggestions.count(), 10 );
+    }
+};
+
+#endif
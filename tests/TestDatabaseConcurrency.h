@@ -0,0 +1,238 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTDATABASECONCURRENCY_H
+#define TOMAHAWK_TESTDATABASECONCURRENCY_H
+
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QThread>
+#include <QTime>
+
+#include "libtomahawk/database/DatabaseCommand_AddFiles.h"
+#include "libtomahawk/database/FileBatch.h"
+
+#define SYNTHETIC_FILES 100000
+#define READER_THREADS 4
+
+
+/// Opens a private connection to the benchmark database, like the database worker threads do.
+static QSqlDatabase
+openConnection( const QString& path, const QString& name )
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase( "QSQLITE", name );
+    db.setDatabaseName( path );
+    db.setConnectOptions( "QSQLITE_BUSY_TIMEOUT=5000" );
+    db.open();
+
+    QSqlQuery query( db );
+    query.exec( "PRAGMA synchronous = NORMAL" );
+    return db;
+}
+
+
+class WriterThread : public QThread
+{
+public:
+    WriterThread( const QString& path, const FileBatch& batch )
+        : m_path( path )
+        , m_batch( batch )
+        , m_ok( false )
+    {
+    }
+
+    bool ok() const { return m_ok; }
+
+protected:
+    void run()
+    {
+        {
+            QSqlDatabase db = openConnection( m_path, "writer" );
+            db.transaction();
+            m_ok = DatabaseCommand_AddFiles::insertFiles( db, QVariant( QVariant::Int ), m_batch );
+            m_ok = db.commit() && m_ok;
+        }
+        QSqlDatabase::removeDatabase( "writer" );
+    }
+
+private:
+    QString m_path;
+    FileBatch m_batch;
+    bool m_ok;
+};
+
+
+class ReaderThread : public QThread
+{
+public:
+    ReaderThread( const QString& path, int index, QThread* writer )
+        : m_path( path )
+        , m_name( QString( "reader%1" ).arg( index ) )
+        , m_writer( writer )
+        , m_reads( 0 )
+        , m_failures( 0 )
+    {
+    }
+
+    int reads() const { return m_reads; }
+    int failures() const { return m_failures; }
+
+protected:
+    void run()
+    {
+        {
+            QSqlDatabase db = openConnection( m_path, m_name );
+            QSqlQuery query( db );
+            query.prepare( "SELECT id, url, size FROM file WHERE id > ? ORDER BY id LIMIT 50" );
+
+            while ( !m_writer->isFinished() )
+            {
+                query.bindValue( 0, m_reads % 1000 );
+                if ( query.exec() )
+                {
+                    while ( query.next() );
+                    m_reads++;
+                }
+                else
+                    m_failures++;
+            }
+        }
+        QSqlDatabase::removeDatabase( m_name );
+    }
+
+private:
+    QString m_path;
+    QString m_name;
+    QThread* m_writer;
+    int m_reads;
+    int m_failures;
+};
+
+
+class TestDatabaseConcurrency : public QObject
+{
+    Q_OBJECT
+
+private:
+    FileBatch syntheticBatch( int count, int offset )
+    {
+        FileBatch batch;
+        batch.reserve( count );
+        for ( int i = offset; i < offset + count; i++ )
+        {
+            batch.append( QString( "file:///music/artist%1/album%2/track%3.mp3" ).arg( i / 100 ).arg( i / 10 ).arg( i ),
+                          1360000000 + i, 4000000 + i, "", "audio/mpeg", 240, 320,
+                          QString( "Artist %1" ).arg( i / 100 ), QString( "Album %1" ).arg( i / 10 ), QString( "Track %1" ).arg( i ),
+                          i % 10 + 1, 2013, QString(), QString(), 1 );
+        }
+
+        return batch;
+    }
+
+    QString createDatabase( const QString& journalMode )
+    {
+        const QString path = QDir::temp().filePath( QString( "tomahawk-concurrency-%1.db" ).arg( QCoreApplication::applicationPid() ) );
+        removeDatabase( path );
+
+        {
+            QSqlDatabase db = openConnection( path, "setup" );
+            QSqlQuery query( db );
+            query.exec( QString( "PRAGMA journal_mode = %1" ).arg( journalMode ) );
+            query.exec( "CREATE TABLE file ("
+                        "id INTEGER PRIMARY KEY AUTOINCREMENT, source INTEGER, url TEXT NOT NULL, size INTEGER NOT NULL, "
+                        "mtime INTEGER NOT NULL, md5 TEXT, mimetype TEXT, duration INTEGER NOT NULL DEFAULT 0, "
+                        "bitrate INTEGER NOT NULL DEFAULT 0 )" );
+            query.exec( "CREATE UNIQUE INDEX file_url_src_uniq ON file(source, url)" );
+
+            // something for the readers to find
+            FileBatch batch = syntheticBatch( 2000, 0 );
+            db.transaction();
+            DatabaseCommand_AddFiles::insertFiles( db, QVariant( QVariant::Int ), batch );
+            db.commit();
+        }
+        QSqlDatabase::removeDatabase( "setup" );
+
+        return path;
+    }
+
+    void removeDatabase( const QString& path )
+    {
+        QFile::remove( path );
+        QFile::remove( path + "-wal" );
+        QFile::remove( path + "-shm" );
+        QFile::remove( path + "-journal" );
+    }
+
+private slots:
+    void benchmarkReadersDuringAddFiles_data()
+    {
+        QTest::addColumn< QString >( "journalMode" );
+
+        QTest::newRow( "rollback journal" ) << "DELETE";
+        QTest::newRow( "write-ahead log" ) << "WAL";
+    }
+
+    void benchmarkReadersDuringAddFiles()
+    {
+        QFETCH( QString, journalMode );
+
+        const QString path = createDatabase( journalMode );
+        WriterThread writer( path, syntheticBatch( SYNTHETIC_FILES, 2000 ) );
+        QList< ReaderThread* > readers;
+        for ( int i = 0; i < READER_THREADS; i++ )
+            readers << new ReaderThread( path, i, &writer );
+
+        QTime t;
+        QBENCHMARK_ONCE
+        {
+            t.start();
+            writer.start();
+            foreach ( ReaderThread* reader, readers )
+                reader->start();
+
+            writer.wait();
+            foreach ( ReaderThread* reader, readers )
+                reader->wait();
+        }
+        const int elapsed = qMax( 1, t.elapsed() );
+
+        int reads = 0;
+        int failures = 0;
+        foreach ( ReaderThread* reader, readers )
+        {
+            reads += reader->reads();
+            failures += reader->failures();
+        }
+        qDeleteAll( readers );
+        removeDatabase( path );
+
+        qDebug() << journalMode << "readers:" << reads * 1000 / elapsed << "queries/s," << failures << "failed while inserting" << SYNTHETIC_FILES << "files in" << elapsed << "ms";
+
+        QVERIFY( writer.ok() );
+        if ( journalMode == "WAL" )
+        {
+            QVERIFY( reads > 0 );
+            QCOMPARE( failures, 0 );
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,170 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTEDITDISTANCE_H
+#define TOMAHAWK_TESTEDITDISTANCE_H
+
+#include <QtTest>
+
+#include "libtomahawk/utils/EditDistance.h"
+
+#define SYNTHETIC_NAMES 10000
+
+class TestEditDistance : public QObject
+{
+    Q_OBJECT
+
+private:
+    // The full-matrix implementation TomahawkUtils::levenshtein() used to have
+    static int matrixDistance( const QString& source, const QString& target )
+    {
+        const int n = source.length();
+        const int m = target.length();
+
+        if ( n == 0 )
+            return m;
+        if ( m == 0 )
+            return n;
+
+        QVector< QVector<int> > matrix( n + 1, QVector<int>( m + 1 ) );
+        for ( int i = 0; i <= n; i++ )
+            matrix[i][0] = i;
+        for ( int j = 0; j <= m; j++ )
+            matrix[0][j] = j;
+
+        for ( int i = 1; i <= n; i++ )
+        {
+            const QChar s_i = source[i - 1];
+            for ( int j = 1; j <= m; j++ )
+            {
+                const QChar t_j = target[j - 1];
+                const int cost = ( s_i == t_j ) ? 0 : 1;
+
+                int cell = qMin( matrix[i][j - 1] + 1, matrix[i - 1][j - 1] + cost );
+                cell = qMin( cell, matrix[i - 1][j] + 1 );
+
+                if ( i > 2 && j > 2 )
+                {
+                    int trans = matrix[i - 2][j - 2] + 1;
+                    if ( source[i - 2] != t_j ) trans++;
+                    if ( s_i != target[j - 2] ) trans++;
+                    cell = qMin( cell, trans );
+                }
+                matrix[i][j] = cell;
+            }
+        }
+
+        return matrix[n][m];
+    }
+
+    static QString randomString( int maxLength, const QString& alphabet )
+    {
+        QString s;
+        const int length = qrand() % ( maxLength + 1 );
+        for ( int i = 0; i < length; i++ )
+            s += alphabet.at( qrand() % alphabet.length() );
+
+        return s;
+    }
+
+    static QStringList syntheticNames( int count )
+    {
+        qsrand( 42 );
+
+        QStringList names;
+        for ( int i = 0; i < count; i++ )
+            names << randomString( 30, "abcdefghijklmnopqrstuvwxyz " );
+
+        return names;
+    }
+
+private slots:
+    void testSimple()
+    {
+        QCOMPARE( TomahawkUtils::EditDistance::distance( "", "" ), 0 );
+        QCOMPARE( TomahawkUtils::EditDistance::distance( "", "abc" ), 3 );
+        QCOMPARE( TomahawkUtils::EditDistance::distance( "kitten", "sitting" ), 3 );
+        QCOMPARE( TomahawkUtils::EditDistance( "the beatles" ).distance( "the beatles" ), 0 );
+        QCOMPARE( TomahawkUtils::EditDistance( "the beatles" ).distance( "the baetles" ), 1 );
+    }
+
+    void testMatchesMatrix_data()
+    {
+        QTest::addColumn< QString >( "alphabet" );
+        QTest::addColumn< int >( "maxLength" );
+
+        QTest::newRow( "binary" ) << QString( "ab" ) << 12;
+        QTest::newRow( "latin" ) << QString( "abcde " ) << 40;
+        QTest::newRow( "non-latin1" ) << QString::fromUtf8( "aø€日本語" ) << 40;
+        QTest::newRow( "long" ) << QString( "abc" ) << 150;
+    }
+
+    void testMatchesMatrix()
+    {
+        QFETCH( QString, alphabet );
+        QFETCH( int, maxLength );
+
+        qsrand( 1 );
+        for ( int i = 0; i < 2000; i++ )
+        {
+            const QString a = randomString( maxLength, alphabet );
+            const QString b = randomString( maxLength, alphabet );
+            const int expected = matrixDistance( a, b );
+
+            QCOMPARE( TomahawkUtils::EditDistance::distance( a, b ), expected );
+            QCOMPARE( TomahawkUtils::EditDistance( a ).distance( b ), expected );
+        }
+    }
+
+    void benchmarkMatrix()
+    {
+        const QStringList names = syntheticNames( SYNTHETIC_NAMES );
+        const QString query( "the quick brown fox jumps" );
+
+        QBENCHMARK
+        {
+            foreach ( const QString& name, names )
+                matrixDistance( query, name );
+        }
+    }
+
+    void benchmarkBitParallel()
+    {
+        const QStringList names = syntheticNames( SYNTHETIC_NAMES );
+        const QString query( "the quick brown fox jumps" );
+
+        QBENCHMARK
+        {
+            foreach ( const QString& name, names )
+                TomahawkUtils::EditDistance::distance( query, name );
+        }
+    }
+
+    void benchmarkBatch()
+    {
+        const QStringList names = syntheticNames( SYNTHETIC_NAMES );
+        const TomahawkUtils::EditDistance query( "the quick brown fox jumps" );
+
+        QBENCHMARK
+        {
+            query.distances( names );
+        }
+    }
+};
+
+#endif
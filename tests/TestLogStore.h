@@ -0,0 +1,217 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTLOGSTORE_H
+#define TOMAHAWK_TESTLOGSTORE_H
+
+#include <QtTest>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include "libtomahawk/utils/LogStore.h"
+
+using namespace TomahawkUtils;
+
+class TestLogStore : public QObject
+{
+    Q_OBJECT
+
+private:
+    QString m_path;
+
+    qint64 fileSize() const
+    {
+        return QFileInfo( m_path ).size();
+    }
+
+private slots:
+    void init()
+    {
+        m_path = QDir::temp().filePath( QString( "tomahawk-testlogstore-%1.db" ).arg( QCoreApplication::applicationPid() ) );
+        QFile::remove( m_path );
+        QFile::remove( m_path + ".compact" );
+    }
+
+    void cleanup()
+    {
+        QFile::remove( m_path );
+        QFile::remove( m_path + ".compact" );
+    }
+
+    void testAppendAndReopen()
+    {
+        {
+            LogStore store( m_path );
+            QVERIFY( store.open() );
+            store.insert( "a", "first", 0 );
+            store.insert( "b", "second", 0 );
+            QCOMPARE( store.pendingWrites(), 2 );
+
+            // pending values are visible before they hit the file
+            QCOMPARE( store.value( "a" ), QByteArray( "first" ) );
+            QVERIFY( store.flush() );
+            QCOMPARE( store.pendingWrites(), 0 );
+
+            store.insert( "a", "third", 0 );
+            store.remove( "b" );
+            store.insert( "c", QByteArray( 64 * 1024, 'x' ), 0 );
+        }
+
+        LogStore store( m_path );
+        QVERIFY( store.open() );
+        QCOMPARE( store.count(), 2 );
+        QCOMPARE( store.value( "a" ), QByteArray( "third" ) );
+        QVERIFY( !store.contains( "b" ) );
+        QCOMPARE( store.value( "c" ), QByteArray( 64 * 1024, 'x' ) );
+    }
+
+    void testTornTail()
+    {
+        qint64 goodSize = 0;
+        {
+            LogStore store( m_path );
+            QVERIFY( store.open() );
+            store.insert( "a", "kept", 0 );
+            QVERIFY( store.flush() );
+            goodSize = fileSize();
+
+            store.insert( "b", "lost halfway", 0 );
+        }
+
+        // killed while writing the last record
+        QFile file( m_path );
+        QVERIFY( file.open( QIODevice::ReadWrite ) );
+        QVERIFY( file.resize( file.size() - 3 ) );
+        file.close();
+
+        LogStore store( m_path );
+        QVERIFY( store.open() );
+        QCOMPARE( store.count(), 1 );
+        QCOMPARE( store.value( "a" ), QByteArray( "kept" ) );
+        QVERIFY( !store.contains( "b" ) );
+        QCOMPARE( fileSize(), goodSize );
+
+        // and appending after the cut works
+        store.insert( "b", "again", 0 );
+        store.close();
+        QVERIFY( store.open() );
+        QCOMPARE( store.value( "b" ), QByteArray( "again" ) );
+    }
+
+    void testCorruptTail()
+    {
+        qint64 goodSize = 0;
+        {
+            LogStore store( m_path );
+            QVERIFY( store.open() );
+            store.insert( "a", "kept", 0 );
+            QVERIFY( store.flush() );
+            goodSize = fileSize();
+
+            store.insert( "b", "garbled", 0 );
+        }
+
+        // flip the first key byte of the last record: length prefix (4), checksum (2), op (1), key length (4)
+        QFile file( m_path );
+        QVERIFY( file.open( QIODevice::ReadWrite ) );
+        QVERIFY( file.seek( goodSize + 6 + 1 + 4 ) );
+        QVERIFY( file.write( "z" ) == 1 );
+        file.close();
+
+        LogStore store( m_path );
+        QVERIFY( store.open() );
+        QCOMPARE( store.count(), 1 );
+        QCOMPARE( store.value( "a" ), QByteArray( "kept" ) );
+        QVERIFY( !store.contains( "b" ) );
+        QVERIFY( !store.contains( "z" ) );
+        QCOMPARE( fileSize(), goodSize );
+    }
+
+    void testExpiryAcrossReopen()
+    {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        {
+            LogStore store( m_path );
+            QVERIFY( store.open() );
+            store.insert( "fresh", "1", now + 3600 * 1000 );
+            store.insert( "stale", "2", now - 1000 );
+            store.insert( "forever", "3", 0 );
+            store.insert( "shortened", "4", now + 3600 * 1000 );
+            store.insert( "extended", "5", now + 3600 * 1000 );
+            QVERIFY( !store.contains( "stale" ) );
+            QVERIFY( store.flush() );
+
+            // only the expiry is appended, the values stay where they are
+            store.setExpiry( "shortened", now - 1000 );
+            store.setExpiry( "extended", 0 );
+            QCOMPARE( store.removeExpired( now ), 2 );
+        }
+
+        LogStore store( m_path );
+        QVERIFY( store.open() );
+        QCOMPARE( store.count(), 3 );
+        QVERIFY( store.contains( "fresh" ) );
+        QVERIFY( store.contains( "forever" ) );
+        QVERIFY( !store.contains( "stale" ) );
+        QVERIFY( !store.contains( "shortened" ) );
+
+        qint64 expiry = -1;
+        QCOMPARE( store.value( "extended", &expiry ), QByteArray( "5" ) );
+        QCOMPARE( expiry, (qint64)0 );
+        QCOMPARE( store.value( "fresh", &expiry ), QByteArray( "1" ) );
+        QCOMPARE( expiry, now + 3600 * 1000 );
+    }
+
+    void testCompaction()
+    {
+        LogStore store( m_path );
+        QVERIFY( store.open() );
+        for ( int round = 0; round < 10; round++ )
+        {
+            for ( int i = 0; i < 100; i++ )
+                store.insert( QByteArray::number( i ), QByteArray( 100, 'a' + round ), 0 );
+            QVERIFY( store.flush() );
+        }
+        store.remove( "0" );
+        store.insert( "expired", "gone", QDateTime::currentMSecsSinceEpoch() - 1000 );
+        QVERIFY( store.flush() );
+
+        const qint64 before = fileSize();
+        QVERIFY( store.compact() );
+        QVERIFY( fileSize() < before / 5 );
+        QVERIFY( !QFile::exists( m_path + ".compact" ) );
+
+        QCOMPARE( store.count(), 99 );
+        QCOMPARE( store.value( "1" ), QByteArray( 100, 'j' ) );
+        QVERIFY( !store.contains( "0" ) );
+
+        // writes after compacting land behind the rewritten values
+        store.insert( "1", "after", 0 );
+        store.close();
+
+        QVERIFY( store.open() );
+        QCOMPARE( store.count(), 99 );
+        QCOMPARE( store.value( "1" ), QByteArray( "after" ) );
+        QCOMPARE( store.value( "99" ), QByteArray( 100, 'j' ) );
+        QVERIFY( !store.contains( "expired" ) );
+    }
+};
+
+#endif
@@ -0,0 +1,236 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTNGRAMINDEX_H
+#define TOMAHAWK_TESTNGRAMINDEX_H
+
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+
+#include <algorithm>
+
+#include "libtomahawk/database/NGramIndex.h"
+#include "libtomahawk/Query.h"
+#include "libtomahawk/Track.h"
+
+class TestNGramIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    QString m_path;
+
+    // rows as DatabaseCommand_UpdateSearchIndex hands them over: sortnames for matching, display names for albums
+    static IndexData track( unsigned int id, unsigned int artistId, const QString& artist, const QString& title )
+    {
+        IndexData data;
+        data.id = id;
+        data.artistId = artistId;
+        data.artist = artist;
+        data.track = title;
+        return data;
+    }
+
+    static IndexData album( unsigned int id, unsigned int artistId, const QString& name, const QString& artist )
+    {
+        IndexData data;
+        data.id = id;
+        data.artistId = artistId;
+        data.album = name.toLower();
+        data.albumName = name;
+        data.artistName = artist;
+        return data;
+    }
+
+    void buildBase( NGramIndex& index )
+    {
+        index.beginIndexing( false );
+        index.appendFields( track( 1, 1, "portishead", "glory box" ) );
+        index.appendFields( track( 2, 1, "portishead", "sour times" ) );
+        index.appendFields( track( 3, 2, "massive attack", "teardrop" ) );
+        index.appendFields( track( 4, 2, "massive attack", "angel" ) );
+        index.appendFields( album( 10, 1, "Dummy", "Portishead" ) );
+        index.appendFields( album( 11, 2, "Mezzanine", "Massive Attack" ) );
+        index.endIndexing();
+    }
+
+    QStringList segmentFiles() const
+    {
+        return QDir( m_path ).entryList( QStringList() << "segment-*", QDir::Files );
+    }
+
+private slots:
+    void init()
+    {
+        m_path = QDir::temp().filePath( QString( "tomahawk-testngramindex-%1" ).arg( QCoreApplication::applicationPid() ) );
+        cleanup();
+    }
+
+    void cleanup()
+    {
+        QDir dir( m_path );
+        foreach ( const QString& name, dir.entryList( QDir::Files ) )
+            dir.remove( name );
+        QDir::temp().rmdir( m_path );
+    }
+
+    void testBuildAndSearch()
+    {
+        NGramIndex index( m_path );
+        QVERIFY( !index.load() );
+        QVERIFY( !index.canUpdateIncrementally() );
+
+        buildBase( index );
+        QCOMPARE( index.maxTrackId(), 4u );
+        QCOMPARE( index.maxAlbumId(), 11u );
+        QCOMPARE( segmentFiles().count(), 1 );
+
+        QMap< int, float > hits = index.search( Tomahawk::Query::get( "glory box", QString() ), 10 );
+        QVERIFY( hits.contains( 1 ) );
+        QCOMPARE( hits.value( 1 ), 1.0f );
+        QVERIFY( !hits.contains( 3 ) );
+
+        // typos still hit
+        hits = index.search( Tomahawk::Query::get( "teardorp", QString() ), 10 );
+        QCOMPARE( hits.keys(), QList< int >() << 3 );
+
+        // artist and title must both match
+        hits = index.search( Tomahawk::Query::get( "Massive Attack", "Angel", QString(), QString(), false ), 10 );
+        QCOMPARE( hits.keys(), QList< int >() << 4 );
+        hits = index.search( Tomahawk::Query::get( "Portishead", "Angel", QString(), QString(), false ), 10 );
+        QVERIFY( hits.isEmpty() );
+
+        QHash< int, IndexData > info;
+        hits = index.searchAlbum( Tomahawk::Query::get( "mezanine", QString() ), 10, &info );
+        QCOMPARE( hits.keys(), QList< int >() << 11 );
+        QCOMPARE( info.value( 11 ).albumName, QString( "Mezzanine" ) );
+        QCOMPARE( info.value( 11 ).artistName, QString( "Massive Attack" ) );
+        QCOMPARE( info.value( 11 ).artistId, 2u );
+
+        hits = index.search( Tomahawk::Query::get( "portishead", QString() ), 1 );
+        QCOMPARE( hits.count(), 1 );
+    }
+
+    void testLoad()
+    {
+        {
+            NGramIndex index( m_path );
+            buildBase( index );
+        }
+
+        NGramIndex index( m_path );
+        QVERIFY( index.load() );
+        QVERIFY( index.canUpdateIncrementally() );
+        QCOMPARE( index.maxTrackId(), 4u );
+        QCOMPARE( index.maxAlbumId(), 11u );
+
+        QCOMPARE( index.search( Tomahawk::Query::get( "sour times", QString() ), 10 ).keys(), QList< int >() << 2 );
+
+        QHash< int, IndexData > info;
+        index.searchAlbum( Tomahawk::Query::get( "dummy", QString() ), 10, &info );
+        QCOMPARE( info.value( 10 ).albumName, QString( "Dummy" ) );
+    }
+
+    void testForeignByteOrder()
+    {
+        {
+            NGramIndex index( m_path );
+            buildBase( index );
+        }
+        QCOMPARE( segmentFiles().count(), 1 );
+
+        // the byte order mark follows magic and version, as a big-endian machine would have written it on a little-endian one
+        QFile file( QDir( m_path ).filePath( segmentFiles().first() ) );
+        QVERIFY( file.open( QIODevice::ReadWrite ) );
+        QVERIFY( file.seek( 8 ) );
+        QByteArray mark = file.read( 4 );
+        std::reverse( mark.begin(), mark.end() );
+        QVERIFY( file.seek( 8 ) );
+        QCOMPARE( file.write( mark ), (qint64)4 );
+        file.close();
+
+        NGramIndex index( m_path );
+        QVERIFY( !index.load() );
+        QVERIFY( segmentFiles().isEmpty() );
+        QVERIFY( index.search( Tomahawk::Query::get( "glory box", QString() ), 10 ).isEmpty() );
+    }
+
+    void testDeltaMerge()
+    {
+        NGramIndex index( m_path );
+        buildBase( index );
+
+        index.beginIndexing( true );
+        index.appendFields( track( 5, 3, "tricky", "hell is round the corner" ) );
+        index.appendFields( album( 12, 3, "Maxinquaye", "Tricky" ) );
+        index.endIndexing();
+
+        // deltas stay in memory
+        QCOMPARE( segmentFiles().count(), 1 );
+        QCOMPARE( index.maxTrackId(), 5u );
+        QCOMPARE( index.maxAlbumId(), 12u );
+
+        QCOMPARE( index.search( Tomahawk::Query::get( "hell is round the corner", QString() ), 10 ).keys(), QList< int >() << 5 );
+        QCOMPARE( index.search( Tomahawk::Query::get( "glory box", QString() ), 10 ).keys(), QList< int >() << 1 );
+        QCOMPARE( index.searchAlbum( Tomahawk::Query::get( "maxinquaye", QString() ), 10 ).keys(), QList< int >() << 12 );
+
+        // the artist and title search sees the delta too
+        const QMap< int, float > hits = index.search( Tomahawk::Query::get( "Tricky", "Hell is round the corner", QString(), QString(), false ), 10 );
+        QCOMPARE( hits.keys(), QList< int >() << 5 );
+
+        // an empty delta changes nothing
+        index.beginIndexing( true );
+        index.endIndexing();
+        QCOMPARE( index.maxTrackId(), 5u );
+        QVERIFY( index.canUpdateIncrementally() );
+
+        // a reload only knows the persisted base
+        NGramIndex reloaded( m_path );
+        QVERIFY( reloaded.load() );
+        QCOMPARE( reloaded.maxTrackId(), 4u );
+    }
+
+    void testWipe()
+    {
+        NGramIndex index( m_path );
+        buildBase( index );
+        QVERIFY( !index.search( Tomahawk::Query::get( "glory box", QString() ), 10 ).isEmpty() );
+
+        index.wipe();
+        QVERIFY( segmentFiles().isEmpty() );
+        QVERIFY( !index.canUpdateIncrementally() );
+        QCOMPARE( index.maxTrackId(), 0u );
+        QVERIFY( index.search( Tomahawk::Query::get( "glory box", QString() ), 10 ).isEmpty() );
+        QVERIFY( index.searchAlbum( Tomahawk::Query::get( "dummy", QString() ), 10 ).isEmpty() );
+
+        // and a rebuild after the wipe doesn't pick up anything old
+        index.beginIndexing( false );
+        index.appendFields( track( 7, 4, "bjork", "joga" ) );
+        index.endIndexing();
+        QCOMPARE( segmentFiles().count(), 1 );
+        QCOMPARE( index.maxTrackId(), 7u );
+        QVERIFY( index.search( Tomahawk::Query::get( "glory box", QString() ), 10 ).isEmpty() );
+
+        NGramIndex reloaded( m_path );
+        QVERIFY( reloaded.load() );
+        QCOMPARE( reloaded.search( Tomahawk::Query::get( "joga", QString() ), 10 ).keys(), QList< int >() << 7 );
+    }
+};
+
+#endif
@@ -0,0 +1,441 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTOPLOGCOMPACTION_H
+#define TOMAHAWK_TESTOPLOGCOMPACTION_H
+
+#include <QtTest>
+
+#include "libtomahawk/database/OplogCompaction.h"
+
+// ops left alone at the end of the log, and ids per range, small enough to get folds across ranges
+#define KEEP_RECENT 10
+#define RANGE_SIZE 16
+
+struct LoggedOp
+{
+    qint64 id;
+    QString guid;
+    QString command;
+    QVariantMap op;
+};
+
+/**
+ * Replays a generated oplog the way a peer applies it and checks that a peer
+ * ends up in the same state from any position, whether the log was compacted
+ * or not. Compaction is also stopped after each range, like on shutdown.
+ */
+class TestOplogCompaction : public QObject
+{
+    Q_OBJECT
+
+private:
+    QList< LoggedOp > m_log;
+
+    // what a peer knows about the collection, its playlists and social actions
+    struct Peer
+    {
+        QMap< uint, QString > files;
+        QMap< QString, QString > social;
+        QMap< QString, QString > titles;
+        QMap< QString, QString > revisions;
+        QMap< QString, QStringList > entries;
+        QMap< QString, QMap< QString, QString > > items; // playlist -> entry guid -> track
+
+        QVariantMap state() const
+        {
+            QVariantMap files;
+            foreach ( uint id, this->files.keys() )
+                files.insert( QString::number( id ), this->files.value( id ) );
+
+            QVariantMap social;
+            foreach ( const QString& key, this->social.keys() )
+                social.insert( key, this->social.value( key ) );
+
+            QVariantMap playlists;
+            foreach ( const QString& guid, titles.keys() )
+            {
+                QStringList tracks;
+                foreach ( const QString& entry, entries.value( guid ) )
+                    tracks << items.value( guid ).value( entry, "<missing " + entry + ">" );
+
+                QVariantMap playlist;
+                playlist.insert( "title", titles.value( guid ) );
+                playlist.insert( "revision", revisions.value( guid ) );
+                playlist.insert( "tracks", tracks );
+                playlists.insert( guid, playlist );
+            }
+
+            QVariantMap state;
+            state.insert( "files", files );
+            state.insert( "social", social );
+            state.insert( "playlists", playlists );
+            return state;
+        }
+
+        void apply( const LoggedOp& logged )
+        {
+            const QVariantMap& op = logged.op;
+
+            if ( logged.command == "addfiles" )
+            {
+                foreach ( const QVariant& file, op.value( "files" ).toList() )
+                    files.insert( file.toMap().value( "id" ).toUInt(), file.toMap().value( "url" ).toString() );
+            }
+            else if ( logged.command == "deletefiles" )
+            {
+                if ( op.value( "deleteAll" ).toBool() )
+                    files.clear();
+                foreach ( const QVariant& id, op.value( "ids" ).toList() )
+                    files.remove( id.toUInt() );
+            }
+            else if ( logged.command == "socialaction" )
+            {
+                social.insert( op.value( "action" ).toString() + "/" + op.value( "track" ).toString(), op.value( "comment" ).toString() );
+            }
+            else if ( logged.command == "createplaylist" )
+            {
+                const QString guid = op.value( "playlist" ).toMap().value( "guid" ).toString();
+                titles.insert( guid, op.value( "playlist" ).toMap().value( "title" ).toString() );
+                revisions.insert( guid, QString() );
+                entries.insert( guid, QStringList() );
+            }
+            else if ( logged.command == "renameplaylist" )
+            {
+                const QString guid = op.value( "playlistguid" ).toString();
+                if ( titles.contains( guid ) )
+                    titles.insert( guid, op.value( "playlistTitle" ).toString() );
+            }
+            else if ( logged.command == "deleteplaylist" )
+            {
+                const QString guid = op.value( "playlistguid" ).toString();
+                titles.remove( guid );
+                revisions.remove( guid );
+                entries.remove( guid );
+                items.remove( guid );
+            }
+            else if ( logged.command == "setplaylistrevision" )
+            {
+                // as in DatabaseCommand_SetPlaylistRevision::exec
+                const QString guid = op.value( "playlistguid" ).toString();
+                if ( !titles.contains( guid ) )
+                    return;
+
+                QString oldrev = op.value( "oldrev" ).toString();
+                const QString current = revisions.value( guid );
+                if ( current != oldrev && op.value( "mergedrevisions" ).toStringList().contains( current ) )
+                    oldrev = current;
+
+                foreach ( const QVariant& entry, op.value( "addedentries" ).toList() )
+                {
+                    items[ guid ].insert( entry.toMap().value( "guid" ).toString(),
+                                          entry.toMap().value( "query" ).toMap().value( "track" ).toString() );
+                }
+
+                if ( current == oldrev )
+                {
+                    revisions.insert( guid, op.value( "newrev" ).toString() );
+                    entries.insert( guid, op.value( "orderedguids" ).toStringList() );
+                }
+            }
+        }
+    };
+
+    void log( const QString& command, const QVariantMap& op )
+    {
+        LoggedOp logged;
+        logged.id = m_log.count() + 1;
+        logged.guid = QString( "op-%1" ).arg( logged.id );
+        logged.command = command;
+        logged.op = op;
+        m_log << logged;
+    }
+
+    void generateLog( int count )
+    {
+        m_log.clear();
+
+        uint fileId = 0;
+        int entryId = 0, revisionId = 0, playlistId = 0;
+        QStringList playlists;
+        QMap< QString, QString > revisions;
+        QMap< QString, QStringList > entries;
+
+        while ( m_log.count() < count )
+        {
+            const int what = qrand() % 100;
+            QVariantMap op;
+
+            if ( what < 15 || fileId == 0 )
+            {
+                QVariantList files;
+                for ( int i = qrand() % 5 + 1; i > 0; i-- )
+                {
+                    QVariantMap file;
+                    file.insert( "id", ++fileId );
+                    file.insert( "url", QString( "file-%1.mp3" ).arg( fileId ) );
+                    files << file;
+                }
+                op.insert( "files", files );
+                log( "addfiles", op );
+            }
+            else if ( what < 25 )
+            {
+                QVariantList ids;
+                for ( int i = qrand() % 3 + 1; i > 0; i-- )
+                    ids << (uint)( qrand() % fileId + 1 );
+                op.insert( "ids", ids );
+                op.insert( "deleteAll", what == 24 && qrand() % 4 == 0 );
+                log( "deletefiles", op );
+            }
+            else if ( what < 45 )
+            {
+                op.insert( "action", qrand() % 2 ? "Love" : "Inbox" );
+                op.insert( "artist", "artist" );
+                op.insert( "track", QString( "track-%1" ).arg( qrand() % 6 ) );
+                op.insert( "comment", qrand() % 2 ? "true" : "false" );
+                log( "socialaction", op );
+            }
+            else if ( what < 50 || playlists.isEmpty() )
+            {
+                const QString guid = QString( "playlist-%1" ).arg( ++playlistId );
+                QVariantMap playlist;
+                playlist.insert( "guid", guid );
+                playlist.insert( "title", guid );
+                op.insert( "playlist", playlist );
+                log( "createplaylist", op );
+
+                playlists << guid;
+                revisions.insert( guid, QString() );
+                entries.insert( guid, QStringList() );
+            }
+            else if ( what < 55 )
+            {
+                op.insert( "playlistguid", playlists.at( qrand() % playlists.count() ) );
+                op.insert( "playlistTitle", QString( "title-%1" ).arg( qrand() % 1000 ) );
+                log( "renameplaylist", op );
+            }
+            else if ( what < 58 )
+            {
+                const QString guid = playlists.takeAt( qrand() % playlists.count() );
+                op.insert( "playlistguid", guid );
+                log( "deleteplaylist", op );
+            }
+            else
+            {
+                const QString guid = playlists.at( qrand() % playlists.count() );
+                QStringList guids = entries.value( guid );
+                QVariantList added;
+
+                for ( int i = qrand() % 3; i > 0 && !guids.isEmpty(); i-- )
+                    guids.removeAt( qrand() % guids.count() );
+                for ( int i = qrand() % 4; i > 0; i-- )
+                {
+                    const QString entry = QString( "entry-%1" ).arg( ++entryId );
+                    QVariantMap query;
+                    query.insert( "track", QString( "track of %1" ).arg( entry ) );
+                    QVariantMap e;
+                    e.insert( "guid", entry );
+                    e.insert( "query", query );
+                    added << e;
+                    guids.insert( qrand() % ( guids.count() + 1 ), entry );
+                }
+
+                const QString newrev = QString( "rev-%1" ).arg( ++revisionId );
+                op.insert( "playlistguid", guid );
+                op.insert( "oldrev", revisions.value( guid ) );
+                op.insert( "newrev", newrev );
+                op.insert( "orderedguids", QVariant( guids ).toList() );
+                op.insert( "addedentries", added );
+                op.insert( "metadataUpdate", qrand() % 20 == 0 );
+                log( "setplaylistrevision", op );
+
+                revisions.insert( guid, newrev );
+                entries.insert( guid, guids );
+            }
+        }
+    }
+
+    /// The log as DatabaseCommand_CompactOplog leaves it after the first ranges ranges.
+    static QList< LoggedOp > compact( const QList< LoggedOp >& log, const OplogCompaction& compaction, qint64 ranges,
+                                      QHash< QString, qint64 >& tombstones )
+    {
+        QList< LoggedOp > compacted;
+        foreach ( LoggedOp logged, log )
+        {
+            if ( compaction.range( logged.id ) < ranges && compaction.dropped().contains( logged.id ) )
+            {
+                tombstones.insert( logged.guid, logged.id );
+                continue;
+            }
+
+            if ( compaction.range( logged.id ) < ranges && compaction.rewritten().contains( logged.id ) )
+                logged.op = compaction.rewritten().value( logged.id );
+
+            compacted << logged;
+        }
+
+        return compacted;
+    }
+
+    OplogCompaction compaction() const
+    {
+        OplogCompaction compaction( m_log.count() - KEEP_RECENT, RANGE_SIZE );
+        foreach ( const LoggedOp& logged, m_log )
+            compaction.add( logged.id, logged.command, logged.op );
+
+        foreach ( qint64 id, compaction.shrinkable() )
+            compaction.shrink( id, m_log.at( id - 1 ).op );
+
+        return compaction;
+    }
+
+    /// Replays log after lastop to a peer that applied the uncompacted log up to it, like DatabaseCommand_loadOps.
+    QVariantMap replay( const QList< LoggedOp >& log, const QHash< QString, qint64 >& tombstones, const QString& lastop ) const
+    {
+        qint64 since = 0;
+        if ( !lastop.isEmpty() )
+        {
+            since = tombstones.value( lastop );
+            foreach ( const LoggedOp& logged, log )
+            {
+                if ( logged.guid == lastop )
+                    since = logged.id;
+            }
+            Q_ASSERT( since > 0 );
+        }
+
+        Peer peer;
+        foreach ( const LoggedOp& logged, m_log )
+        {
+            if ( logged.id <= since )
+                peer.apply( logged );
+        }
+
+        foreach ( const LoggedOp& logged, log )
+        {
+            if ( logged.id > since )
+                peer.apply( logged );
+        }
+
+        return peer.state();
+    }
+
+    void verifyReplay( qint64 ranges )
+    {
+        const OplogCompaction c = compaction();
+        QHash< QString, qint64 > tombstones;
+        const QList< LoggedOp > compacted = compact( m_log, c, ranges, tombstones );
+
+        const QVariantMap expected = replay( m_log, QHash< QString, qint64 >(), QString() );
+        QCOMPARE( replay( compacted, tombstones, QString() ), expected );
+
+        foreach ( const LoggedOp& logged, m_log )
+        {
+            const QVariantMap state = replay( compacted, tombstones, logged.guid );
+            if ( state != expected )
+                QFAIL( qPrintable( QString( "Replay from %1 (%2, %3) differs after compacting %4 ranges" )
+                                   .arg( logged.guid ).arg( logged.command )
+                                   .arg( tombstones.contains( logged.guid ) ? "removed" : "kept" ).arg( ranges ) ) );
+        }
+    }
+
+private slots:
+    void testCompacts()
+    {
+        qsrand( 1 );
+        generateLog( 600 );
+
+        const OplogCompaction c = compaction();
+        QVERIFY( !c.dropped().isEmpty() );
+        QVERIFY( !c.rewritten().isEmpty() );
+
+        // something was folded, and the newest ops weren't touched
+        bool folded = false;
+        foreach ( const QVariantMap& op, c.rewritten() )
+            folded = folded || op.contains( "mergedrevisions" );
+        QVERIFY( folded );
+
+        foreach ( qint64 id, c.dropped() )
+            QVERIFY( id <= c.until() );
+        foreach ( qint64 id, c.rewritten().keys() )
+            QVERIFY( id <= c.until() );
+    }
+
+    void testReplay()
+    {
+        qsrand( 2 );
+        generateLog( 400 );
+
+        const OplogCompaction c = compaction();
+        verifyReplay( c.range( c.until() ) + 1 );
+    }
+
+    void testInterruptedReplay()
+    {
+        qsrand( 3 );
+        generateLog( 200 );
+
+        const OplogCompaction c = compaction();
+        for ( qint64 ranges = 0; ranges <= c.range( c.until() ); ranges++ )
+            verifyReplay( ranges );
+    }
+
+    void testFoldedRevisions()
+    {
+        // a playlist that only ever changes, so its revisions are folded within each range
+        m_log.clear();
+        QVariantMap playlist;
+        playlist.insert( "guid", "playlist" );
+        QVariantMap create;
+        create.insert( "playlist", playlist );
+        log( "createplaylist", create );
+
+        QStringList guids;
+        QString oldrev;
+        for ( int i = 0; i < 3 * RANGE_SIZE + KEEP_RECENT; i++ )
+        {
+            const QString entry = QString( "entry-%1" ).arg( i );
+            QVariantMap query;
+            query.insert( "track", entry );
+            QVariantMap e;
+            e.insert( "guid", entry );
+            e.insert( "query", query );
+
+            if ( i % 3 == 2 )
+                guids.removeFirst();
+            guids << entry;
+
+            QVariantMap op;
+            op.insert( "playlistguid", "playlist" );
+            op.insert( "oldrev", oldrev );
+            op.insert( "newrev", QString( "rev-%1" ).arg( i ) );
+            op.insert( "orderedguids", QVariant( guids ).toList() );
+            op.insert( "addedentries", QVariantList() << e );
+            log( "setplaylistrevision", op );
+
+            oldrev = QString( "rev-%1" ).arg( i );
+        }
+
+        const OplogCompaction c = compaction();
+        QVERIFY( c.dropped().count() > 2 * RANGE_SIZE );
+        verifyReplay( c.range( c.until() ) + 1 );
+    }
+};
+
+#endif
@@ -0,0 +1,125 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTPLAYABLEPROXYMODEL_H
+#define TOMAHAWK_TESTPLAYABLEPROXYMODEL_H
+
+#include <QtTest>
+
+#include "libtomahawk/playlist/PlayableModel.h"
+#include "libtomahawk/playlist/PlayableProxyModel.h"
+#include "libtomahawk/resolvers/Resolver.h"
+#include "libtomahawk/Query.h"
+#include "libtomahawk/Result.h"
+
+// results resolved by it count as online
+class DupeTestResolver : public Tomahawk::Resolver
+{
+public:
+    QString name() const { return "dupes"; }
+    unsigned int weight() const { return 100; }
+    unsigned int timeout() const { return 0; }
+    void resolve( const Tomahawk::query_ptr& query ) { Q_UNUSED( query ); }
+};
+
+class TestPlayableProxyModel : public QObject
+{
+    Q_OBJECT
+
+private:
+    DupeTestResolver m_resolver;
+
+    static Tomahawk::query_ptr query( const QString& artist, const QString& track )
+    {
+        return Tomahawk::Query::get( artist, track, "Album", QString(), false );
+    }
+
+    Tomahawk::result_ptr onlineResult( const QString& url )
+    {
+        Tomahawk::result_ptr result = Tomahawk::Result::get( url );
+        result->setResolvedBy( &m_resolver );
+        return result;
+    }
+
+    static QList< int > sourceRows( const PlayableProxyModel& proxy )
+    {
+        QList< int > rows;
+        for ( int i = 0; i < proxy.rowCount( QModelIndex() ); i++ )
+            rows << proxy.mapToSource( proxy.index( i, 0, QModelIndex() ) ).row();
+
+        return rows;
+    }
+
+private slots:
+    void testHideDupes()
+    {
+        PlayableModel model( 0, false );
+        PlayableProxyModel proxy;
+        proxy.setSourcePlayableModel( &model );
+        proxy.setHideDupeItems( true );
+
+        // separate queries for the same track are dupes, the first one stays
+        model.appendQueries( QList< Tomahawk::query_ptr >() << query( "Portishead", "Glory Box" ) << query( "Portishead", "Sour Times" )
+                                                            << query( "Portishead", "Glory Box" ) << query( "Massive Attack", "Angel" ) );
+        QCOMPARE( sourceRows( proxy ), QList< int >() << 0 << 1 << 3 );
+
+        // appended rows are checked against the ones already there
+        model.appendQueries( QList< Tomahawk::query_ptr >() << query( "Massive Attack", "Angel" ) << query( "Massive Attack", "Teardrop" ) );
+        QCOMPARE( sourceRows( proxy ), QList< int >() << 0 << 1 << 3 << 5 );
+
+        // and rows inserted in front move the first occurrence
+        model.insertQueries( QList< Tomahawk::query_ptr >() << query( "Massive Attack", "Teardrop" ), 0 );
+        QCoreApplication::processEvents();
+        QCOMPARE( sourceRows( proxy ), QList< int >() << 0 << 1 << 2 << 4 );
+
+        proxy.setHideDupeItems( false );
+        QCOMPARE( proxy.rowCount( QModelIndex() ), 7 );
+    }
+
+    void testDupesFollowAcceptedRows()
+    {
+        PlayableModel model( 0, false );
+        PlayableProxyModel proxy;
+        proxy.setSourcePlayableModel( &model );
+        proxy.setHideDupeItems( true );
+        proxy.setShowOfflineResults( false );
+
+        Tomahawk::query_ptr first = query( "Tricky", "Overcome" );
+        Tomahawk::query_ptr other = query( "Tricky", "Black Steel" );
+        Tomahawk::query_ptr second = query( "Tricky", "Overcome" );
+        const Tomahawk::result_ptr firstResult = onlineResult( "test://tricky/overcome/1" );
+        first->addResults( QList< Tomahawk::result_ptr >() << firstResult );
+        other->addResults( QList< Tomahawk::result_ptr >() << onlineResult( "test://tricky/blacksteel" ) );
+        second->addResults( QList< Tomahawk::result_ptr >() << onlineResult( "test://tricky/overcome/2" ) );
+
+        model.appendQueries( QList< Tomahawk::query_ptr >() << first << other << second );
+        QCOMPARE( sourceRows( proxy ), QList< int >() << 0 << 1 );
+
+        // the first one goes offline: the dupe it was hiding takes its place
+        first->removeResult( firstResult );
+        QCoreApplication::processEvents();
+        QCOMPARE( sourceRows( proxy ), QList< int >() << 1 << 2 );
+
+        // and is hidden again once the first one is back
+        first->addResults( QList< Tomahawk::result_ptr >() << firstResult );
+        QCoreApplication::processEvents();
+        QCOMPARE( sourceRows( proxy ), QList< int >() << 0 << 1 );
+    }
+};
+
+#endif
@@ -0,0 +1,129 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTPLAYLISTDELTA_H
+#define TOMAHAWK_TESTPLAYLISTDELTA_H
+
+#include <QtTest>
+
+#include "libtomahawk/database/PlaylistDelta.h"
+
+#define LARGE_PLAYLIST 20000
+
+class TestPlaylistDelta : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QStringList randomList( int maxLength, int alphabet )
+    {
+        QStringList l;
+        const int length = qrand() % ( maxLength + 1 );
+        for ( int i = 0; i < length; i++ )
+            l << QString::number( qrand() % alphabet );
+
+        return l;
+    }
+
+    static QStringList largePlaylist()
+    {
+        QStringList l;
+        for ( int i = 0; i < LARGE_PLAYLIST; i++ )
+            l << QString( "entry-guid-%1" ).arg( i );
+
+        return l;
+    }
+
+    static void verifyRoundTrip( const QStringList& from, const QStringList& to )
+    {
+        QStringList entries = from;
+        QVERIFY( PlaylistDelta::apply( entries, PlaylistDelta::diff( from, to ) ) );
+        QCOMPARE( entries, to );
+    }
+
+private slots:
+    void testSimple()
+    {
+        const QStringList abc = QStringList() << "a" << "b" << "c";
+
+        QVERIFY( PlaylistDelta::diff( abc, abc ).isEmpty() );
+        verifyRoundTrip( QStringList(), abc );
+        verifyRoundTrip( abc, QStringList() );
+        verifyRoundTrip( abc, QStringList() << "c" << "a" << "b" );
+        verifyRoundTrip( abc, QStringList() << "a" << "x" << "c" );
+    }
+
+    void testRandom()
+    {
+        qsrand( 1 );
+        for ( int i = 0; i < 5000; i++ )
+        {
+            const QStringList from = randomList( 15, 20 );
+            QStringList to = randomList( 15, 20 );
+            if ( i % 2 )
+            {
+                // mostly the same entries shuffled around, like a drag and drop
+                to = from;
+                for ( int j = 0; j < to.count() / 3; j++ )
+                    to.move( qrand() % to.count(), qrand() % to.count() );
+            }
+
+            verifyRoundTrip( from, to );
+        }
+    }
+
+    void testSizeFollowsChange()
+    {
+        const QStringList from = largePlaylist();
+
+        QStringList appended = from;
+        appended << "new";
+        QCOMPARE( PlaylistDelta::size( PlaylistDelta::diff( from, appended ) ), 1 );
+
+        QStringList moved = from;
+        moved.move( 10, LARGE_PLAYLIST - 10 );
+        QCOMPARE( PlaylistDelta::size( PlaylistDelta::diff( from, moved ) ), 2 );
+
+        QStringList removed = from;
+        removed.erase( removed.begin() + 100, removed.begin() + 200 );
+        QCOMPARE( PlaylistDelta::size( PlaylistDelta::diff( from, removed ) ), 100 );
+    }
+
+    void testInvalid()
+    {
+        QStringList entries = QStringList() << "a";
+        QVERIFY( !PlaylistDelta::apply( entries, QVariantList() << QVariant( QVariantList() << "-" << 0 << 2 ) ) );
+
+        entries = QStringList() << "a";
+        QVERIFY( !PlaylistDelta::apply( entries, QVariantList() << QVariant( QVariantList() << "+" << 2 << QVariant( QVariantList() << "b" ) ) ) );
+    }
+
+    void benchmarkDiffMove()
+    {
+        const QStringList from = largePlaylist();
+        QStringList to = from;
+        to.move( 5, LARGE_PLAYLIST / 2 );
+
+        QBENCHMARK
+        {
+            PlaylistDelta::diff( from, to );
+        }
+    }
+};
+
+#endif
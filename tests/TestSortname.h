@@ -0,0 +1,136 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTSORTNAME_H
+#define TOMAHAWK_TESTSORTNAME_H
+
+#include <QtTest>
+
+#include "libtomahawk/database/DatabaseImpl.h"
+
+#define SYNTHETIC_NAMES 100000
+
+class TestSortname : public QObject
+{
+    Q_OBJECT
+
+private:
+    // What DatabaseImpl::sortname() used to do
+    static QString regExpSortname( const QString& str, bool replaceArticle )
+    {
+        QString s = str.toLower().trimmed().replace( QRegExp( "[\\s]{2,}" ), " " );
+
+        if ( replaceArticle && s.startsWith( "the " ) )
+            s = s.mid( 4 );
+
+        return s;
+    }
+
+    static QStringList syntheticNames( int count )
+    {
+        const QString alphabet = QString::fromUtf8( "aBcThE \t\n\xc3\xa9\xc3\x9f" );
+
+        qsrand( 42 );
+        QStringList names;
+        for ( int i = 0; i < count; i++ )
+        {
+            QString name = ( i % 3 ) ? QString() : QString( "The" );
+            const int length = qrand() % 24;
+            for ( int j = 0; j < length; j++ )
+                name += alphabet.at( qrand() % alphabet.length() );
+
+            names << name;
+        }
+
+        return names;
+    }
+
+private slots:
+    void testSortname_data()
+    {
+        QTest::addColumn< QString >( "name" );
+
+        QTest::newRow( "empty" ) << QString();
+        QTest::newRow( "plain" ) << QString( "Madonna" );
+        QTest::newRow( "article" ) << QString( "The Beatles" );
+        QTest::newRow( "article tab" ) << QString( "The\tBeatles" );
+        QTest::newRow( "article run" ) << QString( "  The \t Beatles  " );
+        QTest::newRow( "article only" ) << QString( "The " );
+        QTest::newRow( "no article" ) << QString( "Theatre of Tragedy" );
+        QTest::newRow( "single whitespace" ) << QString( "a\tb\nc d" );
+        QTest::newRow( "runs" ) << QString( "a  b\t\tc \n d" );
+    }
+
+    void testSortname()
+    {
+        QFETCH( QString, name );
+
+        QCOMPARE( DatabaseImpl::sortname( name ), regExpSortname( name, false ) );
+        QCOMPARE( DatabaseImpl::sortname( name, true ), regExpSortname( name, true ) );
+    }
+
+    void testSyntheticNames()
+    {
+        foreach ( const QString& name, syntheticNames( 10000 ) )
+        {
+            QCOMPARE( DatabaseImpl::sortname( name ), regExpSortname( name, false ) );
+            QCOMPARE( DatabaseImpl::sortname( name, true ), regExpSortname( name, true ) );
+        }
+    }
+
+    void testJoinSortnames()
+    {
+        foreach ( const QString& name, syntheticNames( 1000 ) )
+        {
+            const QString a = DatabaseImpl::sortname( name );
+            const QString b = DatabaseImpl::sortname( name.right( 5 ) );
+            QCOMPARE( DatabaseImpl::joinSortnames( a, b ), DatabaseImpl::sortname( name + " " + name.right( 5 ) ) );
+        }
+    }
+
+    void testFoldedname()
+    {
+        QCOMPARE( DatabaseImpl::foldedname( "bjork" ), QString( "bjork" ) );
+        QCOMPARE( DatabaseImpl::foldedname( QString::fromUtf8( "bj\xc3\xb6rk" ) ), QString( "bjork" ) );
+        QCOMPARE( DatabaseImpl::foldedname( QString::fromUtf8( "sigur r\xc3\xb3s" ) ), QString( "sigur ros" ) );
+    }
+
+    void benchmarkRegExp()
+    {
+        const QStringList names = syntheticNames( SYNTHETIC_NAMES );
+
+        QBENCHMARK
+        {
+            foreach ( const QString& name, names )
+                regExpSortname( name, true );
+        }
+    }
+
+    void benchmarkSortname()
+    {
+        const QStringList names = syntheticNames( SYNTHETIC_NAMES );
+
+        QBENCHMARK
+        {
+            foreach ( const QString& name, names )
+                DatabaseImpl::sortname( name, true );
+        }
+    }
+};
+
+#endif
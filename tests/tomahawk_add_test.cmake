@@ -1,4 +1,4 @@
-macro(tomahawk_add_test test_class)
+macro(tomahawk_add_test_executable test_class)
     include_directories(${QT_INCLUDES} "${PROJECT_SOURCE_DIR}/src" ${CMAKE_CURRENT_BINARY_DIR} ${QJSON_INCLUDE_DIR})
 
     set(TOMAHAWK_TEST_CLASS ${test_class})
@@ -14,7 +14,16 @@ macro(tomahawk_add_test test_class)
         ${TOMAHAWK_LIBRARIES}
         ${QT_QTTEST_LIBRARY}
         ${QT_QTCORE_LIBRARY}
+        ${QT_QTSQL_LIBRARY}
     )
+endmacro()
 
+macro(tomahawk_add_test test_class)
+    tomahawk_add_test_executable(${test_class})
     add_test(NAME ${TOMAHAWK_TEST_TARGET} COMMAND ${TOMAHAWK_TEST_TARGET})
 endmacro()
+
+# built along with the tests, but too slow for every ctest run, start them by hand
+macro(tomahawk_add_benchmark test_class)
+    tomahawk_add_test_executable(${test_class})
+endmacro()